@@ -15,7 +15,11 @@
    #include "engine.h"
 
    // C/C++:
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
    #include <iostream>
 
 
@@ -153,11 +157,748 @@ int main(int argc, char *argv[])
    eng.setKeyboardCallback(keyboardCallback);
 
 
+   // Optional loader benchmark, scaling with the number of worker threads (see log for per-phase timings):
+   if (argc > 1 && std::string(argv[1]) == "-benchmark")
+   {
+      Eng::ThreadPool &pool = Eng::ThreadPool::getInstance();
+      uint32_t maxNrOfThreads = pool.getNrOfThreads();
+      Eng::Ovo::setCookedCache(false);
+      for (uint32_t nrOfThreads = 0; nrOfThreads <= maxNrOfThreads; nrOfThreads = nrOfThreads ? nrOfThreads * 2 : 1)
+      {
+         pool.setNrOfThreads(nrOfThreads);
+         Eng::Ovo().load("simple3dScene.ovo");
+         Eng::Container::getInstance().reset();
+      }
+      pool.setNrOfThreads(maxNrOfThreads);
+
+      // Streamed vs. mapped loading of a file larger than the window (the scene replicated under a common root):
+      {
+         Eng::Serializer source;
+         std::vector<Eng::Ovo::ChunkInfo> table;
+         if (source.load("simple3dScene.ovo", Eng::Serializer::Mode::memory) && Eng::Ovo().scanChunks(source, table))
+         {
+            // Version and materials, then a root node followed by the copies of the scene hierarchy:
+            uint64_t treeStart = source.getNrOfBytes();
+            for (const Eng::Ovo::ChunkInfo &chunk : table)
+               if (chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::node))
+               {
+                  treeStart = chunk.position;
+                  break;
+               }
+            const uint64_t treeSize = source.getNrOfBytes() - treeStart;
+            const uint32_t nrOfCopies = static_cast<uint32_t>(2 * Eng::Serializer::defaultWindowSize / std::max(treeSize, (uint64_t) 1)) + 1;
+            const std::string rootName = "[synthetic]";
+            const uint8_t *data = static_cast<const uint8_t *>(source.getData());
+            Eng::Serializer synthetic;
+            synthetic.serialize(data, treeStart);
+            synthetic.serialize(static_cast<uint32_t>(Eng::Ovo::ChunkId::node));
+            synthetic.serialize(static_cast<uint32_t>(rootName.size() + 1 + sizeof(glm::mat4) + sizeof(uint32_t) + sizeof("[none]")));
+            synthetic.serialize(rootName);
+            synthetic.serialize(glm::mat4(1.0f));
+            synthetic.serialize(nrOfCopies);
+            synthetic.serialize("[none]");
+            for (uint32_t c = 0; c < nrOfCopies; c++)
+               synthetic.serialize(data + treeStart, treeSize);
+
+            if (synthetic.save("benchmark_streamed.ovo"))
+            {
+               size_t nrOfNodes[2] = { 0, 0 };
+               double ms[2] = { 0.0, 0.0 };
+               Eng::Serializer::Mode modes[2] = { Eng::Serializer::Mode::mapped, Eng::Serializer::Mode::streamed };
+               for (uint32_t c = 0; c < 2; c++)
+               {
+                  const uint64_t t0 = Eng::Timer::getInstance().getCounter();
+                  Eng::Node &root = Eng::Ovo().load("benchmark_streamed.ovo", modes[c]);
+                  ms[c] = Eng::Timer::getInstance().getCounterDiff(t0, Eng::Timer::getInstance().getCounter());
+                  if (root != Eng::Node::empty)
+                  {
+                     const std::string tree = root.getTreeAsString();
+                     nrOfNodes[c] = std::count(tree.begin(), tree.end(), '\n');
+                  }
+                  Eng::Container::getInstance().reset();
+               }
+               ENG_LOG_PLAIN("Streamed loading: %llu-byte file through a %llu-byte window, %zu nodes in %.1f ms (mapped: %zu nodes in %.1f ms), match: %s",
+                             synthetic.getNrOfBytes(), Eng::Serializer::defaultWindowSize, nrOfNodes[1], ms[1], nrOfNodes[0], ms[0],
+                             nrOfNodes[0] && nrOfNodes[0] == nrOfNodes[1] ? "yes" : "no");
+            }
+            std::remove("benchmark_streamed.ovo");
+         }
+      }
+
+      // Indexed access: loads on demand the whole hierarchy and the largest subtree below the root, whose nodes must
+      // match the full load:
+      {
+         Eng::Timer &timer = Eng::Timer::getInstance();
+         Eng::OvoIndex index;
+         const uint64_t t0 = timer.getCounter();
+         if (index.open("simple3dScene.ovo") && index.getEntries().size() > 1)
+         {
+            const double openTime = timer.getCounterDiff(t0, timer.getCounter());
+            const std::vector<Eng::OvoIndex::Entry> &entries = index.getEntries();
+            uint32_t largest = 1;
+            for (uint32_t c = 2; c < entries.size(); c++)
+               if (entries[c].last - entries[c].first > entries[largest].last - entries[largest].first)
+                  largest = c;
+            const std::string names[2] = { entries[0].name, entries[largest].name };
+
+            // Reference node counts, from the full load:
+            size_t nrOfNodes[2] = { 0, 0 };
+            uint64_t t1 = timer.getCounter();
+            Eng::Ovo().load("simple3dScene.ovo");
+            const double loadTime = timer.getCounterDiff(t1, timer.getCounter());
+            for (uint32_t c = 0; c < 2; c++)
+            {
+               Eng::Node *node = dynamic_cast<Eng::Node *>(&Eng::Container::getInstance().find(names[c]));
+               if (node)
+               {
+                  const std::string tree = node->getTreeAsString();
+                  nrOfNodes[c] = std::count(tree.begin(), tree.end(), '\n');
+               }
+            }
+            Eng::Container::getInstance().reset();
+
+            // Subtrees only:
+            for (uint32_t c = 0; c < 2; c++)
+            {
+               size_t nrOfSubtreeNodes = 0;
+               t1 = timer.getCounter();
+               Eng::Node &subtree = index.loadSubtree(names[c]);
+               const double subtreeTime = timer.getCounterDiff(t1, timer.getCounter());
+               if (subtree != Eng::Node::empty)
+               {
+                  const std::string tree = subtree.getTreeAsString();
+                  nrOfSubtreeNodes = std::count(tree.begin(), tree.end(), '\n');
+               }
+               Eng::Container::getInstance().reset();
+               ENG_LOG_PLAIN("Indexed loading: index built in %.1f ms, subtree '%s' with %zu nodes loaded in %.1f ms (full load: %zu nodes in %.1f ms), match: %s",
+                             openTime, names[c].c_str(), nrOfSubtreeNodes, subtreeTime, nrOfNodes[c], loadTime,
+                             nrOfNodes[c] && nrOfNodes[c] == nrOfSubtreeNodes ? "yes" : "no");
+            }
+         }
+      }
+
+      // Export round trip: once loaded again, the exported scene must match the original one (geometry included):
+      {
+         size_t nrOfNodes[2] = { 0, 0 }, nrOfMeshes[2] = { 0, 0 }, nrOfMaterials[2] = { 0, 0 }, nrOfTextures[2] = { 0, 0 };
+         uint64_t geometryHash[2] = { 0, 0 };
+         Eng::Container &container = Eng::Container::getInstance();
+         Eng::Ovo exporter;
+         for (uint32_t c = 0; c < 2; c++)
+         {
+            Eng::Node &root = exporter.load(c == 0 ? "simple3dScene.ovo" : "benchmark_export.ovo");
+            if (root == Eng::Node::empty)
+               break;
+            const std::string tree = root.getTreeAsString();
+            nrOfNodes[c] = std::count(tree.begin(), tree.end(), '\n');
+            nrOfMeshes[c] = container.getMeshList().size();
+            nrOfMaterials[c] = container.getMaterialList().size();
+            nrOfTextures[c] = container.getTextureList().size();
+            geometryHash[c] = 0xcbf29ce484222325ull;
+            for (const Eng::Mesh &mesh : container.getMeshList())
+               geometryHash[c] = (geometryHash[c] ^ mesh.getGeometryKey()) * 0x100000001b3ull;
+            const bool exported = c == 0 && exporter.save("benchmark_export.ovo", root);
+            container.reset();
+            if (c == 0 && exported == false)
+               break;
+         }
+         std::remove("benchmark_export.ovo");
+         ENG_LOG_PLAIN("Export round trip: %zu nodes, %zu meshes, %zu materials, %zu textures, geometry hash %016llx, match: %s",
+                       nrOfNodes[0], nrOfMeshes[0], nrOfMaterials[0], nrOfTextures[0], geometryHash[0],
+                       nrOfNodes[0] && nrOfNodes[0] == nrOfNodes[1] && nrOfMeshes[0] == nrOfMeshes[1] &&
+                       nrOfMaterials[0] == nrOfMaterials[1] && nrOfTextures[0] == nrOfTextures[1] &&
+                       geometryHash[0] == geometryHash[1] ? "yes" : "no");
+      }
+
+      // Import-time mesh optimization (ACMR/ATVR are logged per mesh):
+      Eng::Ovo optimized;
+      optimized.setMeshOptimization(true);
+      optimized.load("simple3dScene.ovo");
+      Eng::Container::getInstance().reset();
+
+      // Compact GPU layouts (buffer sizes and max position error are logged per mesh):
+      Eng::Ovo compact;
+      compact.setCompactGeometry(true);
+      compact.load("simple3dScene.ovo");
+      Eng::Container::getInstance().reset();
+
+      // Geometry sharing (the second copy of the scene references the buffers of the first one):
+      Eng::Ovo().load("simple3dScene.ovo");
+      Eng::Ovo().load("simple3dScene.ovo");
+      ENG_LOG_PLAIN("Geometry sharing: %llu bytes of VRAM saved", Eng::Mesh::getNrOfSharedBytes());
+      Eng::Container::getInstance().reset();
+
+      // Meshlet culling from a ring of viewpoints (submitted triangles and CPU time per view):
+      Eng::Timer &timer = Eng::Timer::getInstance();
+      Eng::Ovo clustered;
+      clustered.setMeshClustering(true);
+      {
+         Eng::List list;
+         list.process(clustered.load("simple3dScene.ovo"));
+         const glm::mat4 projMatrix = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+         const uint32_t nrOfViews = 64;
+         uint64_t nrOfFaces = 0, nrOfVisibleFaces = 0;
+         uint64_t t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfViews; c++)
+         {
+            const float angle = glm::two_pi<float>() * c / nrOfViews;
+            const glm::vec3 eye(50.0f * sin(angle), 20.0f, 50.0f * cos(angle));
+            list.cull(glm::lookAt(eye, glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), projMatrix);
+            nrOfFaces += list.getCullingStats().nrOfFaces;
+            nrOfVisibleFaces += list.getCullingStats().nrOfVisibleFaces;
+         }
+         ENG_LOG_PLAIN("Meshlet culling: %.1f%% of the triangles submitted, %.3f ms per view",
+                       100.0 * nrOfVisibleFaces / (nrOfFaces ? nrOfFaces : 1),
+                       timer.getCounterDiff(t0, timer.getCounter()) / nrOfViews);
+      }
+      Eng::Container::getInstance().reset();
+
+      // LOD chain generation from the first LOD of each mesh, in parallel (reduction and error are logged per level):
+      {
+         Eng::Serializer serial;
+         std::vector<Eng::Ovo::ChunkInfo> table;
+         std::vector<Eng::Mesh::Staging> meshes;
+         if (serial.load("simple3dScene.ovo", Eng::Serializer::Mode::memory) && Eng::Ovo().scanChunks(serial, table))
+            for (const Eng::Ovo::ChunkInfo &chunk : table)
+               if (chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh))
+               {
+                  serial.setPosition(chunk.position);
+                  meshes.emplace_back();
+                  if (Eng::Mesh::decodeChunk(serial, meshes.back()) == false)
+                     meshes.pop_back();
+                  else if (meshes.back().lod.size() > 1)
+                     meshes.back().lod.resize(1);
+               }
+         uint64_t t0 = timer.getCounter();
+         pool.parallelFor(meshes.size(), [&meshes](uint64_t c) { Eng::Mesh::simplifyStaging(meshes[c], 4); });
+         ENG_LOG_PLAIN("LOD generation: %zu meshes in %.1f ms", meshes.size(), timer.getCounterDiff(t0, timer.getCounter()));
+      }
+
+      // LOD selection along a camera path moving away from the scene (triangles at LOD 0 vs. selected LODs):
+      {
+         Eng::Ovo lods;
+         lods.setLodGeneration(4);
+         Eng::Node &scene = lods.load("simple3dScene.ovo");
+         Eng::List list;
+         const glm::mat4 projMatrix = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+         const uint32_t nrOfViews = 64;
+         uint64_t nrOfFaces = 0, nrOfSelectedFaces = 0, nrOfDroppedElems = 0;
+         uint64_t t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfViews; c++)
+         {
+            const glm::vec3 eye(0.0f, 20.0f, 30.0f + 900.0f * c / nrOfViews);
+            list.reset();
+            list.setView(glm::lookAt(eye, glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), projMatrix);
+            list.process(scene);
+            nrOfFaces += list.getLodStats().nrOfFaces;
+            nrOfSelectedFaces += list.getLodStats().nrOfSelectedFaces;
+            nrOfDroppedElems += list.getLodStats().nrOfDroppedElems;
+         }
+         ENG_LOG_PLAIN("LOD selection: %.1f%% of the LOD 0 triangles selected, %llu meshes dropped, %.3f ms per view",
+                       100.0 * nrOfSelectedFaces / (nrOfFaces ? nrOfFaces : 1),
+                       static_cast<unsigned long long>(nrOfDroppedElems),
+                       timer.getCounterDiff(t0, timer.getCounter()) / nrOfViews);
+      }
+      Eng::Container::getInstance().reset();
+
+      // Hierarchical frustum culling on a synthetic 100k-mesh city (100 blocks of 1000 meshes, no geometry uploaded):
+      {
+         const uint32_t nrOfBlocks = 100, nrOfMeshesPerBlock = 1000;
+         Eng::Node city;
+         std::vector<Eng::Node> blocks(nrOfBlocks);
+         std::vector<Eng::Mesh> meshes(nrOfBlocks * nrOfMeshesPerBlock);
+         for (uint32_t b = 0; b < nrOfBlocks; b++)
+         {
+            blocks[b].setMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(100.0f * (b % 10), 0.0f, 100.0f * (b / 10))));
+            city.addChild(blocks[b]);
+            for (uint32_t m = 0; m < nrOfMeshesPerBlock; m++)
+            {
+               Eng::Mesh::Staging staging = {};
+               staging.matrix = glm::translate(glm::mat4(1.0f), glm::vec3(9.0f * (m % 10), 2.0f * (m / 100), 9.0f * (m / 10 % 10)));
+               staging.material = &Eng::Material::empty;
+               staging.radius = 1.8f;
+               staging.bboxMin = glm::vec3(-1.0f);
+               staging.bboxMax = glm::vec3(1.0f);
+               Eng::Mesh &mesh = meshes[b * nrOfMeshesPerBlock + m];
+               mesh.loadStaging(staging);
+               blocks[b].addChild(mesh);
+            }
+         }
+         const glm::mat4 projMatrix = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 1.0f, 400.0f);
+         const uint32_t nrOfViews = 32;
+         for (bool culling : { false, true })
+         {
+            Eng::List list;
+            list.setFrustumCulling(culling);
+            uint64_t nrOfElems = 0, nrOfCulledNodes = 0;
+            uint64_t t0 = timer.getCounter();
+            for (uint32_t c = 0; c < nrOfViews; c++)
+            {
+               const float angle = glm::two_pi<float>() * c / nrOfViews;
+               const glm::vec3 eye(450.0f, 10.0f, 450.0f);
+               list.reset();
+               list.setView(glm::lookAt(eye, eye + glm::vec3(std::cos(angle), -0.1f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f)), projMatrix);
+               list.process(city);
+               nrOfElems += list.getNrOfRenderableElems();
+               nrOfCulledNodes += list.getFrustumStats().nrOfCulledNodes;
+            }
+            ENG_LOG_PLAIN("Frustum culling %s: %llu of %zu meshes listed per view, %llu subtrees skipped, %.3f ms per view",
+                          culling ? "on" : "off", static_cast<unsigned long long>(nrOfElems / nrOfViews), meshes.size(),
+                          static_cast<unsigned long long>(nrOfCulledNodes / nrOfViews),
+                          timer.getCounterDiff(t0, timer.getCounter()) / nrOfViews);
+         }
+
+         // Shadow casters of a spot light above the city (light frustum only, then also against the view):
+         Eng::List list;
+         const glm::vec3 eye(450.0f, 10.0f, 450.0f);
+         list.setView(glm::lookAt(eye, eye + glm::vec3(1.0f, -0.1f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), projMatrix);
+         list.process(city);
+         const glm::mat4 lightMatrix = glm::inverse(glm::lookAt(glm::vec3(450.0f, 300.0f, 450.0f), glm::vec3(450.0f, 0.0f, 450.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
+         const glm::mat4 lightProjMatrix = glm::perspective(glm::radians(75.0f), 1.0f, 1.0f, 1000.0f);
+         std::vector<uint32_t> casters;
+         for (bool receiverCulling : { false, true })
+         {
+            uint64_t t0 = timer.getCounter();
+            for (uint32_t c = 0; c < nrOfViews; c++)
+               list.selectCasters(lightMatrix, lightProjMatrix, casters, receiverCulling);
+            ENG_LOG_PLAIN("Shadow casters (%s): %zu of %u meshes, %.3f ms per light",
+                          receiverCulling ? "light frustum and view" : "light frustum", casters.size(),
+                          list.getNrOfRenderableElems() - list.getNrOfLights(),
+                          timer.getCounterDiff(t0, timer.getCounter()) / nrOfViews);
+         }
+
+         // Scene updates with a few meshes moving per frame (full rebuild vs. patching the list in place):
+         const uint32_t nrOfFrames = 32, nrOfMovedMeshes = 100;
+         for (bool incremental : { false, true })
+         {
+            Eng::List frameList;
+            if (incremental) // First update lists the whole scene
+               frameList.update(city);
+            uint64_t nrOfUpdatedNodes = 0;
+            uint64_t t0 = timer.getCounter();
+            for (uint32_t f = 0; f < nrOfFrames; f++)
+            {
+               for (uint32_t c = 0; c < nrOfMovedMeshes; c++)
+               {
+                  Eng::Mesh &mesh = meshes[(f * 7919 + c * 997) % meshes.size()];
+                  mesh.setMatrix(glm::translate(mesh.getMatrix(), glm::vec3(0.0f, 0.1f, 0.0f)));
+               }
+               if (incremental)
+               {
+                  frameList.update(city);
+                  nrOfUpdatedNodes += frameList.getUpdateStats().nrOfUpdatedNodes;
+               }
+               else
+               {
+                  frameList.reset();
+                  frameList.process(city);
+                  nrOfUpdatedNodes += frameList.getFrustumStats().nrOfVisitedNodes;
+               }
+            }
+            ENG_LOG_PLAIN("Scene update (%s): %u of %zu meshes moved, %llu nodes processed, %.3f ms per frame",
+                          incremental ? "incremental" : "full rebuild", nrOfMovedMeshes, meshes.size(),
+                          static_cast<unsigned long long>(nrOfUpdatedNodes / nrOfFrames),
+                          timer.getCounterDiff(t0, timer.getCounter()) / nrOfFrames);
+         }
+      }
+
+      // Occlusion culling on a synthetic interior (10x10 rooms with doorways and furniture, no geometry uploaded):
+      {
+         const uint32_t nrOfRooms = 10, nrOfItemsPerRoom = 40;
+         const float roomSize = 20.0f;
+         std::shared_ptr<Eng::Mesh::Shape> box = std::make_shared<Eng::Mesh::Shape>();
+         for (uint32_t c = 0; c < 8; c++)
+            box->vertex.push_back(glm::vec3(c & 1 ? 1.0f : -1.0f, c & 2 ? 1.0f : -1.0f, c & 4 ? 1.0f : -1.0f));
+         box->index = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+         Eng::Node house;
+         std::vector<Eng::Node> rooms(nrOfRooms * nrOfRooms);
+         std::vector<Eng::Mesh> walls(rooms.size() * 4), items(rooms.size() * nrOfItemsPerRoom);
+         Eng::Mesh::Staging staging = {};
+         staging.material = &Eng::Material::empty;
+         staging.radius = std::sqrt(3.0f);
+         staging.bboxMin = glm::vec3(-1.0f);
+         staging.bboxMax = glm::vec3(1.0f);
+         for (uint32_t r = 0; r < rooms.size(); r++)
+         {
+            rooms[r].setMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(roomSize * (r % nrOfRooms), 0.0f, roomSize * (r / nrOfRooms))));
+            house.addChild(rooms[r]);
+
+            // Two walls along each axis, with a doorway in the middle:
+            for (uint32_t w = 0; w < 4; w++)
+            {
+               const float offset = (w & 1 ? 6.0f : -6.0f);
+               staging.matrix = w < 2 ? glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(offset, 3.0f, -10.0f)), glm::vec3(4.0f, 3.0f, 0.2f))
+                                      : glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 3.0f, offset)), glm::vec3(0.2f, 3.0f, 4.0f));
+               staging.name = "wall";
+               Eng::Mesh &wall = walls[r * 4 + w];
+               wall.loadStaging(staging);
+               wall.setShape(box);
+               rooms[r].addChild(wall);
+            }
+            for (uint32_t i = 0; i < nrOfItemsPerRoom; i++)
+            {
+               staging.matrix = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-8.0f + 2.0f * (i % 8), 0.5f + (i / 8 % 2), -6.0f + 3.0f * (i / 8))), glm::vec3(0.5f));
+               staging.name = "item";
+               Eng::Mesh &item = items[r * nrOfItemsPerRoom + i];
+               item.loadStaging(staging);
+               rooms[r].addChild(item);
+            }
+         }
+         const glm::mat4 projMatrix = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.5f, 400.0f);
+         const uint32_t nrOfViews = 32;
+         Eng::List list;
+         list.setFrustumCulling(true);
+         uint64_t nrOfElems = 0, nrOfCulledElems = 0, nrOfOccluders = 0;
+         double rasterTime = 0.0, testTime = 0.0;
+         for (uint32_t c = 0; c < nrOfViews; c++)
+         {
+            const float angle = glm::two_pi<float>() * c / nrOfViews;
+            const glm::vec3 eye(roomSize * 5.0f + 2.0f, 1.7f, roomSize * 5.0f + 1.0f);
+            list.reset();
+            list.setView(glm::lookAt(eye, eye + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f)), projMatrix);
+            list.process(house);
+            nrOfElems += list.getNrOfRenderableElems();
+            list.cullOccluded(64);
+            nrOfCulledElems += list.getOcclusionStats().nrOfCulledElems;
+            nrOfOccluders += list.getOcclusionStats().nrOfOccluders;
+            rasterTime += list.getOcclusionStats().rasterTime;
+            testTime += list.getOcclusionStats().testTime;
+         }
+         ENG_LOG_PLAIN("Occlusion culling: %llu of %llu meshes in the frustum culled per view, %llu occluders, raster %.3f ms, test %.3f ms per view",
+                       static_cast<unsigned long long>(nrOfCulledElems / nrOfViews), static_cast<unsigned long long>(nrOfElems / nrOfViews),
+                       static_cast<unsigned long long>(nrOfOccluders / nrOfViews), rasterTime / nrOfViews, testTime / nrOfViews);
+      }
+
+      // Ray casts and overlap queries on the scene, through a BVH over the mesh triangles (queries per second):
+      {
+         Eng::Ovo picking;
+         picking.setShapeRetention(true);
+         Eng::Node &root = picking.load("simple3dScene.ovo");
+         Eng::Bvh bvh;
+         bvh.build(root);
+
+         // Rays from a ring of viewpoints towards the scene center, with some jitter:
+         const uint32_t nrOfRays = 100000, nrOfRaysPerJob = 1000;
+         std::vector<glm::vec3> origin(nrOfRays), direction(nrOfRays);
+         for (uint32_t c = 0; c < nrOfRays; c++)
+         {
+            const float angle = glm::two_pi<float>() * c / nrOfRays;
+            origin[c] = glm::vec3(50.0f * sin(angle), 20.0f, 50.0f * cos(angle));
+            direction[c] = glm::vec3(15.0f * sin(c * 0.37f), 10.0f + 15.0f * cos(c * 0.61f), 15.0f * sin(c * 0.53f)) - origin[c];
+         }
+         uint32_t nrOfHits = 0, nrOfAnyHits = 0;
+         uint64_t t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfRays; c++)
+         {
+            Eng::Bvh::Hit hit;
+            nrOfHits += bvh.rayCast(origin[c], direction[c], hit);
+         }
+         const double closestTime = timer.getCounterDiff(t0, timer.getCounter());
+         t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfRays; c++)
+            nrOfAnyHits += bvh.rayCastAny(origin[c], direction[c]);
+         const double anyTime = timer.getCounterDiff(t0, timer.getCounter());
+         t0 = timer.getCounter();
+         pool.parallelFor(nrOfRays / nrOfRaysPerJob, [&](uint64_t job)
+         {
+            for (uint32_t c = static_cast<uint32_t>(job) * nrOfRaysPerJob; c < (job + 1) * nrOfRaysPerJob; c++)
+            {
+               Eng::Bvh::Hit hit;
+               bvh.rayCast(origin[c], direction[c], hit);
+            }
+         });
+         const double parallelTime = timer.getCounterDiff(t0, timer.getCounter());
+         ENG_LOG_PLAIN("BVH ray casts: %.0f closest-hit (%.0f on %u threads) and %.0f any-hit queries per second, %.1f%% hits",
+                       nrOfRays * 1000.0 / closestTime, nrOfRays * 1000.0 / parallelTime, pool.getNrOfThreads(),
+                       nrOfRays * 1000.0 / anyTime, 100.0 * nrOfHits / nrOfRays);
+
+         // Overlaps and refit after moving the whole scene:
+         const uint32_t nrOfQueries = 10000;
+         std::vector<std::reference_wrapper<const Eng::Mesh>> meshes;
+         t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfQueries; c++)
+         {
+            meshes.clear();
+            bvh.overlapSphere(origin[c * (nrOfRays / nrOfQueries)] * 0.5f, 10.0f, meshes);
+         }
+         const double sphereTime = timer.getCounterDiff(t0, timer.getCounter());
+         const glm::mat4 projMatrix = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+         t0 = timer.getCounter();
+         for (uint32_t c = 0; c < nrOfQueries; c++)
+         {
+            meshes.clear();
+            bvh.overlapFrustum(projMatrix * glm::lookAt(origin[c * (nrOfRays / nrOfQueries)], glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), meshes);
+         }
+         const double frustumTime = timer.getCounterDiff(t0, timer.getCounter());
+         root.setMatrix(glm::rotate(root.getMatrix(), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+         t0 = timer.getCounter();
+         bvh.refit();
+         ENG_LOG_PLAIN("BVH overlaps: %.0f sphere and %.0f frustum queries per second, refit in %.3f ms (%u meshes, %u nodes)",
+                       nrOfQueries * 1000.0 / sphereTime, nrOfQueries * 1000.0 / frustumTime, timer.getCounterDiff(t0, timer.getCounter()),
+                       bvh.getNrOfMeshes(), bvh.getNrOfNodes());
+      }
+      Eng::Container::getInstance().reset();
+
+      // Lossless mesh codec on the LODs of the scene (ratio and decode throughput, SIMD vs. scalar vs. copy):
+      {
+         Eng::Serializer serial;
+         std::vector<Eng::Ovo::ChunkInfo> table;
+         std::vector<Eng::Mesh::Staging> meshes;
+         if (serial.load("simple3dScene.ovo", Eng::Serializer::Mode::memory) && Eng::Ovo().scanChunks(serial, table))
+            for (const Eng::Ovo::ChunkInfo &chunk : table)
+               if (chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh))
+               {
+                  serial.setPosition(chunk.position);
+                  meshes.emplace_back();
+                  if (Eng::Mesh::decodeChunk(serial, meshes.back()) == false)
+                     meshes.pop_back();
+               }
+         struct Encoded { const Eng::Mesh::Staging::Lod *lod; std::vector<uint8_t> vertices, faces; };
+         std::vector<Encoded> encoded;
+         uint64_t nrOfRawBytes = 0, nrOfEncodedBytes = 0;
+         for (const Eng::Mesh::Staging &mesh : meshes)
+            for (const Eng::Mesh::Staging::Lod &lod : mesh.lod)
+            {
+               encoded.push_back({ &lod });
+               Eng::MeshCodec::encodeVertices(lod.vertices, lod.nrOfVertices, encoded.back().vertices);
+               Eng::MeshCodec::encodeFaces(lod.faces, lod.nrOfFaces, encoded.back().faces);
+               nrOfRawBytes += lod.nrOfVertices * sizeof(Eng::Vbo::VertexData) + lod.nrOfFaces * sizeof(Eng::Ebo::FaceData);
+               nrOfEncodedBytes += encoded.back().vertices.size() + encoded.back().faces.size();
+            }
+         std::vector<Eng::Vbo::VertexData> vertices;
+         std::vector<Eng::Ebo::FaceData> faces;
+         const uint32_t nrOfPasses = 16;
+         const double mb = nrOfPasses * nrOfRawBytes / (1024.0 * 1024.0);
+         double ms[3];
+         for (uint32_t mode = 0; mode < 3; mode++)
+         {
+            uint64_t t0 = timer.getCounter();
+            for (uint32_t pass = 0; pass < nrOfPasses; pass++)
+               for (const Encoded &e : encoded)
+               {
+                  vertices.resize(e.lod->nrOfVertices);
+                  faces.resize(e.lod->nrOfFaces);
+                  if (mode == 2)
+                  {
+                     memcpy(vertices.data(), e.lod->vertices, vertices.size() * sizeof(Eng::Vbo::VertexData));
+                     memcpy(faces.data(), e.lod->faces, faces.size() * sizeof(Eng::Ebo::FaceData));
+                     continue;
+                  }
+                  Eng::MeshCodec::decodeVertices(e.vertices.data(), e.vertices.size(), vertices.data(),
+                                                 static_cast<uint32_t>(vertices.size()), mode == 0);
+                  Eng::MeshCodec::decodeFaces(e.faces.data(), e.faces.size(), faces.data(),
+                                              static_cast<uint32_t>(faces.size()), mode == 0);
+               }
+            ms[mode] = timer.getCounterDiff(t0, timer.getCounter());
+         }
+         ENG_LOG_PLAIN("Mesh codec: %llu -> %llu bytes (%.2fx), decode SIMD %.1f MB/s, scalar %.1f MB/s, memcpy %.1f MB/s",
+                       static_cast<unsigned long long>(nrOfRawBytes), static_cast<unsigned long long>(nrOfEncodedBytes),
+                       static_cast<double>(nrOfRawBytes) / (nrOfEncodedBytes ? nrOfEncodedBytes : 1),
+                       mb / (ms[0] / 1000.0), mb / (ms[1] / 1000.0), mb / (ms[2] / 1000.0));
+      }
+
+      // Packed archive vs. loose files: many small textures (DXT1 tiles cut from a source image), then the scene:
+      {
+         const uint32_t nrOfTiles = 240, tileSize = 256, nrOfLevels = 9;
+         std::vector<std::string> tiles;
+         Eng::Serializer source;
+         std::error_code error;
+         std::filesystem::create_directories("benchmark_tiles", error);
+         if (source.load("rusted_metal_26_09_diffuse.dds", Eng::Serializer::Mode::mapped))
+         {
+            const uint32_t headerSize = 128; // Magic and DDS_HEADER
+            uint32_t dataSize = 0;
+            for (uint32_t c = 0, size = tileSize; c < nrOfLevels; c++, size /= 2)
+               dataSize += std::max(size * size / 2, 8u);
+            const uint8_t *src = static_cast<const uint8_t *>(source.getData());
+            for (uint32_t c = 0; c < nrOfTiles && headerSize + (c + 1) * dataSize <= source.getNrOfBytes(); c++)
+            {
+               uint8_t header[headerSize];
+               memcpy(header, src, headerSize);
+               const uint32_t field[] = { tileSize, tileSize, tileSize * tileSize / 2, 0, nrOfLevels }; // Height, width, linear size, depth, levels
+               memcpy(header + 12, field, sizeof(field));
+               char tile[64];
+               snprintf(tile, sizeof(tile), "benchmark_tiles/tile_%03u.dds", c);
+               FILE *file = fopen(tile, "wb");
+               if (file == nullptr)
+                  break;
+               fwrite(header, 1, headerSize, file);
+               fwrite(src + headerSize + c * dataSize, 1, dataSize, file);
+               fclose(file);
+               tiles.push_back(tile);
+            }
+         }
+         Eng::Archive::pack("benchmark_tiles.pak", tiles);
+         double ms[2];
+         for (uint32_t packed = 0; packed < 2; packed++)
+         {
+            if (packed)
+               Eng::Archive::mount("benchmark_tiles.pak");
+            uint64_t t0 = timer.getCounter();
+            for (const std::string &tile : tiles)
+               Eng::Bitmap().load(tile);
+            ms[packed] = timer.getCounterDiff(t0, timer.getCounter());
+         }
+         Eng::Archive::unmountAll();
+         ENG_LOG_PLAIN("Archive: %zu textures loaded in %.1f ms (loose files) vs. %.1f ms (packed)", tiles.size(), ms[0], ms[1]);
+         std::filesystem::remove_all("benchmark_tiles", error);
+         std::filesystem::remove("benchmark_tiles.pak", error);
+
+         // Scene and its images (see log for the per-file timings):
+         Eng::Archive::pack("benchmark_scene.pak", { "simple3dScene.ovo", "rusted_metal_26_09_diffuse.dds",
+                            "rusted_metal_26_09_normal.dds", "rusted_metal_26_09_roughness.dds",
+                            "rusted_metal_26_09_metalness.dds" });
+         for (uint32_t packed = 0; packed < 2; packed++)
+         {
+            if (packed)
+               Eng::Archive::mount("benchmark_scene.pak");
+            Eng::Ovo().load("simple3dScene.ovo");
+            Eng::Container::getInstance().reset();
+         }
+         Eng::Archive::unmountAll();
+         std::filesystem::remove("benchmark_scene.pak", error);
+      }
+
+      // Cold (no cooked cache yet) and warm startup:
+      Eng::Ovo::setCookedCache(true);
+      std::remove(Eng::Ovo::getCookedFilename("simple3dScene.ovo").c_str());
+      for (uint32_t c = 0; c < 2; c++)
+      {
+         Eng::Ovo().load("simple3dScene.ovo");
+         Eng::Container::getInstance().reset();
+      }
+      Eng::Ovo::setCookedCache(false);
+
+      // Reference blocks with known RGBA8 output, decoded by both the scalar and the SIMD path:
+      struct ReferenceBlock
+      {
+         Eng::Bitmap::Format format;
+         uint8_t block[16];
+         uint32_t expected[16];                 ///< 0xAABBGGRR
+      };
+      const ReferenceBlock referenceBlocks[] = {
+         { Eng::Bitmap::Format::r8g8b8_compressed, // BC1, 4 colors
+           { 0xA9, 0xAD, 0x5B, 0x21, 0xE4, 0x1B, 0xE4, 0x1B },
+           { 0xFF4AB6AD, 0xFFDE2821, 0xFF7B877E, 0xFFAD5750,
+             0xFFAD5750, 0xFF7B877E, 0xFFDE2821, 0xFF4AB6AD,
+             0xFF4AB6AD, 0xFFDE2821, 0xFF7B877E, 0xFFAD5750,
+             0xFFAD5750, 0xFF7B877E, 0xFFDE2821, 0xFF4AB6AD } },
+         { Eng::Bitmap::Format::r8g8b8_compressed, // BC1, 3 colors and black
+           { 0x5B, 0x21, 0xA9, 0xAD, 0xE4, 0x1B, 0xE4, 0x1B },
+           { 0xFFDE2821, 0xFF4AB6AD, 0xFF946F67, 0xFF000000,
+             0xFF000000, 0xFF946F67, 0xFF4AB6AD, 0xFFDE2821,
+             0xFFDE2821, 0xFF4AB6AD, 0xFF946F67, 0xFF000000,
+             0xFF000000, 0xFF946F67, 0xFF4AB6AD, 0xFFDE2821 } },
+         { Eng::Bitmap::Format::r8g8b8a8_compressed, // BC3, 8 alpha values, 4 colors even if c0 <= c1
+           { 0xF0, 0x11, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x5B, 0x21, 0xA9, 0xAD, 0xE4, 0x1B, 0xE4, 0x1B },
+           { 0xF0DE2821, 0x114AB6AD, 0xD0AD5750, 0xB07B877E,
+             0x907B877E, 0x71AD5750, 0x514AB6AD, 0x31DE2821,
+             0xF0DE2821, 0x114AB6AD, 0xD0AD5750, 0xB07B877E,
+             0x907B877E, 0x71AD5750, 0x514AB6AD, 0x31DE2821 } },
+         { Eng::Bitmap::Format::r8_compressed, // BC4, 8 values
+           { 0xC8, 0x0D, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+           { 0xFF0000C8, 0xFF00000D, 0xFF0000AD, 0xFF000093,
+             0xFF000078, 0xFF00005D, 0xFF000042, 0xFF000028,
+             0xFF0000C8, 0xFF00000D, 0xFF0000AD, 0xFF000093,
+             0xFF000078, 0xFF00005D, 0xFF000042, 0xFF000028 } },
+         { Eng::Bitmap::Format::r8_compressed, // BC4, 6 values plus 0 and 255
+           { 0x0D, 0xC8, 0x77, 0x39, 0x05, 0x77, 0x39, 0x05 },
+           { 0xFF0000FF, 0xFF000000, 0xFF0000A3, 0xFF00007D,
+             0xFF000058, 0xFF000032, 0xFF0000C8, 0xFF00000D,
+             0xFF0000FF, 0xFF000000, 0xFF0000A3, 0xFF00007D,
+             0xFF000058, 0xFF000032, 0xFF0000C8, 0xFF00000D } },
+         { Eng::Bitmap::Format::r8g8_compressed, // BC5, 6 and 8 values
+           { 0x5A, 0xA0, 0x77, 0x39, 0x05, 0x77, 0x39, 0x05, 0xC8, 0x0D, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+           { 0xFF00C8FF, 0xFF000D00, 0xFF00AD92, 0xFF009384,
+             0xFF007876, 0xFF005D68, 0xFF0042A0, 0xFF00285A,
+             0xFF00C8FF, 0xFF000D00, 0xFF00AD92, 0xFF009384,
+             0xFF007876, 0xFF005D68, 0xFF0042A0, 0xFF00285A } }
+      };
+      uint32_t nrOfMatches = 0, nrOfChecks = 0;
+      for (const ReferenceBlock &reference : referenceBlocks)
+         for (bool simd : { false, true })
+         {
+            Eng::Bitmap bitmap, decoded;
+            bool match = bitmap.load(reference.format, 4, 4, const_cast<uint8_t *>(reference.block)) &&
+                         bitmap.decompress(decoded, simd) && decoded.getNrOfBytes() == sizeof(reference.expected);
+            for (uint32_t c = 0; match && c < 16; c++)
+               for (uint32_t ch = 0; ch < 4; ch++)
+                  match &= decoded.getData()[c * 4 + ch] == ((reference.expected[c] >> (ch * 8)) & 0xFF);
+            nrOfMatches += match;
+            nrOfChecks++;
+         }
+      ENG_LOG_PLAIN("   Reference blocks (BC1/BC3/BC4/BC5, scalar and SIMD): %u/%u match", nrOfMatches, nrOfChecks);
+
+      // CPU block decoding, scalar vs. SIMD (outputs must be bit-exact), and re-encoding:
+      const char *ddsFiles[] = { "rusted_metal_26_09_diffuse.dds", "rusted_metal_26_09_normal.dds",
+                                 "rusted_metal_26_09_roughness.dds", "rusted_metal_26_09_metalness.dds" };
+      for (const char *ddsFile : ddsFiles)
+      {
+         Eng::Bitmap bitmap, scalar, simd;
+         if (bitmap.load(ddsFile, Eng::Serializer::Mode::memory) == false)
+            continue;
+         uint64_t t0 = timer.getCounter();
+         bitmap.decompress(scalar, false);
+         uint64_t t1 = timer.getCounter();
+         bitmap.decompress(simd, true);
+         uint64_t t2 = timer.getCounter();
+         const double mb = scalar.getNrOfResidentBytes() / (1024.0 * 1024.0);
+         const bool exact = scalar.getNrOfResidentBytes() == simd.getNrOfResidentBytes() &&
+                            memcmp(scalar.getData(), simd.getData(), scalar.getNrOfResidentBytes()) == 0;
+         ENG_LOG_PLAIN("   Decoded '%s': scalar %.1f MB/s, SIMD %.1f MB/s, bit-exact: %s", ddsFile,
+                       mb / (timer.getCounterDiff(t0, t1) / 1000.0), mb / (timer.getCounterDiff(t1, t2) / 1000.0),
+                       exact ? "yes" : "no");
+
+         // Re-encode the decoded texels into the original format, and measure the PSNR of the result:
+         uint32_t nrOfChannels = 0;
+         switch (bitmap.getFormat())
+         {
+            case Eng::Bitmap::Format::r8_compressed: nrOfChannels = 1; break;
+            case Eng::Bitmap::Format::r8g8_compressed: nrOfChannels = 2; break;
+            case Eng::Bitmap::Format::r8g8b8_compressed: nrOfChannels = 3; break;
+            case Eng::Bitmap::Format::r8g8b8a8_compressed: nrOfChannels = 4; break;
+            default: continue;
+         }
+         for (Eng::Bitmap::Quality quality : { Eng::Bitmap::Quality::fast, Eng::Bitmap::Quality::high })
+         {
+            Eng::Bitmap encoded, roundTrip;
+            uint64_t t3 = timer.getCounter();
+            simd.compress(encoded, bitmap.getFormat(), quality);
+            uint64_t t4 = timer.getCounter();
+            encoded.decompress(roundTrip);
+            double squaredError = 0.0;
+            uint64_t nrOfSamples = 0;
+            for (uint32_t level = 0; level < simd.getNrOfLevels(); level++)
+            {
+               const uint8_t *a = simd.getData(level), *b = roundTrip.getData(level);
+               for (uint64_t c = 0; c < (uint64_t) simd.getSizeX(level) * simd.getSizeY(level); c++)
+                  for (uint32_t ch = 0; ch < nrOfChannels; ch++)
+                  {
+                     double d = a[c * 4 + ch] - b[c * 4 + ch];
+                     squaredError += d * d;
+                     nrOfSamples++;
+                  }
+            }
+            const double mse = squaredError / nrOfSamples;
+            ENG_LOG_PLAIN("   Encoded '%s' (%s): %.1f MB/s, PSNR %.2f dB", ddsFile,
+                          quality == Eng::Bitmap::Quality::fast ? "fast" : "high", mb / (timer.getCounterDiff(t3, t4) / 1000.0),
+                          mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0);
+         }
+      }
+   }
+
+
    /////////////////
    // Loading scene:   
+   Eng::Container::getInstance().setAsyncTextures(true); // Textures are uploaded by the main loop (see Base::swap())
    Eng::Ovo ovo;
+   ovo.setMeshClustering(true);
    std::reference_wrapper<Eng::Node> root = ovo.load("simple3dScene.ovo");
    std::cout << "Scene graph:\n" << root.get().getTreeAsString() << std::endl;
+   Eng::Container::getInstance().dumpTextureReport();
+
+   // Optional export of the loaded scene (e.g., after import-time processing):
+   if (argc > 2 && std::string(argv[1]) == "-export")
+      ovo.save(argv[2], root);
 
    // Get light ref:
    std::reference_wrapper<Eng::Light> light = dynamic_cast<Eng::Light&>(Eng::Container::getInstance().find("Omni001"));
@@ -189,9 +930,10 @@ int main(int argc, char *argv[])
        camera.setMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.0f, transZ)));
        root.get().setMatrix(glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(rotX), { 1.0f, 0.0f, 0.0f }), glm::radians(rotY), { 0.0f, 1.0f, 0.0f }));
 
-       // Update list:
-       list.reset();
-       list.process(root);
+       // Update list (only the nodes moved since the previous frame are processed):
+       list.setView(glm::inverse(camera.getWorldMatrix()), camera.getProjMatrix());
+       list.update(root);
+       list.cull(glm::inverse(camera.getWorldMatrix()), camera.getProjMatrix());
 
        // Main rendering:
        eng.clear();
@@ -300,10 +300,7 @@ bool ENG_API Eng::Base::init()
 		return false;
 	}
 	if (!glewIsSupported("GL_EXT_texture_compression_s3tc"))
-	{
-		ENG_LOG_ERROR("GL_EXT_texture_compression_s3tc not supported");
-		return false;
-	}
+		ENG_LOG_WARN("GL_EXT_texture_compression_s3tc not supported, BC1/BC3 textures will be decoded on the CPU");
 
 	int workGroupSizes[3] = {0};
 	glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &workGroupSizes[0]);
@@ -436,6 +433,9 @@ bool ENG_API Eng::Base::swap()
 	// New frame:
 	reserved->frameCounter++;
 
+	// Textures loaded in background:
+	Eng::Container::getInstance().processTextureRequests();
+
 	// Done:
 	return true;
 }
@@ -13,9 +13,12 @@
 
 // C/C++:      
 #include <string>
+#include <string_view>
 #include <vector>
 #include <list>
 #include <memory>
+#include <functional>
+#include <limits>
 
 // GLM:
 #ifndef _DEBUG
@@ -70,11 +73,14 @@ namespace Eng
 // Architecture:
 #include "engine_object.h"
 #include "engine_managed.h"
+#include "engine_threadpool.h"
 
 // File formats:
 #include "engine_serializer.h"
+#include "engine_archive.h"
 #include "engine_bitmap.h"
 #include "engine_ovo.h"
+#include "engine_ovo_index.h"
 
 // Objects:
 #include "engine_vao.h"
@@ -86,6 +92,11 @@ namespace Eng
 #include "engine_material.h"
 #include "engine_fbo.h"
 
+// Geometry processing:
+#include "engine_mesh_optimizer.h"
+#include "engine_mesh_codec.h"
+#include "engine_occlusion_buffer.h"
+
 // Scene-graph elems:
 #include "engine_node.h"
 #include "engine_mesh.h"
@@ -93,6 +104,9 @@ namespace Eng
 #include "engine_camera.h"
 #include "engine_list.h"
 
+// Spatial queries:
+#include "engine_bvh.h"
+
 // Storage:
 #include "engine_container.h"
 
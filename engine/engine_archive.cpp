@@ -0,0 +1,626 @@
+/**
+ * @file		engine_archive.cpp
+ * @brief	Packed asset archives and virtual file layer
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Archive file format. The file starts with a header, followed by the directory (one record per entry, sorted by
+ * name hash), the entry names and the entry data. Data is aligned to Archive::alignment.
+ */
+struct Eng::Archive::Format
+{
+	static constexpr char magic[8] = "ENGPACK"; ///< File signature
+	static constexpr uint32_t version = 1; ///< Format revision
+
+
+	/**
+	 * @brief File header.
+	 */
+	struct Header
+	{
+		char magic[8]; ///< Format::magic
+		uint32_t version; ///< Format::version
+		uint32_t nrOfEntries; ///< Number of directory records
+		uint64_t directoryOffset; ///< Offset of the directory
+		uint64_t namesOffset; ///< Offset of the names
+		uint64_t namesSize; ///< Size of the names
+		uint64_t nrOfBytes; ///< Size of the whole archive
+	};
+
+	/**
+	 * @brief Directory record, one per entry.
+	 */
+	struct Record
+	{
+		uint64_t hash; ///< Hash of the normalized name
+		uint64_t offset; ///< Offset of the data from the beginning of the archive
+		uint64_t nrOfBytes; ///< Size of the data
+		uint32_t nameOffset; ///< Offset of the name within the names
+		uint32_t nameLength; ///< Length of the name (not zero-terminated)
+	};
+
+
+	/**
+	 * Rounds the given offset up to the alignment.
+	 * @param offset offset in bytes
+	 * @return aligned offset
+	 */
+	static uint64_t align(uint64_t offset)
+	{
+		return (offset + Eng::Archive::alignment - 1) & ~(Eng::Archive::alignment - 1);
+	}
+};
+
+
+/**
+ * @brief Archive class static reserved structure.
+ */
+struct Eng::Archive::StaticReserved
+{
+	std::mutex mutex; ///< Protects the mounted archives (names are resolved from worker threads)
+	std::vector<std::shared_ptr<Eng::Archive>> mounted; ///< Mounted archives, in mount order
+};
+
+
+/**
+ * @brief Archive class reserved structure.
+ */
+struct Eng::Archive::Reserved
+{
+	std::string filename; ///< Archive file
+	Eng::Serializer serial; ///< Archive content, mapped
+	const Eng::Archive::Format::Record* record; ///< Directory, within the mapping
+	uint32_t nrOfEntries; ///< Number of directory records
+	const char* names; ///< Entry names, within the mapping
+	uint64_t namesSize; ///< Size of the entry names
+
+
+	/**
+	 * Constructor.
+	 */
+	Reserved() : record{nullptr}, nrOfEntries{0}, names{nullptr}, namesSize{0} {}
+};
+
+
+////////////
+// STATIC //
+////////////
+
+// Reserved data:
+std::unique_ptr<Eng::Archive::StaticReserved> Eng::Archive::staticReserved = std::make_unique<
+	Eng::Archive::StaticReserved>();
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Hashes an entry name (64-bit FNV-1a).
+ * @param name normalized name
+ * @return hash
+ */
+static uint64_t hashName(std::string_view name)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (char c : name)
+		hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+
+	// Done:
+	return hash;
+}
+
+
+///////////////////////////
+// BODY OF CLASS Archive //
+///////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::Archive::Archive() : reserved(std::make_unique<Eng::Archive::Reserved>())
+{
+	ENG_LOG_DETAIL("[+]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::Archive::~Archive()
+{
+	ENG_LOG_DETAIL("[-]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the file name of the open archive.
+ * @return file name (empty if not open)
+ */
+const std::string ENG_API& Eng::Archive::getFilename() const
+{
+	return reserved->filename;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the number of entries stored in the archive.
+ * @return number of entries
+ */
+uint32_t ENG_API Eng::Archive::getNrOfEntries() const
+{
+	return reserved->nrOfEntries;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the name of an entry, as a view into the mapping (entries are in directory order, not alphabetical).
+ * @param index entry index
+ * @return entry name (empty if out of range)
+ */
+std::string_view ENG_API Eng::Archive::getName(uint32_t index) const
+{
+	// Safety net:
+	if (index >= reserved->nrOfEntries)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return std::string_view();
+	}
+
+	// Done:
+	const Format::Record& r = reserved->record[index];
+	return std::string_view(reserved->names + r.nameOffset, r.nameLength);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Opens an archive. The file is memory-mapped and the directory is validated in place, without allocations: entries
+ * are then looked up directly within the mapping.
+ * @param filename archive file
+ * @return TF
+ */
+bool ENG_API Eng::Archive::open(const std::string& filename)
+{
+	// Safety net:
+	if (filename.empty())
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	close();
+
+	Eng::Serializer& serial = reserved->serial;
+	if (serial.load(filename, Eng::Serializer::Mode::mapped) == false)
+	{
+		ENG_LOG_ERROR("Unable to load file '%s'", filename.c_str());
+		return false;
+	}
+
+	// Header:
+	Format::Header header;
+	const uint64_t nrOfBytes = serial.getNrOfBytes();
+	if (serial.deserialize(&header, sizeof(Format::Header)) == false || memcmp(header.magic, Format::magic,
+		sizeof(Format::magic)) != 0 || header.version != Format::version || header.nrOfBytes != nrOfBytes ||
+		header.directoryOffset % alignof(Format::Record) || header.directoryOffset > nrOfBytes ||
+		header.nrOfEntries > (nrOfBytes - header.directoryOffset) / sizeof(Format::Record) ||
+		header.namesOffset > nrOfBytes || header.namesSize > nrOfBytes - header.namesOffset)
+	{
+		ENG_LOG_ERROR("File '%s' is not a valid archive", filename.c_str());
+		close();
+		return false;
+	}
+	const uint8_t* base = static_cast<const uint8_t*>(serial.getData());
+	const Format::Record* record = reinterpret_cast<const Format::Record*>(base + header.directoryOffset);
+
+	// Directory:
+	for (uint32_t c = 0; c < header.nrOfEntries; c++)
+	{
+		const Format::Record& r = record[c];
+		if (r.offset > nrOfBytes || r.nrOfBytes > nrOfBytes - r.offset || r.nameOffset > header.namesSize ||
+			r.nameLength > header.namesSize - r.nameOffset || (c && r.hash < record[c - 1].hash))
+		{
+			ENG_LOG_ERROR("File '%s' is not a valid archive", filename.c_str());
+			close();
+			return false;
+		}
+	}
+
+	// Done:
+	reserved->filename = filename;
+	reserved->record = record;
+	reserved->nrOfEntries = header.nrOfEntries;
+	reserved->names = reinterpret_cast<const char*>(base + header.namesOffset);
+	reserved->namesSize = header.namesSize;
+	ENG_LOG_DEBUG("Archive '%s' opened (%u entries, %llu bytes)", filename.c_str(), header.nrOfEntries, nrOfBytes);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Closes the archive. Serializers loaded from the archive in mapped mode keep the mapping alive.
+ */
+void ENG_API Eng::Archive::close()
+{
+	reserved->serial.clear();
+	reserved->filename.clear();
+	reserved->record = nullptr;
+	reserved->nrOfEntries = 0;
+	reserved->names = nullptr;
+	reserved->namesSize = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when an archive is open.
+ * @return TF
+ */
+bool ENG_API Eng::Archive::isOpen() const
+{
+	return reserved->serial.getMode() != Eng::Serializer::Mode::none;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Looks up an entry by name, with a binary search over the directory hashes.
+ * @param name entry name (normalized here, see normalizeName())
+ * @param entry location of the entry within the archive
+ * @return TF (false if not found)
+ */
+bool ENG_API Eng::Archive::find(std::string_view name, Entry& entry) const
+{
+	const std::string normalized = normalizeName(name);
+	const uint64_t hash = hashName(normalized);
+	const Format::Record* last = reserved->record + reserved->nrOfEntries;
+	const Format::Record* r = std::lower_bound(reserved->record, last, hash,
+	                                           [](const Format::Record& record, uint64_t value) { return record.hash < value; });
+	for (; r != last && r->hash == hash; r++)
+		if (std::string_view(reserved->names + r->nameOffset, r->nameLength) == normalized)
+		{
+			entry.offset = r->offset;
+			entry.nrOfBytes = r->nrOfBytes;
+			return true;
+		}
+
+	// Not found:
+	return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads an entry into a serializer. In mapped mode (default), the serializer becomes a view into the archive mapping
+ * and no file is opened. In memory mode, the entry is copied into a buffer. In streamed mode, the archive file is
+ * opened again and the window is restricted to the entry.
+ * @param name entry name
+ * @param serial serializer receiving the entry
+ * @param mode type of storage
+ * @param windowSize window size in bytes (streamed mode only)
+ * @return TF
+ */
+bool ENG_API Eng::Archive::load(std::string_view name, Eng::Serializer& serial, Eng::Serializer::Mode mode,
+                                uint64_t windowSize) const
+{
+	Entry entry;
+	if (find(name, entry) == false)
+	{
+		ENG_LOG_ERROR("Entry '%.*s' not found in archive '%s'", static_cast<int>(name.size()), name.data(),
+		              reserved->filename.c_str());
+		return false;
+	}
+
+	switch (mode)
+	{
+		//////////////////////////////////////
+	case Eng::Serializer::Mode::memory: //
+		serial = Eng::Serializer(static_cast<const uint8_t*>(reserved->serial.getData()) + entry.offset,
+		                         entry.nrOfBytes);
+		break;
+
+		//////////////////////////////////////
+	case Eng::Serializer::Mode::mapped: //
+		return serial.view(reserved->serial, entry.offset, entry.nrOfBytes);
+
+		////////////////////////////////////////
+	case Eng::Serializer::Mode::streamed: //
+	{
+		Eng::Serializer file;
+		if (file.load(reserved->filename, mode, windowSize) == false)
+			return false;
+		return serial.view(file, entry.offset, entry.nrOfBytes);
+	}
+
+		///////////
+	default: //
+		ENG_LOG_ERROR("Invalid mode");
+		return false;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packs a list of files into a new archive. Entries are named after the file paths, relative to the base path (if
+ * any), with forward slashes (see normalizeName()). The archive is written to a temporary file first, so an existing
+ * archive is replaced only on success.
+ * @param filename archive file
+ * @param files files to pack
+ * @param basePath directory the entry names are relative to (empty to keep the paths as they are)
+ * @return TF
+ */
+bool ENG_API Eng::Archive::pack(const std::string& filename, const std::vector<std::string>& files,
+                                const std::string& basePath)
+{
+	// Safety net:
+	if (filename.empty())
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Entries, sorted by hash:
+	struct Item
+	{
+		std::string file;
+		std::string name;
+		Format::Record record;
+	};
+	std::vector<Item> item(files.size());
+	uint64_t namesSize = 0;
+	for (uint64_t c = 0; c < files.size(); c++)
+	{
+		std::error_code error;
+		item[c].file = files[c];
+		item[c].name = normalizeName(basePath.empty() ? files[c] :
+		                             std::filesystem::path(files[c]).lexically_relative(basePath).generic_string());
+		item[c].record.hash = hashName(item[c].name);
+		item[c].record.nrOfBytes = std::filesystem::file_size(files[c], error);
+		if (error || item[c].name.empty())
+		{
+			ENG_LOG_ERROR("Unable to open file '%s'", files[c].c_str());
+			return false;
+		}
+		namesSize += item[c].name.size();
+	}
+	std::sort(item.begin(), item.end(), [](const Item& a, const Item& b)
+	{
+		return a.record.hash != b.record.hash ? a.record.hash < b.record.hash : a.name < b.name;
+	});
+	for (uint64_t c = 1; c < item.size(); c++)
+		if (item[c].name == item[c - 1].name)
+		{
+			ENG_LOG_ERROR("Duplicate entry '%s'", item[c].name.c_str());
+			return false;
+		}
+	if (namesSize > UINT32_MAX)
+	{
+		ENG_LOG_ERROR("Too many entries");
+		return false;
+	}
+
+	// Layout:
+	Format::Header header = {};
+	memcpy(header.magic, Format::magic, sizeof(Format::magic));
+	header.version = Format::version;
+	header.nrOfEntries = static_cast<uint32_t>(item.size());
+	header.directoryOffset = Format::align(sizeof(Format::Header));
+	header.namesOffset = header.directoryOffset + item.size() * sizeof(Format::Record);
+	header.namesSize = namesSize;
+	uint64_t offset = Format::align(header.namesOffset + namesSize);
+	uint32_t nameOffset = 0;
+	for (Item& i : item)
+	{
+		i.record.offset = offset;
+		i.record.nameOffset = nameOffset;
+		i.record.nameLength = static_cast<uint32_t>(i.name.size());
+		offset = Format::align(offset + i.record.nrOfBytes);
+		nameOffset += i.record.nameLength;
+	}
+	header.nrOfBytes = offset;
+
+	// Write:
+	std::string tmpFilename = filename + ".tmp";
+	FILE* file = fopen(tmpFilename.c_str(), "wb");
+	if (file == nullptr)
+	{
+		ENG_LOG_ERROR("Unable to create file '%s'", filename.c_str());
+		return false;
+	}
+	const uint8_t padding[alignment] = {};
+	uint64_t position = 0;
+	bool done = true;
+	auto write = [&](const void* data, uint64_t nrOfBytes, uint64_t alignTo)
+	{
+		if (alignTo > position)
+		{
+			done &= fwrite(padding, 1, alignTo - position, file) == alignTo - position;
+			position = alignTo;
+		}
+		if (nrOfBytes)
+			done &= fwrite(data, 1, nrOfBytes, file) == nrOfBytes;
+		position += nrOfBytes;
+	};
+	write(&header, sizeof(header), 0);
+	for (const Item& i : item)
+		write(&i.record, sizeof(Format::Record), header.directoryOffset);
+	for (const Item& i : item)
+		write(i.name.data(), i.name.size(), header.namesOffset);
+	for (const Item& i : item)
+	{
+		Eng::Serializer source;
+		if (source.load(i.file, Eng::Serializer::Mode::mapped) == false || source.getNrOfBytes() != i.record.nrOfBytes)
+		{
+			ENG_LOG_ERROR("Unable to read file '%s'", i.file.c_str());
+			done = false;
+			break;
+		}
+		write(source.getData(), source.getNrOfBytes(), i.record.offset);
+	}
+	if (done)
+		write(nullptr, 0, header.nrOfBytes);
+	fclose(file);
+
+	std::error_code error;
+	if (done)
+		std::filesystem::rename(tmpFilename, filename, error);
+	if (!done || error)
+	{
+		std::filesystem::remove(tmpFilename, error);
+		ENG_LOG_ERROR("Unable to write file '%s'", filename.c_str());
+		return false;
+	}
+
+	// Done:
+	ENG_LOG_DEBUG("Archive '%s' saved (%u entries, %llu bytes)", filename.c_str(), header.nrOfEntries, header.nrOfBytes);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Normalizes a file name into an entry name: backslashes become forward slashes, and leading "./" are removed. Names
+ * are case-sensitive.
+ * @param name file name
+ * @return entry name
+ */
+std::string ENG_API Eng::Archive::normalizeName(std::string_view name)
+{
+	while (name.size() >= 2 && name[0] == '.' && (name[1] == '/' || name[1] == '\\'))
+		name.remove_prefix(2);
+	std::string normalized(name);
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+
+	// Done:
+	return normalized;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Mounts an archive into the virtual file layer. Names are resolved against the archives mounted last first.
+ * @param filename archive file
+ * @return TF
+ */
+bool ENG_API Eng::Archive::mount(const std::string& filename)
+{
+	// Opened before locking, as opening resolves the archive name itself:
+	std::shared_ptr<Eng::Archive> archive = std::make_shared<Eng::Archive>();
+	if (archive->open(filename) == false)
+		return false;
+
+	// Done:
+	std::lock_guard<std::mutex> lock(staticReserved->mutex);
+	staticReserved->mounted.push_back(archive);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Unmounts an archive from the virtual file layer. Assets already loaded from it in mapped mode stay valid.
+ * @param filename archive file, as passed to mount()
+ * @return TF
+ */
+bool ENG_API Eng::Archive::unmount(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(staticReserved->mutex);
+	std::vector<std::shared_ptr<Eng::Archive>>& mounted = staticReserved->mounted;
+	const uint64_t nrOfMounted = mounted.size();
+	mounted.erase(std::remove_if(mounted.begin(), mounted.end(),
+	                             [&filename](const std::shared_ptr<Eng::Archive>& a) { return a->getFilename() == filename; }),
+	              mounted.end());
+	if (mounted.size() == nrOfMounted)
+	{
+		ENG_LOG_ERROR("Archive '%s' not mounted", filename.c_str());
+		return false;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Unmounts all the archives.
+ */
+void ENG_API Eng::Archive::unmountAll()
+{
+	std::lock_guard<std::mutex> lock(staticReserved->mutex);
+	staticReserved->mounted.clear();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the given name resolves to an entry of a mounted archive.
+ * @param name file name
+ * @return TF
+ */
+bool ENG_API Eng::Archive::contains(const std::string& name)
+{
+	Entry entry;
+	std::lock_guard<std::mutex> lock(staticReserved->mutex);
+	for (const std::shared_ptr<Eng::Archive>& archive : staticReserved->mounted)
+		if (archive->find(name, entry))
+			return true;
+
+	// Not found:
+	return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Resolves a file name against the mounted archives and loads the matching entry (see load()). Invoked by
+ * Serializer::load() before accessing the file system.
+ * @param name file name
+ * @param serial serializer receiving the entry
+ * @param mode type of storage
+ * @param windowSize window size in bytes (streamed mode only)
+ * @return TF (false if not found in any mounted archive)
+ */
+bool ENG_API Eng::Archive::resolve(const std::string& name, Eng::Serializer& serial, Eng::Serializer::Mode mode,
+                                   uint64_t windowSize)
+{
+	std::shared_ptr<Eng::Archive> archive;
+	{
+		Entry entry;
+		std::lock_guard<std::mutex> lock(staticReserved->mutex);
+		for (auto a = staticReserved->mounted.rbegin(); a != staticReserved->mounted.rend() && !archive; a++)
+			if ((*a)->find(name, entry))
+				archive = *a;
+	}
+
+	// Done:
+	return archive && archive->load(name, serial, mode, windowSize);
+}
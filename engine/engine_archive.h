@@ -0,0 +1,81 @@
+/**
+ * @file		engine_archive.h
+ * @brief	Packed asset archives and virtual file layer
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Read-only archive bundling many asset files (e.g., an .ovo scene and its .dds images) into a single file.
+ * The archive starts with a directory of fixed-size records sorted by name hash, so it is memory-mapped once and looked
+ * up in place, without parsing. Entries are aligned and accessed as views into the mapping (no copies). Mounted
+ * archives form a virtual file layer: Serializer::load() (hence Ovo::load() and Bitmap::load()) first resolves file
+ * names against the mounted archives, and only then falls back to the file system.
+ */
+class ENG_API Archive
+{
+	//////////
+public: //
+	//////////
+
+	// Consts:
+	static constexpr uint64_t alignment = 64; ///< Alignment of the entries within the archive
+
+
+	/**
+	 * @brief Location of an entry within the archive file.
+	 */
+	struct Entry
+	{
+		uint64_t offset; ///< Offset from the beginning of the archive
+		uint64_t nrOfBytes; ///< Size in bytes
+	};
+
+
+	// Const/dest:
+	Archive();
+	Archive(Archive const&) = delete;
+	~Archive();
+
+	// Operators:
+	void operator=(Archive const&) = delete;
+
+	// Get/set:
+	const std::string& getFilename() const;
+	uint32_t getNrOfEntries() const;
+	std::string_view getName(uint32_t index) const;
+
+	// Archive:
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const;
+	bool find(std::string_view name, Entry& entry) const;
+	bool load(std::string_view name, Eng::Serializer& serial, Eng::Serializer::Mode mode = Eng::Serializer::Mode::mapped,
+	          uint64_t windowSize = Eng::Serializer::defaultWindowSize) const;
+
+	// Packing:
+	static bool pack(const std::string& filename, const std::vector<std::string>& files, const std::string& basePath = "");
+	static std::string normalizeName(std::string_view name);
+
+	// Virtual file layer:
+	static bool mount(const std::string& filename);
+	static bool unmount(const std::string& filename);
+	static void unmountAll();
+	static bool contains(const std::string& name);
+	static bool resolve(const std::string& name, Eng::Serializer& serial, Eng::Serializer::Mode mode,
+	                    uint64_t windowSize = Eng::Serializer::defaultWindowSize);
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct Format;
+	struct Reserved;
+	std::unique_ptr<Reserved> reserved;
+	struct StaticReserved;
+	static std::unique_ptr<StaticReserved> staticReserved;
+};
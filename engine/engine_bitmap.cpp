@@ -18,6 +18,21 @@
 
 // C/C++:
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// SIMD (x86 only, selected at runtime):
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ENG_BITMAP_SSE
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ENG_TARGET_SSE41
+#else
+#include <cpuid.h>
+#define ENG_TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+#endif
 
 
 ////////////
@@ -27,6 +42,755 @@
 // Special values:
 Eng::Bitmap Eng::Bitmap::empty("[empty]");
 
+// Stride used for faulting in mapped pages:
+static constexpr uint64_t pageSize = 4096;
+
+
+/////////////////
+// BC DECODING //
+/////////////////
+
+// Output texels are r8g8b8a8. Interpolated values are rounded to nearest, as in the reference formulas:
+//    BC1 colors: (2 * c0 + c1 + 1) / 3, (c0 + 2 * c1 + 1) / 3, or (c0 + c1 + 1) / 2 in 3-color mode
+//    BC3 alpha, BC4/BC5 channels: ((7 - i) * v0 + i * v1 + 3) / 7, or ((5 - i) * v0 + i * v1 + 2) / 5 in 6-value mode
+
+/**
+ * Packs a texel.
+ */
+static inline uint32_t bcPack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+
+/**
+ * Computes the 4-color palette of a BC1 color block.
+ * @param block color block (8 bytes)
+ * @param forceFourColors true to always use the 4-color mode (BC3), otherwise the 3-color mode decodes as black
+ * @param palette output palette
+ */
+static inline void bcColorPalette(const uint8_t* block, bool forceFourColors, uint32_t palette[4])
+{
+	uint32_t c0 = block[0] | (block[1] << 8);
+	uint32_t c1 = block[2] | (block[3] << 8);
+
+	// Expand 5:6:5 to 8:8:8 (bit replication):
+	uint32_t r0 = (c0 >> 11) & 0x1F, g0 = (c0 >> 5) & 0x3F, b0 = c0 & 0x1F;
+	uint32_t r1 = (c1 >> 11) & 0x1F, g1 = (c1 >> 5) & 0x3F, b1 = c1 & 0x1F;
+	r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+	r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+	palette[0] = bcPack(r0, g0, b0, 255);
+	palette[1] = bcPack(r1, g1, b1, 255);
+	if (forceFourColors || c0 > c1)
+	{
+		palette[2] = bcPack((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255);
+		palette[3] = bcPack((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255);
+	}
+	else
+	{
+		palette[2] = bcPack((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+		palette[3] = bcPack(0, 0, 0, 255); // RGB formats: black
+	}
+}
+
+
+/**
+ * Computes the 8-value palette and the 16 indices of a BC4 block (also used for the BC3 alpha and BC5 channels).
+ * @param block BC4 block (8 bytes)
+ * @param palette output palette
+ * @param index output indices, one per texel
+ */
+static inline void bcSinglePalette(const uint8_t* block, uint8_t palette[8], uint8_t index[16])
+{
+	uint32_t v0 = block[0], v1 = block[1];
+	palette[0] = static_cast<uint8_t>(v0);
+	palette[1] = static_cast<uint8_t>(v1);
+	if (v0 > v1)
+		for (uint32_t i = 1; i < 7; i++)
+			palette[i + 1] = static_cast<uint8_t>(((7 - i) * v0 + i * v1 + 3) / 7);
+	else
+	{
+		for (uint32_t i = 1; i < 5; i++)
+			palette[i + 1] = static_cast<uint8_t>(((5 - i) * v0 + i * v1 + 2) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	// 16 x 3-bit indices:
+	uint64_t bits = 0;
+	for (uint32_t c = 0; c < 6; c++)
+		bits |= static_cast<uint64_t>(block[2 + c]) << (8 * c);
+	for (uint32_t c = 0; c < 16; c++)
+		index[c] = static_cast<uint8_t>((bits >> (3 * c)) & 0x7);
+}
+
+
+/**
+ * Decodes a 4x4 block (scalar version).
+ * @param format bitmap format
+ * @param block compressed block
+ * @param dst output texels (4 rows of 4 r8g8b8a8 texels)
+ * @param stride distance between rows in bytes
+ */
+static void bcDecodeBlockScalar(Eng::Bitmap::Format format, const uint8_t* block, uint8_t* dst, uint64_t stride)
+{
+	uint32_t texel[16];
+	switch (format)
+	{
+	case Eng::Bitmap::Format::r8g8b8_compressed: // BC1
+	case Eng::Bitmap::Format::r8g8b8a8_compressed: // BC3
+	{
+		const bool bc3 = format == Eng::Bitmap::Format::r8g8b8a8_compressed;
+		const uint8_t* color = bc3 ? block + 8 : block;
+		uint32_t palette[4];
+		bcColorPalette(color, bc3, palette);
+		uint32_t indices = color[4] | (color[5] << 8) | (color[6] << 16) | (static_cast<uint32_t>(color[7]) << 24);
+		for (uint32_t c = 0; c < 16; c++)
+			texel[c] = palette[(indices >> (2 * c)) & 0x3];
+		if (bc3)
+		{
+			uint8_t alphaPalette[8], alphaIndex[16];
+			bcSinglePalette(block, alphaPalette, alphaIndex);
+			for (uint32_t c = 0; c < 16; c++)
+				texel[c] = (texel[c] & 0x00FFFFFF) | (static_cast<uint32_t>(alphaPalette[alphaIndex[c]]) << 24);
+		}
+	}
+	break;
+
+	case Eng::Bitmap::Format::r8_compressed: // BC4
+	{
+		uint8_t palette[8], index[16];
+		bcSinglePalette(block, palette, index);
+		for (uint32_t c = 0; c < 16; c++)
+			texel[c] = bcPack(palette[index[c]], 0, 0, 255);
+	}
+	break;
+
+	case Eng::Bitmap::Format::r8g8_compressed: // BC5
+	{
+		uint8_t paletteR[8], indexR[16], paletteG[8], indexG[16];
+		bcSinglePalette(block, paletteR, indexR);
+		bcSinglePalette(block + 8, paletteG, indexG);
+		for (uint32_t c = 0; c < 16; c++)
+			texel[c] = bcPack(paletteR[indexR[c]], paletteG[indexG[c]], 0, 255);
+	}
+	break;
+
+	default:
+		return;
+	}
+
+	for (uint32_t y = 0; y < 4; y++)
+		memcpy(dst + y * stride, texel + y * 4, 4 * sizeof(uint32_t));
+}
+
+
+#ifdef ENG_BITMAP_SSE
+/**
+ * Returns true when SSE4.1 is available on this CPU.
+ */
+static bool bcHasSse41()
+{
+	static const bool supported = []()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 19)) != 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			return false;
+		return (ecx & (1 << 19)) != 0;
+#endif
+	}();
+	return supported;
+}
+
+
+/**
+ * @brief Shuffle masks for the SIMD decoder.
+ */
+struct BcMasks
+{
+	alignas(16) uint8_t colorRow[256][16]; ///< Row of 4 x 2-bit indices to palette bytes
+	alignas(16) uint8_t spread[4][4][16]; ///< Row y of 16 bytes to channel ch of 4 texels
+
+
+	/**
+	 * Constructor.
+	 */
+	BcMasks()
+	{
+		for (uint32_t row = 0; row < 256; row++)
+			for (uint32_t x = 0; x < 4; x++)
+				for (uint32_t b = 0; b < 4; b++)
+					colorRow[row][x * 4 + b] = static_cast<uint8_t>(((row >> (2 * x)) & 0x3) * 4 + b);
+		for (uint32_t y = 0; y < 4; y++)
+			for (uint32_t ch = 0; ch < 4; ch++)
+				for (uint32_t b = 0; b < 16; b++)
+					spread[y][ch][b] = (b % 4 == ch) ? static_cast<uint8_t>(y * 4 + b / 4) : 0x80;
+	}
+};
+
+static const BcMasks bcMasks;
+
+
+/**
+ * Decodes a 4x4 block (SSE4.1 version). Palettes are computed as in the scalar version, texels are then looked up and
+ * assembled with byte shuffles, one row of 4 texels at a time. The result is bit-exact with the scalar version.
+ * @param format bitmap format
+ * @param block compressed block
+ * @param dst output texels (4 rows of 4 r8g8b8a8 texels)
+ * @param stride distance between rows in bytes
+ */
+ENG_TARGET_SSE41 static void bcDecodeBlockSse41(Eng::Bitmap::Format format, const uint8_t* block, uint8_t* dst,
+                                                uint64_t stride)
+{
+	switch (format)
+	{
+	case Eng::Bitmap::Format::r8g8b8_compressed: // BC1
+	case Eng::Bitmap::Format::r8g8b8a8_compressed: // BC3
+	{
+		const bool bc3 = format == Eng::Bitmap::Format::r8g8b8a8_compressed;
+		const uint8_t* color = bc3 ? block + 8 : block;
+		alignas(16) uint32_t palette[4];
+		bcColorPalette(color, bc3, palette);
+		const __m128i colors = _mm_load_si128(reinterpret_cast<const __m128i*>(palette));
+
+		__m128i alpha = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		if (bc3)
+		{
+			alignas(16) uint8_t alphaPalette[16] = {}, alphaIndex[16];
+			bcSinglePalette(block, alphaPalette, alphaIndex);
+			alpha = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(alphaPalette)),
+			                         _mm_load_si128(reinterpret_cast<const __m128i*>(alphaIndex)));
+		}
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			__m128i row = _mm_shuffle_epi8(colors, _mm_load_si128(reinterpret_cast<const __m128i*>(bcMasks.colorRow[color[4 + y]])));
+			if (bc3)
+				row = _mm_or_si128(_mm_and_si128(row, rgbMask),
+				                   _mm_shuffle_epi8(alpha, _mm_load_si128(reinterpret_cast<const __m128i*>(bcMasks.spread[y][3]))));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * stride), row);
+		}
+	}
+	break;
+
+	case Eng::Bitmap::Format::r8_compressed: // BC4
+	case Eng::Bitmap::Format::r8g8_compressed: // BC5
+	{
+		const bool bc5 = format == Eng::Bitmap::Format::r8g8_compressed;
+		alignas(16) uint8_t palette[16] = {}, index[16];
+		bcSinglePalette(block, palette, index);
+		const __m128i red = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(palette)),
+		                                     _mm_load_si128(reinterpret_cast<const __m128i*>(index)));
+		__m128i green = _mm_setzero_si128();
+		if (bc5)
+		{
+			bcSinglePalette(block + 8, palette, index);
+			green = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(palette)),
+			                         _mm_load_si128(reinterpret_cast<const __m128i*>(index)));
+		}
+		const __m128i opaque = _mm_set1_epi32(static_cast<int32_t>(0xFF000000));
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			__m128i row = _mm_or_si128(opaque, _mm_shuffle_epi8(red, _mm_load_si128(reinterpret_cast<const __m128i*>(bcMasks.spread[y][0]))));
+			if (bc5)
+				row = _mm_or_si128(row, _mm_shuffle_epi8(green, _mm_load_si128(reinterpret_cast<const __m128i*>(bcMasks.spread[y][1]))));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * stride), row);
+		}
+	}
+	break;
+
+	default:
+		return;
+	}
+}
+#endif
+
+
+/////////////////
+// BC ENCODING //
+/////////////////
+
+// Palettes are always rebuilt with the decoding functions above, so indices are chosen against the exact values the GPU
+// will reconstruct. Input texels are r8g8b8a8, 16 per block (row-major).
+
+/**
+ * @brief Per-block kernels of the encoder (scalar or SIMD, bit-exact with each other).
+ */
+struct BcKernels
+{
+	void (*minMax)(const uint8_t* rgba, uint8_t mn[4], uint8_t mx[4]); ///< Per-channel bounds of the 16 texels
+	uint32_t (*colorIndices)(const uint8_t* rgba, const uint32_t palette[4], uint32_t& error); ///< BC1 2-bit indices
+	void (*singleIndices)(const uint8_t* value, const uint8_t palette[16], uint8_t index[16], uint32_t& error); ///< BC4 3-bit indices
+};
+
+
+/**
+ * Computes the per-channel minimum and maximum of a block (scalar version).
+ * @param rgba 16 texels
+ * @param mn output minimum values
+ * @param mx output maximum values
+ */
+static void bcMinMaxScalar(const uint8_t* rgba, uint8_t mn[4], uint8_t mx[4])
+{
+	for (uint32_t ch = 0; ch < 4; ch++)
+	{
+		mn[ch] = 255;
+		mx[ch] = 0;
+	}
+	for (uint32_t c = 0; c < 16; c++)
+		for (uint32_t ch = 0; ch < 4; ch++)
+		{
+			mn[ch] = std::min(mn[ch], rgba[c * 4 + ch]);
+			mx[ch] = std::max(mx[ch], rgba[c * 4 + ch]);
+		}
+}
+
+
+/**
+ * Selects the closest palette entry (RGB distance) for each texel (scalar version). Ties go to the lowest index.
+ * @param rgba 16 texels
+ * @param palette 4 packed colors, as returned by bcColorPalette()
+ * @param error output sum of squared errors
+ * @return 16 x 2-bit indices
+ */
+static uint32_t bcColorIndicesScalar(const uint8_t* rgba, const uint32_t palette[4], uint32_t& error)
+{
+	uint32_t indices = 0;
+	error = 0;
+	for (uint32_t c = 0; c < 16; c++)
+	{
+		uint32_t best = UINT32_MAX, bestIndex = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			int32_t dr = rgba[c * 4 + 0] - static_cast<int32_t>(palette[i] & 0xFF);
+			int32_t dg = rgba[c * 4 + 1] - static_cast<int32_t>((palette[i] >> 8) & 0xFF);
+			int32_t db = rgba[c * 4 + 2] - static_cast<int32_t>((palette[i] >> 16) & 0xFF);
+			uint32_t d = dr * dr + dg * dg + db * db;
+			if (d < best)
+			{
+				best = d;
+				bestIndex = i;
+			}
+		}
+		indices |= bestIndex << (2 * c);
+		error += best;
+	}
+	return indices;
+}
+
+
+/**
+ * Selects the closest palette entry for each value (scalar version). Ties go to the lowest index.
+ * @param value 16 values
+ * @param palette 8 values, as returned by bcSinglePalette()
+ * @param index output indices
+ * @param error output sum of squared errors
+ */
+static void bcSingleIndicesScalar(const uint8_t* value, const uint8_t palette[16], uint8_t index[16], uint32_t& error)
+{
+	error = 0;
+	for (uint32_t c = 0; c < 16; c++)
+	{
+		uint32_t best = UINT32_MAX;
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			uint32_t d = std::abs(value[c] - palette[i]);
+			if (d < best)
+			{
+				best = d;
+				index[c] = static_cast<uint8_t>(i);
+			}
+		}
+		error += best * best;
+	}
+}
+
+
+static const BcKernels bcKernelsScalar = {bcMinMaxScalar, bcColorIndicesScalar, bcSingleIndicesScalar};
+
+
+#ifdef ENG_BITMAP_SSE
+/**
+ * SSE4.1 version of bcMinMaxScalar().
+ */
+ENG_TARGET_SSE41 static void bcMinMaxSse41(const uint8_t* rgba, uint8_t mn[4], uint8_t mx[4])
+{
+	__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba));
+	__m128i hi = lo;
+	for (uint32_t c = 1; c < 4; c++)
+	{
+		const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + c * 16));
+		lo = _mm_min_epu8(lo, t);
+		hi = _mm_max_epu8(hi, t);
+	}
+	lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, 0x4E));
+	hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, 0x4E));
+	lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, 0xB1));
+	hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, 0xB1));
+	uint32_t l = static_cast<uint32_t>(_mm_cvtsi128_si32(lo)), h = static_cast<uint32_t>(_mm_cvtsi128_si32(hi));
+	memcpy(mn, &l, 4);
+	memcpy(mx, &h, 4);
+}
+
+
+/**
+ * SSE4.1 version of bcColorIndicesScalar(): squared distances of 4 texels to one palette entry at a time.
+ */
+ENG_TARGET_SSE41 static uint32_t bcColorIndicesSse41(const uint8_t* rgba, const uint32_t palette[4], uint32_t& error)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	__m128i entry[4];
+	for (uint32_t i = 0; i < 4; i++)
+		entry[i] = _mm_and_si128(_mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int32_t>(palette[i])), zero), rgbMask);
+
+	uint32_t indices = 0;
+	__m128i sum = zero;
+	for (uint32_t q = 0; q < 4; q++)
+	{
+		const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + q * 16));
+		const __m128i lo = _mm_and_si128(_mm_unpacklo_epi8(t, zero), rgbMask);
+		const __m128i hi = _mm_and_si128(_mm_unpackhi_epi8(t, zero), rgbMask);
+
+		__m128i best = _mm_set1_epi32(INT32_MAX), bestIndex = zero;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			const __m128i dLo = _mm_sub_epi16(lo, entry[i]);
+			const __m128i dHi = _mm_sub_epi16(hi, entry[i]);
+			const __m128i d = _mm_hadd_epi32(_mm_madd_epi16(dLo, dLo), _mm_madd_epi16(dHi, dHi));
+			const __m128i closer = _mm_cmplt_epi32(d, best);
+			best = _mm_min_epi32(best, d);
+			bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi32(static_cast<int32_t>(i)), closer);
+		}
+		indices |= static_cast<uint32_t>(_mm_extract_epi32(bestIndex, 0)) << (q * 8 + 0);
+		indices |= static_cast<uint32_t>(_mm_extract_epi32(bestIndex, 1)) << (q * 8 + 2);
+		indices |= static_cast<uint32_t>(_mm_extract_epi32(bestIndex, 2)) << (q * 8 + 4);
+		indices |= static_cast<uint32_t>(_mm_extract_epi32(bestIndex, 3)) << (q * 8 + 6);
+		sum = _mm_add_epi32(sum, best);
+	}
+	sum = _mm_hadd_epi32(sum, sum);
+	sum = _mm_hadd_epi32(sum, sum);
+	error = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+	return indices;
+}
+
+
+/**
+ * SSE4.1 version of bcSingleIndicesScalar(): absolute differences of the 16 values to one palette entry at a time.
+ */
+ENG_TARGET_SSE41 static void bcSingleIndicesSse41(const uint8_t* value, const uint8_t palette[16], uint8_t index[16],
+                                                  uint32_t& error)
+{
+	const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(value));
+	__m128i best = _mm_set1_epi8(static_cast<char>(0xFF)), bestIndex = _mm_setzero_si128();
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const __m128i p = _mm_set1_epi8(static_cast<char>(palette[i]));
+		const __m128i d = _mm_or_si128(_mm_subs_epu8(v, p), _mm_subs_epu8(p, v));
+		const __m128i closer = _mm_andnot_si128(_mm_cmpeq_epi8(d, best), _mm_cmpeq_epi8(_mm_min_epu8(d, best), d));
+		best = _mm_min_epu8(best, d);
+		bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi8(static_cast<char>(i)), closer);
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(index), bestIndex);
+
+	const __m128i lo = _mm_unpacklo_epi8(best, _mm_setzero_si128());
+	const __m128i hi = _mm_unpackhi_epi8(best, _mm_setzero_si128());
+	__m128i sum = _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+	sum = _mm_hadd_epi32(sum, sum);
+	sum = _mm_hadd_epi32(sum, sum);
+	error = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+
+static const BcKernels bcKernelsSse41 = {bcMinMaxSse41, bcColorIndicesSse41, bcSingleIndicesSse41};
+#endif
+
+
+/**
+ * Quantizes a color to 5:6:5.
+ */
+static inline uint32_t bcTo565(float r, float g, float b)
+{
+	uint32_t r5 = static_cast<uint32_t>(std::clamp(r, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	uint32_t g6 = static_cast<uint32_t>(std::clamp(g, 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	uint32_t b5 = static_cast<uint32_t>(std::clamp(b, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (r5 << 11) | (g6 << 5) | b5;
+}
+
+
+/**
+ * Encodes a BC1 color block from the given 5:6:5 endpoints and returns its error.
+ * @param kernels block kernels
+ * @param rgba 16 texels
+ * @param c0 first endpoint
+ * @param c1 second endpoint
+ * @param forceFourColors true for BC3 color blocks
+ * @param block output block (8 bytes)
+ * @return sum of squared errors
+ */
+static uint32_t bcColorEvaluate(const BcKernels& kernels, const uint8_t* rgba, uint32_t c0, uint32_t c1,
+                                bool forceFourColors, uint8_t* block)
+{
+	// c0 > c1 selects the 4-color mode in BC1:
+	if (c0 < c1)
+		std::swap(c0, c1);
+	block[0] = static_cast<uint8_t>(c0);
+	block[1] = static_cast<uint8_t>(c0 >> 8);
+	block[2] = static_cast<uint8_t>(c1);
+	block[3] = static_cast<uint8_t>(c1 >> 8);
+
+	alignas(16) uint32_t palette[4];
+	bcColorPalette(block, forceFourColors, palette);
+	uint32_t error;
+	uint32_t indices = kernels.colorIndices(rgba, palette, error);
+	memcpy(block + 4, &indices, 4);
+	return error;
+}
+
+
+/**
+ * Encodes a BC1 color block. Fast mode uses the inset bounding box of the colors, with its diagonal oriented by the
+ * sign of the covariance. High mode additionally tries the principal axis and refines the best endpoints by least
+ * squares.
+ * @param kernels block kernels
+ * @param rgba 16 texels
+ * @param mn per-channel minimum
+ * @param mx per-channel maximum
+ * @param high true for the high-quality mode
+ * @param forceFourColors true for BC3 color blocks
+ * @param block output block (8 bytes)
+ */
+static void bcEncodeColor(const BcKernels& kernels, const uint8_t* rgba, const uint8_t mn[4], const uint8_t mx[4],
+                          bool high, bool forceFourColors, uint8_t* block)
+{
+	// Bounding box, inset by 1/16 of its extent:
+	float lo[3], hi[3];
+	for (uint32_t ch = 0; ch < 3; ch++)
+	{
+		float inset = (mx[ch] - mn[ch]) / 16.0f;
+		lo[ch] = mn[ch] + inset;
+		hi[ch] = mx[ch] - inset;
+	}
+
+	// Orient the diagonal (green as reference):
+	int32_t covRG = 0, covBG = 0;
+	for (uint32_t c = 0; c < 16; c++)
+	{
+		int32_t g = 2 * rgba[c * 4 + 1] - mn[1] - mx[1];
+		covRG += (2 * rgba[c * 4 + 0] - mn[0] - mx[0]) * g;
+		covBG += (2 * rgba[c * 4 + 2] - mn[2] - mx[2]) * g;
+	}
+	if (covRG < 0)
+		std::swap(lo[0], hi[0]);
+	if (covBG < 0)
+		std::swap(lo[2], hi[2]);
+
+	uint32_t error = bcColorEvaluate(kernels, rgba, bcTo565(hi[0], hi[1], hi[2]), bcTo565(lo[0], lo[1], lo[2]),
+	                                 forceFourColors, block);
+	if (!high || error == 0)
+		return;
+
+	// Principal axis (power iteration on the covariance matrix):
+	float mean[3] = {0.0f, 0.0f, 0.0f};
+	for (uint32_t c = 0; c < 16; c++)
+		for (uint32_t ch = 0; ch < 3; ch++)
+			mean[ch] += rgba[c * 4 + ch] / 16.0f;
+	float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; // rr, rg, rb, gg, gb, bb
+	for (uint32_t c = 0; c < 16; c++)
+	{
+		float r = rgba[c * 4 + 0] - mean[0], g = rgba[c * 4 + 1] - mean[1], b = rgba[c * 4 + 2] - mean[2];
+		cov[0] += r * r;
+		cov[1] += r * g;
+		cov[2] += r * b;
+		cov[3] += g * g;
+		cov[4] += g * b;
+		cov[5] += b * b;
+	}
+	float axis[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+	for (uint32_t it = 0; it < 8; it++)
+	{
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float m = std::max(std::abs(x), std::max(std::abs(y), std::abs(z)));
+		if (m == 0.0f)
+			break;
+		axis[0] = x / m;
+		axis[1] = y / m;
+		axis[2] = z / m;
+	}
+	float length2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	if (length2 > 0.0f)
+	{
+		float tMin = FLT_MAX, tMax = -FLT_MAX;
+		for (uint32_t c = 0; c < 16; c++)
+		{
+			float t = ((rgba[c * 4 + 0] - mean[0]) * axis[0] + (rgba[c * 4 + 1] - mean[1]) * axis[1] +
+			           (rgba[c * 4 + 2] - mean[2]) * axis[2]) / length2;
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+		uint8_t candidate[8];
+		uint32_t e = bcColorEvaluate(kernels, rgba,
+		                             bcTo565(mean[0] + tMax * axis[0], mean[1] + tMax * axis[1], mean[2] + tMax * axis[2]),
+		                             bcTo565(mean[0] + tMin * axis[0], mean[1] + tMin * axis[1], mean[2] + tMin * axis[2]),
+		                             forceFourColors, candidate);
+		if (e < error)
+		{
+			error = e;
+			memcpy(block, candidate, 8);
+		}
+	}
+
+	// Least-squares refinement of the endpoints, given the current indices (4-color mode only):
+	static const float weight[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f}; ///< Weight of c0 for each index
+	for (uint32_t it = 0; it < 2 && error; it++)
+	{
+		uint32_t c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+		if (c0 <= c1 && !forceFourColors)
+			break;
+		uint32_t indices;
+		memcpy(&indices, block + 4, 4);
+
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {0.0f, 0.0f, 0.0f}, bx[3] = {0.0f, 0.0f, 0.0f};
+		for (uint32_t c = 0; c < 16; c++)
+		{
+			float a = weight[(indices >> (2 * c)) & 0x3], b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (uint32_t ch = 0; ch < 3; ch++)
+			{
+				ax[ch] += a * rgba[c * 4 + ch];
+				bx[ch] += b * rgba[c * 4 + ch];
+			}
+		}
+		float det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f)
+			break;
+		float e0[3], e1[3];
+		for (uint32_t ch = 0; ch < 3; ch++)
+		{
+			e0[ch] = (ax[ch] * bb - bx[ch] * ab) / det;
+			e1[ch] = (bx[ch] * aa - ax[ch] * ab) / det;
+		}
+
+		uint8_t candidate[8];
+		uint32_t e = bcColorEvaluate(kernels, rgba, bcTo565(e0[0], e0[1], e0[2]), bcTo565(e1[0], e1[1], e1[2]),
+		                             forceFourColors, candidate);
+		if (e >= error)
+			break;
+		error = e;
+		memcpy(block, candidate, 8);
+	}
+}
+
+
+/**
+ * Encodes a BC4 block from the given endpoints and returns its error.
+ * @param kernels block kernels
+ * @param value 16 values
+ * @param v0 first endpoint (v0 > v1 selects the 8-value mode)
+ * @param v1 second endpoint
+ * @param block output block (8 bytes)
+ * @return sum of squared errors
+ */
+static uint32_t bcSingleEvaluate(const BcKernels& kernels, const uint8_t* value, uint8_t v0, uint8_t v1, uint8_t* block)
+{
+	block[0] = v0;
+	block[1] = v1;
+	alignas(16) uint8_t palette[16] = {}, index[16];
+	bcSinglePalette(block, palette, index);
+	uint32_t error;
+	kernels.singleIndices(value, palette, index, error);
+
+	uint64_t bits = 0;
+	for (uint32_t c = 0; c < 16; c++)
+		bits |= static_cast<uint64_t>(index[c]) << (3 * c);
+	for (uint32_t c = 0; c < 6; c++)
+		block[2 + c] = static_cast<uint8_t>(bits >> (8 * c));
+	return error;
+}
+
+
+/**
+ * Encodes a BC4 block (also used for the BC3 alpha and BC5 channels). Fast mode uses the value range in the 8-value
+ * mode. High mode additionally tries insetting the range and the 6-value mode (exact 0 and 255).
+ * @param kernels block kernels
+ * @param value 16 values
+ * @param mn minimum value
+ * @param mx maximum value
+ * @param high true for the high-quality mode
+ * @param block output block (8 bytes)
+ */
+static void bcEncodeSingle(const BcKernels& kernels, const uint8_t* value, uint8_t mn, uint8_t mx, bool high,
+                           uint8_t* block)
+{
+	uint32_t error = bcSingleEvaluate(kernels, value, mx, mn, block);
+	if (!high || error == 0)
+		return;
+
+	uint8_t candidate[8];
+	for (uint32_t insetMax = 0; insetMax < 3; insetMax++)
+		for (uint32_t insetMin = 0; insetMin < 3; insetMin++)
+		{
+			if ((insetMax == 0 && insetMin == 0) || mx - insetMax <= mn + insetMin)
+				continue;
+			uint32_t e = bcSingleEvaluate(kernels, value, static_cast<uint8_t>(mx - insetMax),
+			                              static_cast<uint8_t>(mn + insetMin), candidate);
+			if (e < error)
+			{
+				error = e;
+				memcpy(block, candidate, 8);
+			}
+		}
+
+	// 6-value mode, with the extremes left to the exact 0 and 255:
+	uint8_t lo = 255, hi = 0;
+	for (uint32_t c = 0; c < 16; c++)
+		if (value[c] != 0 && value[c] != 255)
+		{
+			lo = std::min(lo, value[c]);
+			hi = std::max(hi, value[c]);
+		}
+	if (lo <= hi && bcSingleEvaluate(kernels, value, lo, hi, candidate) < error)
+		memcpy(block, candidate, 8);
+}
+
+
+/**
+ * Halves an r8g8b8a8 image with a box filter (odd sizes are clamped at the border).
+ * @param src source image
+ * @param sizeX source width
+ * @param sizeY source height
+ * @param dst output image, max(1, sizeX / 2) x max(1, sizeY / 2)
+ * @param firstRow first output row
+ * @param lastRow last output row (excluded)
+ */
+static void bitmapDownsample(const uint8_t* src, uint32_t sizeX, uint32_t sizeY, uint8_t* dst, uint32_t firstRow,
+                             uint32_t lastRow)
+{
+	const uint32_t dstSizeX = std::max(1u, sizeX / 2);
+	for (uint32_t y = firstRow; y < lastRow; y++)
+	{
+		const uint8_t* row0 = src + static_cast<uint64_t>(std::min(2 * y, sizeY - 1)) * sizeX * 4;
+		const uint8_t* row1 = src + static_cast<uint64_t>(std::min(2 * y + 1, sizeY - 1)) * sizeX * 4;
+		uint8_t* d = dst + static_cast<uint64_t>(y) * dstSizeX * 4;
+		for (uint32_t x = 0; x < dstSizeX; x++)
+		{
+			const uint32_t x0 = std::min(2 * x, sizeX - 1) * 4, x1 = std::min(2 * x + 1, sizeX - 1) * 4;
+			for (uint32_t ch = 0; ch < 4; ch++)
+				d[x * 4 + ch] = static_cast<uint8_t>((row0[x0 + ch] + row0[x1 + ch] + row1[x0 + ch] + row1[x1 + ch] + 2) / 4);
+		}
+	}
+}
+
 
 /////////////////////////
 // RESERVED STRUCTURES //
@@ -38,21 +802,23 @@ Eng::Bitmap Eng::Bitmap::empty("[empty]");
 struct Eng::Bitmap::Reserved
 {
 	/**
-	 * @brief Bitmap layer.
+	 * @brief Bitmap layer, as a range of the backing store.
 	 */
 	struct Layer
 	{
-		std::vector<uint8_t> data; ///< Image raw data
+		uint64_t offset; ///< Offset of the image raw data in the backing store
+		uint32_t nrOfBytes; ///< Size of the image raw data
 		glm::u32vec2 size; ///< Layer size
 
 
 		/**
 		 * Constructor.
 		 */
-		Layer() : size{0, 0} {}
+		Layer() : offset{0}, nrOfBytes{0}, size{0, 0} {}
 	};
 
 	Eng::Bitmap::Format format; ///< Image format
+	Eng::Serializer storage; ///< Backing store of all the layers (memory buffer or mapped file)
 	std::vector<Layer> layer; ///< Bitmap layers;
 	uint32_t nrOfLevels; ///< Number of levels (mipmaps)
 	uint32_t nrOfSides; ///< Number of sides (faces)
@@ -255,8 +1021,13 @@ uint8_t ENG_API* Eng::Bitmap::getData(uint32_t level, uint32_t side) const
 		ENG_LOG_ERROR("Invalid params");
 		return nullptr;
 	}
+	if (hasData() == false)
+	{
+		ENG_LOG_ERROR("Bitmap data released");
+		return nullptr;
+	}
 
-	return reserved->layer[side * reserved->nrOfLevels + level].data.data();
+	return static_cast<uint8_t*>(reserved->storage.getData()) + reserved->layer[side * reserved->nrOfLevels + level].offset;
 }
 
 
@@ -276,14 +1047,46 @@ uint32_t ENG_API Eng::Bitmap::getNrOfBytes(uint32_t level, uint32_t side) const
 		return 0;
 	}
 
-	return static_cast<uint32_t>(reserved->layer[side * reserved->nrOfLevels + level].data.size());
+	return reserved->layer[side * reserved->nrOfLevels + level].nrOfBytes;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the image data is available (i.e., it has been loaded and not released).
+ * @return TF
+ */
+bool ENG_API Eng::Bitmap::hasData() const
+{
+	return !reserved->layer.empty() && reserved->storage.getNrOfBytes() != 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the number of bytes of image data held on the heap (zero when mapped or released).
+ * @return number of resident bytes
+ */
+uint64_t ENG_API Eng::Bitmap::getNrOfResidentBytes() const
+{
+	return reserved->storage.getNrOfResidentBytes();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases the image data (e.g., once uploaded to a texture). Format, sizes and number of levels/sides stay available.
+ */
+void ENG_API Eng::Bitmap::releaseData()
+{
+	reserved->storage.clear();
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Load image from memory.
- * @param format image format
+ * @param format image format (uncompressed RGB(A), or raw BC1/BC3/BC4/BC5 blocks)
  * @param sizeX width in pixels
  * @param sizeY height in pixels
  * @param data pointer to the image data
@@ -298,19 +1101,24 @@ bool ENG_API Eng::Bitmap::load(Format format, uint32_t sizeX, uint32_t sizeY, ui
 		return false;
 	}
 
-	// Image size:
-	uint32_t colorDepth = 0;
+	// Image size (compressed formats are stored as 4x4 blocks):
+	uint64_t size = 0;
 	switch (format)
 	{
-	case Format::r8g8b8: colorDepth = 3;
+	case Format::r8g8b8: size = (uint64_t)sizeX * (uint64_t)sizeY * 3;
+		break;
+	case Format::r8g8b8a8: size = (uint64_t)sizeX * (uint64_t)sizeY * 4;
+		break;
+	case Format::r8g8b8_compressed:
+	case Format::r8_compressed: size = (uint64_t)((sizeX + 3) / 4) * (uint64_t)((sizeY + 3) / 4) * 8;
 		break;
-	case Format::r8g8b8a8: colorDepth = 4;
+	case Format::r8g8b8a8_compressed:
+	case Format::r8g8_compressed: size = (uint64_t)((sizeX + 3) / 4) * (uint64_t)((sizeY + 3) / 4) * 16;
 		break;
 	default:
 		ENG_LOG_ERROR("Invalid format");
 		return false;
 	}
-	uint64_t size = (uint64_t)sizeX * (uint64_t)sizeY * (uint64_t)colorDepth;
 
 	// Free previous image?
 	reserved->layer.clear();
@@ -320,14 +1128,14 @@ bool ENG_API Eng::Bitmap::load(Format format, uint32_t sizeX, uint32_t sizeY, ui
 	reserved->nrOfSides = 1;
 	reserved->nrOfLevels = 1;
 
-	// Allocate and populate layer:   
+	// Copy into the backing store:
+	reserved->storage = Eng::Serializer(data, size);
+
+	// Store layer:
 	Reserved::Layer l;
 	l.size.x = sizeX;
 	l.size.y = sizeY;
-	l.data.resize(size);
-	memcpy(l.data.data(), data, size);
-
-	// Store layer:
+	l.nrOfBytes = static_cast<uint32_t>(size);
 	reserved->layer.push_back(l);
 
 	// Done:   
@@ -338,14 +1146,18 @@ bool ENG_API Eng::Bitmap::load(Format format, uint32_t sizeX, uint32_t sizeY, ui
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Load image from a .dds file.
+ * Load image from a .dds file. The file content becomes the backing store of the bitmap and levels are accessed in
+ * place, without further allocations or copies. In mapped mode (default), no heap memory is used for the image data:
+ * its pages are touched here, so the disk is read by the loading thread rather than later on, during the upload. In
+ * memory mode, the file is read into a single buffer.
  * @param filename DDS file name
+ * @param mode backing store (memory or mapped)
  * @return TF
  */
-bool ENG_API Eng::Bitmap::load(const std::string& filename)
+bool ENG_API Eng::Bitmap::load(const std::string& filename, Eng::Serializer::Mode mode)
 {
 	// Safety net:
-	if (filename.empty())
+	if (filename.empty() || (mode != Eng::Serializer::Mode::memory && mode != Eng::Serializer::Mode::mapped))
 	{
 		ENG_LOG_ERROR("Invalid params");
 		return false;
@@ -353,42 +1165,31 @@ bool ENG_API Eng::Bitmap::load(const std::string& filename)
 
 	// Free previous image?
 	reserved->layer.clear();
+	reserved->storage.clear();
 
-	// Get file size:
-	FILE* dat = fopen(filename.c_str(), "rb");
-	if (dat == nullptr)
+	// Load file:
+	Eng::Serializer& serial = reserved->storage;
+	if (serial.load(filename, mode) == false)
 	{
 		ENG_LOG_ERROR("File '%s' not found", filename.c_str());
 		return false;
 	}
-	fseek(dat, 0, SEEK_END);
-	uint64_t filesize = ftell(dat);
-	fseek(dat, 0, SEEK_SET);
-
-	// Copy file to memory:
-	std::vector<uint8_t> data(filesize);
-	uint8_t* position = data.data();
-	if (fread(position, sizeof(uint8_t), filesize, dat) != filesize)
-	{
-		ENG_LOG_ERROR("File '%s' damaged", filename.c_str());
-		fclose(dat);
-		return false;
-	}
-	fclose(dat);
 
 	// Check header:   
-	uint32_t magicNumber;
-	memcpy(&magicNumber, position, sizeof(uint32_t));
-	position += sizeof(uint32_t);
-	if (magicNumber != DDS_MAGICNUMBER)
+	uint32_t magicNumber = 0;
+	if (serial.deserialize(&magicNumber, sizeof(uint32_t)) == false || magicNumber != DDS_MAGICNUMBER)
 	{
 		ENG_LOG_ERROR("File '%s' is not a valid DDS", filename.c_str());
 		return false;
 	}
 
 	// Get header:
-	DDS_HEADER* header = reinterpret_cast<DDS_HEADER*>(position);
-	position += sizeof(DDS_HEADER);
+	const DDS_HEADER* header = static_cast<const DDS_HEADER*>(serial.read(sizeof(DDS_HEADER)));
+	if (header == nullptr)
+	{
+		ENG_LOG_ERROR("File '%s' damaged", filename.c_str());
+		return false;
+	}
 	reserved->nrOfLevels = header->dwMipMapCount;
 
 	// Cubemap (old format)?
@@ -430,8 +1231,12 @@ bool ENG_API Eng::Bitmap::load(const std::string& filename)
 	else if (strcmp(fourCC, "DX10") == 0)
 	{
 		// Get header10:
-		DDS_HEADER10* header10 = reinterpret_cast<DDS_HEADER10*>(position);
-		position += sizeof(DDS_HEADER10);
+		const DDS_HEADER10* header10 = static_cast<const DDS_HEADER10*>(serial.read(sizeof(DDS_HEADER10)));
+		if (header10 == nullptr)
+		{
+			ENG_LOG_ERROR("File '%s' damaged", filename.c_str());
+			return false;
+		}
 
 		// Cube map (new format)?
 		ENG_LOG_DEBUG("Array: %u", header10->arraySize);
@@ -496,9 +1301,15 @@ bool ENG_API Eng::Bitmap::load(const std::string& filename)
 				levelSize = 8;
 			if (reserved->compressionFactor == 1.0f && levelSize < 16)
 				levelSize = 16;
-			curLayer.data.resize(levelSize);
-			memcpy(curLayer.data.data(), position, levelSize);
-			position += levelSize;
+			curLayer.offset = serial.getPosition();
+			curLayer.nrOfBytes = levelSize;
+			if (serial.skip(levelSize) == false)
+			{
+				ENG_LOG_ERROR("File '%s' damaged", filename.c_str());
+				reserved->layer.clear();
+				serial.clear();
+				return false;
+			}
 
 			ENG_LOG_DEBUG("Mipmap: %u, %ux%u, %u bytes", c, sizeX, sizeY, levelSize);
 
@@ -510,7 +1321,361 @@ bool ENG_API Eng::Bitmap::load(const std::string& filename)
 		}
 	}
 
+	// Fault in the mapped pages:
+	if (mode == Eng::Serializer::Mode::mapped)
+	{
+		const volatile uint8_t* data = static_cast<const uint8_t*>(serial.getData());
+		uint8_t checksum = 0;
+		for (uint64_t c = 0; c < serial.getNrOfBytes(); c += pageSize)
+			checksum ^= data[c];
+		(void) checksum;
+	}
+
 	// Done:
 	this->setName(filename);
 	return true;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes the bitmap into an uncompressed r8g8b8a8 bitmap, with the same levels and sides. Single-channel (BC4) and
+ * two-channel (BC5) formats are expanded as OpenGL samples them, i.e. (r, 0, 0, 255) and (r, g, 0, 255). Blocks are
+ * decoded in parallel through the ThreadPool, using SSE4.1 when available.
+ * @param output decoded bitmap
+ * @param simd false to force the scalar decoder (e.g., for validation)
+ * @return TF
+ */
+bool ENG_API Eng::Bitmap::decompress(Eng::Bitmap& output, bool simd) const
+{
+	// Safety net:
+	if (hasData() == false || &output == this)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	const Format format = reserved->format;
+	uint32_t blockSize = 0;
+	switch (format)
+	{
+	case Format::r8g8b8_compressed:
+	case Format::r8_compressed:
+		blockSize = 8;
+		break;
+	case Format::r8g8b8a8_compressed:
+	case Format::r8g8_compressed:
+		blockSize = 16;
+		break;
+	case Format::r8g8b8:
+	case Format::r8g8b8a8:
+		break;
+	default:
+		ENG_LOG_ERROR("Invalid format");
+		return false;
+	}
+
+	// Output layers:
+	std::vector<Reserved::Layer> layer(reserved->layer.size());
+	uint64_t nrOfBytes = 0;
+	for (uint32_t c = 0; c < layer.size(); c++)
+	{
+		const Reserved::Layer& in = reserved->layer[c];
+		layer[c].size = in.size;
+		layer[c].offset = nrOfBytes;
+		layer[c].nrOfBytes = in.size.x * in.size.y * 4;
+		nrOfBytes += layer[c].nrOfBytes;
+
+		// Enough input data?
+		uint64_t required = blockSize ? static_cast<uint64_t>((in.size.x + 3) / 4) * ((in.size.y + 3) / 4) * blockSize
+		                              : static_cast<uint64_t>(in.size.x) * in.size.y * getColorDepth();
+		if (in.nrOfBytes < required)
+		{
+			ENG_LOG_ERROR("Corrupted bitmap data");
+			return false;
+		}
+	}
+	Eng::Serializer storage(nullptr, nrOfBytes);
+	const uint8_t* src = static_cast<const uint8_t*>(reserved->storage.getData());
+	uint8_t* dst = static_cast<uint8_t*>(storage.getData());
+
+	// Jobs (bands of block rows, of about the same size):
+	struct Job
+	{
+		uint32_t layer, firstRow, lastRow;
+	};
+	std::vector<Job> job;
+	const uint32_t blocksPerJob = 8192;
+	for (uint32_t c = 0; c < layer.size(); c++)
+	{
+		uint32_t nrOfRows = (layer[c].size.y + 3) / 4;
+		uint32_t rowsPerJob = std::max(1u, blocksPerJob / std::max(1u, (layer[c].size.x + 3) / 4));
+		for (uint32_t row = 0; row < nrOfRows; row += rowsPerJob)
+			job.push_back({c, row, std::min(nrOfRows, row + rowsPerJob)});
+	}
+
+	// Decoder:
+	void (*decodeBlock)(Format, const uint8_t*, uint8_t*, uint64_t) = bcDecodeBlockScalar;
+#ifdef ENG_BITMAP_SSE
+	if (simd && bcHasSse41())
+		decodeBlock = bcDecodeBlockSse41;
+#endif
+
+	// Decode:
+	Eng::ThreadPool::getInstance().parallelFor(job.size(), [&](uint64_t j)
+	{
+		const Reserved::Layer& in = reserved->layer[job[j].layer];
+		const Reserved::Layer& out = layer[job[j].layer];
+		const uint32_t sizeX = in.size.x, sizeY = in.size.y;
+		const uint64_t stride = static_cast<uint64_t>(sizeX) * 4;
+		const uint32_t blocksX = (sizeX + 3) / 4;
+
+		// Uncompressed:
+		if (blockSize == 0)
+		{
+			const uint32_t depth = format == Format::r8g8b8 ? 3 : 4;
+			for (uint32_t y = job[j].firstRow * 4; y < std::min(sizeY, job[j].lastRow * 4); y++)
+			{
+				const uint8_t* s = src + in.offset + static_cast<uint64_t>(y) * sizeX * depth;
+				uint8_t* d = dst + out.offset + y * stride;
+				if (depth == 4)
+					memcpy(d, s, stride);
+				else
+					for (uint32_t x = 0; x < sizeX; x++, s += 3, d += 4)
+					{
+						d[0] = s[0];
+						d[1] = s[1];
+						d[2] = s[2];
+						d[3] = 255;
+					}
+			}
+			return;
+		}
+
+		// Compressed:
+		alignas(16) uint8_t tmp[4 * 4 * 4];
+		for (uint32_t by = job[j].firstRow; by < job[j].lastRow; by++)
+		{
+			const uint8_t* block = src + in.offset + static_cast<uint64_t>(by) * blocksX * blockSize;
+			for (uint32_t bx = 0; bx < blocksX; bx++, block += blockSize)
+			{
+				uint8_t* d = dst + out.offset + static_cast<uint64_t>(by) * 4 * stride + bx * 16;
+				if (bx * 4 + 4 <= sizeX && by * 4 + 4 <= sizeY)
+					decodeBlock(format, block, d, stride);
+				else
+				{
+					// Partial block (edges of levels smaller than 4x4 or not multiple of 4):
+					decodeBlock(format, block, tmp, 16);
+					uint32_t w = std::min(4u, sizeX - bx * 4), h = std::min(4u, sizeY - by * 4);
+					for (uint32_t y = 0; y < h; y++)
+						memcpy(d + y * stride, tmp + y * 16, w * 4);
+				}
+			}
+		}
+	});
+
+	// Done:
+	output.reserved->format = Format::r8g8b8a8;
+	output.reserved->nrOfLevels = reserved->nrOfLevels;
+	output.reserved->nrOfSides = reserved->nrOfSides;
+	output.reserved->compressionFactor = 4.0f;
+	output.reserved->layer = std::move(layer);
+	output.reserved->storage = std::move(storage);
+	output.setName(this->getName());
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Encodes the bitmap into a block-compressed bitmap. Single-level bitmaps get a full mipmap chain (box filter) when
+ * requested, otherwise the existing levels and sides are encoded. Blocks are encoded in parallel through the
+ * ThreadPool, using SSE4.1 when available. Non-r8g8b8a8 sources are decoded first.
+ * @param output encoded bitmap
+ * @param format target format (one of the compressed ones)
+ * @param quality fast (bounding box) or high (principal axis and refinement)
+ * @param mipmaps true to generate the mipmaps of single-level bitmaps
+ * @param simd false to force the scalar kernels (e.g., for validation)
+ * @return TF
+ */
+bool ENG_API Eng::Bitmap::compress(Eng::Bitmap& output, Format format, Quality quality, bool mipmaps, bool simd) const
+{
+	// Safety net:
+	if (hasData() == false || &output == this || (quality != Quality::fast && quality != Quality::high))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	uint32_t blockSize = 0;
+	float compressionFactor = 0.0f;
+	switch (format)
+	{
+	case Format::r8g8b8_compressed:
+	case Format::r8_compressed:
+		blockSize = 8;
+		compressionFactor = 0.5f;
+		break;
+	case Format::r8g8b8a8_compressed:
+	case Format::r8g8_compressed:
+		blockSize = 16;
+		compressionFactor = 1.0f;
+		break;
+	default:
+		ENG_LOG_ERROR("Invalid format");
+		return false;
+	}
+
+	// Source texels (r8g8b8a8):
+	const Eng::Bitmap* source = this;
+	Eng::Bitmap decoded;
+	if (reserved->format != Format::r8g8b8a8)
+	{
+		if (decompress(decoded, simd) == false)
+			return false;
+		source = &decoded;
+	}
+	const uint32_t nrOfSides = reserved->nrOfSides;
+	uint32_t nrOfLevels = reserved->nrOfLevels;
+	std::vector<const uint8_t*> texels;
+	std::vector<glm::u32vec2> size;
+	for (const Reserved::Layer& l : source->reserved->layer)
+	{
+		texels.push_back(static_cast<const uint8_t*>(source->reserved->storage.getData()) + l.offset);
+		size.push_back(l.size);
+	}
+
+	// Mipmaps:
+	std::vector<std::vector<uint8_t>> generated;
+	if (mipmaps && nrOfLevels == 1)
+	{
+		while ((std::max(size[0].x, size[0].y) >> nrOfLevels) > 0)
+			nrOfLevels++;
+		generated.resize(nrOfSides * (nrOfLevels - 1));
+		std::vector<const uint8_t*> base = texels;
+		std::vector<glm::u32vec2> baseSize = size;
+		texels.clear();
+		size.clear();
+		for (uint32_t s = 0; s < nrOfSides; s++)
+		{
+			texels.push_back(base[s]);
+			size.push_back(baseSize[s]);
+			for (uint32_t c = 1; c < nrOfLevels; c++)
+			{
+				const glm::u32vec2 prev = size.back();
+				const glm::u32vec2 cur = {std::max(1u, prev.x / 2), std::max(1u, prev.y / 2)};
+				std::vector<uint8_t>& level = generated[s * (nrOfLevels - 1) + c - 1];
+				level.resize(static_cast<uint64_t>(cur.x) * cur.y * 4);
+				const uint8_t* src = texels.back();
+				const uint32_t rowsPerJob = std::max(1u, 65536 / cur.x);
+				Eng::ThreadPool::getInstance().parallelFor((cur.y + rowsPerJob - 1) / rowsPerJob, [&](uint64_t j)
+				{
+					const uint32_t firstRow = static_cast<uint32_t>(j) * rowsPerJob;
+					bitmapDownsample(src, prev.x, prev.y, level.data(), firstRow, std::min(cur.y, firstRow + rowsPerJob));
+				});
+				texels.push_back(level.data());
+				size.push_back(cur);
+			}
+		}
+	}
+
+	// Output layers:
+	std::vector<Reserved::Layer> layer(texels.size());
+	uint64_t nrOfBytes = 0;
+	for (uint32_t c = 0; c < layer.size(); c++)
+	{
+		layer[c].size = size[c];
+		layer[c].offset = nrOfBytes;
+		layer[c].nrOfBytes = ((size[c].x + 3) / 4) * ((size[c].y + 3) / 4) * blockSize;
+		nrOfBytes += layer[c].nrOfBytes;
+	}
+	Eng::Serializer storage(nullptr, nrOfBytes);
+	uint8_t* dst = static_cast<uint8_t*>(storage.getData());
+
+	// Jobs (bands of block rows, of about the same size):
+	struct Job
+	{
+		uint32_t layer, firstRow, lastRow;
+	};
+	std::vector<Job> job;
+	const uint32_t blocksPerJob = quality == Quality::high ? 1024 : 4096;
+	for (uint32_t c = 0; c < layer.size(); c++)
+	{
+		uint32_t nrOfRows = (layer[c].size.y + 3) / 4;
+		uint32_t rowsPerJob = std::max(1u, blocksPerJob / std::max(1u, (layer[c].size.x + 3) / 4));
+		for (uint32_t row = 0; row < nrOfRows; row += rowsPerJob)
+			job.push_back({c, row, std::min(nrOfRows, row + rowsPerJob)});
+	}
+
+	// Kernels:
+	const BcKernels* kernels = &bcKernelsScalar;
+#ifdef ENG_BITMAP_SSE
+	if (simd && bcHasSse41())
+		kernels = &bcKernelsSse41;
+#endif
+	const bool high = quality == Quality::high;
+
+	// Encode:
+	Eng::ThreadPool::getInstance().parallelFor(job.size(), [&](uint64_t j)
+	{
+		const uint8_t* src = texels[job[j].layer];
+		const Reserved::Layer& out = layer[job[j].layer];
+		const uint32_t sizeX = out.size.x, sizeY = out.size.y;
+		const uint32_t blocksX = (sizeX + 3) / 4;
+
+		alignas(16) uint8_t rgba[64];
+		uint8_t value[2][16], mn[4], mx[4];
+		for (uint32_t by = job[j].firstRow; by < job[j].lastRow; by++)
+		{
+			uint8_t* block = dst + out.offset + static_cast<uint64_t>(by) * blocksX * blockSize;
+			for (uint32_t bx = 0; bx < blocksX; bx++, block += blockSize)
+			{
+				// Gather the 4x4 texels (edge texels are replicated in partial blocks):
+				for (uint32_t y = 0; y < 4; y++)
+				{
+					const uint8_t* row = src + static_cast<uint64_t>(std::min(by * 4 + y, sizeY - 1)) * sizeX * 4;
+					if (bx * 4 + 4 <= sizeX)
+						memcpy(rgba + y * 16, row + bx * 16, 16);
+					else
+						for (uint32_t x = 0; x < 4; x++)
+							memcpy(rgba + y * 16 + x * 4, row + std::min(bx * 4 + x, sizeX - 1) * 4, 4);
+				}
+				kernels->minMax(rgba, mn, mx);
+
+				switch (format)
+				{
+				case Format::r8g8b8_compressed: // BC1
+					bcEncodeColor(*kernels, rgba, mn, mx, high, false, block);
+					break;
+
+				case Format::r8g8b8a8_compressed: // BC3
+					for (uint32_t c = 0; c < 16; c++)
+						value[0][c] = rgba[c * 4 + 3];
+					bcEncodeSingle(*kernels, value[0], mn[3], mx[3], high, block);
+					bcEncodeColor(*kernels, rgba, mn, mx, high, true, block + 8);
+					break;
+
+				case Format::r8_compressed: // BC4
+				case Format::r8g8_compressed: // BC5
+					for (uint32_t ch = 0; ch < blockSize / 8; ch++)
+					{
+						for (uint32_t c = 0; c < 16; c++)
+							value[ch][c] = rgba[c * 4 + ch];
+						bcEncodeSingle(*kernels, value[ch], mn[ch], mx[ch], high, block + ch * 8);
+					}
+					break;
+				}
+			}
+		}
+	});
+
+	// Done:
+	output.reserved->format = format;
+	output.reserved->nrOfLevels = nrOfLevels;
+	output.reserved->nrOfSides = nrOfSides;
+	output.reserved->compressionFactor = compressionFactor;
+	output.reserved->layer = std::move(layer);
+	output.reserved->storage = std::move(storage);
+	output.setName(this->getName());
+	return true;
+}
@@ -8,7 +8,8 @@
 
 
 /**
- * @brief Class for modeling a generic bitmap. 
+ * @brief Class for modeling a generic bitmap. All the levels and sides share a single backing store (a memory buffer or
+ * the mapped file), which can be released once uploaded.
  */
 class ENG_API Bitmap : public Eng::Object
 {
@@ -42,6 +43,22 @@ public: //
 	};
 
 
+	/**
+	 * @brief Block compression quality.
+	 */
+	enum class Quality : uint32_t
+	{
+		none,
+
+		// Modes:
+		fast, ///< Inset bounding box endpoints
+		high, ///< Principal axis endpoints, refined by least squares
+
+		// Terminator:
+		last
+	};
+
+
 	// Const/dest:
 	Bitmap();
 	Bitmap(Bitmap&& other);
@@ -59,10 +76,18 @@ public: //
 	uint32_t getNrOfBytes(uint32_t level = 0, uint32_t side = 0) const;
 	uint8_t* getData(uint32_t level = 0, uint32_t side = 0) const;
 	float getCompressionFactor() const;
+	bool hasData() const;
+	uint64_t getNrOfResidentBytes() const;
 
 	// Loaders:
-	bool load(const std::string& filename);
+	bool load(const std::string& filename, Eng::Serializer::Mode mode = Eng::Serializer::Mode::mapped);
 	bool load(Format format, uint32_t sizeX, uint32_t sizeY, uint8_t* data);
+	void releaseData();
+
+	// Conversion:
+	bool decompress(Eng::Bitmap& output, bool simd = true) const;
+	bool compress(Eng::Bitmap& output, Format format, Quality quality = Quality::fast, bool mipmaps = true,
+	              bool simd = true) const;
 
 
 	/////////////
@@ -0,0 +1,1306 @@
+/**
+ * @file		engine_bvh.cpp
+ * @brief	Bounding volume hierarchy for spatial queries over the scene
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+// SIMD (x86 only, SSE is part of the x64 baseline):
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ENG_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Bvh reserved structure.
+ */
+struct Eng::Bvh::Reserved
+{
+	// Consts:
+	static constexpr float inf = std::numeric_limits<float>::infinity();
+	static constexpr uint32_t maxDepth = 96; ///< Binary levels above which splits fall back to the median
+	static constexpr uint32_t stackSize = 512; ///< Traversal stack entries (enough for maxDepth plus balanced levels)
+
+
+	/**
+	 * @brief Node of the binary tree produced by the builder.
+	 */
+	struct BuildNode
+	{
+		glm::vec3 min; ///< Box min corner
+		glm::vec3 max; ///< Box max corner
+		uint32_t left; ///< First child (inner nodes)
+		uint32_t right; ///< Second child (inner nodes)
+		uint32_t first; ///< First primitive, in the build order (leaves)
+		uint32_t count; ///< Number of primitives (0 for inner nodes)
+	};
+
+	/**
+	 * @brief 4-wide node, with its children boxes stored per component (SSE, one child per lane).
+	 */
+	struct alignas(16) Node4
+	{
+		float minX[4], minY[4], minZ[4]; ///< Children box min corners
+		float maxX[4], maxY[4], maxZ[4]; ///< Children box max corners
+		int32_t child[4]; ///< Inner node or first primitive of a leaf, -1 for unused slots
+		uint32_t count[4]; ///< Number of primitives of a leaf (0 for inner nodes)
+	};
+
+	/**
+	 * @brief Four triangles, stored per component as first vertex and edges (SSE, one triangle per lane).
+	 */
+	struct alignas(16) Tri4
+	{
+		float v0[3][4]; ///< First vertex
+		float e1[3][4]; ///< Edge from the first to the second vertex
+		float e2[3][4]; ///< Edge from the first to the third vertex
+		uint32_t face[4]; ///< Triangle index within the shape (padding lanes are degenerate)
+	};
+
+	/**
+	 * @brief Triangle hierarchy of a mesh shape, in mesh coordinates.
+	 */
+	struct ShapeTree
+	{
+		std::vector<Node4> node; ///< Nodes (the root first), leaves point to packets
+		std::vector<Tri4> packet; ///< Triangle packets
+		glm::vec3 min; ///< Shape box min corner
+		glm::vec3 max; ///< Shape box max corner
+		uint32_t nrOfFaces; ///< Triangles indexed
+	};
+
+	/**
+	 * @brief Mesh placed in the scene.
+	 */
+	struct Instance
+	{
+		const Eng::Mesh* mesh; ///< Mesh
+		const ShapeTree* shape; ///< Triangle hierarchy (nullptr if the mesh has no shape: its box is used instead)
+		uint32_t source; ///< Position in the scene graph traversal
+		glm::mat4 matrix; ///< World matrix
+		glm::mat4 inverse; ///< Inverse world matrix
+		glm::vec3 localMin; ///< Box min corner, in mesh coordinates
+		glm::vec3 localMax; ///< Box max corner, in mesh coordinates
+		glm::vec3 min; ///< Box min corner, in world coordinates
+		glm::vec3 max; ///< Box max corner, in world coordinates
+	};
+
+	/**
+	 * @brief Ray, with the reciprocal of its direction for the slab tests.
+	 */
+	struct Ray
+	{
+		glm::vec3 origin; ///< Origin
+		glm::vec3 direction; ///< Direction (not necessarily normalized)
+		glm::vec3 invDirection; ///< Reciprocal of the direction (clamped away from zero)
+	};
+
+	/**
+	 * @brief Traversal stack entry.
+	 */
+	struct Entry
+	{
+		int32_t node; ///< Node index
+		float distance; ///< Entry distance along the ray
+	};
+
+
+	const Eng::Node* root; ///< Scene graph the hierarchy was built on
+	std::vector<Node4> node; ///< Top-level nodes (the root first), leaves point to instances
+	std::vector<Instance> instance; ///< Meshes, in leaf order
+	std::vector<std::unique_ptr<ShapeTree>> shape; ///< Triangle hierarchies, one per distinct shape
+	uint64_t nrOfFaces; ///< Triangles indexed by all the instances
+
+
+	/**
+	 * Constructor.
+	 */
+	Reserved() : root{nullptr}, nrOfFaces{0} {}
+
+
+	///////////////////
+	// Construction: //
+	///////////////////
+
+	/**
+	 * Surface area (halved) of a box.
+	 * @param min box min corner
+	 * @param max box max corner
+	 * @return area
+	 */
+	static float area(const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 d = glm::max(max - min, glm::vec3(0.0f));
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	/**
+	 * Computes the box of a range of primitives.
+	 * @param pmin primitive box min corners
+	 * @param pmax primitive box max corners
+	 * @param order primitive indices
+	 * @param count number of primitives
+	 * @param n node receiving the box
+	 */
+	static void bound(const glm::vec3* pmin, const glm::vec3* pmax, const uint32_t* order, uint32_t count, BuildNode& n)
+	{
+		n.min = glm::vec3(inf);
+		n.max = glm::vec3(-inf);
+		for (uint32_t c = 0; c < count; c++)
+		{
+			n.min = glm::min(n.min, pmin[order[c]]);
+			n.max = glm::max(n.max, pmax[order[c]]);
+		}
+	}
+
+	/**
+	 * Looks for the best split of a range of primitives according to the binned surface area heuristic, and partitions
+	 * the range accordingly. Ranges that do not fit into a leaf are always split (at the median if the heuristic gives
+	 * up, e.g., when all the centroids coincide or the tree gets too deep).
+	 * @param pmin primitive box min corners
+	 * @param pmax primitive box max corners
+	 * @param centroid primitive box centers
+	 * @param order primitive indices, partitioned in place
+	 * @param count number of primitives
+	 * @param n node of the range (with its box)
+	 * @param depth depth of the node
+	 * @param mid number of primitives going to the first child
+	 * @return true if the range is split, false if it becomes a leaf
+	 */
+	static bool split(const glm::vec3* pmin, const glm::vec3* pmax, const glm::vec3* centroid, uint32_t* order,
+	                  uint32_t count, const BuildNode& n, uint32_t depth, uint32_t& mid)
+	{
+		if (count <= 1)
+			return false;
+
+		glm::vec3 cmin(inf), cmax(-inf);
+		for (uint32_t c = 0; c < count; c++)
+		{
+			cmin = glm::min(cmin, centroid[order[c]]);
+			cmax = glm::max(cmax, centroid[order[c]]);
+		}
+
+		// Evaluate the bin boundaries on each axis (traversing a node costs as much as intersecting a primitive):
+		float bestCost = inf;
+		uint32_t bestAxis = 3, bestBin = 0;
+		if (depth < maxDepth)
+			for (uint32_t a = 0; a < 3; a++)
+			{
+				const float extent = cmax[a] - cmin[a];
+				if (!(extent > 0.0f))
+					continue;
+				const float scale = static_cast<float>(nrOfBins) / extent;
+
+				uint32_t binCount[nrOfBins] = {};
+				glm::vec3 binMin[nrOfBins], binMax[nrOfBins];
+				std::fill_n(binMin, nrOfBins, glm::vec3(inf));
+				std::fill_n(binMax, nrOfBins, glm::vec3(-inf));
+				for (uint32_t c = 0; c < count; c++)
+				{
+					const uint32_t p = order[c];
+					const uint32_t b = std::min(static_cast<uint32_t>((centroid[p][a] - cmin[a]) * scale), nrOfBins - 1);
+					binCount[b]++;
+					binMin[b] = glm::min(binMin[b], pmin[p]);
+					binMax[b] = glm::max(binMax[b], pmax[p]);
+				}
+
+				float rightCost[nrOfBins];
+				glm::vec3 accMin(inf), accMax(-inf);
+				uint32_t accCount = 0;
+				for (uint32_t b = nrOfBins - 1; b > 0; b--)
+				{
+					accMin = glm::min(accMin, binMin[b]);
+					accMax = glm::max(accMax, binMax[b]);
+					accCount += binCount[b];
+					rightCost[b] = accCount ? area(accMin, accMax) * accCount : 0.0f;
+				}
+				accMin = glm::vec3(inf);
+				accMax = glm::vec3(-inf);
+				accCount = 0;
+				for (uint32_t b = 1; b < nrOfBins; b++)
+				{
+					accMin = glm::min(accMin, binMin[b - 1]);
+					accMax = glm::max(accMax, binMax[b - 1]);
+					accCount += binCount[b - 1];
+					if (accCount == 0 || accCount == count)
+						continue;
+					const float cost = area(accMin, accMax) * accCount + rightCost[b];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = a;
+						bestBin = b;
+					}
+				}
+			}
+
+		const float parentArea = area(n.min, n.max);
+		if (count <= maxLeafSize && (bestAxis == 3 || parentArea + bestCost >= parentArea * count))
+			return false;
+
+		// Partition:
+		if (bestAxis < 3)
+		{
+			const float scale = static_cast<float>(nrOfBins) / (cmax[bestAxis] - cmin[bestAxis]);
+			const float base = cmin[bestAxis];
+			const uint32_t* split = std::partition(order, order + count, [&](uint32_t p)
+			{
+				return std::min(static_cast<uint32_t>((centroid[p][bestAxis] - base) * scale), nrOfBins - 1) < bestBin;
+			});
+			mid = static_cast<uint32_t>(split - order);
+			if (mid > 0 && mid < count)
+				return true;
+		}
+
+		// Median along the largest centroid extent:
+		const glm::vec3 extent = cmax - cmin;
+		const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		mid = count / 2;
+		std::nth_element(order, order + mid, order + count, [&](uint32_t p0, uint32_t p1)
+		{
+			return centroid[p0][axis] < centroid[p1][axis];
+		});
+		return true;
+	}
+
+	/**
+	 * Builds the binary subtree of a range of primitives, serially.
+	 * @param pmin primitive box min corners
+	 * @param pmax primitive box max corners
+	 * @param centroid primitive box centers
+	 * @param order primitive indices (all of them)
+	 * @param first first primitive of the range
+	 * @param count number of primitives of the range
+	 * @param depth depth of the subtree root
+	 * @param tree nodes, the subtree is appended to
+	 * @return subtree root index
+	 */
+	static uint32_t buildSubtree(const glm::vec3* pmin, const glm::vec3* pmax, const glm::vec3* centroid,
+	                             uint32_t* order, uint32_t first, uint32_t count, uint32_t depth,
+	                             std::vector<BuildNode>& tree)
+	{
+		const uint32_t index = static_cast<uint32_t>(tree.size());
+		tree.emplace_back();
+		bound(pmin, pmax, order + first, count, tree[index]);
+
+		uint32_t mid;
+		if (split(pmin, pmax, centroid, order + first, count, tree[index], depth, mid) == false)
+		{
+			tree[index].first = first;
+			tree[index].count = count;
+			return index;
+		}
+		const uint32_t left = buildSubtree(pmin, pmax, centroid, order, first, mid, depth + 1, tree);
+		const uint32_t right = buildSubtree(pmin, pmax, centroid, order, first + mid, count - mid, depth + 1, tree);
+		tree[index].left = left;
+		tree[index].right = right;
+		tree[index].count = 0;
+		return index;
+	}
+
+	/**
+	 * Builds the binary tree of a set of primitives. The top levels are split serially, until the ranges are small
+	 * enough, then the remaining subtrees are built in parallel through the ThreadPool and spliced in.
+	 * @param pmin primitive box min corners
+	 * @param pmax primitive box max corners
+	 * @param nrOfPrims number of primitives
+	 * @param order primitive indices, in leaf order
+	 * @param tree nodes (the root first)
+	 */
+	static void buildTree(const glm::vec3* pmin, const glm::vec3* pmax, uint32_t nrOfPrims,
+	                      std::vector<uint32_t>& order, std::vector<BuildNode>& tree)
+	{
+		tree.clear();
+		order.resize(nrOfPrims);
+		std::iota(order.begin(), order.end(), 0);
+		if (nrOfPrims == 0)
+			return;
+
+		std::vector<glm::vec3> centroid(nrOfPrims);
+		for (uint32_t c = 0; c < nrOfPrims; c++)
+			centroid[c] = (pmin[c] + pmax[c]) * 0.5f;
+
+		// Serial top levels:
+		struct Task
+		{
+			uint32_t node, first, count, depth;
+		};
+		std::vector<Task> task, pending;
+		pending.push_back({0, 0, nrOfPrims, 0});
+		tree.emplace_back();
+		while (pending.empty() == false)
+		{
+			const Task t = pending.back();
+			pending.pop_back();
+			if (t.count <= parallelThreshold)
+			{
+				task.push_back(t);
+				continue;
+			}
+
+			bound(pmin, pmax, order.data() + t.first, t.count, tree[t.node]);
+			uint32_t mid;
+			split(pmin, pmax, centroid.data(), order.data() + t.first, t.count, tree[t.node], t.depth, mid);
+			const uint32_t left = static_cast<uint32_t>(tree.size());
+			tree.emplace_back();
+			tree.emplace_back();
+			tree[t.node].left = left;
+			tree[t.node].right = left + 1;
+			tree[t.node].count = 0;
+			pending.push_back({left, t.first, mid, t.depth + 1});
+			pending.push_back({left + 1, t.first + mid, t.count - mid, t.depth + 1});
+		}
+
+		// Parallel subtrees:
+		std::vector<std::vector<BuildNode>> local(task.size());
+		Eng::ThreadPool::getInstance().parallelFor(task.size(), [&](uint64_t c)
+		{
+			buildSubtree(pmin, pmax, centroid.data(), order.data(), task[c].first, task[c].count, task[c].depth, local[c]);
+		});
+
+		// Splice (the local roots replace their placeholders):
+		for (uint32_t c = 0; c < task.size(); c++)
+		{
+			const uint32_t base = static_cast<uint32_t>(tree.size()) - 1;
+			auto remap = [&](uint32_t i) { return i == 0 ? task[c].node : base + i; };
+			for (uint32_t i = 0; i < local[c].size(); i++)
+			{
+				BuildNode n = local[c][i];
+				if (n.count == 0)
+				{
+					n.left = remap(n.left);
+					n.right = remap(n.right);
+				}
+				if (i == 0)
+					tree[task[c].node] = n;
+				else
+					tree.push_back(n);
+			}
+		}
+	}
+
+	/**
+	 * Collapses a binary subtree into 4-wide nodes, by repeatedly opening the inner child with the largest area.
+	 * Parents always precede their children.
+	 * @param tree binary tree
+	 * @param b binary subtree root
+	 * @param out 4-wide nodes, the subtree is appended to
+	 * @return index of the 4-wide subtree root
+	 */
+	static int32_t collapse(const std::vector<BuildNode>& tree, uint32_t b, std::vector<Node4>& out)
+	{
+		uint32_t slot[4];
+		uint32_t n = 0;
+		if (tree[b].count)
+			slot[n++] = b;
+		else
+		{
+			slot[n++] = tree[b].left;
+			slot[n++] = tree[b].right;
+			while (n < 4)
+			{
+				uint32_t best = n;
+				float bestArea = -1.0f;
+				for (uint32_t c = 0; c < n; c++)
+					if (tree[slot[c]].count == 0 && area(tree[slot[c]].min, tree[slot[c]].max) > bestArea)
+					{
+						best = c;
+						bestArea = area(tree[slot[c]].min, tree[slot[c]].max);
+					}
+				if (best == n)
+					break;
+				const uint32_t opened = slot[best];
+				slot[best] = tree[opened].left;
+				slot[n++] = tree[opened].right;
+			}
+		}
+
+		const int32_t index = static_cast<int32_t>(out.size());
+		out.emplace_back();
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			Node4& o = out[index];
+			if (c >= n)
+			{
+				o.minX[c] = o.minY[c] = o.minZ[c] = o.maxX[c] = o.maxY[c] = o.maxZ[c] = inf;
+				o.child[c] = -1;
+				o.count[c] = 0;
+				continue;
+			}
+			const BuildNode& s = tree[slot[c]];
+			o.minX[c] = s.min.x;
+			o.minY[c] = s.min.y;
+			o.minZ[c] = s.min.z;
+			o.maxX[c] = s.max.x;
+			o.maxY[c] = s.max.y;
+			o.maxZ[c] = s.max.z;
+			o.count[c] = s.count;
+			if (s.count)
+				o.child[c] = static_cast<int32_t>(s.first);
+			else
+			{
+				const int32_t child = collapse(tree, slot[c], out);
+				out[index].child[c] = child;
+			}
+		}
+		return index;
+	}
+
+	/**
+	 * Builds the triangle hierarchy of a shape. Triangles with out-of-range indices are skipped.
+	 * @param s shape
+	 * @param out triangle hierarchy
+	 */
+	static void buildShape(const Eng::Mesh::Shape& s, ShapeTree& out)
+	{
+		const uint32_t nrOfVertices = static_cast<uint32_t>(s.vertex.size());
+		std::vector<uint32_t> face;
+		std::vector<glm::vec3> pmin, pmax;
+		face.reserve(s.index.size() / 3);
+		pmin.reserve(s.index.size() / 3);
+		pmax.reserve(s.index.size() / 3);
+		out.min = glm::vec3(inf);
+		out.max = glm::vec3(-inf);
+		for (uint32_t f = 0; f < s.index.size() / 3; f++)
+		{
+			const uint32_t* i = s.index.data() + f * 3;
+			if (i[0] >= nrOfVertices || i[1] >= nrOfVertices || i[2] >= nrOfVertices)
+				continue;
+			const glm::vec3& a = s.vertex[i[0]];
+			const glm::vec3& b = s.vertex[i[1]];
+			const glm::vec3& c = s.vertex[i[2]];
+			face.push_back(f);
+			pmin.push_back(glm::min(a, glm::min(b, c)));
+			pmax.push_back(glm::max(a, glm::max(b, c)));
+			out.min = glm::min(out.min, pmin.back());
+			out.max = glm::max(out.max, pmax.back());
+		}
+		out.nrOfFaces = static_cast<uint32_t>(face.size());
+
+		std::vector<uint32_t> order;
+		std::vector<BuildNode> tree;
+		buildTree(pmin.data(), pmax.data(), out.nrOfFaces, order, tree);
+		out.node.clear();
+		out.packet.clear();
+		if (tree.empty())
+			return;
+		collapse(tree, 0, out.node);
+
+		// Pack the leaves:
+		for (Node4& n : out.node)
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				if (n.child[c] < 0 || n.count[c] == 0)
+					continue;
+				Tri4 p = {};
+				for (uint32_t l = 0; l < n.count[c]; l++)
+				{
+					const uint32_t f = face[order[n.child[c] + l]];
+					const uint32_t* i = s.index.data() + f * 3;
+					const glm::vec3& v0 = s.vertex[i[0]];
+					const glm::vec3 e1 = s.vertex[i[1]] - v0;
+					const glm::vec3 e2 = s.vertex[i[2]] - v0;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						p.v0[k][l] = v0[k];
+						p.e1[k][l] = e1[k];
+						p.e2[k][l] = e2[k];
+					}
+					p.face[l] = f;
+				}
+				n.child[c] = static_cast<int32_t>(out.packet.size());
+				out.packet.push_back(p);
+			}
+	}
+
+	/**
+	 * Collects the meshes of a subtree, with their world matrices, in depth-first order.
+	 * @param n subtree root
+	 * @param matrix world matrix of the subtree root
+	 * @param meshes meshes found
+	 * @param matrices their world matrices
+	 */
+	static void collect(const Eng::Node& n, const glm::mat4& matrix, std::vector<const Eng::Mesh*>& meshes,
+	                    std::vector<glm::mat4>& matrices)
+	{
+		const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(&n);
+		if (mesh && mesh != &Eng::Mesh::empty)
+		{
+			meshes.push_back(mesh);
+			matrices.push_back(matrix);
+		}
+		for (const Eng::Node& child : n.getListOfChildren())
+			collect(child, matrix * child.getMatrix(), meshes, matrices);
+	}
+
+	/**
+	 * Transforms a box, keeping it axis-aligned.
+	 * @param m matrix
+	 * @param min box min corner
+	 * @param max box max corner
+	 * @param outMin transformed box min corner
+	 * @param outMax transformed box max corner
+	 */
+	static void transformBox(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max, glm::vec3& outMin,
+	                         glm::vec3& outMax)
+	{
+		const glm::vec3 center = glm::vec3(m * glm::vec4((min + max) * 0.5f, 1.0f));
+		const glm::vec3 e = (max - min) * 0.5f;
+		const glm::vec3 extent = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y +
+		                         glm::abs(glm::vec3(m[2])) * e.z;
+		outMin = center - extent;
+		outMax = center + extent;
+	}
+
+	/**
+	 * Places an instance, given its world matrix.
+	 * @param i instance
+	 * @param matrix world matrix
+	 */
+	static void place(Instance& i, const glm::mat4& matrix)
+	{
+		i.matrix = matrix;
+		i.inverse = glm::inverse(matrix);
+		transformBox(matrix, i.localMin, i.localMax, i.min, i.max);
+	}
+
+	/**
+	 * Recomputes the boxes of the top-level nodes from the instance boxes, bottom-up.
+	 */
+	void refitNodes()
+	{
+		for (size_t c = node.size(); c-- > 0; )
+		{
+			Node4& n = node[c];
+			for (uint32_t s = 0; s < 4; s++)
+			{
+				if (n.child[s] < 0)
+					continue;
+				glm::vec3 min(inf), max(-inf);
+				if (n.count[s])
+					for (uint32_t i = 0; i < n.count[s]; i++)
+					{
+						min = glm::min(min, instance[n.child[s] + i].min);
+						max = glm::max(max, instance[n.child[s] + i].max);
+					}
+				else
+				{
+					const Node4& k = node[n.child[s]];
+					for (uint32_t t = 0; t < 4; t++)
+						if (k.child[t] >= 0)
+						{
+							min = glm::min(min, glm::vec3(k.minX[t], k.minY[t], k.minZ[t]));
+							max = glm::max(max, glm::vec3(k.maxX[t], k.maxY[t], k.maxZ[t]));
+						}
+				}
+				n.minX[s] = min.x;
+				n.minY[s] = min.y;
+				n.minZ[s] = min.z;
+				n.maxX[s] = max.x;
+				n.maxY[s] = max.y;
+				n.maxZ[s] = max.z;
+			}
+		}
+	}
+
+
+	//////////////
+	// Queries: //
+	//////////////
+
+	/**
+	 * Sets up a ray.
+	 * @param origin origin
+	 * @param direction direction
+	 * @return ray
+	 */
+	static Ray makeRay(const glm::vec3& origin, const glm::vec3& direction)
+	{
+		Ray r;
+		r.origin = origin;
+		r.direction = direction;
+		for (uint32_t c = 0; c < 3; c++)
+			r.invDirection[c] = 1.0f / (std::abs(direction[c]) > 1e-20f ? direction[c] : std::copysign(1e-20f, direction[c]));
+		return r;
+	}
+
+	/**
+	 * Tests a ray against the four children boxes of a node.
+	 * @param n node
+	 * @param r ray
+	 * @param maxDistance farthest distance accepted
+	 * @param distance entry distance of each child
+	 * @return mask of the children hit
+	 */
+	static uint32_t intersectNode(const Node4& n, const Ray& r, float maxDistance, float* distance)
+	{
+#ifdef ENG_BVH_SSE
+		const __m128 ox = _mm_set1_ps(r.origin.x), oy = _mm_set1_ps(r.origin.y), oz = _mm_set1_ps(r.origin.z);
+		const __m128 ix = _mm_set1_ps(r.invDirection.x), iy = _mm_set1_ps(r.invDirection.y);
+		const __m128 iz = _mm_set1_ps(r.invDirection.z);
+		const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minX), ox), ix);
+		const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxX), ox), ix);
+		const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minY), oy), iy);
+		const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxY), oy), iy);
+		const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minZ), oz), iz);
+		const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxZ), oz), iz);
+		const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+		                                _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+		const __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+		                               _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(maxDistance)));
+		_mm_storeu_ps(distance, tNear);
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+#else
+		uint32_t mask = 0;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const glm::vec3 t0 = (glm::vec3(n.minX[c], n.minY[c], n.minZ[c]) - r.origin) * r.invDirection;
+			const glm::vec3 t1 = (glm::vec3(n.maxX[c], n.maxY[c], n.maxZ[c]) - r.origin) * r.invDirection;
+			const glm::vec3 lo = glm::min(t0, t1);
+			const glm::vec3 hi = glm::max(t0, t1);
+			distance[c] = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+			if (distance[c] <= std::min(std::min(hi.x, hi.y), std::min(hi.z, maxDistance)))
+				mask |= 1u << c;
+		}
+		return mask;
+#endif
+	}
+
+	/**
+	 * Tests a ray against a box.
+	 * @param r ray
+	 * @param min box min corner
+	 * @param max box max corner
+	 * @param maxDistance farthest distance accepted
+	 * @param distance entry distance (0 if the origin is inside)
+	 * @return TF
+	 */
+	static bool intersectBox(const Ray& r, const glm::vec3& min, const glm::vec3& max, float maxDistance, float& distance)
+	{
+		const glm::vec3 t0 = (min - r.origin) * r.invDirection;
+		const glm::vec3 t1 = (max - r.origin) * r.invDirection;
+		const glm::vec3 lo = glm::min(t0, t1);
+		const glm::vec3 hi = glm::max(t0, t1);
+		distance = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+		return distance <= std::min(std::min(hi.x, hi.y), std::min(hi.z, maxDistance));
+	}
+
+	/**
+	 * Tests a ray against four triangles (Moller-Trumbore, both sides).
+	 * @param p triangles
+	 * @param r ray
+	 * @param maxDistance farthest distance accepted, updated with the closest hit
+	 * @param face triangle hit
+	 * @param barycentric barycentric coordinates of the hit
+	 * @return TF
+	 */
+	static bool intersectPacket(const Tri4& p, const Ray& r, float& maxDistance, uint32_t& face, glm::vec2& barycentric)
+	{
+		alignas(16) float t[4], u[4], v[4];
+		uint32_t mask;
+#ifdef ENG_BVH_SSE
+		const __m128 dx = _mm_set1_ps(r.direction.x), dy = _mm_set1_ps(r.direction.y), dz = _mm_set1_ps(r.direction.z);
+		const __m128 e1x = _mm_load_ps(p.e1[0]), e1y = _mm_load_ps(p.e1[1]), e1z = _mm_load_ps(p.e1[2]);
+		const __m128 e2x = _mm_load_ps(p.e2[0]), e2y = _mm_load_ps(p.e2[1]), e2z = _mm_load_ps(p.e2[2]);
+
+		const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+		const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		const __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		const __m128 tx = _mm_sub_ps(_mm_set1_ps(r.origin.x), _mm_load_ps(p.v0[0]));
+		const __m128 ty = _mm_sub_ps(_mm_set1_ps(r.origin.y), _mm_load_ps(p.v0[1]));
+		const __m128 tz = _mm_sub_ps(_mm_set1_ps(r.origin.z), _mm_load_ps(p.v0[2]));
+		const __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv);
+
+		const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+		const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+		const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+		const __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+		const __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+
+		const __m128 zero = _mm_setzero_ps();
+		__m128 valid = _mm_cmpneq_ps(det, zero);
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(uu, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(vv, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f)));
+		valid = _mm_and_ps(valid, _mm_cmpgt_ps(tt, zero));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(tt, _mm_set1_ps(maxDistance)));
+		mask = static_cast<uint32_t>(_mm_movemask_ps(valid));
+		if (mask == 0)
+			return false;
+		_mm_store_ps(t, tt);
+		_mm_store_ps(u, uu);
+		_mm_store_ps(v, vv);
+#else
+		mask = 0;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const glm::vec3 e1(p.e1[0][c], p.e1[1][c], p.e1[2][c]);
+			const glm::vec3 e2(p.e2[0][c], p.e2[1][c], p.e2[2][c]);
+			const glm::vec3 pv = glm::cross(r.direction, e2);
+			const float det = glm::dot(e1, pv);
+			if (det == 0.0f)
+				continue;
+			const float inv = 1.0f / det;
+			const glm::vec3 tv = r.origin - glm::vec3(p.v0[0][c], p.v0[1][c], p.v0[2][c]);
+			const glm::vec3 qv = glm::cross(tv, e1);
+			u[c] = glm::dot(tv, pv) * inv;
+			v[c] = glm::dot(r.direction, qv) * inv;
+			t[c] = glm::dot(e2, qv) * inv;
+			if (u[c] >= 0.0f && v[c] >= 0.0f && u[c] + v[c] <= 1.0f && t[c] > 0.0f && t[c] < maxDistance)
+				mask |= 1u << c;
+		}
+		if (mask == 0)
+			return false;
+#endif
+
+		uint32_t best = 4;
+		for (uint32_t c = 0; c < 4; c++)
+			if ((mask & (1u << c)) && (best == 4 || t[c] < t[best]))
+				best = c;
+		maxDistance = t[best];
+		face = p.face[best];
+		barycentric = glm::vec2(u[best], v[best]);
+		return true;
+	}
+
+	/**
+	 * Traverses a 4-wide hierarchy along a ray, visiting the closest children first.
+	 * @param tree nodes
+	 * @param r ray
+	 * @param maxDistance farthest distance accepted (updated by the leaf test)
+	 * @param any stop at the first hit
+	 * @param leaf leaf test, called with the first primitive, the number of primitives and maxDistance, returns TF
+	 * @return TF
+	 */
+	template <typename LeafTest>
+	static bool traverse(const std::vector<Node4>& tree, const Ray& r, float& maxDistance, bool any, LeafTest&& leaf)
+	{
+		if (tree.empty())
+			return false;
+
+		Entry stack[stackSize];
+		uint32_t top = 0;
+		stack[top++] = {0, 0.0f};
+		bool hit = false;
+		while (top)
+		{
+			const Entry e = stack[--top];
+			if (e.distance > maxDistance)
+				continue;
+			const Node4& n = tree[e.node];
+			alignas(16) float distance[4];
+			const uint32_t mask = intersectNode(n, r, maxDistance, distance);
+
+			Entry inner[4];
+			uint32_t nrOfInner = 0;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				if ((mask & (1u << c)) == 0 || n.child[c] < 0)
+					continue;
+				if (n.count[c])
+				{
+					if (leaf(static_cast<uint32_t>(n.child[c]), n.count[c], maxDistance))
+					{
+						hit = true;
+						if (any)
+							return true;
+					}
+				}
+				else
+					inner[nrOfInner++] = {n.child[c], distance[c]};
+			}
+
+			// Push the farthest first, so that the closest is visited next:
+			for (uint32_t c = 1; c < nrOfInner; c++)
+				for (uint32_t d = c; d > 0 && inner[d - 1].distance < inner[d].distance; d--)
+					std::swap(inner[d - 1], inner[d]);
+			for (uint32_t c = 0; c < nrOfInner && top < stackSize; c++)
+				stack[top++] = inner[c];
+		}
+		return hit;
+	}
+
+	/**
+	 * Casts a ray against the instances.
+	 * @param r ray (world coordinates, normalized direction)
+	 * @param maxDistance farthest distance accepted, updated with the closest hit
+	 * @param any stop at the first hit
+	 * @param hit closest hit (if not nullptr)
+	 * @return TF
+	 */
+	bool cast(const Ray& r, float& maxDistance, bool any, Eng::Bvh::Hit* hit) const
+	{
+		return traverse(node, r, maxDistance, any, [&](uint32_t first, uint32_t count, float& distance)
+		{
+			bool found = false;
+			for (uint32_t c = first; c < first + count; c++)
+			{
+				const Instance& i = instance[c];
+				if (i.shape == nullptr)
+				{
+					float d;
+					if (intersectBox(r, i.min, i.max, distance, d) && d < distance)
+					{
+						distance = d;
+						found = true;
+						if (hit)
+						{
+							hit->mesh = *i.mesh;
+							hit->face = Eng::Bvh::Hit::noFace;
+							hit->barycentric = glm::vec2(0.0f);
+						}
+						if (any)
+							return true;
+					}
+					continue;
+				}
+
+				// Mesh coordinates (the direction is not normalized, so that distances stay the same):
+				const Ray local = makeRay(glm::vec3(i.inverse * glm::vec4(r.origin, 1.0f)),
+				                          glm::vec3(i.inverse * glm::vec4(r.direction, 0.0f)));
+				const ShapeTree& s = *i.shape;
+				uint32_t face = Eng::Bvh::Hit::noFace;
+				glm::vec2 barycentric(0.0f);
+				if (traverse(s.node, local, distance, any, [&](uint32_t p, uint32_t, float& d)
+				{
+					return intersectPacket(s.packet[p], local, d, face, barycentric);
+				}))
+				{
+					found = true;
+					if (hit)
+					{
+						hit->mesh = *i.mesh;
+						hit->face = face;
+						hit->barycentric = barycentric;
+					}
+					if (any)
+						return true;
+				}
+			}
+			return found;
+		});
+	}
+
+	/**
+	 * Collects the instances whose box passes a test, visiting the nodes whose children boxes pass the same test.
+	 * @param test box test on four boxes at once, called with a node, returns the mask of the children passing it
+	 * @param boxTest box test on a single box, returns TF
+	 * @param meshes meshes found (appended)
+	 * @return number of meshes found
+	 */
+	template <typename NodeTest, typename BoxTest>
+	uint32_t overlap(NodeTest&& test, BoxTest&& boxTest, std::vector<std::reference_wrapper<const Eng::Mesh>>& meshes) const
+	{
+		if (node.empty())
+			return 0;
+
+		uint32_t found = 0;
+		int32_t stack[stackSize];
+		uint32_t top = 0;
+		stack[top++] = 0;
+		while (top)
+		{
+			const Node4& n = node[stack[--top]];
+			const uint32_t mask = test(n);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				if ((mask & (1u << c)) == 0 || n.child[c] < 0)
+					continue;
+				if (n.count[c] == 0)
+				{
+					if (top < stackSize)
+						stack[top++] = n.child[c];
+					continue;
+				}
+				for (uint32_t i = n.child[c]; i < n.child[c] + n.count[c]; i++)
+					if (boxTest(instance[i].min, instance[i].max))
+					{
+						meshes.push_back(*instance[i].mesh);
+						found++;
+					}
+			}
+		}
+		return found;
+	}
+};
+
+
+///////////////////////
+// BODY OF CLASS Bvh //
+///////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::Bvh::Bvh() : reserved(std::make_unique<Eng::Bvh::Reserved>())
+{
+	ENG_LOG_DETAIL("[+]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Move constructor.
+ */
+ENG_API Eng::Bvh::Bvh(Bvh&& other) : reserved(std::move(other.reserved))
+{
+	ENG_LOG_DETAIL("[M]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::Bvh::~Bvh()
+{
+	ENG_LOG_DETAIL("[-]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Builds the hierarchy over the meshes of a scene graph, with their current world matrices. Meshes with a shape (see
+ * Ovo::setShapeRetention()) are tested against their triangles, the others against their bounding box. The scene graph
+ * must outlive the hierarchy.
+ * @param root scene graph root
+ * @return TF
+ */
+bool ENG_API Eng::Bvh::build(const Eng::Node& root)
+{
+	// Safety net:
+	if (root == Eng::Node::empty)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	reset();
+	reserved->root = &root;
+	const uint64_t t0 = Eng::Timer::getInstance().getCounter();
+
+	// Meshes and their world matrices:
+	std::vector<const Eng::Mesh*> meshes;
+	std::vector<glm::mat4> matrices;
+	Reserved::collect(root, root.getMatrix(), meshes, matrices);
+
+	// Triangle hierarchies, one per distinct shape:
+	std::unordered_map<const Eng::Mesh::Shape*, uint32_t> shapeIndex;
+	std::vector<const Eng::Mesh::Shape*> shapes;
+	for (const Eng::Mesh* m : meshes)
+		if (m->getShape() && shapeIndex.emplace(m->getShape(), static_cast<uint32_t>(shapes.size())).second)
+			shapes.push_back(m->getShape());
+	reserved->shape.resize(shapes.size());
+	Eng::ThreadPool::getInstance().parallelFor(shapes.size(), [&](uint64_t c)
+	{
+		reserved->shape[c] = std::make_unique<Reserved::ShapeTree>();
+		Reserved::buildShape(*shapes[c], *reserved->shape[c]);
+	});
+
+	// Instances:
+	const uint32_t nrOfMeshes = static_cast<uint32_t>(meshes.size());
+	std::vector<Reserved::Instance> instance(nrOfMeshes);
+	std::vector<glm::vec3> pmin(nrOfMeshes), pmax(nrOfMeshes);
+	for (uint32_t c = 0; c < nrOfMeshes; c++)
+	{
+		Reserved::Instance& i = instance[c];
+		i.mesh = meshes[c];
+		i.source = c;
+		i.shape = nullptr;
+		if (meshes[c]->getShape())
+		{
+			const Reserved::ShapeTree* s = reserved->shape[shapeIndex[meshes[c]->getShape()]].get();
+			if (s->nrOfFaces)
+				i.shape = s;
+		}
+		i.localMin = i.shape ? i.shape->min : meshes[c]->getBBoxMin();
+		i.localMax = i.shape ? i.shape->max : meshes[c]->getBBoxMax();
+		Reserved::place(i, matrices[c]);
+		pmin[c] = i.min;
+		pmax[c] = i.max;
+		reserved->nrOfFaces += i.shape ? i.shape->nrOfFaces : 0;
+	}
+
+	// Top level:
+	std::vector<uint32_t> order;
+	std::vector<Reserved::BuildNode> tree;
+	Reserved::buildTree(pmin.data(), pmax.data(), nrOfMeshes, order, tree);
+	if (tree.empty() == false)
+		Reserved::collapse(tree, 0, reserved->node);
+	reserved->instance.resize(nrOfMeshes);
+	for (uint32_t c = 0; c < nrOfMeshes; c++)
+		reserved->instance[c] = instance[order[c]];
+
+	// Done:
+	const uint64_t t1 = Eng::Timer::getInstance().getCounter();
+	ENG_LOG_PLAIN("BVH built in %.1f ms (%u meshes, %u shapes, %llu triangles)", Eng::Timer::getInstance().getCounterDiff(t0, t1),
+	              nrOfMeshes, static_cast<uint32_t>(shapes.size()), reserved->nrOfFaces);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Updates the hierarchy after the node matrices changed: the world boxes of the meshes are recomputed, and the node
+ * boxes refitted bottom-up, without changing the tree topology. The queries get slower as the meshes move away from
+ * their position at build time; the hierarchy is rebuilt if meshes were added or removed.
+ * @return TF
+ */
+bool ENG_API Eng::Bvh::refit()
+{
+	// Safety net:
+	if (reserved->root == nullptr)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	std::vector<const Eng::Mesh*> meshes;
+	std::vector<glm::mat4> matrices;
+	meshes.reserve(reserved->instance.size());
+	matrices.reserve(reserved->instance.size());
+	Reserved::collect(*reserved->root, reserved->root->getMatrix(), meshes, matrices);
+	if (meshes.size() != reserved->instance.size())
+		return build(*reserved->root);
+	for (const Reserved::Instance& i : reserved->instance)
+		if (meshes[i.source] != i.mesh)
+			return build(*reserved->root);
+
+	Eng::ThreadPool::getInstance().parallelFor((reserved->instance.size() + parallelThreshold - 1) / parallelThreshold, [&](uint64_t c)
+	{
+		const size_t last = std::min(static_cast<size_t>((c + 1) * parallelThreshold), reserved->instance.size());
+		for (size_t i = c * parallelThreshold; i < last; i++)
+			Reserved::place(reserved->instance[i], matrices[reserved->instance[i].source]);
+	});
+	reserved->refitNodes();
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Empties the hierarchy.
+ */
+void ENG_API Eng::Bvh::reset()
+{
+	reserved->root = nullptr;
+	reserved->node.clear();
+	reserved->instance.clear();
+	reserved->shape.clear();
+	reserved->nrOfFaces = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of meshes indexed.
+ * @return number of meshes
+ */
+uint32_t ENG_API Eng::Bvh::getNrOfMeshes() const
+{
+	return static_cast<uint32_t>(reserved->instance.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of 4-wide nodes, at both levels.
+ * @return number of nodes
+ */
+uint32_t ENG_API Eng::Bvh::getNrOfNodes() const
+{
+	size_t nrOfNodes = reserved->node.size();
+	for (const std::unique_ptr<Reserved::ShapeTree>& s : reserved->shape)
+		nrOfNodes += s->node.size();
+	return static_cast<uint32_t>(nrOfNodes);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of triangles indexed, counting each mesh placement.
+ * @return number of triangles
+ */
+uint64_t ENG_API Eng::Bvh::getNrOfFaces() const
+{
+	return reserved->nrOfFaces;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Finds the closest mesh hit by a ray. Thread-safe (as long as the hierarchy is not modified).
+ * @param origin ray origin, in world coordinates
+ * @param direction ray direction (does not need to be normalized)
+ * @param hit closest hit
+ * @param maxDistance farthest distance accepted
+ * @return true if a mesh was hit, false otherwise
+ */
+bool ENG_API Eng::Bvh::rayCast(const glm::vec3& origin, const glm::vec3& direction, Hit& hit, float maxDistance) const
+{
+	// Safety net:
+	const float length = glm::length(direction);
+	if (!(length > 0.0f) || !(maxDistance > 0.0f))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	float distance = maxDistance;
+	Hit result;
+	if (reserved->cast(Reserved::makeRay(origin, direction / length), distance, false, &result) == false)
+		return false;
+
+	// Done:
+	result.distance = distance;
+	hit = result;
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tells whether any mesh is hit by a ray (e.g., for line-of-sight tests), stopping at the first hit found.
+ * Thread-safe (as long as the hierarchy is not modified).
+ * @param origin ray origin, in world coordinates
+ * @param direction ray direction (does not need to be normalized)
+ * @param maxDistance farthest distance accepted
+ * @return TF
+ */
+bool ENG_API Eng::Bvh::rayCastAny(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	// Safety net:
+	const float length = glm::length(direction);
+	if (!(length > 0.0f) || !(maxDistance > 0.0f))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Done:
+	float distance = maxDistance;
+	return reserved->cast(Reserved::makeRay(origin, direction / length), distance, true, nullptr);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Finds the meshes whose world bounding box overlaps a sphere. Thread-safe (as long as the hierarchy is not modified).
+ * @param center sphere center, in world coordinates
+ * @param radius sphere radius
+ * @param meshes meshes found (appended)
+ * @return number of meshes found
+ */
+uint32_t ENG_API Eng::Bvh::overlapSphere(const glm::vec3& center, float radius,
+                                         std::vector<std::reference_wrapper<const Eng::Mesh>>& meshes) const
+{
+	// Safety net:
+	if (!(radius >= 0.0f))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return 0;
+	}
+
+	const float radius2 = radius * radius;
+	auto boxTest = [&](const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 d = glm::max(glm::max(min - center, center - max), glm::vec3(0.0f));
+		return glm::dot(d, d) <= radius2;
+	};
+	return reserved->overlap([&](const Reserved::Node4& n)
+	{
+#ifdef ENG_BVH_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+		const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minX), cx), _mm_sub_ps(cx, _mm_load_ps(n.maxX))), zero);
+		const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minY), cy), _mm_sub_ps(cy, _mm_load_ps(n.maxY))), zero);
+		const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minZ), cz), _mm_sub_ps(cz, _mm_load_ps(n.maxZ))), zero);
+		const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(d2, _mm_set1_ps(radius2))));
+#else
+		uint32_t mask = 0;
+		for (uint32_t c = 0; c < 4; c++)
+			if (boxTest(glm::vec3(n.minX[c], n.minY[c], n.minZ[c]), glm::vec3(n.maxX[c], n.maxY[c], n.maxZ[c])))
+				mask |= 1u << c;
+		return mask;
+#endif
+	}, boxTest, meshes);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Finds the meshes whose world bounding box is inside or intersects a frustum. Thread-safe (as long as the hierarchy
+ * is not modified).
+ * @param viewProjMatrix view-projection matrix of the frustum
+ * @param meshes meshes found (appended)
+ * @return number of meshes found
+ */
+uint32_t ENG_API Eng::Bvh::overlapFrustum(const glm::mat4& viewProjMatrix,
+                                          std::vector<std::reference_wrapper<const Eng::Mesh>>& meshes) const
+{
+	// Frustum planes (Gribb-Hartmann, pointing inwards):
+	const glm::mat4 m = glm::transpose(viewProjMatrix);
+	const glm::vec4 plane[6] = {m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+
+	// A box is outside when its corner farthest along a plane normal is behind that plane:
+	auto boxTest = [&](const glm::vec3& min, const glm::vec3& max)
+	{
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			const glm::vec3 v(plane[p].x > 0.0f ? max.x : min.x, plane[p].y > 0.0f ? max.y : min.y,
+			                  plane[p].z > 0.0f ? max.z : min.z);
+			if (glm::dot(glm::vec3(plane[p]), v) + plane[p].w < 0.0f)
+				return false;
+		}
+		return true;
+	};
+	return reserved->overlap([&](const Reserved::Node4& n)
+	{
+#ifdef ENG_BVH_SSE
+		__m128 out = _mm_setzero_ps();
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			const __m128 x = _mm_load_ps(plane[p].x > 0.0f ? n.maxX : n.minX);
+			const __m128 y = _mm_load_ps(plane[p].y > 0.0f ? n.maxY : n.minY);
+			const __m128 z = _mm_load_ps(plane[p].z > 0.0f ? n.maxZ : n.minZ);
+			const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[p].x), x), _mm_mul_ps(_mm_set1_ps(plane[p].y), y)),
+			                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[p].z), z), _mm_set1_ps(plane[p].w)));
+			out = _mm_or_ps(out, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+		return static_cast<uint32_t>(~_mm_movemask_ps(out)) & 0xf;
+#else
+		uint32_t mask = 0;
+		for (uint32_t c = 0; c < 4; c++)
+			if (boxTest(glm::vec3(n.minX[c], n.minY[c], n.minZ[c]), glm::vec3(n.maxX[c], n.maxY[c], n.maxZ[c])))
+				mask |= 1u << c;
+		return mask;
+#endif
+	}, boxTest, meshes);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file		engine_bvh.h
+ * @brief	Bounding volume hierarchy for spatial queries over the scene
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Two-level bounding volume hierarchy over the meshes of a scene graph, for ray casting (e.g., picking, line of
+ * sight) and overlap queries. The top level bounds the meshes in world coordinates, and can be refitted when the node
+ * matrices change; the bottom level bounds the triangles of each mesh shape (see Mesh::getShape()), in mesh
+ * coordinates, and is shared among the meshes with the same shape. Both levels are built with the binned surface area
+ * heuristic, in parallel through the ThreadPool, and stored as 4-wide nodes that are tested with SSE, as are the
+ * triangles (four per leaf). Neither OpenGL nor the container are accessed.
+ */
+class ENG_API Bvh
+{
+	//////////
+public: //
+	//////////
+
+	// Consts:
+	static constexpr uint32_t maxLeafSize = 4; ///< Primitives per leaf (triangles are tested four at a time)
+	static constexpr uint32_t nrOfBins = 16; ///< Bins per axis evaluated by the surface area heuristic
+	static constexpr uint32_t parallelThreshold = 4096; ///< Primitives above which subtrees are built in parallel
+
+
+	/**
+	 * @brief Result of a ray cast.
+	 */
+	struct Hit
+	{
+		std::reference_wrapper<const Eng::Mesh> mesh; ///< Mesh hit
+		float distance; ///< Distance from the ray origin, in world units
+		uint32_t face; ///< Triangle hit, within the mesh shape (noFace if the mesh has no shape and its box was hit)
+		glm::vec2 barycentric; ///< Barycentric coordinates of the hit point, relative to the second and third vertex
+
+
+		// Consts:
+		static constexpr uint32_t noFace = 0xffffffff; ///< No triangle hit
+
+
+		/**
+		 * Constructor.
+		 */
+		Hit() : mesh{Eng::Mesh::empty}, distance{std::numeric_limits<float>::infinity()}, face{noFace}, barycentric{0.0f} {}
+	};
+
+
+	// Const/dest:
+	Bvh();
+	Bvh(Bvh&& other);
+	Bvh(Bvh const&) = delete;
+	~Bvh();
+
+	// Operators:
+	void operator=(Bvh const&) = delete;
+
+	// Construction:
+	bool build(const Eng::Node& root);
+	bool refit();
+	void reset();
+	uint32_t getNrOfMeshes() const;
+	uint32_t getNrOfNodes() const;
+	uint64_t getNrOfFaces() const;
+
+	// Queries:
+	bool rayCast(const glm::vec3& origin, const glm::vec3& direction, Hit& hit,
+	             float maxDistance = std::numeric_limits<float>::infinity()) const;
+	bool rayCastAny(const glm::vec3& origin, const glm::vec3& direction,
+	                float maxDistance = std::numeric_limits<float>::infinity()) const;
+	uint32_t overlapSphere(const glm::vec3& center, float radius,
+	                       std::vector<std::reference_wrapper<const Eng::Mesh>>& meshes) const;
+	uint32_t overlapFrustum(const glm::mat4& viewProjMatrix,
+	                        std::vector<std::reference_wrapper<const Eng::Mesh>>& meshes) const;
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct Reserved;
+	std::unique_ptr<Reserved> reserved;
+};
@@ -15,6 +15,10 @@
 
 // C/C++:
 #include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
 #include <variant>
 
 
@@ -42,10 +46,51 @@ struct Eng::Container::Reserved
 	std::list<Eng::Texture> allTextures;
 
 
+	/**
+	 * @brief Texture shared among materials.
+	 */
+	struct CachedTexture
+	{
+		std::reference_wrapper<Eng::Texture> texture; ///< Texture in allTextures
+		uint32_t refCount; ///< Number of current users
+		uint32_t nrOfHits; ///< Number of times it has been reused instead of loaded
+		uint64_t nrOfBytes; ///< Size in VRAM
+		double loadTime; ///< Time spent for loading and uploading it (ms)
+	};
+
+	std::map<std::string, CachedTexture> textureCache; ///< Shared textures, by key
+
+
+	/**
+	 * @brief Image being loaded in background.
+	 */
+	struct TextureRequest
+	{
+		std::string filename; ///< Image file name
+		std::string key; ///< Texture cache key
+		std::vector<std::pair<uint32_t, Eng::Texture::Type>> user; ///< Waiting materials (by ID) and slots
+		std::shared_ptr<const Eng::Bitmap> bitmap; ///< Loaded image (nullptr if error)
+		double loadTime; ///< Time spent loading the image (ms)
+	};
+
+	/**
+	 * @brief Requests completed by the loading jobs (shared with them, as they may outlive the container).
+	 */
+	struct TextureQueue
+	{
+		std::mutex mutex; ///< Protects the queue
+		std::deque<std::shared_ptr<TextureRequest>> ready; ///< Images ready for upload
+	};
+
+	bool asyncTextures; ///< Load material textures in background
+	std::map<std::string, std::shared_ptr<TextureRequest>> textureRequests; ///< Requests not uploaded yet, by key
+	std::shared_ptr<TextureQueue> textureQueue; ///< Completed requests
+
+
 	/**
 	 * Constructor.
 	 */
-	Reserved() {}
+	Reserved() : asyncTextures{false}, textureQueue{std::make_shared<TextureQueue>()} {}
 };
 
 
@@ -93,6 +138,10 @@ ENG_API Eng::Container::Container(Container&& other) : Eng::Object(std::move(oth
 ENG_API Eng::Container::~Container()
 {
 	ENG_LOG_DETAIL("[-]");
+
+	// Materials first, as they release their textures from the cache:
+	if (reserved)
+		reserved->allMaterials.clear();
 }
 
 
@@ -326,10 +375,16 @@ Eng::Object ENG_API& Eng::Container::find(const uint32_t id) const
  */
 bool ENG_API Eng::Container::reset()
 {
+	// Drop background texture requests:
+	Eng::ThreadPool::getInstance().wait();
+	reserved->textureRequests.clear();
+	reserved->textureQueue->ready.clear();
+
 	reserved->allNodes.clear();
 	reserved->allMeshes.clear();
 	reserved->allLights.clear();
 	reserved->allMaterials.clear();
+	reserved->textureCache.clear();
 	reserved->allTextures.clear();
 
 	// Done:
@@ -383,3 +438,296 @@ bool ENG_API Eng::Container::add(Eng::Object& obj)
 	ENG_LOG_ERROR("Unsupported type");
 	return false;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Builds the texture cache key of an image file: canonical path, size and last modification time. Two materials
+ * referencing the same file through different relative paths get the same key, while a file modified on disk gets a
+ * new one. Does not access the container, so it can be invoked from worker threads.
+ * @param filename image file name
+ * @return cache key (the file name itself if the file cannot be found)
+ */
+std::string ENG_API Eng::Container::getTextureKey(const std::string& filename)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::canonical(filename, error);
+	if (error)
+		return filename;
+	uint64_t size = std::filesystem::file_size(path, error);
+	if (error)
+		return filename;
+	auto time = std::filesystem::last_write_time(path, error);
+	if (error)
+		return filename;
+
+	// Done:
+	return path.string() + "|" + std::to_string(size) + "|" + std::to_string(time.time_since_epoch().count());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns, if existing, the cached texture with the given key, without taking a reference.
+ * @param key cache key (see getTextureKey())
+ * @return found texture or empty
+ */
+Eng::Texture ENG_API& Eng::Container::findTexture(const std::string& key) const
+{
+	auto it = reserved->textureCache.find(key);
+	if (it == reserved->textureCache.end())
+		return Eng::Texture::empty;
+
+	// Done:
+	return it->second.texture;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns, if existing, the cached texture with the given key and takes a reference to it.
+ * @param key cache key (see getTextureKey())
+ * @return found texture or empty (in this case, load it and use addTexture())
+ */
+Eng::Texture ENG_API& Eng::Container::acquireTexture(const std::string& key)
+{
+	auto it = reserved->textureCache.find(key);
+	if (it == reserved->textureCache.end())
+		return Eng::Texture::empty;
+
+	// Done:
+	it->second.refCount++;
+	it->second.nrOfHits++;
+	return it->second.texture;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Adds the given texture to the container and to the texture cache, with one reference taken.
+ * @param tex loaded texture (moved into the container)
+ * @param key cache key (see getTextureKey())
+ * @param nrOfBytes size of the texture in VRAM
+ * @param loadTime time spent for loading and uploading the texture (ms)
+ * @return the stored texture or empty if error
+ */
+Eng::Texture ENG_API& Eng::Container::addTexture(Eng::Texture& tex, const std::string& key, uint64_t nrOfBytes,
+                                                 double loadTime)
+{
+	// Safety net:
+	if (key.empty() || reserved->textureCache.count(key))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return Eng::Texture::empty;
+	}
+	if (add(tex) == false)
+		return Eng::Texture::empty;
+
+	// Done:
+	reserved->textureCache.emplace(key, Reserved::CachedTexture{getLastTexture(), 1, 0, nrOfBytes, loadTime});
+	return getLastTexture();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases a reference to a cached texture. The texture is removed from the container when no longer referenced.
+ * Invoked by materials when their textures are replaced or when they are destroyed.
+ * @param tex texture previously returned by acquireTexture() or addTexture()
+ * @return TF (false for textures not in the cache, e.g., loaded by hand)
+ */
+bool ENG_API Eng::Container::releaseTexture(const Eng::Texture& tex)
+{
+	for (auto it = reserved->textureCache.begin(); it != reserved->textureCache.end(); ++it)
+		if (&it->second.texture.get() == &tex)
+		{
+			if (--it->second.refCount == 0)
+			{
+				reserved->textureCache.erase(it);
+				reserved->allTextures.remove_if([&tex](const Eng::Texture& t) { return &t == &tex; });
+			}
+			return true;
+		}
+
+	// Not found:
+	return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Logs the content of the texture cache and the savings obtained by sharing textures among materials.
+ */
+void ENG_API Eng::Container::dumpTextureReport() const
+{
+	uint64_t refs = 0, hits = 0, totalBytes = 0, savedBytes = 0;
+	double savedTime = 0.0;
+	for (auto& c : reserved->textureCache)
+	{
+		refs += c.second.refCount;
+		hits += c.second.nrOfHits;
+		totalBytes += c.second.nrOfBytes;
+		savedBytes += c.second.nrOfBytes * c.second.nrOfHits;
+		savedTime += c.second.loadTime * c.second.nrOfHits;
+	}
+
+	// Done:
+	ENG_LOG_PLAIN("%llu cached texture(s), %llu reference(s), %llu byte(s) in VRAM", 
+	              static_cast<uint64_t>(reserved->textureCache.size()), refs, totalBytes);
+	ENG_LOG_PLAIN("%llu reuse(s), %llu byte(s) of VRAM and %.1f ms of loading saved", hits, savedBytes, savedTime);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables background loading of material textures. When disabled (default), textures are loaded
+ * synchronously and are set into the materials when the loader returns. When enabled, materials get their textures
+ * later, through processTextureRequests() (invoked by Base::swap() at each frame): applications loading scenes outside
+ * of a rendering loop must call it until getNrOfPendingTextures() returns 0.
+ * @param enable TF
+ */
+void ENG_API Eng::Container::setAsyncTextures(bool enable)
+{
+	reserved->asyncTextures = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when material textures are loaded in background.
+ * @return TF
+ */
+bool ENG_API Eng::Container::isAsyncTextures() const
+{
+	return reserved->asyncTextures;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Requests a texture for a material slot. The image is loaded by the ThreadPool, then uploaded by
+ * processTextureRequests() and set into the material, which meanwhile renders with the default texture. Requests for
+ * the same image are merged.
+ * @param mat material waiting for the texture (identified by its ID, so it can be moved into the container)
+ * @param type material slot
+ * @param filename image file name
+ * @param key cache key (see getTextureKey())
+ * @return TF
+ */
+bool ENG_API Eng::Container::requestTexture(const Eng::Material& mat, Eng::Texture::Type type,
+                                            const std::string& filename, const std::string& key)
+{
+	// Safety net:
+	if (mat == Eng::Material::empty || filename.empty() || key.empty())
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Already requested:
+	auto it = reserved->textureRequests.find(key);
+	if (it != reserved->textureRequests.end())
+	{
+		it->second->user.emplace_back(mat.getId(), type);
+		return true;
+	}
+
+	std::shared_ptr<Reserved::TextureRequest> request = std::make_shared<Reserved::TextureRequest>();
+	request->filename = filename;
+	request->key = key;
+	request->user.emplace_back(mat.getId(), type);
+	request->loadTime = 0.0;
+	reserved->textureRequests[key] = request;
+
+	// Load in background:
+	std::shared_ptr<Reserved::TextureQueue> queue = reserved->textureQueue;
+	Eng::ThreadPool::getInstance().submit([request, queue]()
+	{
+		Eng::Material::loadBitmap(request->filename, request->bitmap, request->loadTime);
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->ready.push_back(request);
+	});
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Uploads the textures loaded in background and sets them into the waiting materials. Invoked once per frame by
+ * Base::swap(), must be called from the OpenGL thread.
+ * @param maxNrOfUploads max number of textures uploaded by this call
+ * @return number of uploaded textures
+ */
+uint32_t ENG_API Eng::Container::processTextureRequests(uint32_t maxNrOfUploads)
+{
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint32_t nrOfUploads = 0;
+	while (nrOfUploads < maxNrOfUploads)
+	{
+		std::shared_ptr<Reserved::TextureRequest> request;
+		{
+			std::lock_guard<std::mutex> lock(reserved->textureQueue->mutex);
+			if (reserved->textureQueue->ready.empty())
+				break;
+			request = reserved->textureQueue->ready.front();
+			reserved->textureQueue->ready.pop_front();
+		}
+		reserved->textureRequests.erase(request->key);
+		if (request->bitmap == nullptr)
+			continue;
+
+		// Materials still existing:
+		std::vector<std::pair<Eng::Material*, Eng::Texture::Type>> user;
+		for (auto& u : request->user)
+		{
+			Eng::Material* mat = dynamic_cast<Eng::Material*>(&find(u.first));
+			if (mat)
+				user.emplace_back(mat, u.second);
+		}
+		if (user.empty())
+			continue;
+
+		// Upload:
+		const Eng::Bitmap& bitmap = *request->bitmap;
+		uint64_t nrOfBytes = 0;
+		for (uint32_t side = 0; side < bitmap.getNrOfSides(); side++)
+			for (uint32_t level = 0; level < bitmap.getNrOfLevels(); level++)
+				nrOfBytes += bitmap.getNrOfBytes(level, side);
+
+		uint64_t startTime = timer.getCounter();
+		Eng::Texture tex;
+		tex.setName(bitmap.getName());
+		tex.load(bitmap);
+		double loadTime = request->loadTime + timer.getCounterDiff(startTime, timer.getCounter());
+		std::reference_wrapper<Eng::Texture> _tex = addTexture(tex, request->key, nrOfBytes, loadTime);
+		nrOfUploads++;
+		if (_tex.get() == Eng::Texture::empty)
+			continue;
+
+		// First user holds the reference taken by addTexture():
+		for (uint32_t c = 0; c < user.size(); c++)
+		{
+			if (c > 0)
+				acquireTexture(request->key);
+			user[c].first->setTexture(_tex, user[c].second);
+		}
+	}
+
+	// Done:
+	if (nrOfUploads && reserved->textureRequests.empty())
+		ENG_LOG_DEBUG("All requested textures uploaded");
+	return nrOfUploads;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the number of textures requested and not uploaded yet.
+ * @return number of pending textures
+ */
+uint32_t ENG_API Eng::Container::getNrOfPendingTextures() const
+{
+	return static_cast<uint32_t>(reserved->textureRequests.size());
+}
@@ -18,6 +18,7 @@ public: //
 
 	// Special values:
 	static Container empty;
+	static constexpr uint32_t defaultMaxNrOfUploads = 4; ///< Default max number of texture uploads per frame
 
 
 	// Const/dest:   
@@ -47,6 +48,22 @@ public: //
 	Eng::Object& find(const std::string& name) const; ///< By name
 	Eng::Object& find(uint32_t id) const; ///< By ID
 
+	// Texture cache:
+	static std::string getTextureKey(const std::string& filename);
+	Eng::Texture& findTexture(const std::string& key) const;
+	Eng::Texture& acquireTexture(const std::string& key);
+	Eng::Texture& addTexture(Eng::Texture& tex, const std::string& key, uint64_t nrOfBytes, double loadTime);
+	bool releaseTexture(const Eng::Texture& tex);
+	void dumpTextureReport() const;
+
+	// Asynchronous texture loading:
+	void setAsyncTextures(bool enable);
+	bool isAsyncTextures() const;
+	bool requestTexture(const Eng::Material& mat, Eng::Texture::Type type, const std::string& filename,
+	                    const std::string& key);
+	uint32_t processTextureRequests(uint32_t maxNrOfUploads = defaultMaxNrOfUploads);
+	uint32_t getNrOfPendingTextures() const;
+
 
 	///////////
 private: //
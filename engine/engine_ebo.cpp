@@ -37,12 +37,13 @@ struct Eng::Ebo::Reserved
 {
 	GLuint oglId; ///< OpenGL shader ID
 	uint32_t nrOfFaces; ///< Nr. of faces
+	Eng::Ebo::Layout layout; ///< Buffer layout
 
 
 	/**
 	 * Constructor.
 	 */
-	Reserved() : oglId{0}, nrOfFaces{0} {}
+	Reserved() : oglId{0}, nrOfFaces{0}, layout{Eng::Ebo::Layout::standard} {}
 };
 
 
@@ -115,6 +116,17 @@ uint32_t ENG_API Eng::Ebo::getNrOfFaces() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the layout of the buffer.
+ * @return layout
+ */
+Eng::Ebo::Layout ENG_API Eng::Ebo::getLayout() const
+{
+	return reserved->layout;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Initializes an OpenGL EBO.
@@ -131,6 +143,7 @@ bool ENG_API Eng::Ebo::init()
 		glDeleteBuffers(1, &reserved->oglId);
 		reserved->oglId = 0;
 		reserved->nrOfFaces = 0;
+		reserved->layout = Layout::standard;
 	}
 
 	// Create it:		    
@@ -157,6 +170,7 @@ bool ENG_API Eng::Ebo::free()
 		glDeleteBuffers(1, &reserved->oglId);
 		reserved->oglId = 0;
 		reserved->nrOfFaces = 0;
+		reserved->layout = Layout::standard;
 	}
 
 	// Done:   
@@ -169,14 +183,22 @@ bool ENG_API Eng::Ebo::free()
  * Create element buffer by allocating the required storage.
  * @param nfOfFaces number of faces to store
  * @param data pointer to the data to copy into the buffer
+ * @param layout FaceData or CompactFaceData
  * @return TF
  */
-bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void* data)
+bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void* data, Layout layout)
 {
+	// Safety net:
+	if (layout != Layout::standard && layout != Layout::compact)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
 	// Init buffer:
 	if (!this->isInitialized())
 		this->init();
-	uint64_t size = nrOfFaces * sizeof(FaceData);
+	uint64_t size = nrOfFaces * static_cast<uint64_t>(layout == Layout::compact ? sizeof(CompactFaceData) : sizeof(FaceData));
 
 	// Create it:		              
 	const GLuint oglId = this->getOglHandle();
@@ -185,6 +207,32 @@ bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void* data)
 
 	// Done:
 	reserved->nrOfFaces = nrOfFaces;
+	reserved->layout = layout;
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reads back the content of the buffer (e.g., for exporting). The current bindings are not affected.
+ * @param data pointer to a destination of at least getNrOfFaces() * sizeof(FaceData) bytes (or CompactFaceData)
+ * @return TF
+ */
+bool ENG_API Eng::Ebo::read(void* data) const
+{
+	// Safety net:
+	if (data == nullptr || reserved->oglId == 0)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, reserved->oglId);
+	const uint64_t unitSize = reserved->layout == Layout::compact ? sizeof(CompactFaceData) : sizeof(FaceData);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(reserved->nrOfFaces * unitSize), data);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	// Done:
 	return true;
 }
 
@@ -35,6 +35,34 @@ public: //
 	};
 
 
+	/** 
+	 * @brief Per-face data, compact layout (for meshes with up to 65536 vertices).
+	 */
+	struct CompactFaceData
+	{
+		uint16_t a, b, c;
+
+
+		/**
+		 * Constructor. 
+		 */
+		inline CompactFaceData() noexcept : a{0}, b{0}, c{0} {}
+	};
+
+
+	/**
+	 * @brief Buffer layouts.
+	 */
+	enum class Layout : uint32_t
+	{
+		standard, ///< FaceData (32-bit indices)
+		compact, ///< CompactFaceData (16-bit indices)
+
+		// Terminator:
+		last
+	};
+
+
 	// Const/dest:
 	Ebo();
 	Ebo(Ebo&& other);
@@ -44,9 +72,11 @@ public: //
 	// Get/set:   
 	uint32_t getNrOfFaces() const;
 	uint32_t getOglHandle() const;
+	Layout getLayout() const;
 
 	// Data:
-	bool create(uint32_t nrOfFaces, const void* data = nullptr);
+	bool create(uint32_t nrOfFaces, const void* data = nullptr, Layout layout = Layout::standard);
+	bool read(void* data) const;
 
 	// Rendering methods:   
 	bool render(uint32_t value = 0, void* data = nullptr) const;
@@ -168,6 +168,24 @@ const glm::mat4 ENG_API& Eng::Light::getProjMatrix() const
  * @return TF
  */
 uint32_t ENG_API Eng::Light::loadChunk(Eng::Serializer& serial, void* data)
+{
+    Staging staging;
+    if (decodeChunk(serial, staging) == false)
+        return 0;
+
+    // Done:
+    return loadStaging(staging);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a light chunk into its CPU-side staging structure. Can be invoked from worker threads.
+ * @param serial serial data
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Light::decodeChunk(Eng::Serializer& serial, Staging& staging)
 {
     // Chunk header
     uint32_t chunkId;
@@ -175,31 +193,24 @@ uint32_t ENG_API Eng::Light::loadChunk(Eng::Serializer& serial, void* data)
     if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::light))
     {
         ENG_LOG_ERROR("Invalid chunk ID found");
-        return 0;
+        return false;
     }
     uint32_t chunkSize;
     serial.deserialize(&chunkSize, sizeof(uint32_t));
 
     // Node properties:       
-    std::string name;
-    serial.deserialize(name);
-    this->setName(name);
-
-    glm::mat4 matrix;
-    serial.deserialize(matrix);
-    this->setMatrix(matrix);
+    serial.deserialize(staging.name);
+    serial.deserialize(staging.matrix);
+    serial.deserialize(staging.nrOfChildren);
 
-    uint32_t nrOfChildren;
-    serial.deserialize(nrOfChildren);
-
-    std::string target;
+    std::string_view target;
     serial.deserialize(target);
 
     // Data:
     uint8_t subtype;
     serial.deserialize(subtype);
 
-    serial.deserialize(reserved->color);
+    serial.deserialize(staging.color);
     float radius;
     serial.deserialize(radius);
     glm::vec3 direction;
@@ -214,7 +225,55 @@ uint32_t ENG_API Eng::Light::loadChunk(Eng::Serializer& serial, void* data)
     serial.deserialize(isVolumetric);
 
     // Done:      
-    return nrOfChildren;
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes the light from a decoded chunk.
+ * @param staging decoded chunk
+ * @return number of children nodes
+ */
+uint32_t ENG_API Eng::Light::loadStaging(const Staging& staging)
+{
+    this->setName(staging.name);
+    this->setMatrix(staging.matrix);
+    reserved->color = staging.color;
+
+    // Done:      
+    return staging.nrOfChildren;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the light as a chunk. Properties not used by the engine are written with their OVO defaults (omni light).
+ * @param serial serial data
+ * @return TF
+ */
+bool ENG_API Eng::Light::saveChunk(Eng::Serializer& serial) const
+{
+    uint64_t chunkPosition = beginChunk(serial, Ovo::ChunkId::light);
+
+    // Node properties:
+    serial.serialize(this->getName());
+    serial.serialize(this->getMatrix());
+    serial.serialize(this->getNrOfChildren());
+    serial.serialize("[none]"); // Target
+
+    // Data:
+    serial.serialize(static_cast<uint8_t>(0)); // Subtype (omni)
+    serial.serialize(reserved->color);
+    serial.serialize(200.0f); // Radius
+    serial.serialize(glm::vec3(0.0f)); // Direction
+    serial.serialize(180.0f); // Cutoff
+    serial.serialize(0.0f); // Spot exponent
+    serial.serialize(static_cast<uint8_t>(1)); // Cast shadows
+    serial.serialize(static_cast<uint8_t>(0)); // Volumetric
+
+    // Done:
+    return endChunk(serial, chunkPosition);
 }
 
 
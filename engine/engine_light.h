@@ -19,6 +19,19 @@ public: //
 	// Special values:
 	static Light empty;
 
+
+	/**
+	 * @brief CPU-side content of a light chunk.
+	 */
+	struct Staging
+	{
+		std::string name; ///< Light name
+		glm::mat4 matrix; ///< Node matrix
+		uint32_t nrOfChildren; ///< Number of children nodes
+		glm::vec3 color; ///< Light color
+	};
+
+
 	// Const/dest:
 	Light();
 	Light(Light&& other);
@@ -41,6 +54,9 @@ public: //
 
 	// Ovo:   
 	uint32_t loadChunk(Eng::Serializer& serial, void* data = nullptr);
+	static bool decodeChunk(Eng::Serializer& serial, Staging& staging);
+	uint32_t loadStaging(const Staging& staging);
+	bool saveChunk(Eng::Serializer& serial) const override;
 
 
 	/////////////
@@ -13,6 +13,18 @@
 // Main include:
 #include "engine.h"
 
+// C/C++:
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// SIMD (x86 only, SSE is part of the x64 baseline):
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ENG_LIST_SSE
+#include <xmmintrin.h>
+#endif
+
 
 ////////////
 // STATIC //
@@ -21,6 +33,9 @@
 // Special values:
 Eng::List Eng::List::empty("[empty]");
 
+// LOD selection:
+float Eng::List::lodBias = 1.0f;
+
 
 /////////////////////////
 // RESERVED STRUCTURES //
@@ -31,14 +46,407 @@ Eng::List Eng::List::empty("[empty]");
  */
 struct Eng::List::Reserved
 {
+	/**
+	 * @brief Position of a bounding sphere with respect to the view frustum.
+	 */
+	enum class Side : uint8_t
+	{
+		outside, ///< Entirely outside (culled)
+		intersecting, ///< Crossing at least one plane (children must be tested)
+		inside, ///< Entirely inside (children are visible without further tests)
+	};
+
+	/**
+	 * @brief Node tracked by update(), in depth-first order.
+	 */
+	struct Tracked
+	{
+		const Eng::Node* node; ///< Node
+		uint32_t parent; ///< Index of the parent (unused for the root)
+		uint32_t end; ///< Index past the last descendant
+		int32_t elem; ///< Renderable element of the node (-1 if none)
+		glm::mat4 matrix; ///< World matrix
+	};
+
+	/**
+	 * @brief Level of detail selected for a mesh, with the pass it was selected in.
+	 */
+	struct PrevLod
+	{
+		uint32_t lod; ///< Level of detail
+		uint32_t pass; ///< Pass of the selection (see lodPass)
+	};
+
+	/**
+	 * @brief Visible part of a renderable element.
+	 */
+	struct Visibility
+	{
+		bool clustered; ///< TF when the element is restricted to the ranges below
+		std::vector<Eng::MeshOptimizer::FaceRange> range; ///< Visible triangle ranges
+	};
+
 	std::vector<Eng::List::RenderableElem> renderableElem; ///< List of rendering elements
 	uint32_t nrOfLights; ///< Number of lights in the list (lights come first)
 
+	// Culling:
+	std::vector<Visibility> visibility; ///< Per-element visibility (empty if cull() was not invoked)
+	Eng::List::CullingStats cullingStats; ///< Stats of the last culling pass
+
+	// LOD selection:
+	bool hasView; ///< TF when setView() was invoked
+	glm::mat4 viewMatrix; ///< Camera (also view) matrix
+	glm::mat4 projMatrix; ///< Projection matrix
+	std::unordered_map<uint32_t, PrevLod> prevLod; ///< LOD selected at the previous frame, by object ID
+	uint32_t lodPass; ///< Current pass, advanced by reset()
+	Eng::List::LodStats lodStats; ///< Stats of the LOD selection since the last reset()
+
+	// Frustum culling:
+	bool frustumCulling; ///< TF to skip the subtrees outside the view set by setView()
+	glm::vec4 plane[6]; ///< View frustum planes, in world coordinates (normalized, pointing inwards)
+	Eng::List::FrustumStats frustumStats; ///< Stats of the frustum culling since the last reset()
+
+	// Occlusion culling:
+	Eng::OcclusionBuffer occlusionBuffer; ///< Depth of the occluders selected by the last cullOccluded()
+	Eng::List::OcclusionStats occlusionStats; ///< Stats of the last occlusion culling pass
+
+	// Incremental updates:
+	std::vector<Tracked> tracked; ///< Nodes of the scene graph handled by update() (empty if not in use)
+	std::unordered_map<const Eng::Node*, uint32_t> trackedIndex; ///< Position of each tracked node
+	std::vector<const Eng::Node*> movedNode; ///< Nodes moved since the last update() (scratch)
+	std::vector<uint32_t> movedIndex; ///< Positions of the moved nodes (scratch)
+	glm::mat4 trackedMatrix; ///< Matrix preceding the root, passed to update()
+	uint64_t trackedRevision; ///< Node revision at the last update() (see Node::getRevision())
+	bool viewChanged; ///< TF when the view changed since the last update()
+	Eng::List::UpdateStats updateStats; ///< Stats of the last update()
+
 
 	/**
 	 * Constructor. 
 	 */
-	Reserved() : nrOfLights{0} {}
+	Reserved() : nrOfLights{0}, hasView{false}, viewMatrix{1.0f}, projMatrix{1.0f}, lodPass{0}, frustumCulling{false},
+	             trackedMatrix{1.0f}, trackedRevision{0}, viewChanged{false} {}
+
+	/**
+	 * Extracts the frustum planes of a view-projection matrix (Gribb-Hartmann).
+	 * @param viewProjMatrix projection matrix multiplied by the view matrix
+	 * @param plane six planes, normalized and pointing inwards (left, right, bottom, top, near, far)
+	 */
+	static void extractPlanes(const glm::mat4& viewProjMatrix, glm::vec4* plane)
+	{
+		const glm::mat4 m = glm::transpose(viewProjMatrix);
+		plane[0] = m[3] + m[0];
+		plane[1] = m[3] - m[0];
+		plane[2] = m[3] + m[1];
+		plane[3] = m[3] - m[1];
+		plane[4] = m[3] + m[2];
+		plane[5] = m[3] - m[2];
+		for (uint32_t c = 0; c < 6; c++)
+			plane[c] /= glm::length(glm::vec3(plane[c]));
+	}
+
+	/**
+	 * Classifies up to four bounding spheres against a frustum at once (SSE, one sphere per lane).
+	 * @param plane six frustum planes (see extractPlanes())
+	 * @param sphere spheres, as center and radius (world coordinates)
+	 * @param count number of spheres (1 to 4)
+	 * @param side position of each sphere
+	 */
+	static void classify(const glm::vec4* plane, const glm::vec4* sphere, uint32_t count, Side* side)
+	{
+#ifdef ENG_LIST_SSE
+		// Transpose into one register per component (unused lanes replicate the first sphere):
+		__m128 x = _mm_loadu_ps(&sphere[0].x);
+		__m128 y = _mm_loadu_ps(&sphere[count > 1 ? 1 : 0].x);
+		__m128 z = _mm_loadu_ps(&sphere[count > 2 ? 2 : 0].x);
+		__m128 r = _mm_loadu_ps(&sphere[count > 3 ? 3 : 0].x);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+		const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+		__m128 out = _mm_setzero_ps();
+		__m128 in = _mm_cmpeq_ps(r, r);
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[p].x), x), _mm_mul_ps(_mm_set1_ps(plane[p].y), y)),
+			                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[p].z), z), _mm_set1_ps(plane[p].w)));
+			out = _mm_or_ps(out, _mm_cmplt_ps(d, negR));
+			in = _mm_and_ps(in, _mm_cmpge_ps(d, r));
+		}
+		const int outMask = _mm_movemask_ps(out);
+		const int inMask = _mm_movemask_ps(in);
+		for (uint32_t c = 0; c < count; c++)
+			side[c] = (outMask >> c) & 1 ? Side::outside : ((inMask >> c) & 1 ? Side::inside : Side::intersecting);
+#else
+		for (uint32_t c = 0; c < count; c++)
+		{
+			side[c] = Side::inside;
+			for (uint32_t p = 0; p < 6; p++)
+			{
+				const float d = glm::dot(glm::vec3(plane[p]), glm::vec3(sphere[c])) + plane[p].w;
+				if (d < -sphere[c].w)
+				{
+					side[c] = Side::outside;
+					break;
+				}
+				if (d < sphere[c].w)
+					side[c] = Side::intersecting;
+			}
+		}
+#endif
+	}
+
+	/**
+	 * Tests whether the convex hull of two spheres lies entirely outside a frustum, i.e., whether both spheres are
+	 * outside the same plane.
+	 * @param plane six frustum planes (see extractPlanes())
+	 * @param first first sphere, as center and radius
+	 * @param second second sphere, as center and radius
+	 * @return TF
+	 */
+	static bool isHullOutside(const glm::vec4* plane, const glm::vec4& first, const glm::vec4& second)
+	{
+		for (uint32_t p = 0; p < 6; p++)
+			if (glm::dot(glm::vec3(plane[p]), glm::vec3(first)) + plane[p].w < -first.w &&
+			    glm::dot(glm::vec3(plane[p]), glm::vec3(second)) + plane[p].w < -second.w)
+				return true;
+
+		// Done:
+		return false;
+	}
+
+	/**
+	 * Transforms a bounding sphere into world coordinates.
+	 * @param center sphere center
+	 * @param radius sphere radius (possibly infinite)
+	 * @param matrix world matrix
+	 * @return sphere, as center and radius
+	 */
+	static glm::vec4 transformSphere(const glm::vec3& center, float radius, const glm::mat4& matrix)
+	{
+		if (std::isinf(radius) == false)
+			radius *= std::sqrt(std::max({glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+			                              glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+			                              glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))}));
+		return glm::vec4(glm::vec3(matrix * glm::vec4(center, 1.0f)), radius);
+	}
+
+	/**
+	 * Appends a node to the list, and then its subtree. With frustum culling, the children are classified four at a
+	 * time through their subtree bounds: subtrees outside the frustum are skipped, the ones inside are appended without
+	 * further tests.
+	 * @param node node
+	 * @param matrix node world matrix
+	 * @param side position of the node subtree bounds (Side::inside when not culling)
+	 * @return TF
+	 */
+	bool processNode(const Eng::Node& node, const glm::mat4& matrix, Side side)
+	{
+		RenderableElem re;
+		re.matrix = matrix;
+		re.reference = node;
+		frustumStats.nrOfVisitedNodes++;
+
+		// Store only renderable elements:
+		const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(&node);
+		if (dynamic_cast<const Eng::Light*>(&node)) // Lights first
+		{
+			renderableElem.insert(renderableElem.begin(), 1, re);
+			nrOfLights++;
+		}
+		else if (mesh) // Only meshes
+		{
+			// Own bounds, when tighter than the subtree ones:
+			Side meshSide = side;
+			if (side == Side::intersecting && node.getNrOfChildren())
+			{
+				glm::vec3 center(0.0f);
+				float radius;
+				if (mesh->getBoundingSphere(center, radius) == false)
+					radius = std::numeric_limits<float>::infinity();
+				const glm::vec4 sphere = transformSphere(center, radius, matrix);
+				classify(plane, &sphere, 1, &meshSide);
+			}
+
+			// Level of detail (meshes too small to be visible are dropped, but not their children):
+			if (meshSide == Side::outside)
+				frustumStats.nrOfCulledElems++;
+			else
+			{
+				frustumStats.nrOfVisibleElems++;
+				const float size = hasView ? projectedSize(*mesh, re.matrix) : std::numeric_limits<float>::infinity();
+				lodStats.nrOfFaces += mesh->getNrOfFaces();
+				if (size < Eng::List::smallFeatureSize)
+					lodStats.nrOfDroppedElems++;
+				else
+				{
+					re.lod = hasView ? selectLod(*mesh, size) : 0;
+					lodStats.nrOfSelectedFaces += mesh->getNrOfFaces(re.lod);
+					renderableElem.push_back(re);
+				}
+			}
+		}
+
+		// Parse hierarchy recursively:
+		if (side != Side::intersecting)
+		{
+			for (const Eng::Node& n : node.getListOfChildren())
+				if (processNode(n, matrix * n.getMatrix(), side) == false)
+					return false;
+			return true;
+		}
+
+		// Children in batches of four:
+		const Eng::Node* batch[4];
+		glm::mat4 batchMatrix[4];
+		glm::vec4 batchSphere[4];
+		uint32_t batchSize = 0;
+		auto flush = [&]() -> bool
+		{
+			Side batchSide[4];
+			classify(plane, batchSphere, batchSize, batchSide);
+			for (uint32_t c = 0; c < batchSize; c++)
+				if (batchSide[c] == Side::outside)
+				{
+					frustumStats.nrOfCulledNodes++;
+					frustumStats.nrOfCulledElems += batch[c]->getSubtreeBounds().nrOfMeshes;
+				}
+				else if (processNode(*batch[c], batchMatrix[c], batchSide[c]) == false)
+					return false;
+			batchSize = 0;
+			return true;
+		};
+		for (const Eng::Node& n : node.getListOfChildren())
+		{
+			const Eng::Node::Bounds& bounds = n.getSubtreeBounds();
+			if (bounds.radius < 0.0f) // Nothing to render
+				continue;
+			batch[batchSize] = &n;
+			batchMatrix[batchSize] = matrix * n.getMatrix();
+			batchSphere[batchSize] = transformSphere(bounds.center, bounds.radius, batchMatrix[batchSize]);
+			if (++batchSize == 4 && flush() == false)
+				return false;
+		}
+
+		// Done:
+		return batchSize == 0 || flush();
+	}
+
+	/**
+	 * Computes the projected size of a mesh bounding sphere, as its radius over half the screen height.
+	 * @param mesh mesh
+	 * @param matrix mesh world matrix
+	 * @return projected size (infinite when the camera is inside the sphere, or when the mesh has no bounds)
+	 */
+	float projectedSize(const Eng::Mesh& mesh, const glm::mat4& matrix) const
+	{
+		// Sphere around the pivot, or around the box when the radius is not available:
+		glm::vec3 center(0.0f);
+		float radius = mesh.getRadius();
+		if (radius <= 0.0f)
+		{
+			center = 0.5f * (mesh.getBBoxMin() + mesh.getBBoxMax());
+			radius = 0.5f * glm::length(mesh.getBBoxMax() - mesh.getBBoxMin());
+		}
+		if (radius <= 0.0f)
+			return std::numeric_limits<float>::infinity();
+		const glm::mat4 modelview = viewMatrix * matrix;
+		radius *= std::sqrt(std::max({glm::dot(glm::vec3(modelview[0]), glm::vec3(modelview[0])),
+		                              glm::dot(glm::vec3(modelview[1]), glm::vec3(modelview[1])),
+		                              glm::dot(glm::vec3(modelview[2]), glm::vec3(modelview[2]))}));
+
+		// Orthographic projections do not depend on the distance:
+		if (projMatrix[3][3] == 1.0f)
+			return radius * projMatrix[1][1];
+
+		// Distance from the eye (not depth, so that turning the camera does not switch LODs):
+		const float distance = glm::length(glm::vec3(modelview * glm::vec4(center, 1.0f)));
+		if (distance <= radius)
+			return std::numeric_limits<float>::infinity();
+		return radius * projMatrix[1][1] / distance;
+	}
+
+	/**
+	 * Selects the level of detail of a mesh. Each level covers half of the projected size of the previous one, and the
+	 * level drawn at the previous frame is kept until the size moves past it by more than the hysteresis.
+	 * @param mesh mesh
+	 * @param size projected size
+	 * @return level of detail
+	 */
+	uint32_t selectLod(const Eng::Mesh& mesh, float size)
+	{
+		const uint32_t nrOfLods = mesh.getNrOfLods();
+		if (nrOfLods < 2)
+			return 0;
+
+		const float target = std::clamp(std::log2(Eng::List::lodReference * Eng::List::lodBias / size), 0.0f,
+		                                static_cast<float>(nrOfLods - 1));
+		uint32_t lod = static_cast<uint32_t>(target);
+		auto prev = prevLod.find(mesh.getId());
+		if (prev != prevLod.end() && prev->second.lod < nrOfLods)
+		{
+			const float level = static_cast<float>(prev->second.lod);
+			if (target >= level - Eng::List::lodHysteresis && target < level + 1.0f + Eng::List::lodHysteresis)
+				lod = prev->second.lod;
+		}
+		prevLod[mesh.getId()] = {lod, lodPass};
+
+		// Done:
+		return lod;
+	}
+
+	/**
+	 * Appends a node and its subtree to the tracked nodes, with their world matrices.
+	 * @param node node
+	 * @param parent index of the parent
+	 * @param matrix node world matrix
+	 */
+	void track(const Eng::Node& node, uint32_t parent, const glm::mat4& matrix)
+	{
+		const uint32_t index = static_cast<uint32_t>(tracked.size());
+		tracked.push_back({&node, parent, 0, -1, matrix});
+		for (const Eng::Node& n : node.getListOfChildren())
+			track(n, index, matrix * n.getMatrix());
+		tracked[index].end = static_cast<uint32_t>(tracked.size());
+	}
+
+	/**
+	 * Recomputes the world matrices of a tracked node and of its descendants, and patches their elements.
+	 * @param index position of the node
+	 */
+	void refresh(uint32_t index)
+	{
+		const uint32_t end = tracked[index].end;
+		for (uint32_t c = index; c < end; c++)
+		{
+			Tracked& t = tracked[c];
+			t.matrix = (c ? tracked[t.parent].matrix : trackedMatrix) * t.node->getMatrix();
+			if (t.elem < 0)
+				continue;
+			RenderableElem& re = renderableElem[t.elem];
+			re.matrix = t.matrix;
+			if (static_cast<uint32_t>(t.elem) >= nrOfLights && viewChanged == false) // Otherwise done for all later
+				updateLod(re);
+			updateStats.nrOfUpdatedElems++;
+		}
+		updateStats.nrOfUpdatedNodes += end - index;
+	}
+
+	/**
+	 * Selects the level of detail of a mesh element for the current view, and keeps the LOD stats up to date.
+	 * @param re mesh element
+	 * @return TF if the level of detail changed
+	 */
+	bool updateLod(RenderableElem& re)
+	{
+		const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+		const uint32_t lod = hasView ? selectLod(mesh, projectedSize(mesh, re.matrix)) : 0;
+		if (lod == re.lod)
+			return false;
+		lodStats.nrOfSelectedFaces += mesh.getNrOfFaces(lod);
+		lodStats.nrOfSelectedFaces -= mesh.getNrOfFaces(re.lod);
+		re.lod = lod;
+		return true;
+	}
 };
 
 
@@ -89,12 +497,104 @@ ENG_API Eng::List::~List()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Reset internal list.
+ * Reset internal list. The LOD history of the meshes not selected since the previous reset() is dropped.
  */
 void ENG_API Eng::List::reset()
 {
+	for (auto prev = reserved->prevLod.begin(); prev != reserved->prevLod.end(); )
+		if (prev->second.pass != reserved->lodPass)
+			prev = reserved->prevLod.erase(prev);
+		else
+			++prev;
+	reserved->lodPass++;
+
 	reserved->renderableElem.clear();
 	reserved->nrOfLights = 0;
+	reserved->visibility.clear();
+	reserved->cullingStats = CullingStats();
+	reserved->lodStats = LodStats();
+	reserved->frustumStats = FrustumStats();
+	reserved->occlusionStats = OcclusionStats();
+	reserved->tracked.clear();
+	reserved->trackedIndex.clear();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the camera used by process() to select the level of detail of the meshes, to drop the ones too small to be
+ * visible and, when enabled, for frustum culling. The view is kept across reset(), and must be updated each time the
+ * camera changes.
+ * @param cameraMatrix camera (also view) matrix (must be already inverted)
+ * @param projMatrix camera projection matrix
+ * @return TF
+ */
+bool ENG_API Eng::List::setView(const glm::mat4& cameraMatrix, const glm::mat4& projMatrix)
+{
+	// Safety net:
+	if (projMatrix[1][1] <= 0.0f)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	if (reserved->hasView == false || reserved->viewMatrix != cameraMatrix || reserved->projMatrix != projMatrix)
+		reserved->viewChanged = true;
+	reserved->viewMatrix = cameraMatrix;
+	reserved->projMatrix = projMatrix;
+	reserved->hasView = true;
+
+	// Frustum planes, in world coordinates:
+	Reserved::extractPlanes(projMatrix * cameraMatrix, reserved->plane);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Removes the view set by setView(), so that process() keeps all the meshes at LOD 0. The LOD history is cleared.
+ */
+void ENG_API Eng::List::resetView()
+{
+	reserved->hasView = false;
+	reserved->prevLod.clear();
+	reserved->viewChanged = true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the statistics of the LOD selection performed since the last reset().
+ * @return LOD stats
+ */
+const Eng::List::LodStats ENG_API& Eng::List::getLodStats() const
+{
+	return reserved->lodStats;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the global LOD bias, shared by all the lists. Values greater than 1 select coarser LODs, smaller values finer
+ * ones.
+ * @param bias LOD bias
+ */
+void ENG_API Eng::List::setLodBias(float bias)
+{
+	lodBias = std::max(bias, 0.0f);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the global LOD bias.
+ * @return LOD bias
+ */
+float ENG_API Eng::List::getLodBias()
+{
+	return lodBias;
 }
 
 
@@ -144,7 +644,9 @@ const Eng::List::RenderableElem ENG_API& Eng::List::getRenderableElem(uint32_t e
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Recursively parse the scenegraph starting at the given node and append the parsed elements to this list. 
+ * Recursively parse the scenegraph starting at the given node and append the parsed elements to this list. With frustum
+ * culling enabled (see setFrustumCulling()), subtrees entirely outside the view are skipped through their bounds (see
+ * Node::getSubtreeBounds()), and so are the meshes outside the view. Lights are never culled.
  * @param node starting node
  * @param prevMatrix previous node matrix
  * @return TF
@@ -158,29 +660,471 @@ bool ENG_API Eng::List::process(const Eng::Node& node, const glm::mat4& prevMatr
 		return false;
 	}
 
-	RenderableElem re;
-	re.matrix = prevMatrix * node.getMatrix();
-	re.reference = node;
+	// Previous culling results are no longer aligned with the elements, and update() has to start over:
+	reserved->visibility.clear();
+	reserved->tracked.clear();
 
-	// Store only renderable elements:
-	if (dynamic_cast<const Eng::Light*>(&node)) // Lights first
+	// Whole subtree outside the view?
+	const glm::mat4 matrix = prevMatrix * node.getMatrix();
+	Reserved::Side side = Reserved::Side::inside;
+	if (reserved->frustumCulling && reserved->hasView)
 	{
-		reserved->renderableElem.insert(reserved->renderableElem.begin(), 1, re);
-		reserved->nrOfLights++;
+		const Eng::Node::Bounds& bounds = node.getSubtreeBounds();
+		if (bounds.radius < 0.0f) // Nothing to render
+			return true;
+		const glm::vec4 sphere = Reserved::transformSphere(bounds.center, bounds.radius, matrix);
+		Reserved::classify(reserved->plane, &sphere, 1, &side);
+		if (side == Reserved::Side::outside)
+		{
+			reserved->frustumStats.nrOfCulledNodes++;
+			reserved->frustumStats.nrOfCulledElems += bounds.nrOfMeshes;
+			return true;
+		}
 	}
-	else if (dynamic_cast<const Eng::Mesh*>(&node)) // Only meshes
-		reserved->renderableElem.push_back(re);
 
-	// Parse hierarchy recursively:
-	for (auto& n : node.getListOfChildren())
-		if (process(n, re.matrix) == false)
-			return false;
+	// Done:
+	return reserved->processNode(node, matrix, side);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Keeps the list in sync with a scene graph across frames, as an alternative to reset() followed by process(). The
+ * first call (or the first one after reset(), process(), cullOccluded(), a change of the hierarchy or a different
+ * starting node) lists all the lights and meshes of the scene graph; the next ones only recompute the world matrices of
+ * the subtrees moved since (see Node::getMovedNodes(), or Node::getSubtreeRevision() after too many changes) and patch
+ * their elements in place, so that a mostly static scene costs in proportion to the nodes that changed. Meshes are
+ * neither frustum culled nor dropped as too small; their level of detail is selected for the view set by setView(),
+ * again for all of them when the view changed.
+ * @param node starting node
+ * @param prevMatrix previous node matrix
+ * @return TF
+ */
+bool ENG_API Eng::List::update(const Eng::Node& node, const glm::mat4& prevMatrix)
+{
+	// Safety net:
+	if (node == Eng::Node::empty)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	Reserved& r = *reserved;
+	r.updateStats = UpdateStats();
+	const uint64_t revision = Eng::Node::getRevision();
+
+	// Rebuild, when the elements no longer match the scene graph:
+	if (r.tracked.empty() || r.tracked[0].node != &node || r.trackedMatrix != prevMatrix ||
+	    node.getHierarchyRevision() > r.trackedRevision)
+	{
+		reset();
+		r.track(node, 0, prevMatrix * node.getMatrix());
+		for (uint32_t c = static_cast<uint32_t>(r.tracked.size()); c-- > 0; ) // Lights first, as in process()
+			if (dynamic_cast<const Eng::Light*>(r.tracked[c].node))
+			{
+				r.tracked[c].elem = static_cast<int32_t>(r.renderableElem.size());
+				r.renderableElem.emplace_back();
+				r.renderableElem.back().reference = *r.tracked[c].node;
+				r.renderableElem.back().matrix = r.tracked[c].matrix;
+			}
+		r.nrOfLights = static_cast<uint32_t>(r.renderableElem.size());
+		for (Reserved::Tracked& t : r.tracked)
+			if (const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(t.node))
+			{
+				t.elem = static_cast<int32_t>(r.renderableElem.size());
+				r.renderableElem.emplace_back();
+				RenderableElem& re = r.renderableElem.back();
+				re.reference = *mesh;
+				re.matrix = t.matrix;
+				r.lodStats.nrOfFaces += mesh->getNrOfFaces();
+				r.lodStats.nrOfSelectedFaces += mesh->getNrOfFaces();
+				r.updateLod(re);
+			}
+		r.trackedIndex.clear();
+		for (uint32_t c = 0; c < r.tracked.size(); c++)
+			r.trackedIndex[r.tracked[c].node] = c;
+		r.trackedMatrix = prevMatrix;
+		r.trackedRevision = revision;
+		r.viewChanged = false;
+		r.updateStats.nrOfVisitedNodes = r.updateStats.nrOfUpdatedNodes = static_cast<uint32_t>(r.tracked.size());
+		r.updateStats.nrOfUpdatedElems = static_cast<uint32_t>(r.renderableElem.size());
+		r.updateStats.rebuilt = true;
+		return true;
+	}
+
+	// Subtrees moved since the last update, found through the moved nodes when available (parents precede children):
+	r.movedNode.clear();
+	if (Eng::Node::getMovedNodes(r.trackedRevision, r.movedNode) && r.movedNode.size() < r.tracked.size())
+	{
+		r.movedIndex.clear();
+		for (const Eng::Node* n : r.movedNode)
+		{
+			auto i = r.trackedIndex.find(n);
+			if (i != r.trackedIndex.end() && r.tracked[i->second].node->getMatrixRevision() > r.trackedRevision)
+				r.movedIndex.push_back(i->second);
+		}
+		r.updateStats.nrOfVisitedNodes = static_cast<uint32_t>(r.movedNode.size());
+		std::sort(r.movedIndex.begin(), r.movedIndex.end());
+		uint32_t end = 0;
+		for (uint32_t c : r.movedIndex)
+			if (c >= end) // Not refreshed along with an ancestor already
+			{
+				r.refresh(c);
+				end = r.tracked[c].end;
+			}
+	}
+
+	// Otherwise, through the subtree revisions:
+	else
+		for (uint32_t c = 0; c < r.tracked.size(); )
+		{
+			const Reserved::Tracked& t = r.tracked[c];
+			r.updateStats.nrOfVisitedNodes++;
+			if (t.node->getSubtreeRevision() <= r.trackedRevision)
+				c = t.end;
+			else if (t.node->getMatrixRevision() <= r.trackedRevision)
+				c++;
+			else
+			{
+				r.refresh(c);
+				c = t.end;
+			}
+		}
+
+	// New view, new levels of detail:
+	if (r.viewChanged)
+	{
+		for (uint32_t c = r.nrOfLights; c < r.renderableElem.size(); c++)
+			if (r.updateLod(r.renderableElem[c]))
+				r.updateStats.nrOfUpdatedElems++;
+		r.viewChanged = false;
+	}
+	r.trackedRevision = revision;
+
+	// Previous culling results no longer apply to the patched elements:
+	if (r.updateStats.nrOfUpdatedElems)
+		r.visibility.clear();
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the statistics of the last update() call.
+ * @return update stats
+ */
+const Eng::List::UpdateStats ENG_API& Eng::List::getUpdateStats() const
+{
+	return reserved->updateStats;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Selects the visible meshlets of the clustered meshes in the list, to be drawn with Pass::visibleMeshes. Meshes are
+ * processed in parallel through the ThreadPool. Must be invoked again after the list or the camera change.
+ * @param cameraMatrix camera (also view) matrix (must be already inverted)
+ * @param projMatrix camera projection matrix
+ * @param coneCulling TF to also cull back-facing meshlets (only valid if back faces are not visible)
+ * @return TF
+ */
+bool ENG_API Eng::List::cull(const glm::mat4& cameraMatrix, const glm::mat4& projMatrix, bool coneCulling)
+{
+	const size_t nrOfElems = reserved->renderableElem.size();
+	reserved->visibility.resize(nrOfElems);
+
+	std::vector<CullingStats> stats(nrOfElems);
+	Eng::ThreadPool::getInstance().parallelFor(nrOfElems, [&](uint64_t c)
+	{
+		Reserved::Visibility& v = reserved->visibility[c];
+		v.clustered = false;
+		v.range.clear();
+		const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(&reserved->renderableElem[c].reference.get());
+		if (mesh == nullptr || mesh->getMeshlets(reserved->renderableElem[c].lod).empty())
+			return;
+
+		// Mirroring transforms flip the winding, so the normal cones can't be trusted:
+		const std::vector<Eng::MeshOptimizer::Meshlet>& meshlet = mesh->getMeshlets(reserved->renderableElem[c].lod);
+		const glm::mat4 modelview = cameraMatrix * reserved->renderableElem[c].matrix;
+		const bool mirrored = glm::determinant(glm::mat3(modelview)) < 0.0f;
+		const glm::vec3 viewPosition = glm::vec3(glm::inverse(modelview)[3]);
+		stats[c].nrOfMeshlets = static_cast<uint32_t>(meshlet.size());
+		stats[c].nrOfVisibleMeshlets = Eng::MeshOptimizer::cullMeshlets(meshlet.data(), stats[c].nrOfMeshlets,
+		                                                                projMatrix * modelview, viewPosition,
+		                                                                coneCulling && !mirrored, v.range);
+		stats[c].nrOfFaces = meshlet.back().firstFace + meshlet.back().nrOfFaces;
+		for (const Eng::MeshOptimizer::FaceRange& r : v.range)
+			stats[c].nrOfVisibleFaces += r.nrOfFaces;
+		v.clustered = true;
+	});
+
+	// Totals:
+	reserved->cullingStats = CullingStats();
+	for (const CullingStats& s : stats)
+	{
+		reserved->cullingStats.nrOfMeshlets += s.nrOfMeshlets;
+		reserved->cullingStats.nrOfVisibleMeshlets += s.nrOfVisibleMeshlets;
+		reserved->cullingStats.nrOfFaces += s.nrOfFaces;
+		reserved->cullingStats.nrOfVisibleFaces += s.nrOfVisibleFaces;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the statistics of the last culling pass.
+ * @return culling stats
+ */
+const Eng::List::CullingStats ENG_API& Eng::List::getCullingStats() const
+{
+	return reserved->cullingStats;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Removes from the list the meshes hidden behind large occluders, as seen from the view set by setView(). The occluders
+ * (the meshes designated through Mesh::setOccluder(), followed by the ones with the largest projected size) are
+ * rasterized into a low-resolution CPU depth buffer (see OcclusionBuffer), then the bounding box of each mesh is tested
+ * against it, in parallel through the ThreadPool. Only meshes with a CPU-side shape (see Mesh::getShape()) can occlude.
+ * Must be invoked after process() and before cull(), whose results are discarded. No OpenGL context is required.
+ * @param maxNrOfOccluders max number of occluders selected by projected size (designated ones are always used)
+ * @return TF
+ */
+bool ENG_API Eng::List::cullOccluded(uint32_t maxNrOfOccluders)
+{
+	// Safety net:
+	if (reserved->hasView == false)
+	{
+		ENG_LOG_ERROR("View not set");
+		return false;
+	}
+
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	const uint64_t t0 = timer.getCounter();
+	reserved->occlusionStats = OcclusionStats();
+	reserved->visibility.clear();
+	const glm::mat4 viewProjMatrix = reserved->projMatrix * reserved->viewMatrix;
+	const uint32_t nrOfElems = static_cast<uint32_t>(reserved->renderableElem.size());
+
+	// Occluders, designated first, then by decreasing projected size:
+	std::vector<uint32_t> occluder;
+	std::vector<std::pair<float, uint32_t>> candidate;
+	for (uint32_t c = reserved->nrOfLights; c < nrOfElems; c++)
+	{
+		const RenderableElem& re = reserved->renderableElem[c];
+		const Eng::Mesh& mesh = dynamic_cast<const Eng::Mesh&>(re.reference.get());
+		if (mesh.getShape() == nullptr || mesh.getShape()->index.empty())
+			continue;
+		if (mesh.isOccluder())
+			occluder.push_back(c);
+		else
+		{
+			const float size = reserved->projectedSize(mesh, re.matrix);
+			if (size >= Eng::List::occluderSize)
+				candidate.push_back({size, c});
+		}
+	}
+	const size_t nrOfCandidates = std::min(candidate.size(), static_cast<size_t>(maxNrOfOccluders));
+	std::partial_sort(candidate.begin(), candidate.begin() + nrOfCandidates, candidate.end(),
+	                  [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+	for (size_t c = 0; c < nrOfCandidates; c++)
+		occluder.push_back(candidate[c].second);
+
+	// Rasterization:
+	Eng::OcclusionBuffer& buffer = reserved->occlusionBuffer;
+	buffer.clear();
+	for (uint32_t c : occluder)
+	{
+		const RenderableElem& re = reserved->renderableElem[c];
+		const Eng::Mesh::Shape& shape = *dynamic_cast<const Eng::Mesh&>(re.reference.get()).getShape();
+		buffer.addOccluder(viewProjMatrix * re.matrix, shape.vertex.data(), static_cast<uint32_t>(shape.vertex.size()),
+		                   shape.index.data(), static_cast<uint32_t>(shape.index.size() / 3));
+	}
+	buffer.rasterize();
+	reserved->occlusionStats.nrOfOccluders = static_cast<uint32_t>(occluder.size());
+	reserved->occlusionStats.nrOfOccluderFaces = buffer.getNrOfFaces();
+	const uint64_t t1 = timer.getCounter();
+
+	// Tests, in batches of meshes:
+	constexpr uint32_t batchSize = 64;
+	const uint32_t nrOfMeshes = nrOfElems - reserved->nrOfLights;
+	std::vector<uint8_t> visible(nrOfMeshes, 1);
+	if (occluder.empty() == false)
+		Eng::ThreadPool::getInstance().parallelFor((nrOfMeshes + batchSize - 1) / batchSize, [&](uint64_t b)
+		{
+			const uint32_t first = static_cast<uint32_t>(b) * batchSize;
+			for (uint32_t c = first; c < std::min(first + batchSize, nrOfMeshes); c++)
+			{
+				const RenderableElem& re = reserved->renderableElem[reserved->nrOfLights + c];
+				const Eng::Mesh& mesh = dynamic_cast<const Eng::Mesh&>(re.reference.get());
+				if (mesh.getBBoxMin() != mesh.getBBoxMax()) // Boxes not available are kept
+					visible[c] = buffer.isVisible(viewProjMatrix * re.matrix, mesh.getBBoxMin(), mesh.getBBoxMax());
+			}
+		});
+
+	// Compaction (order is preserved, update() has to start over):
+	reserved->tracked.clear();
+	uint32_t next = reserved->nrOfLights;
+	for (uint32_t c = 0; c < nrOfMeshes; c++)
+		if (visible[c])
+			reserved->renderableElem[next++] = reserved->renderableElem[reserved->nrOfLights + c];
+	reserved->renderableElem.resize(next);
+	reserved->occlusionStats.nrOfTestedElems = nrOfMeshes;
+	reserved->occlusionStats.nrOfCulledElems = nrOfElems - next;
+
+	// Done:
+	const uint64_t t2 = timer.getCounter();
+	reserved->occlusionStats.rasterTime = timer.getCounterDiff(t0, t1);
+	reserved->occlusionStats.testTime = timer.getCounterDiff(t1, t2);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the statistics of the last occlusion culling pass.
+ * @return occlusion culling stats
+ */
+const Eng::List::OcclusionStats ENG_API& Eng::List::getOcclusionStats() const
+{
+	return reserved->occlusionStats;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the depth buffer rasterized by the last cullOccluded(), e.g., for debugging.
+ * @return occlusion buffer
+ */
+const Eng::OcclusionBuffer ENG_API& Eng::List::getOcclusionBuffer() const
+{
+	return reserved->occlusionBuffer;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Selects the meshes of the list that can cast a shadow from the given light, i.e., whose bounding sphere intersects
+ * the light frustum. With receiver culling, also the meshes whose shadow cannot reach the view set by setView() are
+ * skipped: the shadow of a mesh is bounded by the hull of its sphere and of the same sphere extruded away from the
+ * light up to the light far plane. Only the world matrices of the list and the mesh bounds are used (no OpenGL context
+ * required).
+ * @param lightMatrix light world matrix
+ * @param lightProjMatrix light projection matrix (perspective or orthographic)
+ * @param casters indices of the selected elements, to be drawn with render()
+ * @param receiverCulling TF to skip the meshes whose shadow falls outside the view (ignored if no view is set)
+ * @return TF
+ */
+bool ENG_API Eng::List::selectCasters(const glm::mat4& lightMatrix, const glm::mat4& lightProjMatrix,
+                                      std::vector<uint32_t>& casters, bool receiverCulling) const
+{
+	casters.clear();
+
+	// Light frustum (the far plane points towards the light):
+	glm::vec4 plane[6];
+	Reserved::extractPlanes(lightProjMatrix * glm::inverse(lightMatrix), plane);
+	const bool perspective = lightProjMatrix[2][3] != 0.0f;
+	const glm::vec3 lightPos = glm::vec3(lightMatrix[3]);
+	const glm::vec3 lightDir = -glm::vec3(plane[5]);
+	const float farDistance = glm::dot(glm::vec3(plane[5]), lightPos) + plane[5].w;
+	receiverCulling = receiverCulling && reserved->hasView;
+
+	// Meshes, in batches of four:
+	const uint32_t nrOfElems = static_cast<uint32_t>(reserved->renderableElem.size());
+	for (uint32_t c = reserved->nrOfLights; c < nrOfElems; c += 4)
+	{
+		const uint32_t count = std::min(4u, nrOfElems - c);
+		glm::vec4 sphere[4];
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const RenderableElem& re = reserved->renderableElem[c + i];
+			glm::vec3 center(0.0f);
+			float radius;
+			if (dynamic_cast<const Eng::Mesh&>(re.reference.get()).getBoundingSphere(center, radius) == false)
+				radius = std::numeric_limits<float>::infinity();
+			sphere[i] = Reserved::transformSphere(center, radius, re.matrix);
+		}
+		Reserved::Side side[4];
+		Reserved::classify(plane, sphere, count, side);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (side[i] == Reserved::Side::outside)
+				continue;
+
+			// Shadow outside the view?
+			if (receiverCulling)
+			{
+				const glm::vec3 center = glm::vec3(sphere[i]);
+				glm::vec4 extruded;
+				if (perspective)
+				{
+					const glm::vec3 offset = center - lightPos;
+					const float distance = glm::length(offset);
+					const float cosAngle = glm::dot(offset, lightDir) / distance;
+					if (distance <= sphere[i].w || cosAngle <= 0.0f) // Light inside or beside the mesh
+					{
+						casters.push_back(c + i);
+						continue;
+					}
+					const float scale = std::max(1.0f, farDistance / (cosAngle * distance));
+					extruded = glm::vec4(lightPos + offset * scale, sphere[i].w * scale);
+				}
+				else
+					extruded = glm::vec4(center + lightDir * std::max(0.0f, glm::dot(glm::vec3(plane[5]), center) + plane[5].w),
+					                     sphere[i].w);
+				if (Reserved::isHullOutside(reserved->plane, sphere[i], extruded))
+					continue;
+			}
+			casters.push_back(c + i);
+		}
+	}
 
 	// Done:
 	return true;
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the frustum culling performed by process() against the view set by setView(). Disabled by
+ * default, as lists rendered from other viewpoints (e.g., shadow passes) need the meshes outside the camera frustum.
+ * @param enable TF
+ */
+void ENG_API Eng::List::setFrustumCulling(bool enable)
+{
+	reserved->frustumCulling = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when process() performs frustum culling.
+ * @return TF
+ */
+bool ENG_API Eng::List::isFrustumCulling() const
+{
+	return reserved->frustumCulling;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the statistics of the frustum culling performed since the last reset().
+ * @return frustum culling stats
+ */
+const Eng::List::FrustumStats ENG_API& Eng::List::getFrustumStats() const
+{
+	return reserved->frustumStats;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Parse the list and call the render method of each renderable.
@@ -207,16 +1151,53 @@ bool ENG_API Eng::List::render(const glm::mat4& cameraMatrix, Eng::List::Pass pa
 
 		/////////////////////
 	case Pass::meshes: //
+	case Pass::visibleMeshes: //
 		startRange = reserved->nrOfLights;
 		break;
 	}
 
 	// Iterate through the range:
+	const bool culled = pass == Pass::visibleMeshes && reserved->visibility.size() == reserved->renderableElem.size();
 	for (size_t c = startRange; c < endRange; c++)
 	{
 		RenderableElem& re = reserved->renderableElem.at(c);
 		glm::mat4 finalMatrix = cameraMatrix * re.matrix;
-		re.reference.get().render(0, &finalMatrix);
+		if (culled && reserved->visibility[c].clustered)
+		{
+			if (reserved->visibility[c].range.empty() == false)
+				dynamic_cast<const Eng::Mesh&>(re.reference.get()).render(re.lod, finalMatrix, reserved->visibility[c].range);
+		}
+		else
+			re.reference.get().render(re.lod, &finalMatrix);
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Renders a subset of the elements of the list (e.g., the shadow casters returned by selectCasters()), at the LOD
+ * selected by process().
+ * @param cameraMatrix camera (also view) matrix (must be already inverted)
+ * @param elems indices of the elements to render
+ * @return TF
+ */
+bool ENG_API Eng::List::render(const glm::mat4& cameraMatrix, const std::vector<uint32_t>& elems) const
+{
+	for (uint32_t c : elems)
+	{
+		// Safety net:
+		if (c >= reserved->renderableElem.size())
+		{
+			ENG_LOG_ERROR("Invalid params");
+			return false;
+		}
+
+		const RenderableElem& re = reserved->renderableElem[c];
+		glm::mat4 finalMatrix = cameraMatrix * re.matrix;
+		re.reference.get().render(re.lod, &finalMatrix);
 	}
 
 	// Done:
@@ -19,6 +19,13 @@ public: //
 	// Special values:
 	static List empty;
 
+	// Consts:
+	static constexpr float lodReference = 0.5f; ///< Projected size (radius over half the screen height) drawn at LOD 0
+	static constexpr float lodHysteresis = 0.15f; ///< Extra levels to cross before switching LOD (avoids popping)
+	static constexpr float smallFeatureSize = 0.002f; ///< Projected size below which meshes are dropped
+	static constexpr uint32_t defaultNrOfOccluders = 16; ///< Meshes selected as occluders by cullOccluded()
+	static constexpr float occluderSize = 0.1f; ///< Projected size below which meshes are not selected as occluders
+
 
 	/**
 	 * @brief Types of rendering passes. 
@@ -31,6 +38,7 @@ public: //
 		all,
 		lights,
 		meshes,
+		visibleMeshes, ///< Meshes, restricted to the meshlets selected by cull()
 
 		// Terminator:
 		last
@@ -44,12 +52,105 @@ public: //
 	{
 		std::reference_wrapper<const Eng::Object> reference; ///< Reference to the original object
 		glm::mat4 matrix; ///< Final position in world coordinates     
+		uint32_t lod; ///< Level of detail to draw (meshes only)
 
 
 		/**
 		 * Constructor. 
 		 */
-		RenderableElem() : reference{Eng::Object::empty}, matrix{1.0f} {}
+		RenderableElem() : reference{Eng::Object::empty}, matrix{1.0f}, lod{0} {}
+	};
+
+
+	/**
+	 * @brief Statistics of the last culling pass.
+	 */
+	struct CullingStats
+	{
+		uint32_t nrOfMeshlets; ///< Meshlets tested
+		uint32_t nrOfVisibleMeshlets; ///< Meshlets passing the test
+		uint64_t nrOfFaces; ///< Triangles of the clustered meshes
+		uint64_t nrOfVisibleFaces; ///< Triangles submitted for the clustered meshes
+
+
+		/**
+		 * Constructor.
+		 */
+		CullingStats() : nrOfMeshlets{0}, nrOfVisibleMeshlets{0}, nrOfFaces{0}, nrOfVisibleFaces{0} {}
+	};
+
+
+	/**
+	 * @brief Statistics of the LOD selection performed by the last process() calls.
+	 */
+	struct LodStats
+	{
+		uint64_t nrOfFaces; ///< Triangles of the processed meshes at LOD 0
+		uint64_t nrOfSelectedFaces; ///< Triangles of the processed meshes at the selected LOD
+		uint32_t nrOfDroppedElems; ///< Meshes dropped as too small
+
+
+		/**
+		 * Constructor.
+		 */
+		LodStats() : nrOfFaces{0}, nrOfSelectedFaces{0}, nrOfDroppedElems{0} {}
+	};
+
+
+	/**
+	 * @brief Statistics of the frustum culling performed by the last process() calls.
+	 */
+	struct FrustumStats
+	{
+		uint32_t nrOfVisitedNodes; ///< Nodes traversed
+		uint32_t nrOfCulledNodes; ///< Subtrees skipped as entirely outside the frustum
+		uint32_t nrOfVisibleElems; ///< Meshes inside or intersecting the frustum
+		uint32_t nrOfCulledElems; ///< Meshes outside the frustum, including the ones in skipped subtrees
+
+
+		/**
+		 * Constructor.
+		 */
+		FrustumStats() : nrOfVisitedNodes{0}, nrOfCulledNodes{0}, nrOfVisibleElems{0}, nrOfCulledElems{0} {}
+	};
+
+
+	/**
+	 * @brief Statistics of the last occlusion culling pass.
+	 */
+	struct OcclusionStats
+	{
+		uint32_t nrOfOccluders; ///< Meshes rasterized as occluders
+		uint64_t nrOfOccluderFaces; ///< Occluder triangles rasterized (after clipping)
+		uint32_t nrOfTestedElems; ///< Meshes tested
+		uint32_t nrOfCulledElems; ///< Meshes removed as hidden
+		double rasterTime; ///< Time spent selecting and rasterizing the occluders, in milliseconds
+		double testTime; ///< Time spent testing and removing the meshes, in milliseconds
+
+
+		/**
+		 * Constructor.
+		 */
+		OcclusionStats() : nrOfOccluders{0}, nrOfOccluderFaces{0}, nrOfTestedElems{0}, nrOfCulledElems{0},
+		                   rasterTime{0.0}, testTime{0.0} {}
+	};
+
+
+	/**
+	 * @brief Statistics of the last update() call.
+	 */
+	struct UpdateStats
+	{
+		uint32_t nrOfVisitedNodes; ///< Nodes checked for changes
+		uint32_t nrOfUpdatedNodes; ///< Nodes whose world matrix was recomputed
+		uint32_t nrOfUpdatedElems; ///< Elements patched with a new matrix or level of detail
+		bool rebuilt; ///< TF when the elements were rebuilt from scratch
+
+
+		/**
+		 * Constructor.
+		 */
+		UpdateStats() : nrOfVisitedNodes{0}, nrOfUpdatedNodes{0}, nrOfUpdatedElems{0}, rebuilt{false} {}
 	};
 
 
@@ -63,14 +164,38 @@ public: //
 	const std::vector<Eng::List::RenderableElem>& getRenderableElems() const;
 	const Eng::List::RenderableElem& getRenderableElem(uint32_t elemNr) const;
 
+	// LOD selection:
+	bool setView(const glm::mat4& cameraMatrix, const glm::mat4& projMatrix);
+	void resetView();
+	const LodStats& getLodStats() const;
+	static void setLodBias(float bias);
+	static float getLodBias();
+
 	// Scene graph traversal:
 	void reset();
 	bool process(const Eng::Node& node, const glm::mat4& prevMatrix = glm::mat4(1.0f));
+	bool update(const Eng::Node& node, const glm::mat4& prevMatrix = glm::mat4(1.0f));
+	const UpdateStats& getUpdateStats() const;
 	uint32_t getNrOfRenderableElems() const;
 	uint32_t getNrOfLights() const;
 
+	// Culling:
+	void setFrustumCulling(bool enable);
+	bool isFrustumCulling() const;
+	const FrustumStats& getFrustumStats() const;
+	bool cull(const glm::mat4& cameraMatrix, const glm::mat4& projMatrix, bool coneCulling = true);
+	const CullingStats& getCullingStats() const;
+	bool cullOccluded(uint32_t maxNrOfOccluders = defaultNrOfOccluders);
+	const OcclusionStats& getOcclusionStats() const;
+	const Eng::OcclusionBuffer& getOcclusionBuffer() const;
+
+	// Shadow casters:
+	bool selectCasters(const glm::mat4& lightMatrix, const glm::mat4& lightProjMatrix, std::vector<uint32_t>& casters,
+	                   bool receiverCulling = false) const;
+
 	// Rendering:   
 	bool render(const glm::mat4& cameraMatrix, Pass pass = Pass::all) const;
+	bool render(const glm::mat4& cameraMatrix, const std::vector<uint32_t>& elems) const;
 
 
 	/////////////
@@ -81,6 +206,9 @@ protected: //
 	struct Reserved;
 	std::unique_ptr<Reserved> reserved;
 
+	// LOD selection:
+	static float lodBias;
+
 	// Const/dest:
 	List(const std::string& name);
 
@@ -122,7 +122,7 @@ bool ENG_API Eng::Log::free()
  * @param fileName name of the file invoking the log
  * @param functionName name of the function invoking the log
  * @param text message, with custom series of params
- * @warning race conditions when run concurrently
+ * @warning lazy initialization is not thread-safe: log at least once from the main thread before using workers
  */
 bool ENG_API Eng::Log::log(level lvl, const char* fileName, const char* functionName, int32_t codeLine,
                            const char* text, ...)
@@ -185,6 +185,9 @@ bool ENG_API Eng::Log::log(level lvl, const char* fileName, const char* function
 	if (lvl > Eng::Log::debugLvl)
 		return returnMessage;
 
+	// Serialize output (messages can come from worker threads):
+	std::lock_guard<std::recursive_mutex> lock(staticReserved->mutex);
+
 	// To file:
 	staticReserved->outputFile << prefix << buffer << std::endl;
 
@@ -25,7 +25,8 @@
 
 
 /**
- * @brief Logging facilities. Static components are lazy-loaded at first usage. Beware that it is not thread-safe yet.
+ * @brief Logging facilities. Static components are lazy-loaded at first usage. Output is serialized, but the lazy
+ * initialization is not thread-safe.
  */
 class ENG_API Log
 {
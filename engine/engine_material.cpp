@@ -98,6 +98,12 @@ ENG_API Eng::Material::Material(Material&& other) : Eng::Object(std::move(other)
 ENG_API Eng::Material::~Material()
 {
 	ENG_LOG_DETAIL("[-]");
+
+	// Release shared textures:
+	if (reserved)
+		for (auto& tex : reserved->texture)
+			if (tex.get() != Eng::Texture::empty)
+				Eng::Container::getInstance().releaseTexture(tex);
 }
 
 
@@ -218,29 +224,38 @@ float ENG_API Eng::Material::getOpacity() const
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Sets texture. 
+ * Sets texture. The texture previously at this level is released if it comes from the Container texture cache, so a
+ * cached texture must be set along with a reference taken through Container::acquireTexture() or addTexture(). The
+ * material holds that reference until the texture is replaced or the material is destroyed.
  * @param tex texture
  * @param type texture level
  * @return TF
  */
 bool ENG_API Eng::Material::setTexture(const Eng::Texture& tex, Eng::Texture::Type type)
 {
-	// Set texture accordingly:
+	// Get level:
+	uint32_t level = 0;
 	switch (type)
 	{
-	case Eng::Texture::Type::albedo: reserved->texture[0] = tex;
+	case Eng::Texture::Type::albedo: level = 0;
 		break;
-	case Eng::Texture::Type::normal: reserved->texture[1] = tex;
+	case Eng::Texture::Type::normal: level = 1;
 		break;
-	case Eng::Texture::Type::roughness: reserved->texture[2] = tex;
+	case Eng::Texture::Type::roughness: level = 2;
 		break;
-	case Eng::Texture::Type::metalness: reserved->texture[3] = tex;
+	case Eng::Texture::Type::metalness: level = 3;
 		break;
 	default:
 		ENG_LOG_ERROR("Unsupported texture level");
 		return false;
 	}
 
+	// Replace (and release the previous one, if shared):
+	const Eng::Texture& previous = reserved->texture[level];
+	reserved->texture[level] = tex;
+	if (previous != Eng::Texture::empty)
+		Eng::Container::getInstance().releaseTexture(previous);
+
 	// Done:
 	return true;
 }
@@ -276,6 +291,31 @@ const Eng::Texture ENG_API& Eng::Material::getTexture(Eng::Texture::Type type) c
  * @return 1 on success, 0 if error
  */
 uint32_t ENG_API Eng::Material::loadChunk(Eng::Serializer& serial, void* data)
+{
+	Staging staging;
+	if (decodeChunk(serial, staging) == false)
+		return 0;
+
+	// Load only the images not already in the texture cache (unless they are loaded in background):
+	Eng::Container& container = Eng::Container::getInstance();
+	for (uint32_t c = 0; c < Eng::Material::maxNrOfTextures && !container.isAsyncTextures(); c++)
+		if (!staging.textureName[c].empty() && container.findTexture(staging.textureKey[c]) == Eng::Texture::empty)
+			loadBitmap(staging.textureName[c], staging.bitmap[c], staging.bitmapLoadTime[c]);
+
+	// Done:
+	return loadStaging(staging);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a material chunk into its CPU-side staging structure. Images are not loaded (see loadBitmap()). Neither
+ * OpenGL nor the container are accessed, so this method can be invoked from worker threads.
+ * @param serial serial data
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Material::decodeChunk(Eng::Serializer& serial, Staging& staging)
 {
 	// Chunk header:
 	uint32_t chunkId;
@@ -283,96 +323,128 @@ uint32_t ENG_API Eng::Material::loadChunk(Eng::Serializer& serial, void* data)
 	if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::material))
 	{
 		ENG_LOG_ERROR("Invalid chunk ID found");
-		return 0;
+		return false;
 	}
 	uint32_t chunkSize;
 	serial.deserialize(&chunkSize, sizeof(uint32_t));
 
 	// Material properties:
-	std::string name;
-	serial.deserialize(name);
-	this->setName(name);
+	serial.deserialize(staging.name);
 
 	// PBR props:   
-	serial.deserialize(reserved->emission);
-	serial.deserialize(reserved->albedo);
-	serial.deserialize(reserved->roughness);
-	serial.deserialize(reserved->metalness);
-	serial.deserialize(reserved->opacity);
-
-	// Textures:
-	Eng::Container& container = Eng::Container::getInstance();
-
-	// Albedo:
-	serial.deserialize(name);
-	ENG_LOG_PLAIN("Texture (albedo): %s", name.c_str());
-	if (name != "[none]")
+	serial.deserialize(staging.emission);
+	serial.deserialize(staging.albedo);
+	serial.deserialize(staging.roughness);
+	serial.deserialize(staging.metalness);
+	serial.deserialize(staging.opacity);
+
+	// Textures (albedo, normal, height, roughness, metalness), height is ignored:
+	const char* kind[] = {"albedo", "normal", "height", "roughness", "metalness"};
+	uint32_t curTexture = 0;
+	for (uint32_t c = 0; c < 5; c++)
 	{
-		Eng::Bitmap bitmap;
-		if (!bitmap.load(name))
-			ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-		else
+		std::string_view name;
+		serial.deserialize(name);
+		ENG_LOG_PLAIN("Texture (%s): %.*s", kind[c], static_cast<int>(name.size()), name.data());
+		if (c == 2)
+			continue;
+
+		staging.textureName[curTexture].clear();
+		staging.textureKey[curTexture].clear();
+		staging.bitmap[curTexture].reset();
+		staging.bitmapLoadTime[curTexture] = 0.0;
+		if (name != "[none]")
 		{
-			Eng::Texture tex;
-			tex.load(bitmap);
-			container.add(tex);
-			this->setTexture(container.getLastTexture(), Eng::Texture::Type::albedo);
+			staging.textureName[curTexture] = name;
+			staging.textureKey[curTexture] = Eng::Container::getTextureKey(staging.textureName[curTexture]);
 		}
+		curTexture++;
 	}
 
-	// Normal:
-	serial.deserialize(name);
-	ENG_LOG_PLAIN("Texture (normal): %s", name.c_str());
-	if (name != "[none]")
-	{
-		Eng::Bitmap bitmap;
-		if (!bitmap.load(name))
-			ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-		else
-		{
-			Eng::Texture tex;
-			tex.load(bitmap);
-			container.add(tex);
-			this->setTexture(container.getLastTexture(), Eng::Texture::Type::normal);
-		}
-	}
+	// Done:
+	return true;
+}
 
-	// Height (ignored):
-	serial.deserialize(name);
-	ENG_LOG_PLAIN("Texture (height): %s", name.c_str());
 
-	// Roughness:
-	serial.deserialize(name);
-	ENG_LOG_PLAIN("Texture (roughness): %s", name.c_str());
-	if (name != "[none]")
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads an image file for a texture. Can be invoked from worker threads.
+ * @param filename image file name
+ * @param bitmap loaded image or nullptr if error
+ * @param loadTime time spent loading the image (ms)
+ * @return TF
+ */
+bool ENG_API Eng::Material::loadBitmap(const std::string& filename, std::shared_ptr<const Eng::Bitmap>& bitmap,
+                                       double& loadTime)
+{
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint64_t startTime = timer.getCounter();
+	std::shared_ptr<Eng::Bitmap> _bitmap = std::make_shared<Eng::Bitmap>();
+	if (!_bitmap->load(filename))
 	{
-		Eng::Bitmap bitmap;
-		if (!bitmap.load(name))
-			ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-		else
-		{
-			Eng::Texture tex;
-			tex.load(bitmap);
-			container.add(tex);
-			this->setTexture(container.getLastTexture(), Eng::Texture::Type::roughness);
-		}
+		ENG_LOG_ERROR("Unable to load image file '%s'", filename.c_str());
+		bitmap.reset();
+		return false;
 	}
 
-	// Metalness:
-	serial.deserialize(name); // Metalness
-	ENG_LOG_PLAIN("Texture (metalness): %s", name.c_str());
-	if (name != "[none]")
+	// Done:
+	bitmap = _bitmap;
+	loadTime = timer.getCounterDiff(startTime, timer.getCounter());
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes the material from a decoded chunk. Textures are taken from the container texture cache when available, or
+ * created from the loaded images and added to the cache. Images not loaded yet are requested in background, and the
+ * default texture is used until they are ready. Requires an OpenGL context.
+ * @param staging decoded chunk
+ * @return TF
+ */
+uint32_t ENG_API Eng::Material::loadStaging(const Staging& staging)
+{
+	this->setName(staging.name);
+
+	// PBR props:
+	reserved->emission = staging.emission;
+	reserved->albedo = staging.albedo;
+	reserved->roughness = staging.roughness;
+	reserved->metalness = staging.metalness;
+	reserved->opacity = staging.opacity;
+
+	// Textures:
+	Eng::Container& container = Eng::Container::getInstance();
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	const Eng::Texture::Type type[] = {Eng::Texture::Type::albedo, Eng::Texture::Type::normal,
+	                                   Eng::Texture::Type::roughness, Eng::Texture::Type::metalness};
+	for (uint32_t c = 0; c < Eng::Material::maxNrOfTextures; c++)
 	{
-		Eng::Bitmap bitmap;
-		if (!bitmap.load(name))
-			ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-		else
+		if (staging.textureName[c].empty())
+			continue;
+
+		// Shared:
+		std::reference_wrapper<Eng::Texture> tex = container.acquireTexture(staging.textureKey[c]);
+		if (tex.get() == Eng::Texture::empty && staging.bitmap[c])
 		{
-			Eng::Texture tex;
-			tex.load(bitmap);
-			container.add(tex);
-			this->setTexture(container.getLastTexture(), Eng::Texture::Type::metalness);
+			// First user, upload it:
+			const Eng::Bitmap& bitmap = *staging.bitmap[c];
+			uint64_t nrOfBytes = 0;
+			for (uint32_t side = 0; side < bitmap.getNrOfSides(); side++)
+				for (uint32_t level = 0; level < bitmap.getNrOfLevels(); level++)
+					nrOfBytes += bitmap.getNrOfBytes(level, side);
+
+			uint64_t startTime = timer.getCounter();
+			Eng::Texture _tex;
+			_tex.setName(bitmap.getName());
+			_tex.load(bitmap);
+			double loadTime = staging.bitmapLoadTime[c] + timer.getCounterDiff(startTime, timer.getCounter());
+			tex = container.addTexture(_tex, staging.textureKey[c], nrOfBytes, loadTime);
 		}
+		else if (tex.get() == Eng::Texture::empty && container.isAsyncTextures())
+			container.requestTexture(*this, type[c], staging.textureName[c], staging.textureKey[c]);
+		if (tex.get() != Eng::Texture::empty)
+			this->setTexture(tex, type[c]);
 	}
 
 	// Done:
@@ -380,6 +452,42 @@ uint32_t ENG_API Eng::Material::loadChunk(Eng::Serializer& serial, void* data)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the material as a chunk. Textures are referenced by their file names.
+ * @param serial serial data
+ * @return TF
+ */
+bool ENG_API Eng::Material::saveChunk(Eng::Serializer& serial) const
+{
+	uint64_t chunkPosition = beginChunk(serial, Ovo::ChunkId::material);
+
+	// Material properties:
+	serial.serialize(this->getName());
+
+	// PBR props:
+	serial.serialize(reserved->emission);
+	serial.serialize(reserved->albedo);
+	serial.serialize(reserved->roughness);
+	serial.serialize(reserved->metalness);
+	serial.serialize(reserved->opacity);
+
+	// Textures (albedo, normal, height, roughness, metalness), height is not supported:
+	auto textureName = [](const Eng::Texture& tex) -> std::string
+	{
+		return tex == Eng::Texture::empty ? "[none]" : tex.getName();
+	};
+	serial.serialize(textureName(reserved->texture[0]));
+	serial.serialize(textureName(reserved->texture[1]));
+	serial.serialize("[none]");
+	serial.serialize(textureName(reserved->texture[2]));
+	serial.serialize(textureName(reserved->texture[3]));
+
+	// Done:
+	return endChunk(serial, chunkPosition);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Rendering method.
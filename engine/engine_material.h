@@ -21,6 +21,24 @@ public: //
 	constexpr static uint32_t maxNrOfTextures = 4; ///< Max number of textures per material
 
 
+	/**
+	 * @brief CPU-side content of a material chunk. Texture arrays are in albedo, normal, roughness, metalness order.
+	 */
+	struct Staging
+	{
+		std::string name; ///< Material name
+		glm::vec3 emission; ///< Emissive term
+		glm::vec3 albedo; ///< Albedo color
+		float roughness; ///< Roughness
+		float metalness; ///< Metalness
+		float opacity; ///< Transparency
+		std::string textureName[maxNrOfTextures]; ///< Image file names (empty if no texture)
+		std::string textureKey[maxNrOfTextures]; ///< Texture cache keys
+		std::shared_ptr<const Eng::Bitmap> bitmap[maxNrOfTextures]; ///< Loaded images, only for textures not cached
+		double bitmapLoadTime[maxNrOfTextures]; ///< Time spent loading the images (ms)
+	};
+
+
 	// Const/dest:
 	Material();
 	Material(Material&& other);
@@ -46,6 +64,10 @@ public: //
 
 	// Ovo:   
 	uint32_t loadChunk(Eng::Serializer& serial, void* data = nullptr);
+	static bool decodeChunk(Eng::Serializer& serial, Staging& staging);
+	static bool loadBitmap(const std::string& filename, std::shared_ptr<const Eng::Bitmap>& bitmap, double& loadTime);
+	uint32_t loadStaging(const Staging& staging);
+	bool saveChunk(Eng::Serializer& serial) const override;
 
 
 	/////////////
@@ -20,13 +20,9 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-
-////////////
-// STATIC //
-////////////
-
-// Special values:
-Eng::Mesh Eng::Mesh::empty("[empty]");
+// C/C++:
+#include <cstring>
+#include <unordered_map>
 
 
 /////////////////////////
@@ -34,26 +30,207 @@ Eng::Mesh Eng::Mesh::empty("[empty]");
 /////////////////////////
 
 /**
- * @brief Mesh class reserved structure.
+ * @brief GPU-side geometry, shared among the meshes with identical payload.
  */
-struct Eng::Mesh::Reserved
+struct Eng::Mesh::Geometry
 {
+	/**
+	 * @brief Level of detail, stored as a range of the buffers.
+	 */
+	struct Lod
+	{
+		uint32_t firstVertex; ///< First vertex (added to the indices, which are relative to the LOD)
+		uint32_t nrOfVertices; ///< Number of vertices
+		uint32_t firstFace; ///< First face
+		uint32_t nrOfFaces; ///< Number of faces
+		std::vector<Eng::MeshOptimizer::Meshlet> meshlet; ///< Meshlets (empty if unclustered)
+	};
+
 	// Buffers:
 	Eng::Vao vao;
 	Eng::Vbo vbo;
 	Eng::Ebo ebo;
+	uint64_t nrOfBytes; ///< Size of the buffers
+
+	// Compact layout:
+	glm::mat4 dequantization; ///< Maps quantized positions back to object space (identity if not compact)
+
+	// Levels of detail:
+	std::vector<Lod> lod; ///< From the most detailed
+
+	// Sharing:
+	uint64_t key; ///< Payload hash
+	uint64_t check; ///< Second payload hash, independent from the key (both must match to share)
+	std::weak_ptr<const Eng::Mesh::Shape> shape; ///< CPU-side copy of LOD 0, if kept by any of the meshes
+
+
+	/**
+	 * Constructor
+	 */
+	Geometry() : nrOfBytes{0}, dequantization{1.0f}, key{0}, check{0} {}
+
+	/**
+	 * Destructor
+	 */
+	~Geometry();
+};
+
+
+/**
+ * @brief Mesh class static reserved structure.
+ */
+struct Eng::Mesh::StaticReserved
+{
+	std::unordered_map<uint64_t, std::weak_ptr<Eng::Mesh::Geometry>> geometry; ///< Uploaded geometries, by payload hash
+};
+
+
+/**
+ * @brief Mesh class reserved structure.
+ */
+struct Eng::Mesh::Reserved
+{
+	// Geometry:
+	std::shared_ptr<Eng::Mesh::Geometry> geometry; ///< Buffers (nullptr if not loaded)
 
 	// Material:
 	std::reference_wrapper<const Eng::Material> material;
 
+	// Bounding volumes:
+	float radius; ///< Bounding sphere radius
+	glm::vec3 bboxMin; ///< Bounding box min corner
+	glm::vec3 bboxMax; ///< Bounding box max corner
+
+	// Occlusion:
+	std::shared_ptr<const Eng::Mesh::Shape> shape; ///< CPU-side geometry (nullptr if not kept)
+	bool occluder; ///< TF when designated as occluder
+
 
 	/**
 	 * Constructor
 	 */
-	Reserved() : material{Eng::Material::empty} {}
+	Reserved() : material{Eng::Material::empty}, radius{0.0f}, bboxMin{0.0f}, bboxMax{0.0f}, occluder{false} {}
 };
 
 
+////////////
+// STATIC //
+////////////
+
+// Reserved data:
+std::unique_ptr<Eng::Mesh::StaticReserved> Eng::Mesh::staticReserved = std::make_unique<Eng::Mesh::StaticReserved>();
+
+// Special values:
+Eng::Mesh Eng::Mesh::empty("[empty]");
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Accumulates an array into a 64-bit payload hash (FNV-1a over 64-bit words, with a final avalanche on the tail).
+ * Independent hashes of the same payload are obtained with different seeds and multipliers.
+ * @param hash running hash
+ * @param data array
+ * @param nrOfBytes size of the array
+ * @param prime multiplier (odd)
+ * @return updated hash
+ */
+static uint64_t hashPayload(uint64_t hash, const void* data, uint64_t nrOfBytes, uint64_t prime = 0x100000001b3ull)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t c = 0;
+	for (; c + sizeof(uint64_t) <= nrOfBytes; c += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + c, sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+	}
+	for (; c < nrOfBytes; c++)
+		hash = (hash ^ bytes[c]) * prime;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+
+	// Done:
+	return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the CPU-side copy of a LOD, built on first use and then shared through the given cache.
+ * @param cache shape shared among the meshes referencing the same geometry
+ * @param lod source LOD
+ * @return shape
+ */
+static std::shared_ptr<const Eng::Mesh::Shape> shareShape(std::weak_ptr<const Eng::Mesh::Shape>& cache,
+                                                          const Eng::Mesh::Staging::Lod& lod)
+{
+	std::shared_ptr<const Eng::Mesh::Shape> shape = cache.lock();
+	if (shape)
+		return shape;
+
+	std::shared_ptr<Eng::Mesh::Shape> built = std::make_shared<Eng::Mesh::Shape>();
+	built->vertex.resize(lod.nrOfVertices);
+	for (uint32_t c = 0; c < lod.nrOfVertices; c++)
+		built->vertex[c] = lod.vertices[c].vertex;
+	built->index.resize(lod.nrOfFaces * 3);
+	for (uint32_t c = 0; c < lod.nrOfFaces; c++)
+	{
+		built->index[c * 3] = lod.faces[c].a;
+		built->index[c * 3 + 1] = lod.faces[c].b;
+		built->index[c * 3 + 2] = lod.faces[c].c;
+	}
+	cache = built;
+
+	// Done:
+	return built;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the quantization box of the compact layout. The stored bbox might be stale, so it is extended to the actual
+ * vertices of all the LODs, and flat axes are given a unit extent.
+ * @param staging decoded chunk
+ * @param bboxMin box min corner
+ * @param extent box size
+ */
+static void getQuantizationBox(const Eng::Mesh::Staging& staging, glm::vec3& bboxMin, glm::vec3& extent)
+{
+	bboxMin = staging.bboxMin;
+	glm::vec3 bboxMax = staging.bboxMax;
+	for (const Eng::Mesh::Staging::Lod& l : staging.lod)
+		for (uint32_t c = 0; c < l.nrOfVertices; c++)
+		{
+			bboxMin = glm::min(bboxMin, l.vertices[c].vertex);
+			bboxMax = glm::max(bboxMax, l.vertices[c].vertex);
+		}
+	extent = bboxMax - bboxMin;
+	for (uint32_t c = 0; c < 3; c++)
+		if (extent[c] <= 0.0f)
+			extent[c] = 1.0f;
+}
+
+
+///////////////////////////////////
+// BODY OF STRUCT Mesh::Geometry //
+///////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor. Invoked once the last mesh referencing the geometry releases it, so its entry is removed from the
+ * registry (unless taken by another geometry after a key collision).
+ */
+Eng::Mesh::Geometry::~Geometry()
+{
+	if (staticReserved == nullptr)
+		return;
+	auto registered = staticReserved->geometry.find(key);
+	if (registered != staticReserved->geometry.end() && registered->second.expired())
+		staticReserved->geometry.erase(registered);
+}
+
+
 ////////////////////////
 // BODY OF CLASS Mesh //
 ////////////////////////
@@ -125,6 +302,179 @@ const Eng::Material ENG_API& Eng::Mesh::getMaterial() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the radius of the bounding sphere (in local coordinates).
+ * @return radius
+ */
+float ENG_API Eng::Mesh::getRadius() const
+{
+	return reserved->radius;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the min corner of the bounding box (in local coordinates).
+ * @return min corner
+ */
+const glm::vec3 ENG_API& Eng::Mesh::getBBoxMin() const
+{
+	return reserved->bboxMin;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the max corner of the bounding box (in local coordinates).
+ * @return max corner
+ */
+const glm::vec3 ENG_API& Eng::Mesh::getBBoxMax() const
+{
+	return reserved->bboxMax;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of levels of detail.
+ * @return number of LODs (0 if the mesh has no geometry)
+ */
+uint32_t ENG_API Eng::Mesh::getNrOfLods() const
+{
+	return reserved->geometry ? static_cast<uint32_t>(reserved->geometry->lod.size()) : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of faces of a level of detail.
+ * @param lod level of detail
+ * @return number of faces (0 if the LOD does not exist)
+ */
+uint32_t ENG_API Eng::Mesh::getNrOfFaces(uint32_t lod) const
+{
+	return lod < getNrOfLods() ? reserved->geometry->lod[lod].nrOfFaces : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the meshlets of a level of detail (in local coordinates).
+ * @param lod level of detail
+ * @return meshlets (empty if the mesh was not clustered at import time or if the LOD does not exist)
+ */
+const std::vector<Eng::MeshOptimizer::Meshlet> ENG_API& Eng::Mesh::getMeshlets(uint32_t lod) const
+{
+	static const std::vector<Eng::MeshOptimizer::Meshlet> none;
+	return lod < getNrOfLods() ? reserved->geometry->lod[lod].meshlet : none;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the bounding sphere of the mesh (in local coordinates): the tighter between the sphere around the pivot and the
+ * one around the bounding box.
+ * @param center sphere center
+ * @param radius sphere radius
+ * @return TF (false if the mesh has no bounds, i.e., an empty bounding box)
+ */
+bool ENG_API Eng::Mesh::getBoundingSphere(glm::vec3& center, float& radius) const
+{
+	// No bounds:
+	if (reserved->bboxMin == reserved->bboxMax)
+		return false;
+
+	center = 0.5f * (reserved->bboxMin + reserved->bboxMax);
+	radius = 0.5f * glm::length(reserved->bboxMax - reserved->bboxMin);
+	if (reserved->radius > 0.0f && reserved->radius < radius)
+	{
+		center = glm::vec3(0.0f);
+		radius = reserved->radius;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Designates the mesh as occluder: List::cullOccluded() always rasterizes it (if it has a shape, see getShape()), in
+ * addition to the occluders it selects automatically.
+ * @param occluder TF
+ */
+void ENG_API Eng::Mesh::setOccluder(bool occluder)
+{
+	reserved->occluder = occluder;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the mesh is designated as occluder.
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::isOccluder() const
+{
+	return reserved->occluder;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the CPU-side shape of the mesh, e.g., a simplified occluder authored for it. Shapes are otherwise kept at load
+ * time from LOD 0 (see Ovo::setShapeRetention()), and replaced at each loadStaging().
+ * @param shape shape, in mesh coordinates (nullptr to release it)
+ */
+void ENG_API Eng::Mesh::setShape(const std::shared_ptr<const Shape>& shape)
+{
+	reserved->shape = shape;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the CPU-side shape of the mesh.
+ * @return shape, or nullptr if not kept
+ */
+const Eng::Mesh::Shape ENG_API* Eng::Mesh::getShape() const
+{
+	return reserved->shape.get();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a key identifying the geometry: meshes loaded with identical payload (vertices, faces and meshlets of all the
+ * LODs, and buffer layout) share the same buffers and the same key, which can be used to group them for instancing.
+ * @return geometry key (0 if the mesh has no geometry)
+ */
+uint64_t ENG_API Eng::Mesh::getGeometryKey() const
+{
+	return reserved->geometry ? reserved->geometry->key : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the amount of GPU memory currently saved by sharing geometry among meshes, i.e., the size of the buffers that
+ * would have been uploaded again for each mesh referencing an already loaded geometry.
+ * @return number of bytes
+ */
+uint64_t ENG_API Eng::Mesh::getNrOfSharedBytes()
+{
+	uint64_t nrOfBytes = 0;
+	for (const auto& g : staticReserved->geometry)
+	{
+		const uint64_t nrOfReferences = g.second.use_count();
+		if (nrOfReferences > 1)
+			nrOfBytes += (nrOfReferences - 1) * g.second.lock()->nrOfBytes;
+	}
+	return nrOfBytes;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Loads the specific information of a given object. In its base class, this function loads the file version chunk.
@@ -133,112 +483,617 @@ const Eng::Material ENG_API& Eng::Mesh::getMaterial() const
  * @return TF
  */
 uint32_t ENG_API Eng::Mesh::loadChunk(Eng::Serializer& serial, void* data)
+{
+	Staging staging;
+	if (decodeChunk(serial, staging) == false)
+		return 0;
+
+	// Done:
+	return loadStaging(staging);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a mesh chunk into its CPU-side staging structure. Neither OpenGL nor the container are accessed, so this
+ * method can be invoked from worker threads (each using its own serializer).
+ * @param serial serial data
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::decodeChunk(Eng::Serializer& serial, Staging& staging)
 {
 	// Chunk header
 	uint32_t chunkId;
 	serial.deserialize(&chunkId, sizeof(uint32_t));
-	if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::mesh))
+	const bool encoded = chunkId == static_cast<uint32_t>(Ovo::ChunkId::encodedMesh);
+	if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::mesh) && encoded == false)
 	{
 		ENG_LOG_ERROR("Invalid chunk ID found");
-		return 0;
+		return false;
 	}
 	uint32_t chunkSize;
 	serial.deserialize(&chunkSize, sizeof(uint32_t));
 
 	// Node properties:       
-	std::string name;
-	serial.deserialize(name);
-	this->setName(name);
-
-	glm::mat4 matrix;
-	serial.deserialize(matrix);
-	this->setMatrix(matrix);
+	serial.deserialize(staging.name);
+	serial.deserialize(staging.matrix);
+	serial.deserialize(staging.nrOfChildren);
 
-	uint32_t nrOfChildren;
-	serial.deserialize(nrOfChildren);
-
-	std::string target;
+	std::string_view target;
 	serial.deserialize(target);
 
 	// Data:
 	uint8_t subtype;
 	serial.deserialize(subtype);
 
-	std::string materialName;
-	serial.deserialize(materialName);
-	std::reference_wrapper<const Eng::Material> mat = Eng::Material::empty;
-	mat = dynamic_cast<Eng::Material&>(Eng::Container::getInstance().find(materialName));
-	this->setMaterial(mat);
-
-	float radius;
-	serial.deserialize(radius);
-
-	glm::vec3 bboxMin;
-	serial.deserialize(bboxMin);
-
-	glm::vec3 bboxMax;
-	serial.deserialize(bboxMax);
+	serial.deserialize(staging.materialName);
+	staging.material = nullptr;
+	staging.compact = false;
+	staging.keepShape = false;
+	serial.deserialize(staging.radius);
+	serial.deserialize(staging.bboxMin);
+	serial.deserialize(staging.bboxMax);
 
 	uint8_t hasPhysics;
 	serial.deserialize(hasPhysics);
 	if (hasPhysics)
 	{
 		ENG_LOG_ERROR("Physics section not supported");
-		return 0;
+		return false;
 	}
 
 	uint32_t nrOfLods;
 	serial.deserialize(nrOfLods);
 
+	staging.lod.resize(nrOfLods);
 	for (uint32_t curLod = 0; curLod < nrOfLods; curLod++)
 	{
-		uint32_t nrOfVertices;
-		serial.deserialize(nrOfVertices);
+		Staging::Lod& lod = staging.lod[curLod];
+		serial.deserialize(lod.nrOfVertices);
+		serial.deserialize(lod.nrOfFaces);
+
+		ENG_LOG_PLAIN("LOD: %u, v: %u, f: %u", curLod + 1, lod.nrOfVertices, lod.nrOfFaces);
+
+		// Encoded arrays are decoded into the LOD storage:
+		if (encoded)
+		{
+			uint32_t nrOfVertexBytes = 0, nrOfFaceBytes = 0;
+			Eng::Serializer::View<uint8_t> vertices, faces;
+			serial.deserialize(nrOfVertexBytes);
+			serial.deserialize(vertices, nrOfVertexBytes);
+			serial.deserialize(nrOfFaceBytes);
+			serial.deserialize(faces, nrOfFaceBytes);
+
+			// A byte never expands to more than 255 (checked before allocating):
+			if (vertices.empty() || faces.empty() ||
+			    lod.nrOfVertices * sizeof(Eng::Vbo::VertexData) > 256ull * vertices.size() ||
+			    lod.nrOfFaces * sizeof(Eng::Ebo::FaceData) > 256ull * faces.size())
+			{
+				ENG_LOG_ERROR("Corrupted mesh data");
+				return false;
+			}
+			lod.vertexStorage.resize(lod.nrOfVertices);
+			lod.faceStorage.resize(lod.nrOfFaces);
+			if (Eng::MeshCodec::decodeVertices(vertices.data(), vertices.size(), lod.vertexStorage.data(),
+			                                   lod.nrOfVertices) == false ||
+			    Eng::MeshCodec::decodeFaces(faces.data(), faces.size(), lod.faceStorage.data(), lod.nrOfFaces) == false)
+			{
+				ENG_LOG_ERROR("Corrupted mesh data");
+				return false;
+			}
+			lod.vertices = lod.vertexStorage.data();
+			lod.faces = lod.faceStorage.data();
+			continue;
+		}
+
+		// Arrays are accessed in place (no copies):
+		Eng::Serializer::View<Eng::Vbo::VertexData> vertices;
+		Eng::Serializer::View<Eng::Ebo::FaceData> faces;
+		if (serial.deserialize(vertices, lod.nrOfVertices) == false || serial.deserialize(faces, lod.nrOfFaces) == false)
+		{
+			ENG_LOG_ERROR("Corrupted mesh data");
+			return false;
+		}
+		lod.vertices = vertices.data();
+		lod.faces = faces.data();
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes the mesh from a decoded chunk: resolves the material and uploads the geometry. Geometry with the same
+ * payload as an already loaded mesh is not uploaded again, but shared with it. Requires an OpenGL context.
+ * @param staging decoded chunk
+ * @return number of children nodes
+ */
+uint32_t ENG_API Eng::Mesh::loadStaging(const Staging& staging)
+{
+	this->setName(staging.name);
+	this->setMatrix(staging.matrix);
+
+	if (staging.material)
+		this->setMaterial(*staging.material);
+	else
+	{
+		std::reference_wrapper<const Eng::Material> mat = Eng::Material::empty;
+		mat = dynamic_cast<Eng::Material&>(Eng::Container::getInstance().find(staging.materialName));
+		this->setMaterial(mat);
+	}
+	reserved->radius = staging.radius;
+	reserved->bboxMin = staging.bboxMin;
+	reserved->bboxMax = staging.bboxMax;
+	invalidateBounds();
+
+	reserved->geometry = nullptr;
+	reserved->shape = nullptr;
+	if (staging.lod.empty())
+		return staging.nrOfChildren;
 
-		uint32_t nrOfFaces;
-		serial.deserialize(nrOfFaces);
+	// Payload hashes (meshlets included, as clustering reorders the faces, and the quantization box, if compact):
+	uint64_t key = 0xcbf29ce484222325ull, check = 0x84222325cbf29ce4ull;
+	auto hash = [&key, &check](const void* data, uint64_t nrOfBytes)
+	{
+		key = hashPayload(key, data, nrOfBytes);
+		check = hashPayload(check, data, nrOfBytes, 0xc2b2ae3d27d4eb4full);
+	};
+	hash(&staging.compact, sizeof(bool));
+	if (staging.compact)
+	{
+		hash(&staging.bboxMin, sizeof(glm::vec3));
+		hash(&staging.bboxMax, sizeof(glm::vec3));
+	}
+	for (const Staging::Lod& l : staging.lod)
+	{
+		const uint32_t nrOfElements[] = {l.nrOfVertices, l.nrOfFaces, static_cast<uint32_t>(l.meshlet.size())};
+		hash(nrOfElements, sizeof(nrOfElements));
+		hash(l.vertices, l.nrOfVertices * sizeof(Eng::Vbo::VertexData));
+		hash(l.faces, l.nrOfFaces * sizeof(Eng::Ebo::FaceData));
+		hash(l.meshlet.data(), l.meshlet.size() * sizeof(Eng::MeshOptimizer::Meshlet));
+	}
+	key += key == 0;
 
-		ENG_LOG_PLAIN("LOD: %u, v: %u, f: %u", curLod + 1, nrOfVertices, nrOfFaces);
+	// Already uploaded (128 bits of hash are taken as proof of identical payloads)?
+	auto shared = staticReserved->geometry.find(key);
+	std::shared_ptr<Geometry> registered = shared != staticReserved->geometry.end() ? shared->second.lock() : nullptr;
+	if (registered && registered->check == check)
+	{
+		reserved->geometry = registered;
+		ENG_LOG_DEBUG("Mesh '%s': geometry shared (%llu bytes)", staging.name.c_str(),
+		              static_cast<unsigned long long>(reserved->geometry->nrOfBytes));
+		if (staging.keepShape)
+			reserved->shape = shareShape(reserved->geometry->shape, staging.lod[0]);
+		return staging.nrOfChildren;
+	}
+	reserved->geometry = std::make_shared<Geometry>();
+	reserved->geometry->key = key;
+	reserved->geometry->check = check;
+	if (registered)
+		ENG_LOG_WARN("Mesh '%s': payload hash collision, geometry not shared", staging.name.c_str());
+	else
+		staticReserved->geometry[key] = reserved->geometry;
+	Geometry& geometry = *reserved->geometry;
+	if (staging.keepShape)
+		reserved->shape = shareShape(geometry.shape, staging.lod[0]);
 
-		std::vector<Eng::Vbo::VertexData> allVertices(nrOfVertices);
-		serial.deserialize(allVertices.data(), nrOfVertices * sizeof(Eng::Vbo::VertexData));
+	// All the LODs share the same buffers, one range each:
+	uint32_t nrOfVertices = 0, nrOfFaces = 0;
+	bool narrow = true; ///< TF if each LOD can use 16-bit indices
+	for (const Staging::Lod& l : staging.lod)
+	{
+		Geometry::Lod lod;
+		lod.firstVertex = nrOfVertices;
+		lod.nrOfVertices = l.nrOfVertices;
+		lod.firstFace = nrOfFaces;
+		lod.nrOfFaces = l.nrOfFaces;
+		lod.meshlet = l.meshlet;
+		geometry.lod.push_back(std::move(lod));
+		nrOfVertices += l.nrOfVertices;
+		nrOfFaces += l.nrOfFaces;
+		narrow = narrow && l.nrOfVertices <= UINT16_MAX + 1u;
+	}
 
-		std::vector<Eng::Ebo::FaceData> allFaces(nrOfFaces);
-		serial.deserialize(allFaces.data(), nrOfFaces * sizeof(Eng::Ebo::FaceData));
+	geometry.vao.init();
+	geometry.vao.render();
 
-		// Store only first LOD for now:
-		if (curLod == 0)
+	// Single LODs are uploaded in place:
+	const Staging::Lod& first = staging.lod[0];
+	std::vector<Eng::Vbo::VertexData> vertexStorage;
+	std::vector<Eng::Ebo::FaceData> faceStorage;
+	const Eng::Vbo::VertexData* vertices = first.vertices;
+	const Eng::Ebo::FaceData* faces = first.faces;
+	if (staging.lod.size() > 1)
+	{
+		vertexStorage.reserve(nrOfVertices);
+		faceStorage.reserve(nrOfFaces);
+		for (const Staging::Lod& l : staging.lod)
 		{
-			reserved->vao.init();
-			reserved->vao.render();
+			vertexStorage.insert(vertexStorage.end(), l.vertices, l.vertices + l.nrOfVertices);
+			faceStorage.insert(faceStorage.end(), l.faces, l.faces + l.nrOfFaces);
+		}
+		vertices = vertexStorage.data();
+		faces = faceStorage.data();
+	}
+
+	if (staging.compact && nrOfVertices)
+	{
+		glm::vec3 bboxMin, extent;
+		getQuantizationBox(staging, bboxMin, extent);
+
+		std::vector<Eng::Vbo::CompactVertexData> compactVertices(nrOfVertices);
+		const float maxError = Eng::MeshOptimizer::compactVertices(vertices, nrOfVertices, bboxMin, bboxMin + extent,
+		                                                           compactVertices.data());
+		geometry.vbo.create(nrOfVertices, compactVertices.data(), Eng::Vbo::Layout::compact);
+		geometry.dequantization = glm::scale(glm::translate(glm::mat4(1.0f), bboxMin), extent);
 
-			reserved->vbo.create(nrOfVertices, allVertices.data());
-			reserved->ebo.create(nrOfFaces, allFaces.data());
+		// 16-bit indices only if all the vertices of each LOD are addressable (indices are relative to the LOD):
+		uint64_t faceBytes = nrOfFaces * sizeof(Eng::Ebo::FaceData);
+		std::vector<Eng::Ebo::CompactFaceData> compactFaces(nrOfFaces);
+		bool compacted = narrow;
+		for (uint32_t c = 0; c < staging.lod.size() && compacted; c++)
+			compacted = Eng::MeshOptimizer::compactFaces(faces + geometry.lod[c].firstFace, geometry.lod[c].nrOfFaces,
+			                                             geometry.lod[c].nrOfVertices,
+			                                             compactFaces.data() + geometry.lod[c].firstFace);
+		if (compacted)
+		{
+			geometry.ebo.create(nrOfFaces, compactFaces.data(), Eng::Ebo::Layout::compact);
+			faceBytes = nrOfFaces * sizeof(Eng::Ebo::CompactFaceData);
 		}
+		else
+			geometry.ebo.create(nrOfFaces, faces);
+		geometry.nrOfBytes = nrOfVertices * sizeof(Eng::Vbo::CompactVertexData) + faceBytes;
+
+		ENG_LOG_PLAIN("Mesh '%s': vertex buffer %llu -> %llu bytes, index buffer %llu -> %llu bytes, max position error %g",
+		               staging.name.c_str(),
+		               static_cast<unsigned long long>(nrOfVertices * sizeof(Eng::Vbo::VertexData)),
+		               static_cast<unsigned long long>(nrOfVertices * sizeof(Eng::Vbo::CompactVertexData)),
+		               static_cast<unsigned long long>(nrOfFaces * sizeof(Eng::Ebo::FaceData)),
+		               static_cast<unsigned long long>(faceBytes), maxError);
+	}
+	else
+	{
+		geometry.vbo.create(nrOfVertices, vertices);
+		geometry.ebo.create(nrOfFaces, faces);
+		geometry.nrOfBytes = nrOfVertices * sizeof(Eng::Vbo::VertexData) + nrOfFaces * sizeof(Eng::Ebo::FaceData);
 	}
 
 	// Done:      
-	return nrOfChildren;
+	return staging.nrOfChildren;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Generates a LOD chain for a decoded chunk with a single LOD (authored chains are kept), by simplifying each level
+ * into the next one (see MeshOptimizer::simplify()). The max error starts at MeshOptimizer::defaultLodError and doubles
+ * at each level; the chain stops early when a level can't be reduced enough. Neither OpenGL nor the container are
+ * accessed, so this method can be invoked from worker threads.
+ * @param staging decoded chunk
+ * @param nrOfLods total number of LODs, including the first one
+ * @param ratio triangles kept by each LOD, relative to the previous one
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::simplifyStaging(Staging& staging, uint32_t nrOfLods, float ratio)
+{
+	// Safety net:
+	if (ratio <= 0.0f || ratio >= 1.0f)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	if (staging.lod.size() != 1 || nrOfLods < 2 || staging.lod[0].nrOfFaces == 0)
+		return true;
+
+	staging.lod.reserve(nrOfLods);
+	const uint32_t nrOfBaseFaces = staging.lod[0].nrOfFaces;
+	float maxError = Eng::MeshOptimizer::defaultLodError;
+	float totalError = 0.0f; ///< Bound of the error against the first LOD
+	std::vector<Eng::Ebo::FaceData> faces(staging.lod[0].faces, staging.lod[0].faces + nrOfBaseFaces);
+	for (uint32_t c = 1; c < nrOfLods; c++, maxError *= 2.0f)
+	{
+		const Staging::Lod& base = staging.lod[0];
+		const uint32_t target = static_cast<uint32_t>(nrOfBaseFaces * std::pow(ratio, static_cast<float>(c)));
+		std::vector<Eng::Ebo::FaceData> simplified;
+		float error;
+		if (Eng::MeshOptimizer::simplify(base.vertices, base.nrOfVertices, faces.data(), static_cast<uint32_t>(faces.size()),
+		                                 target, maxError, simplified, error) == false)
+			return false;
+
+		// Not worth a level:
+		if (simplified.empty() || simplified.size() > faces.size() * 0.9f)
+			break;
+
+		// Own the vertices actually used:
+		Staging::Lod lod;
+		lod.vertexStorage.assign(base.vertices, base.vertices + base.nrOfVertices);
+		lod.faceStorage = simplified;
+		lod.nrOfFaces = static_cast<uint32_t>(simplified.size());
+		lod.nrOfVertices = Eng::MeshOptimizer::optimizeVertexFetch(lod.vertexStorage.data(), base.nrOfVertices,
+		                                                           lod.faceStorage.data(), lod.nrOfFaces);
+		lod.vertexStorage.resize(lod.nrOfVertices);
+		lod.vertices = lod.vertexStorage.data();
+		lod.faces = lod.faceStorage.data();
+
+		totalError += error;
+		ENG_LOG_PLAIN("Mesh '%s', LOD %u: %u -> %u triangles (%.1f%%), error %.3f%% of the extent", staging.name.c_str(),
+		              c + 1, nrOfBaseFaces, lod.nrOfFaces, 100.0f * lod.nrOfFaces / nrOfBaseFaces, 100.0f * totalError);
+		staging.lod.push_back(std::move(lod));
+		faces = std::move(simplified);
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Optimizes the geometry of a decoded chunk for the GPU: triangles are reordered for post-transform cache locality and
+ * then, by clusters, to reduce overdraw; vertices are finally reordered in order of first use. Each LOD is copied into
+ * its own storage first, as the serializer storage is read-only. Neither OpenGL nor the container are accessed, so this
+ * method can be invoked from worker threads.
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::optimizeStaging(Staging& staging)
+{
+	for (uint32_t c = 0; c < staging.lod.size(); c++)
+	{
+		Staging::Lod& lod = staging.lod[c];
+		if (lod.nrOfFaces == 0)
+			continue;
+
+		// Own the geometry:
+		if (lod.vertexStorage.data() != lod.vertices)
+			lod.vertexStorage.assign(lod.vertices, lod.vertices + lod.nrOfVertices);
+		if (lod.faceStorage.data() != lod.faces)
+			lod.faceStorage.assign(lod.faces, lod.faces + lod.nrOfFaces);
+
+		Eng::MeshOptimizer::CacheStats before = Eng::MeshOptimizer::analyzeVertexCache(lod.faceStorage.data(),
+		                                                                                lod.nrOfFaces, lod.nrOfVertices);
+		std::vector<Eng::Ebo::FaceData> original = lod.faceStorage;
+		if (Eng::MeshOptimizer::optimizeVertexCache(lod.faceStorage.data(), lod.nrOfFaces, lod.nrOfVertices) == false)
+			return false;
+
+		// Keep the original order if it was already better (e.g., exported as strips):
+		if (Eng::MeshOptimizer::analyzeVertexCache(lod.faceStorage.data(), lod.nrOfFaces, lod.nrOfVertices).acmr > before.acmr)
+			lod.faceStorage = std::move(original);
+		if (Eng::MeshOptimizer::optimizeOverdraw(lod.faceStorage.data(), lod.nrOfFaces, lod.vertexStorage.data(),
+		                                         lod.nrOfVertices) == false)
+			return false;
+		uint32_t nrOfVertices = Eng::MeshOptimizer::optimizeVertexFetch(lod.vertexStorage.data(), lod.nrOfVertices,
+		                                                                lod.faceStorage.data(), lod.nrOfFaces);
+		if (nrOfVertices == 0)
+			return false;
+		lod.vertexStorage.resize(nrOfVertices);
+		lod.nrOfVertices = nrOfVertices;
+		lod.vertices = lod.vertexStorage.data();
+		lod.faces = lod.faceStorage.data();
+		Eng::MeshOptimizer::CacheStats after = Eng::MeshOptimizer::analyzeVertexCache(lod.faces, lod.nrOfFaces,
+		                                                                               lod.nrOfVertices);
+
+		ENG_LOG_PLAIN("Mesh '%s', LOD %u: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", staging.name.c_str(), c + 1,
+		              before.acmr, after.acmr, before.atvr, after.atvr);
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Partitions the geometry of a decoded chunk into meshlets (see MeshOptimizer::buildMeshlets()), used for culling the
+ * parts of the mesh that are not visible. Triangles are reordered, so each LOD is copied into its own storage first.
+ * Neither OpenGL nor the container are accessed, so this method can be invoked from worker threads.
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::clusterStaging(Staging& staging)
+{
+	for (uint32_t c = 0; c < staging.lod.size(); c++)
+	{
+		Staging::Lod& lod = staging.lod[c];
+		if (lod.nrOfFaces == 0)
+			continue;
+
+		// Own the faces:
+		if (lod.faceStorage.data() != lod.faces)
+			lod.faceStorage.assign(lod.faces, lod.faces + lod.nrOfFaces);
+		if (Eng::MeshOptimizer::buildMeshlets(lod.faceStorage.data(), lod.nrOfFaces, lod.vertices, lod.nrOfVertices,
+		                                      lod.meshlet) == false)
+			return false;
+		lod.faces = lod.faceStorage.data();
+
+		ENG_LOG_PLAIN("Mesh '%s', LOD %u: %zu meshlets, %.1f triangles per meshlet", staging.name.c_str(), c + 1,
+		              lod.meshlet.size(), static_cast<float>(lod.nrOfFaces) / static_cast<float>(lod.meshlet.size()));
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the mesh as a chunk, with raw geometry arrays. Geometry is read back from the GPU (requires an OpenGL context).
+ * @param serial serial data
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::saveChunk(Eng::Serializer& serial) const
+{
+	return saveChunk(serial, false);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the mesh as a chunk. Geometry is read back from the GPU (requires an OpenGL context). Meshes uploaded with
+ * the compact layouts (see Ovo::setCompactGeometry()) are refused, as only their quantized positions are available.
+ * @param serial serial data
+ * @param encoded TF to store the geometry arrays through MeshCodec (as an Ovo::ChunkId::encodedMesh chunk)
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::saveChunk(Eng::Serializer& serial, bool encoded) const
+{
+	// Full precision required:
+	const Geometry* geometry = reserved->geometry.get();
+	if (geometry && geometry->vbo.getLayout() == Eng::Vbo::Layout::compact)
+	{
+		ENG_LOG_ERROR("Mesh '%s' has quantized positions and cannot be exported", this->getName().c_str());
+		return false;
+	}
+
+	uint64_t chunkPosition = beginChunk(serial, encoded ? Ovo::ChunkId::encodedMesh : Ovo::ChunkId::mesh);
+
+	// Node properties:
+	serial.serialize(this->getName());
+	serial.serialize(this->getMatrix());
+	serial.serialize(this->getNrOfChildren());
+	serial.serialize("[none]"); // Target
+
+	// Data:
+	serial.serialize(static_cast<uint8_t>(1)); // Subtype (default mesh)
+	serial.serialize(reserved->material.get().getName());
+	serial.serialize(reserved->radius);
+	serial.serialize(reserved->bboxMin);
+	serial.serialize(reserved->bboxMax);
+	serial.serialize(static_cast<uint8_t>(0)); // No physics
+
+	// Geometry (all the LODs):
+	uint32_t nrOfVertices = geometry ? geometry->vbo.getNrOfVertices() : 0;
+	uint32_t nrOfFaces = geometry ? geometry->ebo.getNrOfFaces() : 0;
+	serial.serialize(static_cast<uint32_t>(nrOfVertices ? geometry->lod.size() : 0));
+	if (nrOfVertices)
+	{
+		std::vector<Eng::Vbo::VertexData> vertices(nrOfVertices);
+		std::vector<Eng::Ebo::FaceData> faces(nrOfFaces);
+
+		if (geometry->vbo.read(vertices.data()) == false)
+			return false;
+
+		// 16-bit indices are expanded back (lossless):
+		if (geometry->ebo.getLayout() == Eng::Ebo::Layout::compact)
+		{
+			std::vector<Eng::Ebo::CompactFaceData> compact(nrOfFaces);
+			if (nrOfFaces && geometry->ebo.read(compact.data()) == false)
+				return false;
+			for (uint32_t c = 0; c < nrOfFaces; c++)
+			{
+				faces[c].a = compact[c].a;
+				faces[c].b = compact[c].b;
+				faces[c].c = compact[c].c;
+			}
+		}
+		else if (nrOfFaces && geometry->ebo.read(faces.data()) == false)
+			return false;
+		std::vector<uint8_t> vertexBytes, faceBytes;
+		for (const Geometry::Lod& lod : geometry->lod)
+		{
+			serial.serialize(lod.nrOfVertices);
+			serial.serialize(lod.nrOfFaces);
+			if (encoded)
+			{
+				if (Eng::MeshCodec::encodeVertices(vertices.data() + lod.firstVertex, lod.nrOfVertices, vertexBytes) == false ||
+				    Eng::MeshCodec::encodeFaces(faces.data() + lod.firstFace, lod.nrOfFaces, faceBytes) == false)
+					return false;
+				serial.serialize(static_cast<uint32_t>(vertexBytes.size()));
+				serial.serialize(vertexBytes.data(), vertexBytes.size());
+				serial.serialize(static_cast<uint32_t>(faceBytes.size()));
+				serial.serialize(faceBytes.data(), faceBytes.size());
+			}
+			else
+			{
+				serial.serialize(vertices.data() + lod.firstVertex, lod.nrOfVertices * sizeof(Eng::Vbo::VertexData));
+				serial.serialize(faces.data() + lod.firstFace, lod.nrOfFaces * sizeof(Eng::Ebo::FaceData));
+			}
+		}
+	}
+
+	// Done:
+	return endChunk(serial, chunkPosition);
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Rendering method. 
- * @param value generic value
- * @param data generic pointer to any kind of data
+ * @param value level of detail (clamped to the available ones)
+ * @param data pointer to the modelview matrix
  * @return TF
  */
 bool ENG_API Eng::Mesh::render(uint32_t value, void* data) const
 {
+	// Safety net:
+	if (getNrOfLods() == 0)
+		return true;
+	const Geometry& geometry = *reserved->geometry;
+	const Geometry::Lod& lod = geometry.lod[std::min(value, getNrOfLods() - 1)];
+
+	// Quantized positions are mapped back by the modelview (normals are not affected):
+	const glm::mat4& modelview = *((glm::mat4*)data);
+	Eng::Program& program = dynamic_cast<Eng::Program&>(Eng::Program::getCached());
+	program.setMat4("modelviewMat", modelview * geometry.dequantization);
+	program.setMat3("normalMat", glm::inverseTranspose(glm::mat3(modelview)));
+
+	reserved->material.get().render();
+
+	geometry.vao.render();
+	const bool compact = geometry.ebo.getLayout() == Eng::Ebo::Layout::compact;
+	const uint64_t faceSize = compact ? sizeof(Eng::Ebo::CompactFaceData) : sizeof(Eng::Ebo::FaceData);
+	glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(lod.nrOfFaces * 3), compact ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+	                         reinterpret_cast<void*>(static_cast<uintptr_t>(lod.firstFace * faceSize)),
+	                         static_cast<GLint>(lod.firstVertex));
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rendering method, restricted to the given triangle ranges (e.g., the visible meshlets), submitted as a single
+ * multi-draw call.
+ * @param lod level of detail (clamped to the available ones)
+ * @param modelview modelview matrix
+ * @param ranges triangle ranges to draw, relative to the LOD
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::render(uint32_t lod, const glm::mat4& modelview,
+                               const std::vector<Eng::MeshOptimizer::FaceRange>& ranges) const
+{
+	// Safety net:
+	if (getNrOfLods() == 0)
+		return true;
+	const Geometry& geometry = *reserved->geometry;
+	const Geometry::Lod& range = geometry.lod[std::min(lod, getNrOfLods() - 1)];
+
+	// Quantized positions are mapped back by the modelview (normals are not affected):
 	Eng::Program& program = dynamic_cast<Eng::Program&>(Eng::Program::getCached());
-	program.setMat4("modelviewMat", *((glm::mat4*)data));
-	program.setMat3("normalMat", glm::inverseTranspose(glm::mat3(*((glm::mat4*)data))));
+	program.setMat4("modelviewMat", modelview * geometry.dequantization);
+	program.setMat3("normalMat", glm::inverseTranspose(glm::mat3(modelview)));
 
 	reserved->material.get().render();
 
-	reserved->vao.render();
-	glDrawElements(GL_TRIANGLES, reserved->ebo.getNrOfFaces() * 3, GL_UNSIGNED_INT, nullptr);
+	// Byte offsets into the element buffer:
+	const bool compact = geometry.ebo.getLayout() == Eng::Ebo::Layout::compact;
+	const uint64_t faceSize = compact ? sizeof(Eng::Ebo::CompactFaceData) : sizeof(Eng::Ebo::FaceData);
+	std::vector<GLsizei> count(ranges.size());
+	std::vector<void*> offset(ranges.size());
+	std::vector<GLint> baseVertex(ranges.size(), static_cast<GLint>(range.firstVertex));
+	for (size_t c = 0; c < ranges.size(); c++)
+	{
+		count[c] = static_cast<GLsizei>(ranges[c].nrOfFaces * 3);
+		offset[c] = reinterpret_cast<void*>(static_cast<uintptr_t>((range.firstFace + ranges[c].firstFace) * faceSize));
+	}
+
+	geometry.vao.render();
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, count.data(), compact ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, offset.data(),
+	                              static_cast<GLsizei>(ranges.size()), baseVertex.data());
 
 	// Done:
 	return true;
@@ -19,6 +19,49 @@ public: //
 	// Special values:
 	static Mesh empty;
 
+	/**
+	 * @brief CPU-side content of a mesh chunk. Arrays point into the serializer storage, which must outlive this
+	 * struct, or into the storage of the LOD itself once the geometry is processed (e.g., by optimizeStaging()).
+	 */
+	struct Staging
+	{
+		/**
+		 * @brief Geometry of a single level of detail.
+		 */
+		struct Lod
+		{
+			const Eng::Vbo::VertexData* vertices; ///< Vertex array
+			uint32_t nrOfVertices; ///< Number of vertices
+			const Eng::Ebo::FaceData* faces; ///< Face array
+			uint32_t nrOfFaces; ///< Number of faces
+			std::vector<Eng::Vbo::VertexData> vertexStorage; ///< Processed vertices (empty if unprocessed)
+			std::vector<Eng::Ebo::FaceData> faceStorage; ///< Processed faces (empty if unprocessed)
+			std::vector<Eng::MeshOptimizer::Meshlet> meshlet; ///< Triangle clusters (empty if unclustered)
+		};
+
+		std::string name; ///< Mesh name
+		glm::mat4 matrix; ///< Node matrix
+		uint32_t nrOfChildren; ///< Number of children nodes
+		std::string materialName; ///< Name of the material
+		const Eng::Material* material; ///< Pre-resolved material (nullptr to look it up by name)
+		float radius; ///< Bounding sphere radius
+		glm::vec3 bboxMin; ///< Bounding box min corner
+		glm::vec3 bboxMax; ///< Bounding box max corner
+		std::vector<Lod> lod; ///< Levels of detail
+		bool compact; ///< Upload using the compact buffer layouts (quantized positions, 16-bit indices when possible)
+		bool keepShape; ///< Keep a CPU-side copy of the LOD 0 positions and triangles (see getShape())
+	};
+
+
+	/**
+	 * @brief CPU-side copy of the geometry (positions and triangles only), for CPU queries such as occlusion culling.
+	 */
+	struct Shape
+	{
+		std::vector<glm::vec3> vertex; ///< Vertex positions
+		std::vector<uint32_t> index; ///< Vertex indices, three per triangle
+	};
+
 
 	// Const/dest:
 	Mesh();
@@ -32,12 +75,41 @@ public: //
 	// Get/set:
 	bool setMaterial(const Eng::Material& mat);
 	const Eng::Material& getMaterial() const;
+	float getRadius() const;
+	const glm::vec3& getBBoxMin() const;
+	const glm::vec3& getBBoxMax() const;
+	uint32_t getNrOfLods() const;
+	uint32_t getNrOfFaces(uint32_t lod = 0) const;
+	const std::vector<Eng::MeshOptimizer::Meshlet>& getMeshlets(uint32_t lod = 0) const;
+
+	// Bounding volumes:
+	bool getBoundingSphere(glm::vec3& center, float& radius) const override;
+
+	// Occlusion:
+	void setOccluder(bool occluder);
+	bool isOccluder() const;
+	void setShape(const std::shared_ptr<const Shape>& shape);
+	const Shape* getShape() const;
+
+	// Geometry sharing:
+	uint64_t getGeometryKey() const;
+	static uint64_t getNrOfSharedBytes();
 
 	// Rendering methods:   
 	bool render(uint32_t value = 0, void* data = nullptr) const;
+	bool render(uint32_t lod, const glm::mat4& modelview, const std::vector<Eng::MeshOptimizer::FaceRange>& ranges) const;
 
 	// Ovo:   
 	uint32_t loadChunk(Eng::Serializer& serial, void* data = nullptr);
+	static bool decodeChunk(Eng::Serializer& serial, Staging& staging);
+	uint32_t loadStaging(const Staging& staging);
+	bool saveChunk(Eng::Serializer& serial) const override;
+	bool saveChunk(Eng::Serializer& serial, bool encoded) const;
+
+	// Processing:
+	static bool simplifyStaging(Staging& staging, uint32_t nrOfLods, float ratio = Eng::MeshOptimizer::defaultLodRatio);
+	static bool optimizeStaging(Staging& staging);
+	static bool clusterStaging(Staging& staging);
 
 
 	///////////
@@ -45,8 +117,11 @@ private: //
 	///////////
 
 	// Reserved:
+	struct Geometry;
 	struct Reserved;
 	std::unique_ptr<Reserved> reserved;
+	struct StaticReserved;
+	static std::unique_ptr<StaticReserved> staticReserved;
 
 	// Const/dest:
 	Mesh(const std::string& name);
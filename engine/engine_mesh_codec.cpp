@@ -0,0 +1,581 @@
+/**
+ * @file		engine_mesh_codec.cpp
+ * @brief	Lossless compression of mesh geometry
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <algorithm>
+#include <cstring>
+
+// SIMD (x86 only, SSE2 is part of the x64 baseline):
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ENG_MESH_CODEC_SSE
+#include <emmintrin.h>
+#endif
+
+
+////////////
+// STATIC //
+////////////
+
+// Filtering:
+static constexpr uint32_t maxChannels = 6; ///< Max 32-bit words per element
+static constexpr uint32_t blockSize = 16; ///< Elements unfiltered at once by the SIMD path
+
+// LZ77 backend (sequences of literals followed by a back-reference, as in LZ4):
+static constexpr uint32_t lzMinMatch = 4; ///< Shortest back-reference
+static constexpr uint32_t lzMaxOffset = 65535; ///< Farthest back-reference (16-bit offsets)
+static constexpr uint32_t lzHashBits = 16; ///< Size of the match finder table (log2)
+static constexpr uint32_t lzChunkSize = 16; ///< Slack required to copy in 16-byte chunks
+
+
+/**
+ * Zigzag-encodes a delta, so that small negative values become small unsigned values.
+ */
+static inline uint32_t zigzag(uint32_t delta)
+{
+	return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+
+/**
+ * Reverses zigzag().
+ */
+static inline uint32_t unzigzag(uint32_t value)
+{
+	return (value >> 1) ^ (0u - (value & 1));
+}
+
+
+/**
+ * Filters an array of elements made of 32-bit words: each word is replaced by the zigzag-encoded delta with the same
+ * word of the previous element, and the bytes are split into planes (byte b of word k goes into plane k * 4 + b).
+ * @param data elements
+ * @param nrOfElements number of elements
+ * @param nrOfChannels words per element
+ * @param planes output, nrOfElements * nrOfChannels * 4 bytes
+ */
+static void filterWords(const uint8_t* data, uint64_t nrOfElements, uint32_t nrOfChannels, uint8_t* planes)
+{
+	uint32_t prev[maxChannels] = {};
+	for (uint64_t i = 0; i < nrOfElements; i++)
+		for (uint32_t k = 0; k < nrOfChannels; k++)
+		{
+			uint32_t word;
+			memcpy(&word, data + (i * nrOfChannels + k) * sizeof(uint32_t), sizeof(uint32_t));
+			const uint32_t value = zigzag(word - prev[k]);
+			prev[k] = word;
+			for (uint32_t b = 0; b < 4; b++)
+				planes[(k * 4 + b) * nrOfElements + i] = static_cast<uint8_t>(value >> (8 * b));
+		}
+}
+
+
+/**
+ * Reverses filterWords(), from the given element on.
+ * @param planes byte planes
+ * @param nrOfElements number of elements
+ * @param nrOfChannels words per element
+ * @param first first element to unfilter
+ * @param prev words of the element before the first one
+ * @param data output elements
+ */
+static void unfilterWordsScalar(const uint8_t* planes, uint64_t nrOfElements, uint32_t nrOfChannels, uint64_t first,
+                                uint32_t prev[maxChannels], uint8_t* data)
+{
+	for (uint64_t i = first; i < nrOfElements; i++)
+		for (uint32_t k = 0; k < nrOfChannels; k++)
+		{
+			const uint8_t* plane = planes + k * 4 * nrOfElements + i;
+			const uint32_t value = plane[0] | (plane[nrOfElements] << 8) | (plane[2 * nrOfElements] << 16) |
+			                       (static_cast<uint32_t>(plane[3 * nrOfElements]) << 24);
+			prev[k] += unzigzag(value);
+			memcpy(data + (i * nrOfChannels + k) * sizeof(uint32_t), &prev[k], sizeof(uint32_t));
+		}
+}
+
+
+#ifdef ENG_MESH_CODEC_SSE
+/**
+ * Reverses filterWords() with SSE2, blockSize elements at a time: the four planes of a word are interleaved back with
+ * unpacks, and the deltas are accumulated with an in-register prefix sum. Elements of one word (indices) and of six
+ * words (vertices) are also written back with vector stores.
+ * @param planes byte planes
+ * @param nrOfElements number of elements
+ * @param nrOfChannels words per element
+ * @param data output elements
+ */
+static void unfilterWordsSse(const uint8_t* planes, uint64_t nrOfElements, uint32_t nrOfChannels, uint8_t* data)
+{
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i carry[maxChannels];
+	for (uint32_t k = 0; k < nrOfChannels; k++)
+		carry[k] = _mm_setzero_si128();
+
+	uint64_t i = 0;
+	for (; i + blockSize <= nrOfElements; i += blockSize)
+	{
+		// Words of 16 elements, 4 per register:
+		__m128i word[maxChannels][4];
+		for (uint32_t k = 0; k < nrOfChannels; k++)
+		{
+			const uint8_t* plane = planes + k * 4 * nrOfElements + i;
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + nrOfElements));
+			const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + 2 * nrOfElements));
+			const __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + 3 * nrOfElements));
+			const __m128i lo01 = _mm_unpacklo_epi8(p0, p1), hi01 = _mm_unpackhi_epi8(p0, p1);
+			const __m128i lo23 = _mm_unpacklo_epi8(p2, p3), hi23 = _mm_unpackhi_epi8(p2, p3);
+			word[k][0] = _mm_unpacklo_epi16(lo01, lo23);
+			word[k][1] = _mm_unpackhi_epi16(lo01, lo23);
+			word[k][2] = _mm_unpacklo_epi16(hi01, hi23);
+			word[k][3] = _mm_unpackhi_epi16(hi01, hi23);
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				__m128i x = _mm_xor_si128(_mm_srli_epi32(word[k][j], 1),
+				                          _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(word[k][j], one)));
+				x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+				x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+				x = _mm_add_epi32(x, carry[k]);
+				carry[k] = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+				word[k][j] = x;
+			}
+		}
+
+		// Back to interleaved words:
+		__m128i* dst = reinterpret_cast<__m128i*>(data + i * nrOfChannels * sizeof(uint32_t));
+		if (nrOfChannels == 1)
+			for (uint32_t j = 0; j < 4; j++)
+				_mm_storeu_si128(dst + j, word[0][j]);
+		else if (nrOfChannels == 6)
+			for (uint32_t j = 0; j < 4; j++, dst += 6)
+			{
+				// 6x4 transpose, 4 elements of 6 words each into 6 registers:
+				const __m128i t0 = _mm_unpacklo_epi32(word[0][j], word[1][j]);
+				const __m128i t1 = _mm_unpacklo_epi32(word[2][j], word[3][j]);
+				const __m128i t2 = _mm_unpackhi_epi32(word[0][j], word[1][j]);
+				const __m128i t3 = _mm_unpackhi_epi32(word[2][j], word[3][j]);
+				const __m128i t4 = _mm_unpacklo_epi32(word[4][j], word[5][j]);
+				const __m128i t5 = _mm_unpackhi_epi32(word[4][j], word[5][j]);
+				_mm_storeu_si128(dst, _mm_unpacklo_epi64(t0, t1));
+				_mm_storeu_si128(dst + 1, _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(t4), _mm_castsi128_pd(t0), 2)));
+				_mm_storeu_si128(dst + 2, _mm_unpackhi_epi64(t1, t4));
+				_mm_storeu_si128(dst + 3, _mm_unpacklo_epi64(t2, t3));
+				_mm_storeu_si128(dst + 4, _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(t5), _mm_castsi128_pd(t2), 2)));
+				_mm_storeu_si128(dst + 5, _mm_unpackhi_epi64(t3, t5));
+			}
+		else
+			for (uint32_t k = 0; k < nrOfChannels; k++)
+			{
+				alignas(16) uint32_t value[blockSize];
+				for (uint32_t j = 0; j < 4; j++)
+					_mm_store_si128(reinterpret_cast<__m128i*>(value + j * 4), word[k][j]);
+				for (uint32_t j = 0; j < blockSize; j++)
+					memcpy(data + ((i + j) * nrOfChannels + k) * sizeof(uint32_t), &value[j], sizeof(uint32_t));
+			}
+	}
+
+	// Tail:
+	uint32_t prev[maxChannels];
+	for (uint32_t k = 0; k < nrOfChannels; k++)
+		prev[k] = static_cast<uint32_t>(_mm_cvtsi128_si32(carry[k]));
+	unfilterWordsScalar(planes, nrOfElements, nrOfChannels, i, prev, data);
+}
+#endif
+
+
+/**
+ * Filters and compresses an array of elements made of 32-bit words. The first byte of the output is the Method.
+ * @param data elements
+ * @param nrOfElements number of elements
+ * @param nrOfChannels words per element
+ * @param output encoded array
+ * @return TF
+ */
+static bool encodeWords(const void* data, uint64_t nrOfElements, uint32_t nrOfChannels, std::vector<uint8_t>& output)
+{
+	const uint64_t nrOfBytes = nrOfElements * nrOfChannels * sizeof(uint32_t);
+	std::vector<uint8_t> planes(nrOfBytes);
+	filterWords(static_cast<const uint8_t*>(data), nrOfElements, nrOfChannels, planes.data());
+
+	std::vector<uint8_t> compressed;
+	if (Eng::MeshCodec::compress(planes.data(), nrOfBytes, compressed) == false)
+		return false;
+
+	// Keep the smaller representation:
+	output.clear();
+	if (compressed.size() < nrOfBytes)
+	{
+		output.reserve(compressed.size() + 1);
+		output.push_back(static_cast<uint8_t>(Eng::MeshCodec::Method::lz));
+		output.insert(output.end(), compressed.begin(), compressed.end());
+	}
+	else
+	{
+		output.reserve(nrOfBytes + 1);
+		output.push_back(static_cast<uint8_t>(Eng::MeshCodec::Method::stored));
+		output.insert(output.end(), planes.begin(), planes.end());
+	}
+
+	// Done:
+	return true;
+}
+
+
+/**
+ * Reverses encodeWords().
+ * @param encoded encoded array
+ * @param nrOfEncodedBytes size of the encoded array
+ * @param data output elements
+ * @param nrOfElements number of elements
+ * @param nrOfChannels words per element
+ * @param simd TF to use the SIMD paths when available
+ * @return TF
+ */
+static bool decodeWords(const void* encoded, uint64_t nrOfEncodedBytes, void* data, uint64_t nrOfElements,
+                        uint32_t nrOfChannels, bool simd)
+{
+	// Safety net:
+	if (encoded == nullptr || nrOfEncodedBytes == 0 || (data == nullptr && nrOfElements))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(encoded);
+	const uint64_t nrOfBytes = nrOfElements * nrOfChannels * sizeof(uint32_t);
+	std::unique_ptr<uint8_t[]> storage; // Not value-initialized
+	const uint8_t* planes = bytes + 1;
+	switch (static_cast<Eng::MeshCodec::Method>(bytes[0]))
+	{
+		////////////////////////////////////////
+	case Eng::MeshCodec::Method::stored: //
+		if (nrOfEncodedBytes - 1 != nrOfBytes)
+		{
+			ENG_LOG_ERROR("Corrupted data");
+			return false;
+		}
+		break;
+
+		////////////////////////////////////
+	case Eng::MeshCodec::Method::lz: //
+		storage.reset(new uint8_t[nrOfBytes]);
+		if (Eng::MeshCodec::decompress(bytes + 1, nrOfEncodedBytes - 1, storage.get(), nrOfBytes, simd) == false)
+			return false;
+		planes = storage.get();
+		break;
+
+	default:
+		ENG_LOG_ERROR("Unsupported method");
+		return false;
+	}
+
+#ifdef ENG_MESH_CODEC_SSE
+	if (simd)
+	{
+		unfilterWordsSse(planes, nrOfElements, nrOfChannels, static_cast<uint8_t*>(data));
+		return true;
+	}
+#endif
+	uint32_t prev[maxChannels] = {};
+	unfilterWordsScalar(planes, nrOfElements, nrOfChannels, 0, prev, static_cast<uint8_t*>(data));
+
+	// Done:
+	return true;
+}
+
+
+/**
+ * Appends an extended length (runs of 255, then the remainder).
+ */
+static void lzWriteLength(std::vector<uint8_t>& output, uint64_t length)
+{
+	for (; length >= 255; length -= 255)
+		output.push_back(255);
+	output.push_back(static_cast<uint8_t>(length));
+}
+
+
+/**
+ * Reads an extended length.
+ * @return TF (false if the input is truncated)
+ */
+static inline bool lzReadLength(const uint8_t*& src, const uint8_t* srcEnd, uint64_t& length)
+{
+	uint8_t byte;
+	do
+	{
+		if (src == srcEnd)
+			return false;
+		byte = *src++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+
+/**
+ * Copies nrOfBytes in 16-byte chunks, possibly writing up to 15 bytes past the end.
+ */
+static inline void lzWildCopy(uint8_t* dst, const uint8_t* src, uint64_t nrOfBytes, bool simd)
+{
+#ifdef ENG_MESH_CODEC_SSE
+	if (simd)
+	{
+		for (uint64_t c = 0; c < nrOfBytes; c += lzChunkSize)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + c), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + c)));
+		return;
+	}
+#endif
+	for (uint64_t c = 0; c < nrOfBytes; c += lzChunkSize)
+		memcpy(dst + c, src + c, lzChunkSize);
+}
+
+
+/////////////////////////////
+// BODY OF CLASS MeshCodec //
+/////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Encodes a vertex array. Each vertex is handled as six 32-bit words (position, packed normal, uv and tangent).
+ * @param vertices vertex array
+ * @param nrOfVertices number of vertices
+ * @param output encoded array
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::encodeVertices(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                            std::vector<uint8_t>& output)
+{
+	static_assert(sizeof(Eng::Vbo::VertexData) == maxChannels * sizeof(uint32_t), "Unexpected vertex layout");
+
+	// Safety net:
+	if (vertices == nullptr && nrOfVertices)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Done:
+	return encodeWords(vertices, nrOfVertices, sizeof(Eng::Vbo::VertexData) / sizeof(uint32_t), output);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a vertex array encoded by encodeVertices().
+ * @param data encoded array
+ * @param nrOfBytes size of the encoded array
+ * @param vertices output vertex array
+ * @param nrOfVertices number of vertices
+ * @param simd TF to use the SIMD paths when available (the output is the same)
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::decodeVertices(const void* data, uint64_t nrOfBytes, Eng::Vbo::VertexData* vertices,
+                                            uint32_t nrOfVertices, bool simd)
+{
+	return decodeWords(data, nrOfBytes, vertices, nrOfVertices, sizeof(Eng::Vbo::VertexData) / sizeof(uint32_t), simd);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Encodes a face array. Indices are handled as a single stream, so that each index is predicted by the previous one.
+ * @param faces face array
+ * @param nrOfFaces number of faces
+ * @param output encoded array
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::encodeFaces(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, std::vector<uint8_t>& output)
+{
+	static_assert(sizeof(Eng::Ebo::FaceData) == 3 * sizeof(uint32_t), "Unexpected face layout");
+
+	// Safety net:
+	if (faces == nullptr && nrOfFaces)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Done:
+	return encodeWords(faces, nrOfFaces * 3ull, 1, output);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a face array encoded by encodeFaces().
+ * @param data encoded array
+ * @param nrOfBytes size of the encoded array
+ * @param faces output face array
+ * @param nrOfFaces number of faces
+ * @param simd TF to use the SIMD paths when available (the output is the same)
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::decodeFaces(const void* data, uint64_t nrOfBytes, Eng::Ebo::FaceData* faces,
+                                         uint32_t nrOfFaces, bool simd)
+{
+	return decodeWords(data, nrOfBytes, faces, nrOfFaces * 3ull, 1, simd);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Compresses a buffer with the LZ77 backend. The output is a series of sequences, each made of a token (literal length
+ * and match length, 4 bits each, with 15 meaning that extra length bytes follow), the literals, and a 16-bit offset
+ * back into the output followed by the match length; the last sequence has literals only. Matches are found greedily
+ * through a hash table of 4-byte prefixes.
+ * @param data buffer to compress
+ * @param nrOfBytes size of the buffer
+ * @param output compressed buffer
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::compress(const void* data, uint64_t nrOfBytes, std::vector<uint8_t>& output)
+{
+	// Safety net:
+	if ((data == nullptr && nrOfBytes) || nrOfBytes >= UINT32_MAX)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	const uint8_t* src = static_cast<const uint8_t*>(data);
+	output.clear();
+	output.reserve(nrOfBytes / 2 + 16);
+	auto emit = [&output, src](uint64_t anchor, uint64_t nrOfLiterals, uint32_t offset, uint64_t matchLength)
+	{
+		const uint64_t code = matchLength ? matchLength - lzMinMatch : 0;
+		output.push_back(static_cast<uint8_t>((std::min<uint64_t>(nrOfLiterals, 15) << 4) | std::min<uint64_t>(code, 15)));
+		if (nrOfLiterals >= 15)
+			lzWriteLength(output, nrOfLiterals - 15);
+		output.insert(output.end(), src + anchor, src + anchor + nrOfLiterals);
+		if (matchLength == 0)
+			return;
+		output.push_back(static_cast<uint8_t>(offset));
+		output.push_back(static_cast<uint8_t>(offset >> 8));
+		if (code >= 15)
+			lzWriteLength(output, code - 15);
+	};
+
+	std::vector<uint32_t> table(1u << lzHashBits, UINT32_MAX);
+	uint64_t anchor = 0, position = 0, misses = 0;
+	while (position + lzMinMatch <= nrOfBytes)
+	{
+		uint32_t prefix;
+		memcpy(&prefix, src + position, sizeof(uint32_t));
+		const uint32_t hash = (prefix * 2654435761u) >> (32 - lzHashBits);
+		const uint32_t candidate = table[hash];
+		table[hash] = static_cast<uint32_t>(position);
+
+		uint32_t other = ~prefix;
+		if (candidate != UINT32_MAX && position - candidate <= lzMaxOffset)
+			memcpy(&other, src + candidate, sizeof(uint32_t));
+		if (other == prefix)
+		{
+			uint64_t length = lzMinMatch;
+			while (position + length < nrOfBytes && src[candidate + length] == src[position + length])
+				length++;
+			emit(anchor, position - anchor, static_cast<uint32_t>(position - candidate), length);
+			position += length;
+			anchor = position;
+			misses = 0;
+		}
+		else
+			position += 1 + (misses++ >> 6); // Skip faster through incompressible data
+	}
+	emit(anchor, nrOfBytes - anchor, 0, 0);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decompresses a buffer compressed by compress(). The input is fully validated, so corrupted data is detected and never
+ * read or written out of bounds.
+ * @param data compressed buffer
+ * @param nrOfBytes size of the compressed buffer
+ * @param output decompressed buffer
+ * @param nrOfOutputBytes size of the decompressed buffer (must match the original size)
+ * @param simd TF to use the SIMD paths when available (the output is the same)
+ * @return TF
+ */
+bool ENG_API Eng::MeshCodec::decompress(const void* data, uint64_t nrOfBytes, void* output, uint64_t nrOfOutputBytes,
+                                        bool simd)
+{
+	// Safety net:
+	if (data == nullptr || nrOfBytes == 0 || (output == nullptr && nrOfOutputBytes))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	const uint8_t* src = static_cast<const uint8_t*>(data);
+	const uint8_t* const srcEnd = src + nrOfBytes;
+	uint8_t* const dstBegin = static_cast<uint8_t*>(output);
+	uint8_t* dst = dstBegin;
+	uint8_t* const dstEnd = dst + nrOfOutputBytes;
+	while (true)
+	{
+		// Literals:
+		if (src == srcEnd)
+			break;
+		const uint8_t token = *src++;
+		uint64_t nrOfLiterals = token >> 4;
+		if (nrOfLiterals == 15 && lzReadLength(src, srcEnd, nrOfLiterals) == false)
+			break;
+		if (nrOfLiterals > static_cast<uint64_t>(srcEnd - src) || nrOfLiterals > static_cast<uint64_t>(dstEnd - dst))
+			break;
+		if (static_cast<uint64_t>(srcEnd - src) >= nrOfLiterals + lzChunkSize &&
+		    static_cast<uint64_t>(dstEnd - dst) >= nrOfLiterals + lzChunkSize)
+			lzWildCopy(dst, src, nrOfLiterals, simd);
+		else
+			memcpy(dst, src, nrOfLiterals);
+		src += nrOfLiterals;
+		dst += nrOfLiterals;
+
+		// Last sequence?
+		if (src == srcEnd)
+		{
+			if (dst == dstEnd)
+				return true;
+			break;
+		}
+
+		// Match:
+		if (srcEnd - src < 2)
+			break;
+		const uint64_t offset = src[0] | (src[1] << 8);
+		src += 2;
+		uint64_t length = token & 15;
+		if (length == 15 && lzReadLength(src, srcEnd, length) == false)
+			break;
+		length += lzMinMatch;
+		if (offset == 0 || offset > static_cast<uint64_t>(dst - dstBegin) || length > static_cast<uint64_t>(dstEnd - dst))
+			break;
+		const uint8_t* match = dst - offset;
+		if (offset >= lzChunkSize && static_cast<uint64_t>(dstEnd - dst) >= length + lzChunkSize)
+			lzWildCopy(dst, match, length, simd);
+		else if (offset == 1)
+			memset(dst, *match, length);
+		else
+			for (uint64_t c = 0; c < length; c++)
+				dst[c] = match[c];
+		dst += length;
+	}
+
+	// Done:
+	ENG_LOG_ERROR("Corrupted data");
+	return false;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file		engine_mesh_codec.h
+ * @brief	Lossless compression of mesh geometry
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Lossless codec for vertex and face arrays. Arrays are filtered into byte planes of zigzag-encoded deltas
+ * (between consecutive vertices, for each 32-bit attribute word, and between consecutive indices), which are then
+ * compressed with a byte-oriented LZ77 backend. All methods work on CPU-side arrays, so they can be invoked from
+ * worker threads and do not require an OpenGL context.
+ */
+class ENG_API MeshCodec
+{
+	//////////
+public: //
+	//////////
+
+	/**
+	 * @brief Backend used for an encoded array, stored in its first byte.
+	 */
+	enum class Method : uint32_t
+	{
+		stored, ///< Byte planes stored as they are (incompressible data)
+		lz, ///< Byte planes compressed with the LZ77 backend
+
+		// Terminator:
+		last
+	};
+
+
+	// Const/dest:
+	MeshCodec() = delete;
+
+	// Geometry:
+	static bool encodeVertices(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices, std::vector<uint8_t>& output);
+	static bool decodeVertices(const void* data, uint64_t nrOfBytes, Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+	                           bool simd = true);
+	static bool encodeFaces(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, std::vector<uint8_t>& output);
+	static bool decodeFaces(const void* data, uint64_t nrOfBytes, Eng::Ebo::FaceData* faces, uint32_t nrOfFaces,
+	                        bool simd = true);
+
+	// Backend:
+	static bool compress(const void* data, uint64_t nrOfBytes, std::vector<uint8_t>& output);
+	static bool decompress(const void* data, uint64_t nrOfBytes, void* output, uint64_t nrOfOutputBytes, bool simd = true);
+};
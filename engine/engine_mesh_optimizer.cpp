@@ -0,0 +1,1140 @@
+/**
+ * @file		engine_mesh_optimizer.cpp
+ * @brief	CPU-side mesh geometry processing
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+////////////
+// STATIC //
+////////////
+
+// Vertex scoring (Forsyth, "Linear-speed vertex cache optimisation"):
+static constexpr uint32_t scoringCacheSize = 32; ///< LRU cache size assumed by the scores
+static constexpr uint32_t maxValence = 32; ///< Valence scores are clamped beyond this value
+
+
+/**
+ * Simulates a FIFO post-transform cache over a triangle list.
+ * @param faces triangle list
+ * @param nrOfFaces number of triangles
+ * @param nrOfVertices number of vertices
+ * @param cacheSize cache size
+ * @param misses optional output, misses of each triangle (0 to 3)
+ * @return total number of misses
+ */
+static uint64_t simulateFifoCache(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices,
+                                  uint32_t cacheSize, uint8_t* misses = nullptr)
+{
+	// A vertex is resident if fewer than cacheSize misses happened since it was loaded:
+	std::vector<uint64_t> stamp(nrOfVertices, 0);
+	uint64_t time = cacheSize + 1;
+	uint64_t total = 0;
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+	{
+		uint8_t m = 0;
+		for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+			if (time - stamp[v] > cacheSize)
+			{
+				stamp[v] = time++;
+				m++;
+			}
+		if (misses)
+			misses[c] = m;
+		total += m;
+	}
+	return total;
+}
+
+
+/**
+ * Checks that all the indices refer to existing vertices.
+ * @return TF
+ */
+static bool validateFaces(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices)
+{
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		if (faces[c].a >= nrOfVertices || faces[c].b >= nrOfVertices || faces[c].c >= nrOfVertices)
+			return false;
+	return true;
+}
+
+
+// Simplification:
+static constexpr float normalWeight = 2.5e-4f; ///< Cost of a unit squared normal difference (relative to the extent)
+static constexpr float uvWeight = 1.0e-2f; ///< Cost of a unit squared texture coordinate difference
+
+
+/**
+ * @brief Error quadric (symmetric 4x4 matrix, upper triangle), accumulating the squared distances to a set of planes.
+ */
+struct Quadric
+{
+	double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+	double weight; ///< Sum of the plane weights
+
+
+	/**
+	 * Constructor.
+	 */
+	Quadric() : a00{0.0}, a01{0.0}, a02{0.0}, a03{0.0}, a11{0.0}, a12{0.0}, a13{0.0}, a22{0.0}, a23{0.0}, a33{0.0},
+	            weight{0.0} {}
+
+	/**
+	 * Adds a plane.
+	 * @param n unit plane normal
+	 * @param d plane offset
+	 * @param w plane weight
+	 */
+	void addPlane(const glm::dvec3& n, double d, double w)
+	{
+		a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+		a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+		a22 += w * n.z * n.z; a23 += w * n.z * d;
+		a33 += w * d * d;
+		weight += w;
+	}
+
+	/**
+	 * Accumulates another quadric.
+	 * @param q quadric
+	 */
+	void operator+=(const Quadric& q)
+	{
+		a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+		a11 += q.a11; a12 += q.a12; a13 += q.a13;
+		a22 += q.a22; a23 += q.a23;
+		a33 += q.a33;
+		weight += q.weight;
+	}
+
+	/**
+	 * Evaluates the error at the given point.
+	 * @param p point
+	 * @return weighted mean squared distance to the planes
+	 */
+	double evaluate(const glm::vec3& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double e = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+		                 a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+		                 a22 * z * z + 2.0 * a23 * z + a33;
+		return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+	}
+};
+
+
+/**
+ * Returns the key of an undirected edge.
+ * @param a first vertex
+ * @param b second vertex
+ * @return key (min << 32 | max)
+ */
+static inline uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+	return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+
+/////////////////////////////////
+// BODY OF CLASS MeshOptimizer //
+/////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Computes the post-transform cache efficiency of a triangle list, by simulating a FIFO cache.
+ * @param faces triangle list
+ * @param nrOfFaces number of triangles
+ * @param nrOfVertices number of vertices
+ * @param cacheSize cache size (in vertices)
+ * @return ACMR and ATVR (zeros if error)
+ */
+Eng::MeshOptimizer::CacheStats ENG_API Eng::MeshOptimizer::analyzeVertexCache(const Eng::Ebo::FaceData* faces,
+                                                                              uint32_t nrOfFaces, uint32_t nrOfVertices,
+                                                                              uint32_t cacheSize)
+{
+	CacheStats stats = {0.0f, 0.0f};
+
+	// Safety net:
+	if (faces == nullptr || nrOfFaces == 0 || cacheSize == 0 || !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return stats;
+	}
+
+	std::vector<bool> used(nrOfVertices, false);
+	uint32_t nrOfUsedVertices = 0;
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+			if (!used[v])
+			{
+				used[v] = true;
+				nrOfUsedVertices++;
+			}
+
+	uint64_t misses = simulateFifoCache(faces, nrOfFaces, nrOfVertices, cacheSize);
+
+	// Done:
+	stats.acmr = static_cast<float>(misses) / nrOfFaces;
+	stats.atvr = static_cast<float>(misses) / nrOfUsedVertices;
+	return stats;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reorders the triangles for post-transform cache locality (Forsyth's greedy algorithm: each step emits the triangle
+ * whose vertices score best, given their position in a simulated LRU cache and their number of remaining triangles).
+ * The algorithm does not depend on the exact cache size of the GPU.
+ * @param faces triangle list, reordered in place
+ * @param nrOfFaces number of triangles
+ * @param nrOfVertices number of vertices
+ * @return TF
+ */
+bool ENG_API Eng::MeshOptimizer::optimizeVertexCache(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices)
+{
+	// Safety net:
+	if (faces == nullptr || !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	if (nrOfFaces < 2)
+		return true;
+
+	// Score tables:
+	static const struct ScoreTable
+	{
+		float cache[scoringCacheSize]; ///< By cache position
+		float valence[maxValence + 1]; ///< By number of remaining triangles
+
+
+		/**
+		 * Constructor.
+		 */
+		ScoreTable()
+		{
+			for (uint32_t c = 0; c < scoringCacheSize; c++)
+				cache[c] = c < 3 ? 0.75f : std::pow(1.0f - (c - 3) / static_cast<float>(scoringCacheSize - 3), 1.5f);
+			valence[0] = 0.0f;
+			for (uint32_t c = 1; c <= maxValence; c++)
+				valence[c] = 2.0f / std::sqrt(static_cast<float>(c));
+		}
+	} table;
+
+	// Vertex to triangle adjacency (live triangles first in each range):
+	std::vector<uint32_t> nrOfLiveFaces(nrOfVertices, 0);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+	{
+		nrOfLiveFaces[faces[c].a]++;
+		nrOfLiveFaces[faces[c].b]++;
+		nrOfLiveFaces[faces[c].c]++;
+	}
+	std::vector<uint32_t> offset(nrOfVertices + 1, 0);
+	for (uint32_t v = 0; v < nrOfVertices; v++)
+		offset[v + 1] = offset[v] + nrOfLiveFaces[v];
+	std::vector<uint32_t> adjacency(offset[nrOfVertices]);
+	{
+		std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+		for (uint32_t c = 0; c < nrOfFaces; c++)
+			for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+				adjacency[fill[v]++] = c;
+	}
+
+	// Scores:
+	std::vector<int32_t> cachePosition(nrOfVertices, -1);
+	auto vertexScore = [&](uint32_t v) -> float
+	{
+		if (nrOfLiveFaces[v] == 0)
+			return -1.0f;
+		float score = table.valence[std::min(nrOfLiveFaces[v], maxValence)];
+		if (cachePosition[v] >= 0)
+			score += table.cache[cachePosition[v]];
+		return score;
+	};
+	std::vector<float> score(nrOfVertices);
+	for (uint32_t v = 0; v < nrOfVertices; v++)
+		score[v] = vertexScore(v);
+	std::vector<float> faceScore(nrOfFaces);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		faceScore[c] = score[faces[c].a] + score[faces[c].b] + score[faces[c].c];
+
+	// Greedy emission:
+	std::vector<Eng::Ebo::FaceData> output(nrOfFaces);
+	std::vector<bool> emitted(nrOfFaces, false);
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(scoringCacheSize + 3);
+	newCache.reserve(scoringCacheSize + 3);
+	uint32_t next = 0; ///< Fallback when the cache leads nowhere (first unemitted triangle, in input order)
+	uint32_t best = 0;
+	for (uint32_t c = 1; c < nrOfFaces; c++)
+		if (faceScore[c] > faceScore[best])
+			best = c;
+
+	for (uint32_t nrOfEmitted = 0; nrOfEmitted < nrOfFaces; nrOfEmitted++)
+	{
+		// Dead end?
+		if (best == UINT32_MAX)
+		{
+			while (emitted[next])
+				next++;
+			best = next;
+		}
+
+		// Emit:
+		const Eng::Ebo::FaceData face = faces[best];
+		output[nrOfEmitted] = face;
+		emitted[best] = true;
+		for (uint32_t v : {face.a, face.b, face.c})
+		{
+			uint32_t* first = adjacency.data() + offset[v];
+			uint32_t* last = first + nrOfLiveFaces[v];
+			std::iter_swap(std::find(first, last, best), last - 1);
+			nrOfLiveFaces[v]--;
+		}
+
+		// Update the LRU cache (the emitted vertices go first):
+		newCache.assign({face.a, face.b, face.c});
+		for (uint32_t v : cache)
+			if (v != face.a && v != face.b && v != face.c)
+				newCache.push_back(v);
+		for (uint32_t c = 0; c < newCache.size(); c++)
+			cachePosition[newCache[c]] = c < scoringCacheSize ? static_cast<int32_t>(c) : -1;
+
+		// Rescore the vertices involved and their live triangles, and pick the best one:
+		for (uint32_t v : newCache)
+			score[v] = vertexScore(v);
+		best = UINT32_MAX;
+		float bestScore = -FLT_MAX;
+		for (uint32_t v : newCache)
+			for (uint32_t c = offset[v]; c < offset[v] + nrOfLiveFaces[v]; c++)
+			{
+				uint32_t f = adjacency[c];
+				faceScore[f] = score[faces[f].a] + score[faces[f].b] + score[faces[f].c];
+				if (faceScore[f] > bestScore)
+				{
+					bestScore = faceScore[f];
+					best = f;
+				}
+			}
+
+		if (newCache.size() > scoringCacheSize)
+			newCache.resize(scoringCacheSize);
+		std::swap(cache, newCache);
+	}
+
+	// Done:
+	std::copy(output.begin(), output.end(), faces);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reorders clusters of triangles to reduce overdraw (Sander et al., "Fast triangle reordering for vertex locality and
+ * reduced overdraw"). The triangle list is split where the cache is flushed anyway and where restarting the cache keeps
+ * the ACMR within the threshold; clusters are then sorted so that the ones facing away from the mesh center come first.
+ * The triangle list is left unchanged if the overall ACMR grows beyond the threshold. Should be invoked after
+ * optimizeVertexCache().
+ * @param faces triangle list, reordered in place
+ * @param nrOfFaces number of triangles
+ * @param vertices vertex array
+ * @param nrOfVertices number of vertices
+ * @param threshold max ACMR growth of a cluster when splitting it (e.g., 1.05 allows a 5% worse ACMR)
+ * @return TF
+ */
+bool ENG_API Eng::MeshOptimizer::optimizeOverdraw(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces,
+                                                 const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                                 float threshold)
+{
+	// Safety net:
+	if (faces == nullptr || vertices == nullptr || threshold < 1.0f || !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	if (nrOfFaces < 2)
+		return true;
+
+	// Hard boundaries (all the vertices of the triangle missed the cache):
+	std::vector<uint8_t> misses(nrOfFaces);
+	simulateFifoCache(faces, nrOfFaces, nrOfVertices, defaultCacheSize, misses.data());
+	std::vector<uint32_t> hard;
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		if (c == 0 || misses[c] == 3)
+			hard.push_back(c);
+	hard.push_back(nrOfFaces);
+
+	// Soft boundaries (restarting the cache here keeps the ACMR of the cluster within the threshold):
+	std::vector<uint32_t> cluster;
+	std::vector<uint64_t> stamp(nrOfVertices, 0);
+	uint64_t time = defaultCacheSize + 1;
+	for (uint32_t h = 0; h + 1 < hard.size(); h++)
+	{
+		const uint32_t start = hard[h], end = hard[h + 1];
+		uint32_t clusterMisses = 0;
+		for (uint32_t c = start; c < end; c++)
+			clusterMisses += misses[c];
+		const float limit = threshold * clusterMisses / (end - start);
+
+		cluster.push_back(start);
+		time += defaultCacheSize + 1; // Flush
+		uint32_t subStart = start, subMisses = 0;
+		for (uint32_t c = start; c < end; c++)
+		{
+			for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+				if (time - stamp[v] > defaultCacheSize)
+				{
+					stamp[v] = time++;
+					subMisses++;
+				}
+			if (c + 1 < end && static_cast<float>(subMisses) / (c + 1 - subStart) <= limit)
+			{
+				cluster.push_back(c + 1);
+				subStart = c + 1;
+				subMisses = 0;
+				time += defaultCacheSize + 1;
+			}
+		}
+	}
+	cluster.push_back(nrOfFaces);
+
+	// Sort key of each cluster (area-weighted centroid and normal):
+	auto position = [vertices](uint32_t v) -> const glm::vec3& { return vertices[v].vertex; };
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> centroid(cluster.size() - 1, glm::vec3(0.0f)), normal(cluster.size() - 1, glm::vec3(0.0f));
+	std::vector<float> area(cluster.size() - 1, 0.0f);
+	for (uint32_t k = 0; k + 1 < cluster.size(); k++)
+		for (uint32_t c = cluster[k]; c < cluster[k + 1]; c++)
+		{
+			const glm::vec3& p0 = position(faces[c].a);
+			const glm::vec3& p1 = position(faces[c].b);
+			const glm::vec3& p2 = position(faces[c].c);
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float a = glm::length(n);
+			glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+			centroid[k] += center * a;
+			normal[k] += n;
+			area[k] += a;
+			meshCentroid += center * a;
+			meshArea += a;
+		}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	struct Cluster
+	{
+		uint32_t first, last;
+		float key;
+	};
+	std::vector<Cluster> order(cluster.size() - 1);
+	for (uint32_t k = 0; k < order.size(); k++)
+	{
+		order[k].first = cluster[k];
+		order[k].last = cluster[k + 1];
+		order[k].key = 0.0f;
+		float length = glm::length(normal[k]);
+		if (area[k] > 0.0f && length > 0.0f)
+			order[k].key = glm::dot(centroid[k] / area[k] - meshCentroid, normal[k] / length);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+	std::vector<Eng::Ebo::FaceData> output;
+	output.reserve(nrOfFaces);
+	for (const Cluster& k : order)
+		output.insert(output.end(), faces + k.first, faces + k.last);
+
+	// Clusters also lose the vertices they shared through the cache, so the overall ACMR is checked as well:
+	uint64_t totalMisses = 0;
+	for (uint8_t m : misses)
+		totalMisses += m;
+	if (simulateFifoCache(output.data(), nrOfFaces, nrOfVertices, defaultCacheSize) > threshold * totalMisses)
+	{
+		ENG_LOG_DETAIL("Overdraw ordering skipped (ACMR above threshold)");
+		return true;
+	}
+
+	// Done:
+	std::copy(output.begin(), output.end(), faces);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reorders the vertices in order of first use by the triangles, for pre-transform (fetch) locality, and updates the
+ * indices accordingly. Vertices not referenced by any triangle are dropped. Should be invoked after the triangle
+ * reordering.
+ * @param vertices vertex array, reordered in place
+ * @param nrOfVertices number of vertices
+ * @param faces triangle list, remapped in place
+ * @param nrOfFaces number of triangles
+ * @return number of vertices left (0 if error)
+ */
+uint32_t ENG_API Eng::MeshOptimizer::optimizeVertexFetch(Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                                        Eng::Ebo::FaceData* faces, uint32_t nrOfFaces)
+{
+	// Safety net:
+	if (vertices == nullptr || faces == nullptr || !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return 0;
+	}
+
+	std::vector<uint32_t> remap(nrOfVertices, UINT32_MAX);
+	std::vector<Eng::Vbo::VertexData> output;
+	output.reserve(nrOfVertices);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		for (uint32_t* v : {&faces[c].a, &faces[c].b, &faces[c].c})
+		{
+			if (remap[*v] == UINT32_MAX)
+			{
+				remap[*v] = static_cast<uint32_t>(output.size());
+				output.push_back(vertices[*v]);
+			}
+			*v = remap[*v];
+		}
+
+	// Done:
+	std::copy(output.begin(), output.end(), vertices);
+	return static_cast<uint32_t>(output.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Simplifies a triangle list by iterated edge collapses, ordered by quadric error (Garland-Heckbert), with vertices
+ * collapsing onto existing ones so that the vertex array is shared with the input. Vertices with the same position
+ * (e.g., along UV seams) are collapsed together, and only onto vertices connected by an edge, so that attribute seams
+ * stay closed; normal and texture coordinate changes are added to the cost. Vertices on open borders or non-manifold
+ * edges are locked, and collapses flipping a triangle or breaking the link condition (i.e., creating non-manifold
+ * edges) are rejected.
+ * @param vertices vertex array
+ * @param nrOfVertices number of vertices
+ * @param faces source triangle list
+ * @param nrOfFaces number of triangles
+ * @param targetFaces number of triangles to reach (if allowed by the max error)
+ * @param maxError max error, relative to the bounding box diagonal
+ * @param output simplified triangle list, indexing the same vertex array
+ * @param error max geometric error of the result, relative to the bounding box diagonal
+ * @return TF
+ */
+bool ENG_API Eng::MeshOptimizer::simplify(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                         const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t targetFaces,
+                                         float maxError, std::vector<Eng::Ebo::FaceData>& output, float& error)
+{
+	error = 0.0f;
+	output.clear();
+
+	// Safety net:
+	if (vertices == nullptr || faces == nullptr || maxError < 0.0f || !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	output.assign(faces, faces + nrOfFaces);
+	if (nrOfFaces <= targetFaces || nrOfVertices == 0)
+		return true;
+
+	// Extent:
+	glm::vec3 bboxMin(FLT_MAX), bboxMax(-FLT_MAX);
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+	{
+		bboxMin = glm::min(bboxMin, vertices[c].vertex);
+		bboxMax = glm::max(bboxMax, vertices[c].vertex);
+	}
+	const double extent = glm::length(bboxMax - bboxMin);
+	if (extent <= 0.0)
+		return true;
+	const double scale = 1.0 / (extent * extent);
+
+	// Vertices sharing the same position are welded (first one of each group):
+	std::vector<uint32_t> sorted(nrOfVertices);
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+		sorted[c] = c;
+	auto positionLess = [vertices](uint32_t a, uint32_t b)
+	{
+		const glm::vec3& pa = vertices[a].vertex;
+		const glm::vec3& pb = vertices[b].vertex;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		if (pa.z != pb.z) return pa.z < pb.z;
+		return a < b;
+	};
+	std::sort(sorted.begin(), sorted.end(), positionLess);
+	std::vector<uint32_t> weld(nrOfVertices);
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+		weld[sorted[c]] = c && vertices[sorted[c]].vertex == vertices[sorted[c - 1]].vertex ? weld[sorted[c - 1]] : sorted[c];
+
+	// Vertices of each welded position:
+	std::vector<uint32_t> groupOffset(nrOfVertices + 1, 0);
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+		groupOffset[weld[c] + 1]++;
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+		groupOffset[c + 1] += groupOffset[c];
+	std::vector<uint32_t> group(nrOfVertices);
+	{
+		std::vector<uint32_t> fill(groupOffset.begin(), groupOffset.end() - 1);
+		for (uint32_t c = 0; c < nrOfVertices; c++)
+			group[fill[weld[c]]++] = c;
+	}
+
+	// Attributes:
+	std::vector<glm::vec3> normal(nrOfVertices);
+	std::vector<glm::vec2> uv(nrOfVertices);
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+	{
+		normal[c] = glm::vec3(glm::unpackSnorm3x10_1x2(vertices[c].normal));
+		uv[c] = glm::unpackHalf2x16(vertices[c].uv);
+	}
+
+	// Quadrics (area-weighted planes of the adjacent triangles):
+	std::vector<Quadric> quadric(nrOfVertices);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+	{
+		const glm::dvec3 p0 = vertices[faces[c].a].vertex, p1 = vertices[faces[c].b].vertex, p2 = vertices[faces[c].c].vertex;
+		glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+		const double area = glm::length(n);
+		if (area <= 0.0)
+			continue;
+		n /= area;
+		for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+			quadric[weld[v]].addPlane(n, -glm::dot(n, p0), area * 0.5);
+	}
+
+	/**
+	 * @brief Edge collapse candidate.
+	 */
+	struct Collapse
+	{
+		uint32_t from; ///< Welded vertex to remove
+		uint32_t to; ///< Welded vertex to keep
+		float cost; ///< Total cost (geometric and attributes)
+		float geometric; ///< Geometric part of the cost
+	};
+
+	std::vector<uint32_t> remap(nrOfVertices); ///< Collapse target of each vertex
+	std::vector<uint8_t> alive(nrOfVertices);
+	std::vector<uint8_t> locked(nrOfVertices);
+	std::vector<uint64_t> edge, wedgeEdge;
+	std::vector<uint32_t> adjOffset(nrOfVertices + 1), adjFace;
+	std::vector<Collapse> collapse;
+	std::vector<uint32_t> ringFrom, ringTo;
+	const double maxCost = static_cast<double>(maxError) * maxError;
+	double maxGeometric = 0.0;
+	while (output.size() > targetFaces)
+	{
+		const uint32_t nrOfCurFaces = static_cast<uint32_t>(output.size());
+
+		// Welded edges: open borders and non-manifold edges lock their vertices:
+		edge.clear();
+		wedgeEdge.clear();
+		std::fill(alive.begin(), alive.end(), 0);
+		std::fill(locked.begin(), locked.end(), 0);
+		for (const Eng::Ebo::FaceData& f : output)
+		{
+			const uint32_t w[3] = {f.a, f.b, f.c};
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				alive[w[i]] = 1;
+				edge.push_back(edgeKey(weld[w[i]], weld[w[(i + 1) % 3]]));
+				wedgeEdge.push_back(edgeKey(w[i], w[(i + 1) % 3]));
+			}
+		}
+		std::sort(edge.begin(), edge.end());
+		std::sort(wedgeEdge.begin(), wedgeEdge.end());
+		for (size_t c = 0; c < edge.size();)
+		{
+			size_t last = c + 1;
+			while (last < edge.size() && edge[last] == edge[c])
+				last++;
+			if (last - c != 2)
+			{
+				locked[static_cast<uint32_t>(edge[c] >> 32)] = 1;
+				locked[static_cast<uint32_t>(edge[c])] = 1;
+			}
+			c = last;
+		}
+
+		// Welded vertex to triangle adjacency:
+		std::fill(adjOffset.begin(), adjOffset.end(), 0);
+		for (const Eng::Ebo::FaceData& f : output)
+			for (uint32_t v : {f.a, f.b, f.c})
+				adjOffset[weld[v] + 1]++;
+		for (uint32_t c = 0; c < nrOfVertices; c++)
+			adjOffset[c + 1] += adjOffset[c];
+		adjFace.resize(adjOffset[nrOfVertices]);
+		{
+			std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+			for (uint32_t c = 0; c < nrOfCurFaces; c++)
+				for (uint32_t v : {output[c].a, output[c].b, output[c].c})
+					adjFace[fill[weld[v]]++] = c;
+		}
+
+		// Each vertex at the removed position needs a partner at the kept one, sharing an edge with it:
+		auto partner = [&](uint32_t w, uint32_t to) -> uint32_t
+		{
+			for (uint32_t i = groupOffset[to]; i < groupOffset[to + 1]; i++)
+				if (alive[group[i]] && std::binary_search(wedgeEdge.begin(), wedgeEdge.end(), edgeKey(w, group[i])))
+					return group[i];
+			return UINT32_MAX;
+		};
+
+		// Candidates, both directions of each edge:
+		collapse.clear();
+		for (size_t c = 0; c < edge.size(); c++)
+		{
+			const uint32_t a = static_cast<uint32_t>(edge[c] >> 32), b = static_cast<uint32_t>(edge[c]);
+			if ((c && edge[c] == edge[c - 1]) || a == b)
+				continue;
+			for (uint32_t k = 0; k < 2; k++)
+			{
+				const uint32_t from = k ? b : a, to = k ? a : b;
+				if (locked[from])
+					continue;
+				const double geometric = quadric[from].evaluate(vertices[to].vertex) * scale;
+				double attribute = 0.0;
+				bool valid = true;
+				for (uint32_t i = groupOffset[from]; i < groupOffset[from + 1] && valid; i++)
+				{
+					const uint32_t w = group[i];
+					if (alive[w] == 0)
+						continue;
+					const uint32_t p = partner(w, to);
+					if (p == UINT32_MAX)
+						valid = false;
+					else
+						attribute += normalWeight * glm::dot(normal[w] - normal[p], normal[w] - normal[p]) +
+						             uvWeight * glm::dot(uv[w] - uv[p], uv[w] - uv[p]);
+				}
+				if (valid && geometric + attribute <= maxCost)
+					collapse.push_back({from, to, static_cast<float>(geometric + attribute), static_cast<float>(geometric)});
+			}
+		}
+		std::sort(collapse.begin(), collapse.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		// Independent collapses, cheapest first (the 1-ring of a collapsed vertex is locked until the next pass):
+		for (uint32_t c = 0; c < nrOfVertices; c++)
+			remap[c] = c;
+		uint32_t nrOfRemovedFaces = 0;
+		uint32_t nrOfCollapses = 0;
+		for (const Collapse& k : collapse)
+		{
+			if (locked[k.from] || locked[k.to])
+				continue;
+
+			// Flip check:
+			bool flip = false;
+			uint32_t nrOfDegenerate = 0;
+			for (uint32_t i = adjOffset[k.from]; i < adjOffset[k.from + 1] && !flip; i++)
+			{
+				const Eng::Ebo::FaceData& f = output[adjFace[i]];
+				glm::vec3 p[3] = {vertices[f.a].vertex, vertices[f.b].vertex, vertices[f.c].vertex};
+				const uint32_t w[3] = {weld[f.a], weld[f.b], weld[f.c]};
+				if (w[0] == k.to || w[1] == k.to || w[2] == k.to)
+				{
+					nrOfDegenerate++;
+					continue;
+				}
+				const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (uint32_t j = 0; j < 3; j++)
+					if (w[j] == k.from)
+						p[j] = vertices[k.to].vertex;
+				const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				flip = glm::dot(before, after) <= 0.0f;
+			}
+			if (flip)
+				continue;
+
+			// Link condition (the only common neighbors are those of the triangles being removed), to keep manifolds:
+			ringFrom.clear();
+			ringTo.clear();
+			for (uint32_t i = adjOffset[k.from]; i < adjOffset[k.from + 1]; i++)
+				for (uint32_t v : {output[adjFace[i]].a, output[adjFace[i]].b, output[adjFace[i]].c})
+					ringFrom.push_back(weld[v]);
+			for (uint32_t i = adjOffset[k.to]; i < adjOffset[k.to + 1]; i++)
+				for (uint32_t v : {output[adjFace[i]].a, output[adjFace[i]].b, output[adjFace[i]].c})
+					ringTo.push_back(weld[v]);
+			std::sort(ringFrom.begin(), ringFrom.end());
+			ringFrom.erase(std::unique(ringFrom.begin(), ringFrom.end()), ringFrom.end());
+			std::sort(ringTo.begin(), ringTo.end());
+			ringTo.erase(std::unique(ringTo.begin(), ringTo.end()), ringTo.end());
+			uint32_t nrOfCommon = 0;
+			for (size_t i = 0, j = 0; i < ringFrom.size() && j < ringTo.size();)
+				if (ringFrom[i] < ringTo[j])
+					i++;
+				else if (ringTo[j] < ringFrom[i])
+					j++;
+				else
+				{
+					nrOfCommon += ringFrom[i] != k.from && ringFrom[i] != k.to;
+					i++;
+					j++;
+				}
+			if (nrOfCommon != nrOfDegenerate)
+				continue;
+
+			// Collapse:
+			for (uint32_t i = groupOffset[k.from]; i < groupOffset[k.from + 1]; i++)
+				if (alive[group[i]])
+					remap[group[i]] = partner(group[i], k.to);
+			quadric[k.to] += quadric[k.from];
+			maxGeometric = std::max(maxGeometric, static_cast<double>(k.geometric));
+			locked[k.to] = 1;
+			for (uint32_t i = adjOffset[k.from]; i < adjOffset[k.from + 1]; i++)
+				for (uint32_t v : {output[adjFace[i]].a, output[adjFace[i]].b, output[adjFace[i]].c})
+					locked[weld[v]] = 1;
+			nrOfCollapses++;
+			nrOfRemovedFaces += nrOfDegenerate;
+			if (nrOfCurFaces - nrOfRemovedFaces <= targetFaces)
+				break;
+		}
+		if (nrOfCollapses == 0)
+			break;
+
+		// Apply and drop the degenerate triangles:
+		uint32_t nrOfFacesLeft = 0;
+		for (uint32_t c = 0; c < nrOfCurFaces; c++)
+		{
+			Eng::Ebo::FaceData f = output[c];
+			f.a = remap[f.a];
+			f.b = remap[f.b];
+			f.c = remap[f.c];
+			if (weld[f.a] != weld[f.b] && weld[f.b] != weld[f.c] && weld[f.a] != weld[f.c])
+				output[nrOfFacesLeft++] = f;
+		}
+		output.resize(nrOfFacesLeft);
+	}
+
+	// Done:
+	error = static_cast<float>(std::sqrt(maxGeometric));
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Partitions a triangle list into meshlets, i.e., clusters of adjacent triangles with similar orientation, and reorders
+ * the triangles so that each meshlet is a contiguous range. Meshlets grow greedily from a seed triangle, preferring
+ * candidates adding the fewest new vertices and then those best aligned with the cluster normal. Each meshlet gets a
+ * bounding sphere and a normal cone (see cullMeshlets()). Should be invoked after optimizeVertexCache(), whose order is
+ * used for seeding and mostly preserved within each meshlet.
+ * @param faces triangle list, reordered in place
+ * @param nrOfFaces number of triangles
+ * @param vertices vertex array
+ * @param nrOfVertices number of vertices
+ * @param meshlets output meshlets, in triangle list order
+ * @param maxVertices max unique vertices per meshlet
+ * @param maxFaces max triangles per meshlet
+ * @return TF
+ */
+bool ENG_API Eng::MeshOptimizer::buildMeshlets(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces,
+                                              const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                              std::vector<Meshlet>& meshlets, uint32_t maxVertices, uint32_t maxFaces)
+{
+	meshlets.clear();
+
+	// Safety net:
+	if (faces == nullptr || vertices == nullptr || maxVertices < 3 || maxFaces == 0 ||
+	    !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Vertex to triangle adjacency:
+	std::vector<uint32_t> adjOffset(nrOfVertices + 1, 0);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+			adjOffset[v + 1]++;
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+		adjOffset[c + 1] += adjOffset[c];
+	std::vector<uint32_t> adjFace(adjOffset[nrOfVertices]);
+	std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+		for (uint32_t v : {faces[c].a, faces[c].b, faces[c].c})
+			adjFace[fill[v]++] = c;
+
+	// Unit face normals (zero for degenerate triangles):
+	std::vector<glm::vec3> normal(nrOfFaces);
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+	{
+		const glm::vec3 n = glm::cross(vertices[faces[c].b].vertex - vertices[faces[c].a].vertex,
+		                               vertices[faces[c].c].vertex - vertices[faces[c].a].vertex);
+		const float length = glm::length(n);
+		normal[c] = length > 0.0f ? n / length : glm::vec3(0.0f);
+	}
+
+	std::vector<uint8_t> emitted(nrOfFaces, 0);
+	std::vector<uint32_t> tag(nrOfVertices, UINT32_MAX); // Meshlet containing the vertex
+	std::vector<uint32_t> meshletVertex;
+	std::vector<Eng::Ebo::FaceData> output;
+	output.reserve(nrOfFaces);
+	meshletVertex.reserve(maxVertices);
+	uint32_t cursor = 0;
+	uint32_t seed = UINT32_MAX;
+	while (output.size() < nrOfFaces)
+	{
+		const uint32_t id = static_cast<uint32_t>(meshlets.size());
+		Meshlet m;
+		m.firstFace = static_cast<uint32_t>(output.size());
+		meshletVertex.clear();
+		glm::vec3 normalSum(0.0f);
+
+		// Seed (a neighbor of the previous meshlet if any, the next triangle in order otherwise):
+		if (seed == UINT32_MAX)
+		{
+			while (emitted[cursor])
+				cursor++;
+			seed = cursor;
+		}
+
+		uint32_t face = seed;
+		while (true)
+		{
+			emitted[face] = 1;
+			output.push_back(faces[face]);
+			for (uint32_t v : {faces[face].a, faces[face].b, faces[face].c})
+				if (tag[v] != id)
+				{
+					tag[v] = id;
+					meshletVertex.push_back(v);
+				}
+			normalSum += normal[face];
+			if (output.size() - m.firstFace >= maxFaces)
+				break;
+
+			// Best candidate, around the last triangle first and then around the whole meshlet:
+			const glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+			uint32_t best = UINT32_MAX;
+			float bestScore = FLT_MAX;
+			auto evaluate = [&](uint32_t v)
+			{
+				for (uint32_t i = adjOffset[v]; i < adjOffset[v + 1]; i++)
+				{
+					const uint32_t t = adjFace[i];
+					if (emitted[t])
+						continue;
+					const uint32_t newVertices = (tag[faces[t].a] != id) + (tag[faces[t].b] != id) + (tag[faces[t].c] != id);
+					if (meshletVertex.size() + newVertices > maxVertices)
+						continue;
+
+					// Vertex reuse first, orientation as a tie-breaker (0 to 0.5):
+					const float score = static_cast<float>(newVertices) + 0.25f * (1.0f - glm::dot(normal[t], axis));
+					if (score < bestScore)
+					{
+						bestScore = score;
+						best = t;
+					}
+				}
+			};
+			for (uint32_t v : {faces[face].a, faces[face].b, faces[face].c})
+				evaluate(v);
+			if (best == UINT32_MAX)
+				for (uint32_t v : meshletVertex)
+					evaluate(v);
+			if (best == UINT32_MAX)
+				break;
+			face = best;
+		}
+		m.nrOfFaces = static_cast<uint32_t>(output.size()) - m.firstFace;
+
+		// Bounding sphere (centered on the bounding box):
+		glm::vec3 bboxMin(FLT_MAX), bboxMax(-FLT_MAX);
+		for (uint32_t v : meshletVertex)
+		{
+			bboxMin = glm::min(bboxMin, vertices[v].vertex);
+			bboxMax = glm::max(bboxMax, vertices[v].vertex);
+		}
+		m.center = (bboxMin + bboxMax) * 0.5f;
+		m.radius = 0.0f;
+		for (uint32_t v : meshletVertex)
+			m.radius = glm::max(m.radius, glm::length(vertices[v].vertex - m.center));
+
+		// Normal cone (too wide beyond ~84 degrees to be worth testing):
+		m.coneAxis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f, 0.0f, 1.0f);
+		float minDot = 1.0f;
+		for (uint32_t c = m.firstFace; c < output.size(); c++)
+		{
+			const glm::vec3 n = glm::cross(vertices[output[c].b].vertex - vertices[output[c].a].vertex,
+			                               vertices[output[c].c].vertex - vertices[output[c].a].vertex);
+			if (glm::length(n) > 0.0f)
+				minDot = glm::min(minDot, glm::dot(glm::normalize(n), m.coneAxis));
+		}
+		m.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+		meshlets.push_back(m);
+
+		// Next seed, adjacent to this meshlet if possible:
+		seed = UINT32_MAX;
+		for (uint32_t v : meshletVertex)
+		{
+			for (uint32_t i = adjOffset[v]; i < adjOffset[v + 1] && seed == UINT32_MAX; i++)
+				if (!emitted[adjFace[i]])
+					seed = adjFace[i];
+			if (seed != UINT32_MAX)
+				break;
+		}
+	}
+
+	// Done:
+	std::copy(output.begin(), output.end(), faces);
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Selects the meshlets visible from the given viewpoint and returns their triangles as ranges, with adjacent visible
+ * meshlets merged into a single range. A meshlet is culled when its bounding sphere is outside the view frustum or,
+ * with cone culling, when all its triangles are back-facing (counter-clockwise front faces).
+ * @param meshlets meshlets, in triangle list order
+ * @param nrOfMeshlets number of meshlets
+ * @param modelviewProj object to clip space matrix
+ * @param viewPosition viewpoint, in object space
+ * @param coneCulling TF to also cull back-facing meshlets (only valid if back faces are not visible)
+ * @param ranges output ranges
+ * @return number of visible meshlets
+ */
+uint32_t ENG_API Eng::MeshOptimizer::cullMeshlets(const Meshlet* meshlets, uint32_t nrOfMeshlets,
+                                                 const glm::mat4& modelviewProj, const glm::vec3& viewPosition,
+                                                 bool coneCulling, std::vector<FaceRange>& ranges)
+{
+	ranges.clear();
+
+	// Safety net:
+	if (meshlets == nullptr && nrOfMeshlets)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return 0;
+	}
+
+	// Frustum planes, in object space (Gribb-Hartmann):
+	const glm::mat4 m = glm::transpose(modelviewProj);
+	glm::vec4 plane[6] = {m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+	for (glm::vec4& p : plane)
+		p /= glm::length(glm::vec3(p));
+
+	uint32_t nrOfVisible = 0;
+	for (uint32_t c = 0; c < nrOfMeshlets; c++)
+	{
+		const Meshlet& k = meshlets[c];
+
+		bool visible = true;
+		for (const glm::vec4& p : plane)
+			if (glm::dot(glm::vec3(p), k.center) + p.w < -k.radius)
+			{
+				visible = false;
+				break;
+			}
+		if (visible && coneCulling && k.coneCutoff < 1.0f)
+		{
+			const glm::vec3 toCenter = k.center - viewPosition;
+			if (glm::dot(toCenter, k.coneAxis) >= k.coneCutoff * glm::length(toCenter) + k.radius)
+				visible = false;
+		}
+		if (visible == false)
+			continue;
+
+		// Merge with the previous range if contiguous:
+		nrOfVisible++;
+		if (ranges.empty() == false && ranges.back().firstFace + ranges.back().nrOfFaces == k.firstFace)
+			ranges.back().nrOfFaces += k.nrOfFaces;
+		else
+			ranges.push_back({k.firstFace, k.nrOfFaces});
+	}
+
+	// Done:
+	return nrOfVisible;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Quantizes the vertex positions to 16-bit unsigned normalized values within the given box. The remaining attributes
+ * are already packed and are copied as they are. Positions outside the box are clamped.
+ * @param vertices source vertex array
+ * @param nrOfVertices number of vertices
+ * @param bboxMin quantization box min corner
+ * @param bboxMax quantization box max corner
+ * @param output destination array of nrOfVertices elements
+ * @return max position error (in object space), or a negative value on error
+ */
+float ENG_API Eng::MeshOptimizer::compactVertices(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices,
+                                                 const glm::vec3& bboxMin, const glm::vec3& bboxMax,
+                                                 Eng::Vbo::CompactVertexData* output)
+{
+	// Safety net:
+	if (vertices == nullptr || output == nullptr || glm::any(glm::lessThan(bboxMax, bboxMin)))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return -1.0f;
+	}
+
+	// Flat axes are kept valid:
+	const glm::vec3 extent = glm::max(bboxMax - bboxMin, glm::vec3(FLT_MIN));
+	const float maxValue = static_cast<float>(UINT16_MAX);
+
+	float maxError = 0.0f;
+	for (uint32_t c = 0; c < nrOfVertices; c++)
+	{
+		const glm::vec3 n = glm::clamp((vertices[c].vertex - bboxMin) / extent, 0.0f, 1.0f);
+		const glm::u16vec3 q = glm::u16vec3(glm::round(n * maxValue));
+		output[c].vertex = glm::u16vec4(q, 0);
+		output[c].normal = vertices[c].normal;
+		output[c].uv = vertices[c].uv;
+		output[c].tangent = vertices[c].tangent;
+
+		const glm::vec3 dequantized = bboxMin + glm::vec3(q) / maxValue * extent;
+		maxError = glm::max(maxError, glm::length(dequantized - vertices[c].vertex));
+	}
+
+	// Done:
+	return maxError;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Narrows the indices of a triangle list to 16 bits.
+ * @param faces source triangle list
+ * @param nrOfFaces number of triangles
+ * @param nrOfVertices number of vertices (at most 65536)
+ * @param output destination array of nrOfFaces elements
+ * @return TF
+ */
+bool ENG_API Eng::MeshOptimizer::compactFaces(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices,
+                                             Eng::Ebo::CompactFaceData* output)
+{
+	// Safety net:
+	if (faces == nullptr || output == nullptr || nrOfVertices > UINT16_MAX + 1u ||
+	    !validateFaces(faces, nrOfFaces, nrOfVertices))
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	for (uint32_t c = 0; c < nrOfFaces; c++)
+	{
+		output[c].a = static_cast<uint16_t>(faces[c].a);
+		output[c].b = static_cast<uint16_t>(faces[c].b);
+		output[c].c = static_cast<uint16_t>(faces[c].c);
+	}
+
+	// Done:
+	return true;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file		engine_mesh_optimizer.h
+ * @brief	CPU-side mesh geometry processing
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Import-time processing of indexed triangle lists. All methods work in place on CPU-side arrays, so they can be
+ * invoked from worker threads and do not require an OpenGL context.
+ */
+class ENG_API MeshOptimizer
+{
+	//////////
+public: //
+	//////////
+
+	// Consts:
+	static constexpr uint32_t defaultCacheSize = 16; ///< FIFO post-transform cache size used for the statistics
+	static constexpr float defaultOverdrawThreshold = 1.05f; ///< Max ACMR growth allowed when splitting clusters
+	static constexpr uint32_t defaultMeshletVertices = 64; ///< Max unique vertices per meshlet
+	static constexpr uint32_t defaultMeshletFaces = 124; ///< Max triangles per meshlet
+	static constexpr float defaultLodRatio = 0.5f; ///< Triangles kept by each LOD, relative to the previous one
+	static constexpr float defaultLodError = 0.01f; ///< Max error of the first generated LOD (doubling at each level)
+
+
+	/**
+	 * @brief Post-transform vertex cache statistics.
+	 */
+	struct CacheStats
+	{
+		float acmr; ///< Average cache miss ratio (transformed vertices per triangle, 0.5 to 3)
+		float atvr; ///< Average transformed to vertex ratio (transformed vertices per referenced vertex, 1 to 3)
+	};
+
+
+	/**
+	 * @brief Cluster of adjacent triangles, stored as a contiguous range of the triangle list.
+	 */
+	struct Meshlet
+	{
+		uint32_t firstFace; ///< First triangle
+		uint32_t nrOfFaces; ///< Number of triangles
+		glm::vec3 center; ///< Bounding sphere center
+		float radius; ///< Bounding sphere radius
+		glm::vec3 coneAxis; ///< Average facing direction
+		float coneCutoff; ///< Sine of the normal cone half-angle (1 if the cone is too wide to cull)
+	};
+
+
+	/**
+	 * @brief Contiguous range of triangles to draw.
+	 */
+	struct FaceRange
+	{
+		uint32_t firstFace; ///< First triangle
+		uint32_t nrOfFaces; ///< Number of triangles
+	};
+
+
+	// Const/dest:
+	MeshOptimizer() = delete;
+
+	// Statistics:
+	static CacheStats analyzeVertexCache(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices,
+	                                     uint32_t cacheSize = defaultCacheSize);
+
+	// Optimizations:
+	static bool optimizeVertexCache(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices);
+	static bool optimizeOverdraw(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, const Eng::Vbo::VertexData* vertices,
+	                             uint32_t nrOfVertices, float threshold = defaultOverdrawThreshold);
+	static uint32_t optimizeVertexFetch(Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices, Eng::Ebo::FaceData* faces,
+	                                    uint32_t nrOfFaces);
+
+	// Simplification:
+	static bool simplify(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices, const Eng::Ebo::FaceData* faces,
+	                     uint32_t nrOfFaces, uint32_t targetFaces, float maxError, std::vector<Eng::Ebo::FaceData>& output,
+	                     float& error);
+
+	// Clustering:
+	static bool buildMeshlets(Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, const Eng::Vbo::VertexData* vertices,
+	                          uint32_t nrOfVertices, std::vector<Meshlet>& meshlets,
+	                          uint32_t maxVertices = defaultMeshletVertices, uint32_t maxFaces = defaultMeshletFaces);
+	static uint32_t cullMeshlets(const Meshlet* meshlets, uint32_t nrOfMeshlets, const glm::mat4& modelviewProj,
+	                             const glm::vec3& viewPosition, bool coneCulling, std::vector<FaceRange>& ranges);
+
+	// Compaction:
+	static float compactVertices(const Eng::Vbo::VertexData* vertices, uint32_t nrOfVertices, const glm::vec3& bboxMin,
+	                             const glm::vec3& bboxMax, Eng::Vbo::CompactVertexData* output);
+	static bool compactFaces(const Eng::Ebo::FaceData* faces, uint32_t nrOfFaces, uint32_t nrOfVertices,
+	                         Eng::Ebo::CompactFaceData* output);
+};
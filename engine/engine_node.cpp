@@ -14,6 +14,10 @@
 #include "engine.h"
 
 // C/C++:
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
 #include <map>
 
 
@@ -24,6 +28,49 @@
 // Special values:
 Eng::Node Eng::Node::empty("[empty]");
 
+// Change tracking:
+static std::atomic<uint64_t> revisionCounter{0};
+static std::vector<std::pair<uint64_t, const Eng::Node*>> movedNodes; ///< Last matrix changes, by revision
+static uint64_t movedNodesStart = 0; ///< Revision of the last change dropped from movedNodes
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Grows a bounding sphere to enclose another one. Negative radii stand for empty spheres, infinite ones for unbounded
+ * volumes.
+ * @param center sphere center, updated
+ * @param radius sphere radius, updated
+ * @param otherCenter center of the sphere to enclose
+ * @param otherRadius radius of the sphere to enclose
+ */
+static void mergeSphere(glm::vec3& center, float& radius, const glm::vec3& otherCenter, float otherRadius)
+{
+	if (otherRadius < 0.0f || std::isinf(radius))
+		return;
+	if (radius < 0.0f || std::isinf(otherRadius))
+	{
+		center = otherCenter;
+		radius = otherRadius;
+		return;
+	}
+
+	// One inside the other?
+	const float distance = glm::length(otherCenter - center);
+	if (distance + otherRadius <= radius)
+		return;
+	if (distance + radius <= otherRadius)
+	{
+		center = otherCenter;
+		radius = otherRadius;
+		return;
+	}
+
+	// Done:
+	const float newRadius = 0.5f * (distance + radius + otherRadius);
+	center += (otherCenter - center) * ((newRadius - radius) / distance);
+	radius = newRadius;
+}
+
 
 /////////////////////////
 // RESERVED STRUCTURES //
@@ -38,12 +85,22 @@ struct Eng::Node::Reserved
 	std::reference_wrapper<Eng::Node> parent; ///< Parent node
 	std::list<std::reference_wrapper<Eng::Node>> children; ///< List of children nodes      
 
+	// Bounding volumes:
+	Eng::Node::Bounds bounds; ///< Subtree bounds (see getSubtreeBounds())
+	bool boundsValid; ///< TF when the subtree bounds are up to date
+
+	// Change tracking:
+	uint64_t matrixRevision; ///< Revision of the last change of the node matrix
+	uint64_t subtreeRevision; ///< Revision of the last change in the subtree (matrices or hierarchy)
+	uint64_t hierarchyRevision; ///< Revision of the last child added or removed in the subtree
+
 
 	/**
 	 * Constructor. 
 	 */
 	Reserved() : matrix{1.0f},
-	             parent{Eng::Node::empty} {}
+	             parent{Eng::Node::empty}, bounds{glm::vec3(0.0f), -1.0f, 0, 0}, boundsValid{false},
+	             matrixRevision{0}, subtreeRevision{0}, hierarchyRevision{0} {}
 };
 
 
@@ -94,12 +151,29 @@ ENG_API Eng::Node::~Node()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Set node matrix.
+ * Set node matrix. The node is flagged as dirty (see Object::isDirty()) and stamped with a new revision, propagated to
+ * its ancestors, so that lists can update only the subtrees that moved (see List::update()).
  * @param matrix glm mat4x4 
  */
 void ENG_API Eng::Node::setMatrix(const glm::mat4& matrix)
 {
 	reserved->matrix = matrix;
+	setDirty(true);
+
+	// The bounds of the ancestors depend on this matrix:
+	if (getParent() != Eng::Node::empty)
+		getParent().invalidateBounds();
+
+	// Change tracking (the oldest half of the moved nodes is dropped when full):
+	const uint64_t revision = ++revisionCounter;
+	reserved->matrixRevision = revision;
+	propagateRevision(revision, false);
+	if (movedNodes.size() == 2 * maxNrOfMovedNodes)
+	{
+		movedNodesStart = movedNodes[maxNrOfMovedNodes - 1].first;
+		movedNodes.erase(movedNodes.begin(), movedNodes.begin() + maxNrOfMovedNodes);
+	}
+	movedNodes.push_back({revision, this});
 }
 
 
@@ -207,6 +281,8 @@ Eng::Node ENG_API& Eng::Node::removeChild(uint32_t id)
 	i->get().setParent(Eng::Node::empty);
 	auto& x = i->get();
 	reserved->children.erase(i);
+	invalidateBounds();
+	propagateRevision(++revisionCounter, true);
 	return x;
 }
 
@@ -236,6 +312,8 @@ bool ENG_API Eng::Node::addChild(Eng::Node& child)
 	// Add and update:
 	reserved->children.push_back(child);
 	child.setParent(*this);
+	invalidateBounds();
+	propagateRevision(++revisionCounter, true);
 	return true;
 }
 
@@ -262,6 +340,170 @@ const std::list<std::reference_wrapper<Eng::Node>> ENG_API& Eng::Node::getListOf
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the bounding sphere of the geometry owned by this node (children excluded), in node coordinates. Plain nodes
+ * have no geometry, so the sphere is left untouched.
+ * @return TF (false if the node has no geometry)
+ */
+bool ENG_API Eng::Node::getBoundingSphere(glm::vec3&, float&) const
+{
+	return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the bounding sphere of this node and of all its descendants, used for hierarchical culling. Bounds are cached
+ * and recomputed only after a change in the subtree (node matrices, hierarchy or mesh geometry). Not thread-safe.
+ * @return subtree bounds
+ */
+const Eng::Node::Bounds ENG_API& Eng::Node::getSubtreeBounds() const
+{
+	if (reserved->boundsValid)
+		return reserved->bounds;
+
+	// Own geometry:
+	Bounds& b = reserved->bounds;
+	b.center = glm::vec3(0.0f);
+	b.radius = -1.0f;
+	b.nrOfMeshes = 0;
+	b.nrOfLights = 0;
+	if (dynamic_cast<const Eng::Light*>(this))
+	{
+		b.radius = std::numeric_limits<float>::infinity();
+		b.nrOfLights = 1;
+	}
+	else if (dynamic_cast<const Eng::Mesh*>(this))
+	{
+		b.nrOfMeshes = 1;
+		if (getBoundingSphere(b.center, b.radius) == false)
+			b.radius = std::numeric_limits<float>::infinity();
+	}
+
+	// Children, in node coordinates:
+	for (const Eng::Node& child : reserved->children)
+	{
+		const Bounds& cb = child.getSubtreeBounds();
+		b.nrOfMeshes += cb.nrOfMeshes;
+		b.nrOfLights += cb.nrOfLights;
+		if (cb.radius < 0.0f || std::isinf(cb.radius))
+		{
+			mergeSphere(b.center, b.radius, cb.center, cb.radius);
+			continue;
+		}
+		const glm::mat4& m = child.getMatrix();
+		const float scale = std::sqrt(std::max({glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+		                                        glm::dot(glm::vec3(m[1]), glm::vec3(m[1])),
+		                                        glm::dot(glm::vec3(m[2]), glm::vec3(m[2]))}));
+		mergeSphere(b.center, b.radius, glm::vec3(m * glm::vec4(cb.center, 1.0f)), cb.radius * scale);
+	}
+
+	// Done:
+	reserved->boundsValid = true;
+	return b;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Marks the subtree bounds of this node and of its ancestors as outdated. Ancestors of an outdated node are already
+ * outdated, so the walk stops at the first one.
+ */
+void ENG_API Eng::Node::invalidateBounds()
+{
+	for (Eng::Node* node = this; *node != Eng::Node::empty && node->reserved->boundsValid; node = &node->getParent())
+		node->reserved->boundsValid = false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the revision of the last change of the node matrix (0 if never set).
+ * @return revision
+ */
+uint64_t ENG_API Eng::Node::getMatrixRevision() const
+{
+	return reserved->matrixRevision;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the revision of the last change of a matrix or of the hierarchy within the subtree of this node. Subtrees whose
+ * revision is not newer than a previously read getRevision() did not change since.
+ * @return revision
+ */
+uint64_t ENG_API Eng::Node::getSubtreeRevision() const
+{
+	return reserved->subtreeRevision;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the revision of the last child added or removed within the subtree of this node.
+ * @return revision
+ */
+uint64_t ENG_API Eng::Node::getHierarchyRevision() const
+{
+	return reserved->hierarchyRevision;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the latest revision stamped on any node. Revisions grow with each change, and are shared by all the nodes.
+ * @return revision
+ */
+uint64_t ENG_API Eng::Node::getRevision()
+{
+	return revisionCounter;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the nodes whose matrix changed after a given revision, oldest first (nodes changed several times are repeated).
+ * Only the last changes are remembered (see maxNrOfMovedNodes): older revisions are reported as not available, and
+ * their subtrees must be checked through getSubtreeRevision() instead. The nodes may have been destroyed since, so they
+ * must only be compared against known ones. Not thread-safe.
+ * @param revision revision (see getRevision())
+ * @param nodes nodes moved after the revision (appended)
+ * @return TF (false if the changes since the revision are no longer available)
+ */
+bool ENG_API Eng::Node::getMovedNodes(uint64_t revision, std::vector<const Eng::Node*>& nodes)
+{
+	if (revision < movedNodesStart)
+		return false;
+
+	auto first = std::upper_bound(movedNodes.begin(), movedNodes.end(), revision,
+	                              [](uint64_t r, const std::pair<uint64_t, const Eng::Node*>& m) { return r < m.first; });
+	for (; first != movedNodes.end(); first++)
+		nodes.push_back(first->second);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Stamps a revision on the subtrees of this node and of its ancestors.
+ * @param revision new revision
+ * @param hierarchy TF if the revision comes from a change in the hierarchy
+ */
+void ENG_API Eng::Node::propagateRevision(uint64_t revision, bool hierarchy)
+{
+	for (Eng::Node* node = this; *node != Eng::Node::empty; node = &node->getParent())
+	{
+		node->reserved->subtreeRevision = revision;
+		if (hierarchy)
+			node->reserved->hierarchyRevision = revision;
+	}
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Loads the specific information of a given object. In its base class, this function loads the file version chunk.
@@ -270,6 +512,24 @@ const std::list<std::reference_wrapper<Eng::Node>> ENG_API& Eng::Node::getListOf
  * @return TF
  */
 uint32_t ENG_API Eng::Node::loadChunk(Eng::Serializer& serial, void* data)
+{
+	Staging staging;
+	if (decodeChunk(serial, staging) == false)
+		return 0;
+
+	// Done:
+	return loadStaging(staging);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes a node chunk into its CPU-side staging structure. Can be invoked from worker threads.
+ * @param serial serial data
+ * @param staging decoded chunk
+ * @return TF
+ */
+bool ENG_API Eng::Node::decodeChunk(Eng::Serializer& serial, Staging& staging)
 {
 	// Chunk header
 	uint32_t chunkId;
@@ -277,27 +537,57 @@ uint32_t ENG_API Eng::Node::loadChunk(Eng::Serializer& serial, void* data)
 	if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::node))
 	{
 		ENG_LOG_ERROR("Invalid chunk ID found");
-		return 0;
+		return false;
 	}
 	uint32_t chunkSize;
 	serial.deserialize(&chunkSize, sizeof(uint32_t));
 
 	// Node properties:       
-	std::string name;
-	serial.deserialize(name);
-	this->setName(name);
+	serial.deserialize(staging.name);
+	serial.deserialize(staging.matrix);
+	serial.deserialize(staging.nrOfChildren);
 
-	glm::mat4 matrix;
-	serial.deserialize(matrix);
+	std::string_view target;
+	serial.deserialize(target);
 
-	uint32_t nrOfChildren;
-	serial.deserialize(nrOfChildren);
+	// Done:      
+	return true;
+}
 
-	std::string target;
-	serial.deserialize(target);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes the node from a decoded chunk.
+ * @param staging decoded chunk
+ * @return number of children nodes
+ */
+uint32_t ENG_API Eng::Node::loadStaging(const Staging& staging)
+{
+	this->setName(staging.name);
 
 	// Done:      
-	return nrOfChildren;
+	return staging.nrOfChildren;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the node as a chunk (children are saved separately, right after their parent).
+ * @param serial serial data
+ * @return TF
+ */
+bool ENG_API Eng::Node::saveChunk(Eng::Serializer& serial) const
+{
+	uint64_t chunkPosition = beginChunk(serial, Ovo::ChunkId::node);
+
+	// Node properties:
+	serial.serialize(this->getName());
+	serial.serialize(this->getMatrix());
+	serial.serialize(this->getNrOfChildren());
+	serial.serialize("[none]"); // Target
+
+	// Done:
+	return endChunk(serial, chunkPosition);
 }
 
 
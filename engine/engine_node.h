@@ -19,6 +19,32 @@ public: //
 	// Special values:
 	static Node empty;
 
+	// Consts:
+	static constexpr uint32_t maxNrOfMovedNodes = 65536; ///< Matrix changes remembered for getMovedNodes()
+
+
+	/**
+	 * @brief CPU-side content of a node chunk.
+	 */
+	struct Staging
+	{
+		std::string name; ///< Node name
+		glm::mat4 matrix; ///< Node matrix
+		uint32_t nrOfChildren; ///< Number of children nodes
+	};
+
+
+	/**
+	 * @brief Bounding sphere of a node and of all its descendants, in node coordinates (before the node matrix).
+	 */
+	struct Bounds
+	{
+		glm::vec3 center; ///< Sphere center
+		float radius; ///< Sphere radius (negative if nothing to bound, infinite if the subtree contains lights)
+		uint32_t nrOfMeshes; ///< Meshes in the subtree
+		uint32_t nrOfLights; ///< Lights in the subtree
+	};
+
 
 	// Const/dest:
 	Node();
@@ -42,8 +68,22 @@ public: //
 	Node& removeChild(uint32_t id);
 	const std::list<std::reference_wrapper<Node>>& getListOfChildren() const;
 
+	// Bounding volumes:
+	virtual bool getBoundingSphere(glm::vec3& center, float& radius) const;
+	const Bounds& getSubtreeBounds() const;
+
+	// Change tracking:
+	uint64_t getMatrixRevision() const;
+	uint64_t getSubtreeRevision() const;
+	uint64_t getHierarchyRevision() const;
+	static uint64_t getRevision();
+	static bool getMovedNodes(uint64_t revision, std::vector<const Node*>& nodes);
+
 	// Ovo:   
 	uint32_t loadChunk(Eng::Serializer& serial, void* data = nullptr);
+	static bool decodeChunk(Eng::Serializer& serial, Staging& staging);
+	uint32_t loadStaging(const Staging& staging);
+	bool saveChunk(Eng::Serializer& serial) const override;
 
 	// Debugging:
 	std::string getTreeAsString() const;
@@ -62,4 +102,10 @@ protected: //
 
 	// Hierarchy:
 	void setParent(Node& parent);
+
+	// Bounding volumes:
+	void invalidateBounds();
+
+	// Change tracking:
+	void propagateRevision(uint64_t revision, bool hierarchy);
 };
@@ -13,6 +13,9 @@
 // Main include:
 #include "engine.h"
 
+// C/C++:
+#include <atomic>
+
 
 ////////////
 // STATIC //
@@ -21,9 +24,9 @@
 // Special values:
 Eng::Object Eng::Object::empty("[empty]");
 
-// Parity check and counters:
-static int32_t counter = 0;
-static uint32_t idCounter = 0;
+// Parity check and counters (objects can be created by worker threads):
+static std::atomic<int32_t> counter{0};
+static std::atomic<uint32_t> idCounter{0};
 
 
 /////////////////////////
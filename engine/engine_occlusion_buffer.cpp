@@ -0,0 +1,614 @@
+/**
+ * @file		engine_occlusion_buffer.cpp
+ * @brief	CPU depth buffer for occlusion culling
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// SIMD (x86 only, SSE is part of the x64 baseline):
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ENG_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief OcclusionBuffer reserved structure.
+ */
+struct Eng::OcclusionBuffer::Reserved
+{
+	/**
+	 * @brief Occluder queued for the next rasterize().
+	 */
+	struct Occluder
+	{
+		glm::mat4 viewProjMatrix; ///< Model-view-projection matrix
+		const glm::vec3* vertices; ///< Vertex positions
+		uint32_t nrOfVertices; ///< Number of vertices
+		const uint32_t* indices; ///< Vertex indices, three per triangle
+		uint32_t nrOfFaces; ///< Number of triangles
+	};
+
+	/**
+	 * @brief Screen-space triangle, ready for rasterization.
+	 */
+	struct Triangle
+	{
+		glm::vec3 edge[3]; ///< Edge functions (a * x + b * y + c, positive inside)
+		glm::vec3 depth; ///< Depth plane (dz/dx, dz/dy, depth at the origin)
+		glm::ivec4 rect; ///< Covered pixels (min x, min y, max x, max y, inclusive)
+	};
+
+	/**
+	 * @brief Range of occluder triangles transformed and binned by the same job.
+	 */
+	struct Job
+	{
+		uint32_t occluder; ///< Occluder index
+		uint32_t firstFace; ///< First triangle of the range
+		uint32_t nrOfFaces; ///< Number of triangles of the range
+		std::vector<Triangle> triangle; ///< Triangles surviving the setup (clipping may add some)
+		std::vector<std::vector<uint32_t>> bin; ///< Triangles overlapping each tile
+	};
+
+	uint32_t nrOfTilesX; ///< Tiles per row
+	uint32_t nrOfTilesY; ///< Tiles per column
+	std::vector<glm::uvec2> levelSize; ///< Size of each level
+	std::vector<std::vector<float>> level; ///< Level 0 is the depth buffer, each next one keeps the max of 2x2 texels
+	std::vector<Occluder> occluder; ///< Queued occluders
+	std::vector<Job> job; ///< Per-job storage (kept across frames)
+	uint64_t nrOfFaces; ///< Triangles binned since the last clear()
+
+
+	/**
+	 * Constructor.
+	 */
+	Reserved() : nrOfTilesX{0}, nrOfTilesY{0}, nrOfFaces{0} {}
+
+	/**
+	 * Sets up a triangle given in clip coordinates (in front of the near plane), and bins it into the tiles it
+	 * overlaps.
+	 * @param v0 first vertex
+	 * @param v1 second vertex
+	 * @param v2 third vertex
+	 * @param j job storing the triangle
+	 */
+	void setupTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, Job& j) const
+	{
+		if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f)
+			return;
+
+		// Screen coordinates and depth in [0, 1]:
+		const glm::vec2 size(levelSize[0]);
+		glm::vec3 p[3];
+		const glm::vec4* v[3] = {&v0, &v1, &v2};
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			const glm::vec3 ndc = glm::vec3(*v[c]) / v[c]->w;
+			p[c] = glm::vec3((ndc.x * 0.5f + 0.5f) * size.x, (ndc.y * 0.5f + 0.5f) * size.y, ndc.z * 0.5f + 0.5f);
+		}
+
+		// Both sides are rasterized, with counter-clockwise winding:
+		float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+		if (!(std::abs(area) > 0.0f) || std::isinf(area))
+			return;
+		if (area < 0.0f)
+		{
+			std::swap(p[1], p[2]);
+			area = -area;
+		}
+
+		// Covered pixel centers:
+		Triangle t;
+		t.rect.x = std::max(static_cast<int>(std::ceil(std::min({p[0].x, p[1].x, p[2].x}) - 0.5f)), 0);
+		t.rect.y = std::max(static_cast<int>(std::ceil(std::min({p[0].y, p[1].y, p[2].y}) - 0.5f)), 0);
+		t.rect.z = std::min(static_cast<int>(std::floor(std::max({p[0].x, p[1].x, p[2].x}) - 0.5f)),
+		                    static_cast<int>(levelSize[0].x) - 1);
+		t.rect.w = std::min(static_cast<int>(std::floor(std::max({p[0].y, p[1].y, p[2].y}) - 0.5f)),
+		                    static_cast<int>(levelSize[0].y) - 1);
+		if (t.rect.x > t.rect.z || t.rect.y > t.rect.w)
+			return;
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			const glm::vec3& a = p[c];
+			const glm::vec3& b = p[(c + 1) % 3];
+			t.edge[c] = glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - b.x * a.y);
+		}
+		const float dzdx = ((p[1].z - p[0].z) * (p[2].y - p[0].y) - (p[2].z - p[0].z) * (p[1].y - p[0].y)) / area;
+		const float dzdy = ((p[2].z - p[0].z) * (p[1].x - p[0].x) - (p[1].z - p[0].z) * (p[2].x - p[0].x)) / area;
+		t.depth = glm::vec3(dzdx, dzdy, p[0].z - dzdx * p[0].x - dzdy * p[0].y);
+
+		// Binning:
+		const uint32_t index = static_cast<uint32_t>(j.triangle.size());
+		j.triangle.push_back(t);
+		for (int y = t.rect.y / static_cast<int>(tileSize); y <= t.rect.w / static_cast<int>(tileSize); y++)
+			for (int x = t.rect.x / static_cast<int>(tileSize); x <= t.rect.z / static_cast<int>(tileSize); x++)
+				j.bin[y * nrOfTilesX + x].push_back(index);
+	}
+
+	/**
+	 * Transforms, clips against the near plane and bins a range of occluder triangles.
+	 * @param j job
+	 */
+	void binJob(Job& j) const
+	{
+		const Occluder& o = occluder[j.occluder];
+		for (uint32_t f = j.firstFace; f < j.firstFace + j.nrOfFaces; f++)
+		{
+			glm::vec4 v[3];
+			bool valid = true;
+			for (uint32_t c = 0; c < 3 && valid; c++)
+			{
+				const uint32_t index = o.indices[f * 3 + c];
+				valid = index < o.nrOfVertices;
+				if (valid)
+					v[c] = o.viewProjMatrix * glm::vec4(o.vertices[index], 1.0f);
+			}
+			if (valid == false)
+				continue;
+
+			// Trivially outside one of the side or far planes:
+			bool outside = false;
+			for (uint32_t axis = 0; axis < 2 && !outside; axis++)
+				outside = (v[0][axis] < -v[0].w && v[1][axis] < -v[1].w && v[2][axis] < -v[2].w) ||
+				          (v[0][axis] > v[0].w && v[1][axis] > v[1].w && v[2][axis] > v[2].w);
+			if (outside || (v[0].z > v[0].w && v[1].z > v[1].w && v[2].z > v[2].w))
+				continue;
+
+			// Near plane clipping (a triangle becomes a quad at most):
+			glm::vec4 poly[4];
+			uint32_t nrOfPoints = 0;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				const glm::vec4& a = v[c];
+				const glm::vec4& b = v[(c + 1) % 3];
+				const float da = a.z + a.w;
+				const float db = b.z + b.w;
+				if (da >= 0.0f)
+					poly[nrOfPoints++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f))
+					poly[nrOfPoints++] = a + (b - a) * (da / (da - db));
+			}
+			for (uint32_t c = 2; c < nrOfPoints; c++)
+				setupTriangle(poly[0], poly[c - 1], poly[c], j);
+		}
+	}
+
+	/**
+	 * Rasterizes the triangles binned into a tile, keeping the nearest depth, then reduces the tile into the levels
+	 * that are entirely contained within it.
+	 * @param tile tile index
+	 */
+	void rasterizeTile(uint32_t tile)
+	{
+		const int tileX = static_cast<int>((tile % nrOfTilesX) * tileSize);
+		const int tileY = static_cast<int>((tile / nrOfTilesX) * tileSize);
+		const uint32_t pitch = levelSize[0].x;
+		float* depth = level[0].data();
+
+		for (const Job& j : job)
+			for (uint32_t index : j.bin[tile])
+			{
+				const Triangle& t = j.triangle[index];
+				const int x0 = std::max(t.rect.x, tileX) & ~3; // Four pixels at a time (tiles are multiples of four)
+				const int x1 = std::min(t.rect.z, tileX + static_cast<int>(tileSize) - 1);
+				const int y0 = std::max(t.rect.y, tileY);
+				const int y1 = std::min(t.rect.w, tileY + static_cast<int>(tileSize) - 1);
+#ifdef ENG_OCCLUSION_SSE
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 a0 = _mm_set1_ps(t.edge[0].x), a1 = _mm_set1_ps(t.edge[1].x), a2 = _mm_set1_ps(t.edge[2].x);
+				const __m128 dzdx = _mm_set1_ps(t.depth.x);
+				const __m128 start = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+				for (int y = y0; y <= y1; y++)
+				{
+					const float yc = static_cast<float>(y) + 0.5f;
+					const __m128 r0 = _mm_set1_ps(t.edge[0].y * yc + t.edge[0].z);
+					const __m128 r1 = _mm_set1_ps(t.edge[1].y * yc + t.edge[1].z);
+					const __m128 r2 = _mm_set1_ps(t.edge[2].y * yc + t.edge[2].z);
+					const __m128 rz = _mm_set1_ps(t.depth.y * yc + t.depth.z);
+					__m128 px = start;
+					float* row = depth + y * pitch;
+					for (int x = x0; x <= x1; x += 4, px = _mm_add_ps(px, _mm_set1_ps(4.0f)))
+					{
+						const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), r0), zero),
+						                                            _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), r1), zero)),
+						                                 _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+						if (_mm_movemask_ps(inside) == 0)
+							continue;
+						const __m128 z = _mm_max_ps(_mm_min_ps(_mm_add_ps(_mm_mul_ps(dzdx, px), rz), one), zero);
+						const __m128 prev = _mm_loadu_ps(row + x);
+						const __m128 next = _mm_min_ps(prev, z);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, next), _mm_andnot_ps(inside, prev)));
+					}
+				}
+#else
+				for (int y = y0; y <= y1; y++)
+				{
+					const float yc = static_cast<float>(y) + 0.5f;
+					float* row = depth + y * pitch;
+					for (int x = x0; x <= x1; x++)
+					{
+						const float xc = static_cast<float>(x) + 0.5f;
+						if (t.edge[0].x * xc + (t.edge[0].y * yc + t.edge[0].z) < 0.0f ||
+						    t.edge[1].x * xc + (t.edge[1].y * yc + t.edge[1].z) < 0.0f ||
+						    t.edge[2].x * xc + (t.edge[2].y * yc + t.edge[2].z) < 0.0f)
+							continue;
+						const float z = std::clamp(t.depth.x * xc + (t.depth.y * yc + t.depth.z), 0.0f, 1.0f);
+						row[x] = std::min(row[x], z);
+					}
+				}
+#endif
+			}
+
+		// Levels within the tile:
+		for (uint32_t l = 1; l < level.size() && (tileSize >> l) > 0; l++)
+		{
+			const uint32_t side = tileSize >> l;
+			const uint32_t srcPitch = levelSize[l - 1].x;
+			const uint32_t dstPitch = levelSize[l].x;
+			const float* src = level[l - 1].data();
+			float* dst = level[l].data();
+			const uint32_t x0 = static_cast<uint32_t>(tileX) >> l;
+			const uint32_t y0 = static_cast<uint32_t>(tileY) >> l;
+			for (uint32_t y = y0; y < y0 + side; y++)
+				for (uint32_t x = x0; x < x0 + side; x++)
+					dst[y * dstPitch + x] = std::max(std::max(src[(y * 2) * srcPitch + x * 2], src[(y * 2) * srcPitch + x * 2 + 1]),
+					                                 std::max(src[(y * 2 + 1) * srcPitch + x * 2],
+					                                          src[(y * 2 + 1) * srcPitch + x * 2 + 1]));
+		}
+	}
+};
+
+
+///////////////////////////////////
+// BODY OF CLASS OcclusionBuffer //
+///////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor. The buffer is initialized at the default resolution.
+ */
+ENG_API Eng::OcclusionBuffer::OcclusionBuffer() : reserved(std::make_unique<Eng::OcclusionBuffer::Reserved>())
+{
+	ENG_LOG_DETAIL("[+]");
+	init();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Move constructor.
+ */
+ENG_API Eng::OcclusionBuffer::OcclusionBuffer(OcclusionBuffer&& other) : reserved(std::move(other.reserved))
+{
+	ENG_LOG_DETAIL("[M]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::OcclusionBuffer::~OcclusionBuffer()
+{
+	ENG_LOG_DETAIL("[-]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the resolution of the buffer, and clears it. Both sides must be multiples of the tile size.
+ * @param sizeX horizontal resolution
+ * @param sizeY vertical resolution
+ * @return TF
+ */
+bool ENG_API Eng::OcclusionBuffer::init(uint32_t sizeX, uint32_t sizeY)
+{
+	// Safety net:
+	if (sizeX == 0 || sizeY == 0 || sizeX % tileSize || sizeY % tileSize)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	reserved->nrOfTilesX = sizeX / tileSize;
+	reserved->nrOfTilesY = sizeY / tileSize;
+	reserved->levelSize.clear();
+	reserved->level.clear();
+	glm::uvec2 size(sizeX, sizeY);
+	while (true)
+	{
+		reserved->levelSize.push_back(size);
+		reserved->level.emplace_back(static_cast<size_t>(size.x) * size.y);
+		if (size.x == 1 && size.y == 1)
+			break;
+		size = glm::max((size + 1u) / 2u, glm::uvec2(1));
+	}
+	reserved->job.clear();
+
+	// Done:
+	clear();
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the horizontal resolution of a level.
+ * @param level level (0 is the depth buffer)
+ * @return number of texels
+ */
+uint32_t ENG_API Eng::OcclusionBuffer::getSizeX(uint32_t level) const
+{
+	return level < reserved->levelSize.size() ? reserved->levelSize[level].x : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the vertical resolution of a level.
+ * @param level level (0 is the depth buffer)
+ * @return number of texels
+ */
+uint32_t ENG_API Eng::OcclusionBuffer::getSizeY(uint32_t level) const
+{
+	return level < reserved->levelSize.size() ? reserved->levelSize[level].y : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of levels of the max-depth hierarchy, down to a single texel.
+ * @return number of levels
+ */
+uint32_t ENG_API Eng::OcclusionBuffer::getNrOfLevels() const
+{
+	return static_cast<uint32_t>(reserved->level.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the depth values of a level, in [0, 1] from the near to the far plane, row by row from the bottom of the screen.
+ * Level 0 holds the nearest occluder depth per pixel, each next level the max over 2x2 texels of the previous one.
+ * @param level level
+ * @return depth values, or nullptr if the level does not exist
+ */
+const float ENG_API* Eng::OcclusionBuffer::getDepth(uint32_t level) const
+{
+	return level < reserved->level.size() ? reserved->level[level].data() : nullptr;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of occluder triangles binned since the last clear(), after clipping and culling of the triangles
+ * outside the screen.
+ * @return number of triangles
+ */
+uint64_t ENG_API Eng::OcclusionBuffer::getNrOfFaces() const
+{
+	return reserved->nrOfFaces;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Clears the buffer to the far plane (so that everything is visible) and removes the queued occluders.
+ */
+void ENG_API Eng::OcclusionBuffer::clear()
+{
+	for (std::vector<float>& l : reserved->level)
+		std::fill(l.begin(), l.end(), 1.0f);
+	reserved->occluder.clear();
+	reserved->nrOfFaces = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Queues an occluder for the next rasterize(). Arrays are not copied, so they must stay valid until then. Both sides of
+ * the triangles are rasterized.
+ * @param viewProjMatrix model-view-projection matrix of the occluder
+ * @param vertices vertex positions
+ * @param nrOfVertices number of vertices
+ * @param indices vertex indices, three per triangle
+ * @param nrOfFaces number of triangles
+ * @return TF
+ */
+bool ENG_API Eng::OcclusionBuffer::addOccluder(const glm::mat4& viewProjMatrix, const glm::vec3* vertices,
+                                               uint32_t nrOfVertices, const uint32_t* indices, uint32_t nrOfFaces)
+{
+	// Safety net:
+	if (vertices == nullptr || indices == nullptr || nrOfVertices == 0 || nrOfFaces == 0)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	reserved->occluder.push_back({viewProjMatrix, vertices, nrOfVertices, indices, nrOfFaces});
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rasterizes the queued occluders into the buffer (keeping the nearest depth with respect to the occluders already
+ * rasterized since the last clear()), and rebuilds the max-depth levels. Triangles are transformed and binned in
+ * parallel, by ranges of facesPerJob, then tiles are rasterized in parallel.
+ * @return TF
+ */
+bool ENG_API Eng::OcclusionBuffer::rasterize()
+{
+	Eng::ThreadPool& pool = Eng::ThreadPool::getInstance();
+	const uint32_t nrOfTiles = reserved->nrOfTilesX * reserved->nrOfTilesY;
+
+	// Jobs (storage is recycled across frames):
+	uint32_t nrOfJobs = 0;
+	for (uint32_t c = 0; c < reserved->occluder.size(); c++)
+		for (uint32_t first = 0; first < reserved->occluder[c].nrOfFaces; first += facesPerJob)
+		{
+			if (nrOfJobs == reserved->job.size())
+				reserved->job.emplace_back();
+			Reserved::Job& j = reserved->job[nrOfJobs++];
+			j.occluder = c;
+			j.firstFace = first;
+			j.nrOfFaces = std::min(facesPerJob, reserved->occluder[c].nrOfFaces - first);
+			j.triangle.clear();
+			j.bin.resize(nrOfTiles);
+			for (std::vector<uint32_t>& b : j.bin)
+				b.clear();
+		}
+	reserved->job.resize(nrOfJobs);
+
+	// Transform and bin:
+	pool.parallelFor(nrOfJobs, [this](uint64_t c) { reserved->binJob(reserved->job[c]); });
+	for (const Reserved::Job& j : reserved->job)
+		reserved->nrOfFaces += j.triangle.size();
+
+	// Rasterize, with the levels contained within each tile:
+	pool.parallelFor(nrOfTiles, [this](uint64_t c) { reserved->rasterizeTile(static_cast<uint32_t>(c)); });
+	reserved->occluder.clear();
+
+	// Coarser levels, across tiles:
+	for (uint32_t l = 1; l < reserved->level.size(); l++)
+	{
+		if ((tileSize >> l) > 0)
+			continue;
+		const glm::uvec2 src = reserved->levelSize[l - 1];
+		const glm::uvec2 dst = reserved->levelSize[l];
+		const std::vector<float>& s = reserved->level[l - 1];
+		std::vector<float>& d = reserved->level[l];
+		for (uint32_t y = 0; y < dst.y; y++)
+			for (uint32_t x = 0; x < dst.x; x++)
+			{
+				const uint32_t x0 = x * 2, x1 = std::min(x * 2 + 1, src.x - 1);
+				const uint32_t y0 = y * 2, y1 = std::min(y * 2 + 1, src.y - 1);
+				d[y * dst.x + x] = std::max(std::max(s[y0 * src.x + x0], s[y0 * src.x + x1]),
+				                            std::max(s[y1 * src.x + x0], s[y1 * src.x + x1]));
+			}
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tests a bounding box against the rasterized occluders: the box is hidden when its nearest depth lies behind the
+ * max-depth of all the texels covered by its screen rectangle, at the level where the rectangle spans a few texels.
+ * Boxes crossing the near plane or outside the screen are reported as visible. Thread-safe once rasterize() returned.
+ * @param viewProjMatrix model-view-projection matrix of the box
+ * @param bboxMin box min corner
+ * @param bboxMax box max corner
+ * @return TF
+ */
+bool ENG_API Eng::OcclusionBuffer::isVisible(const glm::mat4& viewProjMatrix, const glm::vec3& bboxMin,
+                                             const glm::vec3& bboxMax) const
+{
+	// Screen rectangle and nearest depth of the eight corners, in normalized device coordinates:
+	float minX, minY, maxX, maxY, minZ;
+#ifdef ENG_OCCLUSION_SSE
+	const glm::mat4& m = viewProjMatrix;
+	const __m128 xs = _mm_setr_ps(bboxMin.x, bboxMax.x, bboxMin.x, bboxMax.x);
+	const __m128 ys = _mm_setr_ps(bboxMin.y, bboxMin.y, bboxMax.y, bboxMax.y);
+	__m128 lo = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	__m128 hiX = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+	__m128 hiY = hiX, loX = lo, loY = lo;
+	for (uint32_t c = 0; c < 2; c++)
+	{
+		const __m128 zs = _mm_set1_ps(c ? bboxMax.z : bboxMin.z);
+		__m128 clip[4];
+		for (uint32_t r = 0; r < 4; r++)
+			clip[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][r]), xs), _mm_mul_ps(_mm_set1_ps(m[1][r]), ys)),
+			                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][r]), zs), _mm_set1_ps(m[3][r])));
+		const __m128 crossing = _mm_or_ps(_mm_cmplt_ps(clip[2], _mm_sub_ps(_mm_setzero_ps(), clip[3])),
+		                                  _mm_cmple_ps(clip[3], _mm_setzero_ps()));
+		if (_mm_movemask_ps(crossing))
+			return true;
+		const __m128 x = _mm_div_ps(clip[0], clip[3]);
+		const __m128 y = _mm_div_ps(clip[1], clip[3]);
+		const __m128 z = _mm_div_ps(clip[2], clip[3]);
+		loX = _mm_min_ps(loX, x);
+		hiX = _mm_max_ps(hiX, x);
+		loY = _mm_min_ps(loY, y);
+		hiY = _mm_max_ps(hiY, y);
+		lo = _mm_min_ps(lo, z);
+	}
+	alignas(16) float v[5][4];
+	_mm_store_ps(v[0], loX);
+	_mm_store_ps(v[1], loY);
+	_mm_store_ps(v[2], hiX);
+	_mm_store_ps(v[3], hiY);
+	_mm_store_ps(v[4], lo);
+	minX = std::min({v[0][0], v[0][1], v[0][2], v[0][3]});
+	minY = std::min({v[1][0], v[1][1], v[1][2], v[1][3]});
+	maxX = std::max({v[2][0], v[2][1], v[2][2], v[2][3]});
+	maxY = std::max({v[3][0], v[3][1], v[3][2], v[3][3]});
+	minZ = std::min({v[4][0], v[4][1], v[4][2], v[4][3]});
+#else
+	minX = minY = minZ = std::numeric_limits<float>::infinity();
+	maxX = maxY = -std::numeric_limits<float>::infinity();
+	for (uint32_t c = 0; c < 8; c++)
+	{
+		const glm::vec4 clip = viewProjMatrix * glm::vec4(c & 1 ? bboxMax.x : bboxMin.x, c & 2 ? bboxMax.y : bboxMin.y,
+		                                                  c & 4 ? bboxMax.z : bboxMin.z, 1.0f);
+		if (clip.z < -clip.w || clip.w <= 0.0f)
+			return true;
+		minX = std::min(minX, clip.x / clip.w);
+		maxX = std::max(maxX, clip.x / clip.w);
+		minY = std::min(minY, clip.y / clip.w);
+		maxY = std::max(maxY, clip.y / clip.w);
+		minZ = std::min(minZ, clip.z / clip.w);
+	}
+#endif
+
+	// Outside the screen (left to frustum culling)?
+	if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || std::isnan(minZ))
+		return true;
+	minZ = minZ * 0.5f + 0.5f;
+
+	// Covered pixels:
+	const glm::uvec2 size = reserved->levelSize[0];
+	const int x0 = std::clamp(static_cast<int>(std::floor((minX * 0.5f + 0.5f) * size.x)), 0, static_cast<int>(size.x) - 1);
+	const int x1 = std::clamp(static_cast<int>(std::floor((maxX * 0.5f + 0.5f) * size.x)), 0, static_cast<int>(size.x) - 1);
+	const int y0 = std::clamp(static_cast<int>(std::floor((minY * 0.5f + 0.5f) * size.y)), 0, static_cast<int>(size.y) - 1);
+	const int y1 = std::clamp(static_cast<int>(std::floor((maxY * 0.5f + 0.5f) * size.y)), 0, static_cast<int>(size.y) - 1);
+
+	// Level where the rectangle spans up to five texels per side:
+	const uint32_t extent = static_cast<uint32_t>(std::max(x1 - x0, y1 - y0)) + 1;
+	uint32_t l = 0;
+	while ((extent >> l) > 4 && l + 1 < reserved->level.size())
+		l++;
+	const std::vector<float>& level = reserved->level[l];
+	const uint32_t pitch = reserved->levelSize[l].x;
+	for (uint32_t y = static_cast<uint32_t>(y0) >> l; y <= static_cast<uint32_t>(y1) >> l; y++)
+		for (uint32_t x = static_cast<uint32_t>(x0) >> l; x <= static_cast<uint32_t>(x1) >> l; x++)
+			if (level[y * pitch + x] >= minZ)
+				return true;
+
+	// Done:
+	return false;
+}
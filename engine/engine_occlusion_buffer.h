@@ -0,0 +1,64 @@
+/**
+ * @file		engine_occlusion_buffer.h
+ * @brief	CPU depth buffer for occlusion culling
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Low-resolution depth buffer rasterized on the CPU, used to test bounding boxes against a set of occluders.
+ * Occluder triangles are transformed, clipped and binned into screen tiles, then the tiles are rasterized in parallel
+ * through the ThreadPool (SSE, four pixels at a time). A hierarchy of max-depth levels is built on top of the buffer,
+ * so that a box is tested against a few texels regardless of its screen size. Neither OpenGL nor the container are
+ * accessed.
+ */
+class ENG_API OcclusionBuffer
+{
+	//////////
+public: //
+	//////////
+
+	// Consts:
+	static constexpr uint32_t tileSize = 32; ///< Side of the binning tiles, in pixels
+	static constexpr uint32_t defaultSizeX = 256; ///< Default horizontal resolution
+	static constexpr uint32_t defaultSizeY = 128; ///< Default vertical resolution
+	static constexpr uint32_t facesPerJob = 1024; ///< Occluder triangles transformed and binned by each job
+
+
+	// Const/dest:
+	OcclusionBuffer();
+	OcclusionBuffer(OcclusionBuffer&& other);
+	OcclusionBuffer(OcclusionBuffer const&) = delete;
+	~OcclusionBuffer();
+
+	// Operators:
+	void operator=(OcclusionBuffer const&) = delete;
+
+	// Get/set:
+	bool init(uint32_t sizeX = defaultSizeX, uint32_t sizeY = defaultSizeY);
+	uint32_t getSizeX(uint32_t level = 0) const;
+	uint32_t getSizeY(uint32_t level = 0) const;
+	uint32_t getNrOfLevels() const;
+	const float* getDepth(uint32_t level = 0) const;
+	uint64_t getNrOfFaces() const;
+
+	// Rasterization:
+	void clear();
+	bool addOccluder(const glm::mat4& viewProjMatrix, const glm::vec3* vertices, uint32_t nrOfVertices,
+	                 const uint32_t* indices, uint32_t nrOfFaces);
+	bool rasterize();
+
+	// Queries:
+	bool isVisible(const glm::mat4& viewProjMatrix, const glm::vec3& bboxMin, const glm::vec3& bboxMax) const;
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct Reserved;
+	std::unique_ptr<Reserved> reserved;
+};
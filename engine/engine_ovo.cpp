@@ -1,6 +1,6 @@
 /**
  * @file		engine_ovo.cpp
- * @brief	OVO importing
+ * @brief	OVO importing and exporting
  *
  * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
  */
@@ -12,6 +12,9 @@
 
 // Main include:
 #include "engine.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <functional>
 #include <map>
 
@@ -19,10 +22,199 @@
 #include <glm/gtc/packing.hpp>
 
 
+////////////
+// STATIC //
+////////////
+
+// Cooked cache enabled:
+bool Eng::Ovo::cookedCache = false;
+
+
+/**
+ * Gets the size and the last modification time of a file.
+ * @param filename file name
+ * @param size file size in bytes
+ * @param time last modification time (file clock ticks)
+ * @return TF
+ */
+static bool getFileStamp(const std::string& filename, uint64_t& size, int64_t& time)
+{
+	std::error_code error;
+	size = std::filesystem::file_size(filename, error);
+	if (error)
+		return false;
+	time = static_cast<int64_t>(std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+	if (error)
+		return false;
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Scene decoded into CPU-side staging structures, ready for assembly on the OpenGL thread.
+ */
+struct Eng::Ovo::SceneStaging
+{
+	std::vector<uint32_t> chunkId; ///< Chunk IDs, in file order
+	std::vector<uint32_t> slot; ///< Index of each chunk within the staging list of its type
+	std::vector<Eng::Node::Staging> node; ///< Plain nodes
+	std::vector<Eng::Material::Staging> material; ///< Materials
+	std::vector<Eng::Mesh::Staging> mesh; ///< Meshes
+	std::vector<Eng::Light::Staging> light; ///< Lights
+	std::vector<int32_t> meshMaterial; ///< Material of each mesh, as index in this scene (-1 to look it up by name)
+};
+
+
+/**
+ * @brief Cooked cache file format. The file starts with a header and a directory with the offset of each section.
+ * Sections and geometry arrays are aligned, so the arrays can be passed as they are to glBufferData().
+ */
+struct Eng::Ovo::Cooked
+{
+	static constexpr char magic[8] = "OVOCOOK"; ///< File signature
+	static constexpr uint32_t version = 5; ///< Format revision
+	static constexpr uint64_t alignment = 64; ///< Alignment of sections and arrays
+
+
+	/**
+	 * @brief File sections.
+	 */
+	enum class Section : uint32_t
+	{
+		strings, ///< Names, zero-terminated
+		textures, ///< TextureRecord array
+		materials, ///< MaterialRecord array
+		nodes, ///< NodeRecord array, in hierarchy (file) order
+		lods, ///< LodRecord array
+		geometry, ///< Vertex and face arrays
+
+		// Terminator:
+		last
+	};
+
+	/**
+	 * @brief File header.
+	 */
+	struct Header
+	{
+		char magic[8]; ///< Cooked::magic
+		uint32_t version; ///< Cooked::version
+		uint32_t nrOfSections; ///< Section::last
+		uint64_t sourceSize; ///< Size of the source .ovo file
+		int64_t sourceTime; ///< Last modification time of the source .ovo file
+		uint32_t nrOfTextures; ///< Number of texture records
+		uint32_t nrOfMaterials; ///< Number of material records
+		uint32_t nrOfNodes; ///< Number of node records
+		uint32_t nrOfLods; ///< Number of LOD records
+		uint32_t meshOptimization; ///< 1 if the geometry was optimized at import time (see Ovo::setMeshOptimization())
+		uint32_t nrOfGeneratedLods; ///< LOD chain length generated at import time (see Ovo::setLodGeneration())
+		float lodRatio; ///< Reduction ratio of the generated LODs
+	};
+
+	/**
+	 * @brief Directory entry, one per section.
+	 */
+	struct Directory
+	{
+		uint64_t offset; ///< Offset from the beginning of the file
+		uint64_t size; ///< Size in bytes
+	};
+
+	/**
+	 * @brief String reference.
+	 */
+	struct String
+	{
+		uint32_t offset; ///< Offset within the strings section
+		uint32_t length; ///< Length, without the terminator
+	};
+
+	/**
+	 * @brief Texture record.
+	 */
+	struct TextureRecord
+	{
+		String filename; ///< Image file name
+	};
+
+	/**
+	 * @brief Material record.
+	 */
+	struct MaterialRecord
+	{
+		String name; ///< Material name
+		glm::vec3 emission; ///< Emissive term
+		glm::vec3 albedo; ///< Albedo color
+		float roughness; ///< Roughness
+		float metalness; ///< Metalness
+		float opacity; ///< Transparency
+		int32_t texture[Eng::Material::maxNrOfTextures]; ///< Texture record index (-1 if none)
+	};
+
+	/**
+	 * @brief Node, mesh or light record.
+	 */
+	struct NodeRecord
+	{
+		uint32_t chunkId; ///< Kind of node (as Ovo::ChunkId)
+		uint32_t nrOfChildren; ///< Number of children nodes (following records)
+		String name; ///< Node name
+		glm::mat4 matrix; ///< Node matrix
+		String materialName; ///< Mesh material name
+		int32_t material; ///< Mesh material record index (-1 to look it up by name)
+		float radius; ///< Mesh bounding sphere radius
+		glm::vec3 bboxMin; ///< Mesh bounding box min corner
+		glm::vec3 bboxMax; ///< Mesh bounding box max corner
+		glm::vec3 color; ///< Light color
+		uint32_t firstLod; ///< First mesh LOD record
+		uint32_t nrOfLods; ///< Number of mesh LOD records
+	};
+
+	/**
+	 * @brief Mesh level of detail record.
+	 */
+	struct LodRecord
+	{
+		uint32_t nrOfVertices; ///< Number of vertices
+		uint32_t nrOfFaces; ///< Number of faces
+		uint64_t vertexOffset; ///< Offset of the vertex array within the geometry section
+		uint64_t faceOffset; ///< Offset of the face array within the geometry section
+		uint32_t nrOfVertexBytes; ///< Size of the vertex array encoded by MeshCodec (0 if raw)
+		uint32_t nrOfFaceBytes; ///< Size of the face array encoded by MeshCodec (0 if raw)
+	};
+
+
+	/**
+	 * Rounds the given offset up to the alignment.
+	 * @param offset offset in bytes
+	 * @return aligned offset
+	 */
+	static uint64_t align(uint64_t offset)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+};
+
+
 ///////////////////////
 // BODY OF CLASS Ovo //
 ///////////////////////
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::Ovo::Ovo() : meshOptimization{false}, compactGeometry{false}, meshClustering{false}, nrOfGeneratedLods{0},
+                          lodRatio{0.5f}, meshCompression{false}, shapeRetention{false}
+{}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Loads the specific information of a given object. In its base class, this function loads the file version chunk.
@@ -71,8 +263,8 @@ uint32_t ENG_API Eng::Ovo::ignoreChunk(Eng::Serializer& serial)
 	uint32_t chunkSize;
 	serial.deserialize(chunkSize);
 
-	std::vector<uint8_t> dummy(chunkSize);
-	serial.deserialize(dummy.data(), chunkSize);
+	// Seek past the payload (nothing is read in streamed mode):
+	serial.skip(chunkSize);
 
 	// Done:   
 	return chunkSize;
@@ -81,11 +273,50 @@ uint32_t ENG_API Eng::Ovo::ignoreChunk(Eng::Serializer& serial)
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Loads an OVO file.
+ * Builds the table of the chunks from the current position to the end of the data, by only reading their headers.
+ * The serializer position is restored when done.
+ * @param serializer serial data
+ * @param table output table of chunks, in file order
+ * @return TF (false if the data is truncated)
+ */
+bool ENG_API Eng::Ovo::scanChunks(Eng::Serializer& serial, std::vector<ChunkInfo>& table)
+{
+	uint64_t startPosition = serial.getPosition();
+	table.clear();
+	while (serial.getPosition() < serial.getNrOfBytes())
+	{
+		ChunkInfo chunk;
+		chunk.position = serial.getPosition();
+		if (serial.deserialize(chunk.id) == false || serial.deserialize(chunk.size) == false ||
+			serial.skip(chunk.size) == false)
+		{
+			ENG_LOG_ERROR("Truncated chunk found at position %llu", chunk.position);
+			serial.setPosition(startPosition);
+			return false;
+		}
+		table.push_back(chunk);
+	}
+	serial.setPosition(startPosition);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads an OVO file. By default, the file is memory-mapped and geometry is uploaded directly from the mapping. In
+ * mapped and memory modes, loading happens in three phases: the chunk table is built from the chunk headers, then the
+ * chunks are decoded in parallel by the ThreadPool, and finally the hierarchy is assembled and uploaded on the calling
+ * (OpenGL) thread. When enabled (see setCookedCache()), the decoded scene is also saved as a cooked cache file next to
+ * the source, which is used instead of the source as long as the latter is not modified (files found in a mounted
+ * archive are never cooked, see Archive::mount()). In streamed mode, each chunk is processed serially as soon as it is
+ * resident, so the memory required is bounded by the window size plus the largest chunk.
  * @param filename 3D file 
+ * @param mode serializer storage used for reading the file
  * @return root node or Node::empty if error
  */
-Eng::Node ENG_API& Eng::Ovo::load(const std::string& filename)
+Eng::Node ENG_API& Eng::Ovo::load(const std::string& filename, Eng::Serializer::Mode mode)
 {
 	// Safety net:
 	if (filename.empty())
@@ -94,32 +325,35 @@ Eng::Node ENG_API& Eng::Ovo::load(const std::string& filename)
 		return Eng::Node::empty;
 	}
 
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint64_t startTime = timer.getCounter();
+	const uint64_t sharedBytes = Eng::Mesh::getNrOfSharedBytes();
 
-	/////////////////////////////////////////
-	// STEP 1: load file into a memory buffer
-	bool error = false;
-	FILE* dat = fopen(filename.c_str(), "rb");
-	if (dat == nullptr)
+
+	///////////////////////////////
+	// STEP 0: cooked cache, if any
+	bool cooking = cookedCache && mode != Eng::Serializer::Mode::streamed && Eng::Archive::contains(filename) == false;
+	if (cooking)
 	{
-		ENG_LOG_ERROR("Unable to open file '%s'", filename.c_str());
-		return Eng::Node::empty;
+		std::reference_wrapper<Eng::Node> root = loadCooked(getCookedFilename(filename), filename);
+		if (root.get() != Eng::Node::empty)
+		{
+			ENG_LOG_PLAIN("File '%s' loaded in %.1f ms (cooked, %llu bytes of geometry shared)", filename.c_str(),
+			              timer.getCounterDiff(startTime, timer.getCounter()),
+			              Eng::Mesh::getNrOfSharedBytes() - sharedBytes);
+			return root;
+		}
 	}
 
-	// Get file length (max 2 GB):
-	uint64_t length;
-	fseek(dat, 0L, SEEK_END);
-	length = ftell(dat);
-	fseek(dat, 0L, SEEK_SET);
 
-	// Init mem and copy:
-	Eng::Serializer serial(nullptr, length);
-	if (fread(serial.getData(), sizeof(uint8_t), length, dat) != length)
+	/////////////////////////////////////////
+	// STEP 1: map (or load) file into memory
+	Eng::Serializer serial;
+	if (serial.load(filename, mode) == false)
 	{
-		ENG_LOG_ERROR("File '%s' is corrupted", filename.c_str());
-		fclose(dat);
+		ENG_LOG_ERROR("Unable to load file '%s'", filename.c_str());
 		return Eng::Node::empty;
 	}
-	fclose(dat);
 
 	// First chunk must be the format version:   
 	if (loadChunk(serial) == 0)
@@ -131,82 +365,1264 @@ Eng::Node ENG_API& Eng::Ovo::load(const std::string& filename)
 
 	///////////////////////////////
 	// STEP 2: Materials and geoms:  
-	Eng::Container& container = Eng::Container::getInstance();
-	std::function<Eng::Node&(void)> parse;
-	parse = [&serial, &container, this, &parse, &error](void)-> Eng::Node&
+	std::reference_wrapper<Eng::Node> root(Eng::Node::empty);
+	if (serial.getMode() == Eng::Serializer::Mode::streamed)
+		root = loadSerial(serial);
+	else
 	{
-		switch (*(static_cast<uint8_t*>(serial.getDataAtCurPos())))
-		{
-			///////////////////////////////////////////////////////////
-		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material): //
-		{
-			ENG_LOG_DEBUG("Processing material...");
+		SceneStaging scene;
+		root = loadParallel(serial, scene);
+		if (cooking && root.get() != Eng::Node::empty)
+			saveCooked(getCookedFilename(filename), filename, scene);
+	}
 
-			Eng::Material mat;
-			mat.loadChunk(serial);
-			container.add(mat);
-			return Eng::Node::empty;
-		}
-		break;
+	// Stats:
+	const char* modeName = "memory";
+	if (serial.getMode() == Eng::Serializer::Mode::mapped)
+		modeName = "mapped";
+	else if (serial.getMode() == Eng::Serializer::Mode::streamed)
+		modeName = "streamed";
+	ENG_LOG_PLAIN("File '%s' loaded in %.1f ms (%s, %llu bytes, %llu bytes of file data on heap, %llu bytes of geometry shared)",
+	              filename.c_str(), timer.getCounterDiff(startTime, timer.getCounter()), modeName,
+	              serial.getNrOfBytes(), serial.getNrOfResidentBytes(), Eng::Mesh::getNrOfSharedBytes() - sharedBytes);
 
-			///////////////////////////////////////////////////////
-		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node): //
-		{
-			ENG_LOG_DEBUG("Processing node...");
+	// Done:   
+	return root;
+}
 
-			Eng::Node node;
-			uint32_t nrOfChildren = node.loadChunk(serial);
-			container.add(node);
-			std::reference_wrapper<Eng::Node> _node = container.getLastNode();
-			while (_node.get().getNrOfChildren() < nrOfChildren)
-				_node.get().addChild(parse());
-			return _node;
-		}
-		break;
 
-			///////////////////////////////////////////////////////
-		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh): //
-		{
-			ENG_LOG_DEBUG("Processing mesh...");
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the cooked cache files used by load(). Disabled by default, as cache files are written next to
+ * the source files (their folder must be writable).
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setCookedCache(bool enable)
+{
+	cookedCache = enable;
+}
 
-			Eng::Mesh mesh;
-			uint32_t nrOfChildren = mesh.loadChunk(serial);
-			container.add(mesh);
-			std::reference_wrapper<Eng::Mesh> _mesh = container.getLastMesh();
-			while (_mesh.get().getNrOfChildren() < nrOfChildren)
-				_mesh.get().addChild(parse());
-			return _mesh;
-		}
-		break;
 
-			////////////////////////////////////////////////////////
-		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light): //
-		{
-			ENG_LOG_DEBUG("Processing light...");
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when load() uses cooked cache files.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isCookedCache()
+{
+	return cookedCache;
+}
 
-			Eng::Light light;
-			uint32_t nrOfChildren = light.loadChunk(serial);
-			container.add(light);
-			std::reference_wrapper<Eng::Light> _light = container.getLastLight();
-			while (_light.get().getNrOfChildren() < nrOfChildren)
-				_light.get().addChild(parse());
-			return _light;
-		}
-		break;
 
-			///////////
-		default: //
-			ENG_LOG_WARN("Unknown chunk ID (%u) found: ignored", *(static_cast<uint32_t *>(serial.getDataAtCurPos())));
-			ignoreChunk(serial);
-			return Eng::Node::empty;
-		}
-	};
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the import-time optimization of the mesh geometry (see Mesh::optimizeStaging()) for the next
+ * loads through this object. Disabled by default. Cooked caches are only reused when built with the same setting.
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setMeshOptimization(bool enable)
+{
+	meshOptimization = enable;
+}
 
-	// Iterate:
-	std::reference_wrapper<Eng::Node> root(Eng::Node::empty);
-	while (serial.getDataAtCurPos() && !error)
-		root = parse();
 
-	// Done:   
-	return root;
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the mesh geometry is optimized at import time.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isMeshOptimization() const
+{
+	return meshOptimization;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the compact GPU layouts for the mesh geometry (16-bit quantized positions, 16-bit indices for
+ * meshes with up to 65536 vertices) for the next loads through this object. Disabled by default. Cooked caches keep
+ * full precision and are shared between both settings, but compact meshes cannot be exported through save(), as only
+ * their quantized positions are kept.
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setCompactGeometry(bool enable)
+{
+	compactGeometry = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the mesh geometry is uploaded using the compact GPU layouts.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isCompactGeometry() const
+{
+	return compactGeometry;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the partitioning of the mesh geometry into meshlets (see Mesh::clusterStaging()) for the next
+ * loads through this object, as required by List::cull(). Disabled by default. Meshlets are rebuilt at each load, so
+ * cooked caches are shared between both settings.
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setMeshClustering(bool enable)
+{
+	meshClustering = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the mesh geometry is partitioned into meshlets.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isMeshClustering() const
+{
+	return meshClustering;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the generation of a LOD chain for the meshes with a single LOD (see Mesh::simplifyStaging()) for
+ * the next loads through this object. Disabled by default. The generated LODs are stored in the cooked cache, which is
+ * only reused when built with the same setting.
+ * @param nrOfLods total number of LODs, including the first one (0 or 1 to disable)
+ * @param ratio triangles kept by each LOD, relative to the previous one
+ */
+void ENG_API Eng::Ovo::setLodGeneration(uint32_t nrOfLods, float ratio)
+{
+	// Safety net:
+	if (ratio <= 0.0f || ratio >= 1.0f)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return;
+	}
+
+	nrOfGeneratedLods = nrOfLods > 1 ? nrOfLods : 0;
+	lodRatio = ratio;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the length of the LOD chains generated at import time.
+ * @return number of LODs, including the first one (0 if disabled)
+ */
+uint32_t ENG_API Eng::Ovo::getNrOfGeneratedLods() const
+{
+	return nrOfGeneratedLods;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables keeping a CPU-side copy of the LOD 0 positions and triangles of each mesh (see Mesh::getShape())
+ * for the next loads through this object, as required by CPU queries such as List::cullOccluded(). Disabled by default.
+ * Shapes are shared among the meshes sharing the same geometry, and cooked caches are shared between both settings.
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setShapeRetention(bool enable)
+{
+	shapeRetention = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when a CPU-side copy of the mesh geometry is kept.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isShapeRetention() const
+{
+	return shapeRetention;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the compression of the mesh geometry (see MeshCodec) in the files written through this object,
+ * i.e., by save() and in the cooked cache. Disabled by default. Loading accepts both encodings, whatever the setting.
+ * @param enable TF
+ */
+void ENG_API Eng::Ovo::setMeshCompression(bool enable)
+{
+	meshCompression = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the mesh geometry is compressed in the files written through this object.
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::isMeshCompression() const
+{
+	return meshCompression;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the name of the cooked cache file of an OVO file.
+ * @param filename OVO file name
+ * @return cooked cache file name
+ */
+std::string ENG_API Eng::Ovo::getCookedFilename(const std::string& filename)
+{
+	return filename + ".cooked";
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves a hierarchy as an OVO file: version chunk, materials used by the meshes (in order of first use), then the
+ * nodes in depth-first order. Geometry is read back from the GPU, so an OpenGL context is required. The file can be
+ * loaded again through load(), e.g. to skip expensive import-time processing at startup. Hierarchies containing
+ * compact meshes (see setCompactGeometry()) are refused.
+ * @param filename 3D file
+ * @param root root node of the hierarchy to save
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::save(const std::string& filename, const Eng::Node& root)
+{
+	// Safety net:
+	if (filename.empty() || root == Eng::Node::empty)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint64_t startTime = timer.getCounter();
+
+	// Complete background texture loading, so that materials reference their textures:
+	Eng::Container& container = Eng::Container::getInstance();
+	while (container.getNrOfPendingTextures())
+	{
+		Eng::ThreadPool::getInstance().wait();
+		container.processTextureRequests(UINT32_MAX);
+	}
+
+	// Materials, in order of first use:
+	std::vector<const Eng::Material*> material;
+	std::function<void(const Eng::Node&)> gather;
+	gather = [&material, &gather](const Eng::Node& node)
+	{
+		const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(&node);
+		if (mesh && mesh->getMaterial() != Eng::Material::empty &&
+			std::find(material.begin(), material.end(), &mesh->getMaterial()) == material.end())
+			material.push_back(&mesh->getMaterial());
+		for (auto& child : node.getListOfChildren())
+			gather(child.get());
+	};
+	gather(root);
+
+	// Serialize:
+	Eng::Serializer serial;
+	bool done = Eng::Ovo::saveChunk(serial);
+	uint32_t nrOfChunks = 1;
+	for (auto m : material)
+	{
+		done = done && m->saveChunk(serial);
+		nrOfChunks++;
+	}
+	std::function<void(const Eng::Node&)> write;
+	write = [this, &serial, &done, &nrOfChunks, &write](const Eng::Node& node)
+	{
+		const Eng::Mesh* mesh = dynamic_cast<const Eng::Mesh*>(&node);
+		done = done && (mesh ? mesh->saveChunk(serial, meshCompression) : node.saveChunk(serial));
+		nrOfChunks++;
+		for (auto& child : node.getListOfChildren())
+			write(child.get());
+	};
+	write(root);
+	if (done == false || serial.save(filename) == false)
+	{
+		ENG_LOG_ERROR("Unable to save file '%s'", filename.c_str());
+		return false;
+	}
+
+	// Done:
+	ENG_LOG_PLAIN("File '%s' saved in %.1f ms (%u chunks, %llu bytes)", filename.c_str(),
+	              timer.getCounterDiff(startTime, timer.getCounter()), nrOfChunks, serial.getNrOfBytes());
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object. In its base class, this function saves the file version chunk.
+ * @param serial serial data
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::saveChunk(Eng::Serializer& serial) const
+{
+	uint64_t chunkPosition = beginChunk(serial, Ovo::ChunkId::version);
+	serial.serialize(Ovo::version);
+
+	// Done:
+	return endChunk(serial, chunkPosition);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Writes a chunk header at the current position. The payload size is set by endChunk().
+ * @param serial serial data
+ * @param chunkId chunk ID
+ * @return position of the chunk header
+ */
+uint64_t ENG_API Eng::Ovo::beginChunk(Eng::Serializer& serial, ChunkId chunkId)
+{
+	uint64_t chunkPosition = serial.getPosition();
+	serial.serialize(static_cast<uint32_t>(chunkId));
+	serial.serialize(static_cast<uint32_t>(0));
+
+	// Done:
+	return chunkPosition;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Completes a chunk started with beginChunk(), by writing its payload size.
+ * @param serial serial data, positioned at the end of the chunk payload
+ * @param chunkPosition position of the chunk header
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::endChunk(Eng::Serializer& serial, uint64_t chunkPosition)
+{
+	uint64_t endPosition = serial.getPosition();
+	uint64_t chunkSize = endPosition - chunkPosition - 2 * sizeof(uint32_t);
+	if (chunkSize > UINT32_MAX)
+	{
+		ENG_LOG_ERROR("Chunk too large");
+		return false;
+	}
+	serial.setPosition(chunkPosition + sizeof(uint32_t));
+	serial.serialize(static_cast<uint32_t>(chunkSize));
+	serial.setPosition(endPosition);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the scene by processing the chunks one at a time, in file order, on the calling thread.
+ * @param serial serial data, positioned after the version chunk
+ * @return root node or Node::empty if error
+ */
+Eng::Node ENG_API& Eng::Ovo::loadSerial(Eng::Serializer& serial)
+{
+	bool error = false;
+	Eng::Container& container = Eng::Container::getInstance();
+
+	// Makes the chunk at the current position fully resident (streamed mode):
+	auto prefetchChunk = [&serial, &error]() -> bool
+	{
+		uint32_t header[2];
+		if (serial.prefetch(sizeof(header)) == false)
+		{
+			error = true;
+			return false;
+		}
+		memcpy(header, serial.getDataAtCurPos(), sizeof(header));
+		if (serial.prefetch(sizeof(header) + static_cast<uint64_t>(header[1])) == false)
+		{
+			error = true;
+			return false;
+		}
+		return true;
+	};
+
+	std::function<Eng::Node&(void)> parse;
+	parse = [&serial, &container, this, &parse, &error, &prefetchChunk](void)-> Eng::Node&
+	{
+		// Truncated file?
+		const uint8_t* chunkId = static_cast<const uint8_t*>(serial.getDataAtCurPos());
+		if (chunkId == nullptr)
+		{
+			ENG_LOG_ERROR("Unexpected end of file at position %llu", serial.getPosition());
+			error = true;
+			return Eng::Node::empty;
+		}
+
+		switch (*chunkId)
+		{
+			///////////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material): //
+		{
+			ENG_LOG_DEBUG("Processing material...");
+			if (!prefetchChunk())
+				return Eng::Node::empty;
+
+			Eng::Material mat;
+			mat.loadChunk(serial);
+			container.add(mat);
+			return Eng::Node::empty;
+		}
+		break;
+
+			///////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node): //
+		{
+			ENG_LOG_DEBUG("Processing node...");
+			if (!prefetchChunk())
+				return Eng::Node::empty;
+
+			Eng::Node node;
+			uint32_t nrOfChildren = node.loadChunk(serial);
+			container.add(node);
+			std::reference_wrapper<Eng::Node> _node = container.getLastNode();
+			while (_node.get().getNrOfChildren() < nrOfChildren && !error)
+			{
+				Eng::Node& child = parse();
+				if (error == false)
+					_node.get().addChild(child);
+			}
+			return _node;
+		}
+		break;
+
+			///////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh): //
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::encodedMesh):
+		{
+			ENG_LOG_DEBUG("Processing mesh...");
+			if (!prefetchChunk())
+				return Eng::Node::empty;
+
+			Eng::Mesh::Staging staging;
+			if (Eng::Mesh::decodeChunk(serial, staging) == false ||
+			    Eng::Mesh::simplifyStaging(staging, nrOfGeneratedLods, lodRatio) == false ||
+			    (meshOptimization && Eng::Mesh::optimizeStaging(staging) == false))
+			{
+				ENG_LOG_ERROR("Unable to decode mesh chunk");
+				error = true;
+				return Eng::Node::empty;
+			}
+
+			// Meshlets (unclustered meshes are still drawn as a whole, as in buildScene()):
+			if (meshClustering && Eng::Mesh::clusterStaging(staging) == false)
+				for (Eng::Mesh::Staging::Lod& lod : staging.lod)
+					lod.meshlet.clear();
+
+			Eng::Mesh mesh;
+			staging.compact = compactGeometry;
+			staging.keepShape = shapeRetention;
+			uint32_t nrOfChildren = mesh.loadStaging(staging);
+			container.add(mesh);
+			std::reference_wrapper<Eng::Mesh> _mesh = container.getLastMesh();
+			while (_mesh.get().getNrOfChildren() < nrOfChildren && !error)
+			{
+				Eng::Node& child = parse();
+				if (error == false)
+					_mesh.get().addChild(child);
+			}
+			return _mesh;
+		}
+		break;
+
+			////////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light): //
+		{
+			ENG_LOG_DEBUG("Processing light...");
+			if (!prefetchChunk())
+				return Eng::Node::empty;
+
+			Eng::Light light;
+			uint32_t nrOfChildren = light.loadChunk(serial);
+			container.add(light);
+			std::reference_wrapper<Eng::Light> _light = container.getLastLight();
+			while (_light.get().getNrOfChildren() < nrOfChildren && !error)
+			{
+				Eng::Node& child = parse();
+				if (error == false)
+					_light.get().addChild(child);
+			}
+			return _light;
+		}
+		break;
+
+			///////////
+		default: //
+			ENG_LOG_WARN("Unknown chunk ID (%u) found: ignored", *(static_cast<uint32_t *>(serial.getDataAtCurPos())));
+			ignoreChunk(serial);
+			return Eng::Node::empty;
+		}
+	};
+
+	// Iterate:
+	std::reference_wrapper<Eng::Node> root(Eng::Node::empty);
+	while (serial.getDataAtCurPos() && !error)
+		root = parse();
+	if (error)
+		return Eng::Node::empty;
+
+	// Done:
+	return root;
+}
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the scene in three phases: chunk table, parallel decoding of the chunks into staging structures, and assembly
+ * of the hierarchy with OpenGL uploads on the calling thread. The outcome is the same as with loadSerial(), as both
+ * rely on the same decodeChunk()/loadStaging() methods and objects are created in file order.
+ * @param serial serial data, positioned after the version chunk
+ * @param scene decoded scene (its geometry points into the serializer storage)
+ * @return root node or Node::empty if error
+ */
+Eng::Node ENG_API& Eng::Ovo::loadParallel(Eng::Serializer& serial, SceneStaging& scene)
+{
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	Eng::ThreadPool& pool = Eng::ThreadPool::getInstance();
+
+	// Phase 1, chunk table:
+	uint64_t startTime = timer.getCounter();
+	std::vector<ChunkInfo> table;
+	if (scanChunks(serial, table) == false)
+		return Eng::Node::empty;
+	uint64_t scanTime = timer.getCounter();
+
+	// Phase 2, parallel decoding:
+	if (decodeChunks(serial, table, scene) == false)
+		return Eng::Node::empty;
+	loadImages(scene);
+	uint64_t decodeTime = timer.getCounter();
+
+	// Phase 3, hierarchy and uploads:
+	std::reference_wrapper<Eng::Node> root = buildScene(scene);
+
+	// Stats:
+	uint64_t endTime = timer.getCounter();
+	ENG_LOG_PLAIN("Chunks: %zu, scan: %.1f ms, decode: %.1f ms (%u worker threads), build/upload: %.1f ms",
+	              table.size(), timer.getCounterDiff(startTime, scanTime), timer.getCounterDiff(scanTime, decodeTime),
+	              pool.getNrOfThreads(), timer.getCounterDiff(decodeTime, endTime));
+
+	// Done:
+	return root;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads a selection of chunks: decoding, images and hierarchy. Chunks must be in file order, with each node followed by
+ * its whole subtree, and materials placed before the meshes using them.
+ * @param serial serial data (memory-based or mapped)
+ * @param table chunks to load
+ * @return root node (the first node of the selection) or Node::empty if error
+ */
+Eng::Node ENG_API& Eng::Ovo::loadChunks(const Eng::Serializer& serial, const std::vector<ChunkInfo>& table)
+{
+	SceneStaging scene;
+	if (decodeChunks(serial, table, scene) == false)
+		return Eng::Node::empty;
+	loadImages(scene);
+
+	// Done:
+	return buildScene(scene);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decodes, through the ThreadPool, the given chunks into staging structures. Each job reads through its own view of the
+ * serializer data, which must be memory-based or mapped and must outlive the decoded scene.
+ * @param serial serial data
+ * @param table chunks to decode, in file order
+ * @param scene decoded scene
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::decodeChunks(const Eng::Serializer& serial, const std::vector<ChunkInfo>& table,
+                                    SceneStaging& scene)
+{
+	// Safety net:
+	if (serial.getMode() != Eng::Serializer::Mode::memory && serial.getMode() != Eng::Serializer::Mode::mapped)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Staging slots:
+	scene.chunkId.resize(table.size());
+	scene.slot.resize(table.size());
+	uint32_t nrOfNodes = 0, nrOfMaterials = 0, nrOfMeshes = 0, nrOfLights = 0;
+	for (uint32_t c = 0; c < table.size(); c++)
+	{
+		// Encoded meshes are staged like any other mesh:
+		scene.chunkId[c] = table[c].id == static_cast<uint32_t>(Eng::Ovo::ChunkId::encodedMesh) ?
+		                   static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh) : table[c].id;
+		switch (scene.chunkId[c])
+		{
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node): scene.slot[c] = nrOfNodes++;
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material): scene.slot[c] = nrOfMaterials++;
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh): scene.slot[c] = nrOfMeshes++;
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light): scene.slot[c] = nrOfLights++;
+			break;
+		default: scene.slot[c] = 0;
+		}
+	}
+	scene.node.resize(nrOfNodes);
+	scene.material.resize(nrOfMaterials);
+	scene.mesh.resize(nrOfMeshes);
+	scene.light.resize(nrOfLights);
+	scene.meshMaterial.assign(nrOfMeshes, -1);
+
+	// Decode:
+	std::atomic<bool> error{false};
+	Eng::ThreadPool::getInstance().parallelFor(table.size(), [&](uint64_t c)
+	{
+		Eng::Serializer reader;
+		if (reader.share(serial) == false || reader.setPosition(table[c].position) == false)
+		{
+			error = true;
+			return;
+		}
+
+		bool done = true;
+		switch (scene.chunkId[c])
+		{
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node):
+			done = Eng::Node::decodeChunk(reader, scene.node[scene.slot[c]]);
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material):
+			done = Eng::Material::decodeChunk(reader, scene.material[scene.slot[c]]);
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh):
+			done = Eng::Mesh::decodeChunk(reader, scene.mesh[scene.slot[c]]) &&
+			       Eng::Mesh::simplifyStaging(scene.mesh[scene.slot[c]], nrOfGeneratedLods, lodRatio) &&
+			       (!meshOptimization || Eng::Mesh::optimizeStaging(scene.mesh[scene.slot[c]]));
+			break;
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light):
+			done = Eng::Light::decodeChunk(reader, scene.light[scene.slot[c]]);
+			break;
+		}
+		if (done == false)
+			error = true;
+	});
+	if (error)
+	{
+		ENG_LOG_ERROR("Unable to decode chunks");
+		return false;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads, through the ThreadPool, the images required by the materials of a decoded scene. Each image is loaded only
+ * once and only when its texture is not already cached. Nothing is done when textures are loaded in background.
+ * @param scene decoded scene
+ */
+void ENG_API Eng::Ovo::loadImages(SceneStaging& scene)
+{
+	Eng::Container& container = Eng::Container::getInstance();
+	if (container.isAsyncTextures())
+		return;
+
+	// Distinct images:
+	std::map<std::string, uint32_t> imageSlot;
+	std::vector<std::string> image;
+	for (auto& m : scene.material)
+		for (uint32_t c = 0; c < Eng::Material::maxNrOfTextures; c++)
+			if (!m.textureName[c].empty() && container.findTexture(m.textureKey[c]) == Eng::Texture::empty &&
+				imageSlot.count(m.textureKey[c]) == 0)
+			{
+				imageSlot[m.textureKey[c]] = static_cast<uint32_t>(image.size());
+				image.push_back(m.textureName[c]);
+			}
+
+	// Load:
+	std::vector<std::shared_ptr<const Eng::Bitmap>> bitmap(image.size());
+	std::vector<double> bitmapLoadTime(image.size(), 0.0);
+	Eng::ThreadPool::getInstance().parallelFor(image.size(), [&](uint64_t i)
+	{
+		Eng::Material::loadBitmap(image[i], bitmap[i], bitmapLoadTime[i]);
+	});
+
+	// Share among materials:
+	for (auto& m : scene.material)
+		for (uint32_t c = 0; c < Eng::Material::maxNrOfTextures; c++)
+			if (imageSlot.count(m.textureKey[c]))
+			{
+				m.bitmap[c] = bitmap[imageSlot[m.textureKey[c]]];
+				m.bitmapLoadTime[c] = bitmapLoadTime[imageSlot[m.textureKey[c]]];
+			}
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Creates the objects of a decoded scene, in file order, and assembles their hierarchy. Requires an OpenGL context.
+ * @param scene decoded scene
+ * @return root node or Node::empty if error
+ */
+Eng::Node ENG_API& Eng::Ovo::buildScene(SceneStaging& scene)
+{
+	Eng::Container& container = Eng::Container::getInstance();
+	std::vector<std::reference_wrapper<Eng::Material>> material;
+	uint32_t curChunk = 0;
+
+	// Meshlets (unclustered meshes are still drawn as a whole):
+	if (meshClustering)
+		Eng::ThreadPool::getInstance().parallelFor(scene.mesh.size(), [&](uint64_t c)
+		{
+			if (Eng::Mesh::clusterStaging(scene.mesh[c]) == false)
+				for (Eng::Mesh::Staging::Lod& lod : scene.mesh[c].lod)
+					lod.meshlet.clear();
+		});
+
+	std::function<Eng::Node&(void)> build;
+	build = [&](void)-> Eng::Node&
+	{
+		uint32_t chunkId = scene.chunkId[curChunk];
+		uint32_t curSlot = scene.slot[curChunk];
+		curChunk++;
+		switch (chunkId)
+		{
+			///////////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material): //
+		{
+			Eng::Material mat;
+			mat.loadStaging(scene.material[curSlot]);
+			container.add(mat);
+			material.push_back(container.getLastMaterial());
+			return Eng::Node::empty;
+		}
+		break;
+
+			///////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node): //
+		{
+			Eng::Node node;
+			uint32_t nrOfChildren = node.loadStaging(scene.node[curSlot]);
+			container.add(node);
+			std::reference_wrapper<Eng::Node> _node = container.getLastNode();
+			while (_node.get().getNrOfChildren() < nrOfChildren && curChunk < scene.chunkId.size())
+				_node.get().addChild(build());
+			return _node;
+		}
+		break;
+
+			///////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh): //
+		{
+			// Pre-resolved material:
+			int32_t matIndex = scene.meshMaterial[curSlot];
+			if (matIndex >= 0 && matIndex < static_cast<int32_t>(material.size()))
+				scene.mesh[curSlot].material = &material[matIndex].get();
+			scene.mesh[curSlot].compact = compactGeometry;
+			scene.mesh[curSlot].keepShape = shapeRetention;
+
+			Eng::Mesh mesh;
+			uint32_t nrOfChildren = mesh.loadStaging(scene.mesh[curSlot]);
+			container.add(mesh);
+			std::reference_wrapper<Eng::Mesh> _mesh = container.getLastMesh();
+			while (_mesh.get().getNrOfChildren() < nrOfChildren && curChunk < scene.chunkId.size())
+				_mesh.get().addChild(build());
+			return _mesh;
+		}
+		break;
+
+			////////////////////////////////////////////////////////
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light): //
+		{
+			Eng::Light light;
+			uint32_t nrOfChildren = light.loadStaging(scene.light[curSlot]);
+			container.add(light);
+			std::reference_wrapper<Eng::Light> _light = container.getLastLight();
+			while (_light.get().getNrOfChildren() < nrOfChildren && curChunk < scene.chunkId.size())
+				_light.get().addChild(build());
+			return _light;
+		}
+		break;
+
+			///////////
+		default: //
+			ENG_LOG_WARN("Unknown chunk ID (%u) found: ignored", chunkId);
+			return Eng::Node::empty;
+		}
+	};
+
+	// Iterate:
+	std::reference_wrapper<Eng::Node> root(Eng::Node::empty);
+	while (curChunk < scene.chunkId.size())
+		root = build();
+
+	// Done:
+	return root;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads a scene from its cooked cache file. The file is mapped, tables are read in place and geometry is uploaded
+ * directly from the mapping.
+ * @param cookedFilename cooked cache file name
+ * @param filename source OVO file name (the cache is only used if matching its size and modification time)
+ * @return root node or Node::empty if the cache is missing, outdated or invalid
+ */
+Eng::Node ENG_API& Eng::Ovo::loadCooked(const std::string& cookedFilename, const std::string& filename)
+{
+	// Up to date?
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	std::error_code error;
+	if (std::filesystem::exists(cookedFilename, error) == false || !getFileStamp(filename, sourceSize, sourceTime))
+		return Eng::Node::empty;
+
+	Eng::Serializer serial;
+	if (serial.load(cookedFilename, Eng::Serializer::Mode::mapped) == false)
+		return Eng::Node::empty;
+	const Cooked::Header* header = static_cast<const Cooked::Header*>(serial.read(sizeof(Cooked::Header)));
+	if (header == nullptr || memcmp(header->magic, Cooked::magic, sizeof(Cooked::magic)) ||
+		header->version != Cooked::version || header->nrOfSections != static_cast<uint32_t>(Cooked::Section::last))
+	{
+		ENG_LOG_WARN("Invalid cooked file '%s' ignored", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+	if (header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+	{
+		ENG_LOG_DEBUG("Cooked file '%s' is outdated", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+	if (header->meshOptimization != static_cast<uint32_t>(meshOptimization) ||
+	    header->nrOfGeneratedLods != nrOfGeneratedLods || header->lodRatio != lodRatio)
+	{
+		ENG_LOG_DEBUG("Cooked file '%s' was built with different import settings", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+
+	// Sections:
+	const Cooked::Directory* dir = static_cast<const Cooked::Directory*>(serial.read(sizeof(Cooked::Directory) * header->nrOfSections));
+	if (dir == nullptr)
+	{
+		ENG_LOG_WARN("Invalid cooked file '%s' ignored", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+	const uint8_t* base = static_cast<const uint8_t*>(serial.getData());
+	for (uint32_t c = 0; c < header->nrOfSections; c++)
+		if (dir[c].offset > serial.getNrOfBytes() || dir[c].size > serial.getNrOfBytes() - dir[c].offset)
+		{
+			ENG_LOG_WARN("Invalid cooked file '%s' ignored", cookedFilename.c_str());
+			return Eng::Node::empty;
+		}
+	auto section = [&](Cooked::Section s) { return base + dir[static_cast<uint32_t>(s)].offset; };
+	auto sectionSize = [&](Cooked::Section s) { return dir[static_cast<uint32_t>(s)].size; };
+	if (sectionSize(Cooked::Section::textures) != header->nrOfTextures * sizeof(Cooked::TextureRecord) ||
+		sectionSize(Cooked::Section::materials) != header->nrOfMaterials * sizeof(Cooked::MaterialRecord) ||
+		sectionSize(Cooked::Section::nodes) != header->nrOfNodes * sizeof(Cooked::NodeRecord) ||
+		sectionSize(Cooked::Section::lods) != header->nrOfLods * sizeof(Cooked::LodRecord))
+	{
+		ENG_LOG_WARN("Invalid cooked file '%s' ignored", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+	const char* strings = reinterpret_cast<const char*>(section(Cooked::Section::strings));
+	const Cooked::TextureRecord* texture = reinterpret_cast<const Cooked::TextureRecord*>(section(Cooked::Section::textures));
+	const Cooked::MaterialRecord* material = reinterpret_cast<const Cooked::MaterialRecord*>(section(Cooked::Section::materials));
+	const Cooked::NodeRecord* node = reinterpret_cast<const Cooked::NodeRecord*>(section(Cooked::Section::nodes));
+	const Cooked::LodRecord* lod = reinterpret_cast<const Cooked::LodRecord*>(section(Cooked::Section::lods));
+	const uint8_t* geometry = section(Cooked::Section::geometry);
+
+	// Readers with bound checks:
+	bool valid = true;
+	auto getString = [&](const Cooked::String& str) -> std::string
+	{
+		if (static_cast<uint64_t>(str.offset) + str.length >= sectionSize(Cooked::Section::strings))
+		{
+			valid = false;
+			return std::string();
+		}
+		return std::string(strings + str.offset, str.length);
+	};
+	auto getArray = [&](uint64_t offset, uint64_t nrOfBytes) -> const void*
+	{
+		if (offset > sectionSize(Cooked::Section::geometry) || nrOfBytes > sectionSize(Cooked::Section::geometry) - offset)
+		{
+			valid = false;
+			return nullptr;
+		}
+		return geometry + offset;
+	};
+
+	/**
+	 * @brief Mesh LOD stored encoded.
+	 */
+	struct EncodedLod
+	{
+		uint32_t mesh; ///< Mesh slot
+		uint32_t lod; ///< LOD within the mesh
+		uint32_t record; ///< LOD record
+	};
+	std::vector<EncodedLod> encoded;
+
+	// Materials:
+	SceneStaging scene;
+	scene.material.resize(header->nrOfMaterials);
+	for (uint32_t c = 0; c < header->nrOfMaterials && valid; c++)
+	{
+		Eng::Material::Staging& m = scene.material[c];
+		m.name = getString(material[c].name);
+		m.emission = material[c].emission;
+		m.albedo = material[c].albedo;
+		m.roughness = material[c].roughness;
+		m.metalness = material[c].metalness;
+		m.opacity = material[c].opacity;
+		for (uint32_t t = 0; t < Eng::Material::maxNrOfTextures; t++)
+		{
+			m.textureName[t].clear();
+			m.textureKey[t].clear();
+			m.bitmapLoadTime[t] = 0.0;
+			int32_t index = material[c].texture[t];
+			if (index >= static_cast<int32_t>(header->nrOfTextures))
+				valid = false;
+			else if (index >= 0)
+			{
+				m.textureName[t] = getString(texture[index].filename);
+				m.textureKey[t] = Eng::Container::getTextureKey(m.textureName[t]);
+			}
+		}
+		scene.chunkId.push_back(static_cast<uint32_t>(Eng::Ovo::ChunkId::material));
+		scene.slot.push_back(c);
+	}
+
+	// Nodes:
+	for (uint32_t c = 0; c < header->nrOfNodes && valid; c++)
+	{
+		const Cooked::NodeRecord& n = node[c];
+		scene.chunkId.push_back(n.chunkId);
+		switch (n.chunkId)
+		{
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node):
+			scene.slot.push_back(static_cast<uint32_t>(scene.node.size()));
+			scene.node.push_back({getString(n.name), n.matrix, n.nrOfChildren});
+			break;
+
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh):
+		{
+			scene.slot.push_back(static_cast<uint32_t>(scene.mesh.size()));
+			scene.mesh.emplace_back();
+			Eng::Mesh::Staging& m = scene.mesh.back();
+			m.name = getString(n.name);
+			m.matrix = n.matrix;
+			m.nrOfChildren = n.nrOfChildren;
+			m.materialName = getString(n.materialName);
+			m.material = nullptr;
+			m.radius = n.radius;
+			m.bboxMin = n.bboxMin;
+			m.bboxMax = n.bboxMax;
+			if (n.firstLod > header->nrOfLods || n.nrOfLods > header->nrOfLods - n.firstLod)
+			{
+				valid = false;
+				break;
+			}
+			for (uint32_t l = n.firstLod; l < n.firstLod + n.nrOfLods; l++)
+			{
+				Eng::Mesh::Staging::Lod staged;
+				staged.nrOfVertices = lod[l].nrOfVertices;
+				staged.nrOfFaces = lod[l].nrOfFaces;
+
+				// Encoded arrays are decoded below, in parallel:
+				if (lod[l].nrOfVertexBytes || lod[l].nrOfFaceBytes)
+				{
+					staged.vertices = nullptr;
+					staged.faces = nullptr;
+					m.lod.push_back(std::move(staged));
+					encoded.push_back({static_cast<uint32_t>(scene.mesh.size() - 1),
+					                   static_cast<uint32_t>(m.lod.size() - 1), l});
+					getArray(lod[l].vertexOffset, lod[l].nrOfVertexBytes);
+					getArray(lod[l].faceOffset, lod[l].nrOfFaceBytes);
+					continue;
+				}
+				const uint64_t nrOfVertexBytes = staged.nrOfVertices * sizeof(Eng::Vbo::VertexData);
+				const uint64_t nrOfFaceBytes = staged.nrOfFaces * sizeof(Eng::Ebo::FaceData);
+				const void* vertices = getArray(lod[l].vertexOffset, nrOfVertexBytes);
+				const void* faces = getArray(lod[l].faceOffset, nrOfFaceBytes);
+				staged.vertices = static_cast<const Eng::Vbo::VertexData*>(vertices);
+				staged.faces = static_cast<const Eng::Ebo::FaceData*>(faces);
+				m.lod.push_back(std::move(staged));
+			}
+			scene.meshMaterial.push_back(n.material);
+		}
+		break;
+
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light):
+			scene.slot.push_back(static_cast<uint32_t>(scene.light.size()));
+			scene.light.push_back({getString(n.name), n.matrix, n.nrOfChildren, n.color});
+			break;
+
+		default:
+			valid = false;
+		}
+	}
+
+	// Encoded geometry:
+	std::atomic<bool> decoded(true);
+	if (valid)
+		Eng::ThreadPool::getInstance().parallelFor(encoded.size(), [&](uint64_t c)
+		{
+			const Cooked::LodRecord& r = lod[encoded[c].record];
+			Eng::Mesh::Staging::Lod& l = scene.mesh[encoded[c].mesh].lod[encoded[c].lod];
+			if (l.nrOfVertices * sizeof(Eng::Vbo::VertexData) > 256ull * r.nrOfVertexBytes ||
+			    l.nrOfFaces * sizeof(Eng::Ebo::FaceData) > 256ull * r.nrOfFaceBytes)
+			{
+				decoded = false;
+				return;
+			}
+			l.vertexStorage.resize(l.nrOfVertices);
+			l.faceStorage.resize(l.nrOfFaces);
+			if (Eng::MeshCodec::decodeVertices(geometry + r.vertexOffset, r.nrOfVertexBytes, l.vertexStorage.data(), l.nrOfVertices) == false ||
+			    Eng::MeshCodec::decodeFaces(geometry + r.faceOffset, r.nrOfFaceBytes, l.faceStorage.data(), l.nrOfFaces) == false)
+				decoded = false;
+			l.vertices = l.vertexStorage.data();
+			l.faces = l.faceStorage.data();
+		});
+	if (valid == false || decoded == false)
+	{
+		ENG_LOG_WARN("Invalid cooked file '%s' ignored", cookedFilename.c_str());
+		return Eng::Node::empty;
+	}
+
+	// Done:
+	loadImages(scene);
+	return buildScene(scene);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves a decoded scene as a cooked cache file. The file is written under a temporary name and then renamed, so a
+ * partially written cache is never used.
+ * @param cookedFilename cooked cache file name
+ * @param filename source OVO file name
+ * @param scene decoded scene
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::saveCooked(const std::string& cookedFilename, const std::string& filename,
+                                  const SceneStaging& scene)
+{
+	Cooked::Header header = {};
+	memcpy(header.magic, Cooked::magic, sizeof(Cooked::magic));
+	header.version = Cooked::version;
+	header.nrOfSections = static_cast<uint32_t>(Cooked::Section::last);
+	header.meshOptimization = static_cast<uint32_t>(meshOptimization);
+	header.nrOfGeneratedLods = nrOfGeneratedLods;
+	header.lodRatio = lodRatio;
+	if (getFileStamp(filename, header.sourceSize, header.sourceTime) == false)
+		return false;
+
+	// Tables (geometry is only laid out here, and written later):
+	std::vector<uint8_t> section[static_cast<uint32_t>(Cooked::Section::last)];
+	auto append = [&section](Cooked::Section s, const void* data, uint64_t nrOfBytes)
+	{
+		const uint8_t* ptr = static_cast<const uint8_t*>(data);
+		section[static_cast<uint32_t>(s)].insert(section[static_cast<uint32_t>(s)].end(), ptr, ptr + nrOfBytes);
+	};
+	auto addString = [&append, &section](const std::string& text) -> Cooked::String
+	{
+		Cooked::String str = {static_cast<uint32_t>(section[static_cast<uint32_t>(Cooked::Section::strings)].size()),
+		                      static_cast<uint32_t>(text.size())};
+		append(Cooked::Section::strings, text.c_str(), text.size() + 1);
+		return str;
+	};
+
+	// Textures and materials:
+	std::map<std::string, int32_t> textureIndex;
+	std::map<std::string, int32_t> materialIndex;
+	for (auto& m : scene.material)
+	{
+		Cooked::MaterialRecord r = {};
+		r.name = addString(m.name);
+		r.emission = m.emission;
+		r.albedo = m.albedo;
+		r.roughness = m.roughness;
+		r.metalness = m.metalness;
+		r.opacity = m.opacity;
+		for (uint32_t t = 0; t < Eng::Material::maxNrOfTextures; t++)
+		{
+			r.texture[t] = -1;
+			if (m.textureName[t].empty())
+				continue;
+			if (textureIndex.count(m.textureName[t]) == 0)
+			{
+				Cooked::TextureRecord tr = {addString(m.textureName[t])};
+				append(Cooked::Section::textures, &tr, sizeof(tr));
+				textureIndex[m.textureName[t]] = header.nrOfTextures++;
+			}
+			r.texture[t] = textureIndex[m.textureName[t]];
+		}
+		append(Cooked::Section::materials, &r, sizeof(r));
+		materialIndex.emplace(m.name, header.nrOfMaterials++);
+	}
+
+	// Geometry encoding, in parallel (two arrays per LOD, in file order):
+	std::vector<const Eng::Mesh::Staging::Lod*> lods;
+	for (uint32_t c = 0; c < scene.chunkId.size(); c++)
+		if (scene.chunkId[c] == static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh))
+			for (auto& l : scene.mesh[scene.slot[c]].lod)
+				lods.push_back(&l);
+	std::vector<std::vector<uint8_t>> encoded(meshCompression ? 2 * lods.size() : 0);
+	std::atomic<bool> compressed(true);
+	Eng::ThreadPool::getInstance().parallelFor(encoded.size(), [&](uint64_t c)
+	{
+		const Eng::Mesh::Staging::Lod& l = *lods[c / 2];
+		if ((c % 2 ? Eng::MeshCodec::encodeFaces(l.faces, l.nrOfFaces, encoded[c])
+		           : Eng::MeshCodec::encodeVertices(l.vertices, l.nrOfVertices, encoded[c])) == false)
+			compressed = false;
+	});
+	if (compressed == false)
+		return false;
+
+	// Nodes, in file order:
+	uint64_t geometrySize = 0;
+	for (uint32_t c = 0; c < scene.chunkId.size(); c++)
+	{
+		Cooked::NodeRecord r = {};
+		r.chunkId = scene.chunkId[c];
+		r.material = -1;
+		switch (scene.chunkId[c])
+		{
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node):
+		{
+			const Eng::Node::Staging& n = scene.node[scene.slot[c]];
+			r.name = addString(n.name);
+			r.matrix = n.matrix;
+			r.nrOfChildren = n.nrOfChildren;
+		}
+		break;
+
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh):
+		{
+			const Eng::Mesh::Staging& m = scene.mesh[scene.slot[c]];
+			r.name = addString(m.name);
+			r.matrix = m.matrix;
+			r.nrOfChildren = m.nrOfChildren;
+			r.materialName = addString(m.materialName);
+			if (materialIndex.count(m.materialName))
+				r.material = materialIndex[m.materialName];
+			r.radius = m.radius;
+			r.bboxMin = m.bboxMin;
+			r.bboxMax = m.bboxMax;
+			r.firstLod = header.nrOfLods;
+			r.nrOfLods = static_cast<uint32_t>(m.lod.size());
+			for (auto& l : m.lod)
+			{
+				Cooked::LodRecord lr = {};
+				lr.nrOfVertices = l.nrOfVertices;
+				lr.nrOfFaces = l.nrOfFaces;
+				if (meshCompression)
+				{
+					lr.nrOfVertexBytes = static_cast<uint32_t>(encoded[2 * header.nrOfLods].size());
+					lr.nrOfFaceBytes = static_cast<uint32_t>(encoded[2 * header.nrOfLods + 1].size());
+				}
+				lr.vertexOffset = geometrySize;
+				geometrySize = Cooked::align(geometrySize + (meshCompression ? lr.nrOfVertexBytes : l.nrOfVertices * sizeof(Eng::Vbo::VertexData)));
+				lr.faceOffset = geometrySize;
+				geometrySize = Cooked::align(geometrySize + (meshCompression ? lr.nrOfFaceBytes : l.nrOfFaces * sizeof(Eng::Ebo::FaceData)));
+				append(Cooked::Section::lods, &lr, sizeof(lr));
+				header.nrOfLods++;
+			}
+		}
+		break;
+
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light):
+		{
+			const Eng::Light::Staging& l = scene.light[scene.slot[c]];
+			r.name = addString(l.name);
+			r.matrix = l.matrix;
+			r.nrOfChildren = l.nrOfChildren;
+			r.color = l.color;
+		}
+		break;
+
+		default:
+			continue;
+		}
+		append(Cooked::Section::nodes, &r, sizeof(r));
+		header.nrOfNodes++;
+	}
+
+	// Directory:
+	Cooked::Directory dir[static_cast<uint32_t>(Cooked::Section::last)];
+	uint64_t offset = Cooked::align(sizeof(Cooked::Header) + sizeof(dir));
+	for (uint32_t c = 0; c < static_cast<uint32_t>(Cooked::Section::last); c++)
+	{
+		dir[c].offset = offset;
+		dir[c].size = (c == static_cast<uint32_t>(Cooked::Section::geometry)) ? geometrySize : section[c].size();
+		offset = Cooked::align(offset + dir[c].size);
+	}
+
+	// Write:
+	std::string tmpFilename = cookedFilename + ".tmp";
+	FILE* file = fopen(tmpFilename.c_str(), "wb");
+	if (file == nullptr)
+	{
+		ENG_LOG_WARN("Unable to write cooked file '%s'", cookedFilename.c_str());
+		return false;
+	}
+	const uint8_t padding[Cooked::alignment] = {};
+	uint64_t position = 0;
+	bool done = true;
+	auto write = [&](const void* data, uint64_t nrOfBytes, uint64_t alignTo)
+	{
+		if (alignTo > position)
+		{
+			done &= fwrite(padding, 1, alignTo - position, file) == alignTo - position;
+			position = alignTo;
+		}
+		if (nrOfBytes)
+			done &= fwrite(data, 1, nrOfBytes, file) == nrOfBytes;
+		position += nrOfBytes;
+	};
+	write(&header, sizeof(header), 0);
+	write(dir, sizeof(dir), position);
+	for (uint32_t c = 0; c < static_cast<uint32_t>(Cooked::Section::geometry); c++)
+		write(section[c].data(), section[c].size(), dir[c].offset);
+	uint64_t geometryOffset = dir[static_cast<uint32_t>(Cooked::Section::geometry)].offset;
+	for (uint64_t c = 0; c < lods.size(); c++)
+	{
+		const Eng::Mesh::Staging::Lod& l = *lods[c];
+		if (meshCompression)
+			write(encoded[2 * c].data(), encoded[2 * c].size(), geometryOffset);
+		else
+			write(l.vertices, l.nrOfVertices * sizeof(Eng::Vbo::VertexData), geometryOffset);
+		geometryOffset = Cooked::align(position);
+		if (meshCompression)
+			write(encoded[2 * c + 1].data(), encoded[2 * c + 1].size(), geometryOffset);
+		else
+			write(l.faces, l.nrOfFaces * sizeof(Eng::Ebo::FaceData), geometryOffset);
+		geometryOffset = Cooked::align(position);
+	}
+	write(nullptr, 0, offset);
+	fclose(file);
+
+	std::error_code error;
+	if (done)
+		std::filesystem::rename(tmpFilename, cookedFilename, error);
+	if (!done || error)
+	{
+		std::filesystem::remove(tmpFilename, error);
+		ENG_LOG_WARN("Unable to write cooked file '%s'", cookedFilename.c_str());
+		return false;
+	}
+
+	// Done:
+	ENG_LOG_DEBUG("Cooked file '%s' saved (%llu bytes)", cookedFilename.c_str(), offset);
+	return true;
 }
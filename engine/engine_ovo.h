@@ -1,6 +1,6 @@
 /**
  * @file		engine_ovo.h
- * @brief	OVO importing 
+ * @brief	OVO importing and exporting
  *
  * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
  */
@@ -25,7 +25,7 @@ public: //
 	//////////	   
 
 	/**
-	 * @brief Chunk IDs (taken from the OVO format specs).
+	 * @brief Chunk IDs (taken from the OVO format specs, followed by the engine extensions).
 	 */
 	enum class ChunkId : uint32_t
 	{
@@ -35,16 +35,99 @@ public: //
 		light = 16,
 		mesh = 18,
 
+		// Extensions (skipped as unknown chunks by other readers):
+		encodedMesh = 64, ///< Mesh with the geometry arrays stored through MeshCodec
+
 		// Terminator:
 		last
 	};
 
 
+	/**
+	 * @brief Location of a chunk within the file.
+	 */
+	struct ChunkInfo
+	{
+		uint32_t id; ///< Chunk ID
+		uint32_t size; ///< Payload size in bytes
+		uint64_t position; ///< Offset of the chunk header
+	};
+
+
 	// Consts:
 	static constexpr uint32_t version = 8; ///< OVO format revision (divide by 10)   
 
+	// Const/dest:
+	Ovo();
+
 	// Loading methods:
-	Eng::Node& load(const std::string& filename);
+	Eng::Node& load(const std::string& filename, Eng::Serializer::Mode mode = Eng::Serializer::Mode::mapped);
 	virtual uint32_t loadChunk(Eng::Serializer& serial, void* data = nullptr);
 	uint32_t ignoreChunk(Eng::Serializer& serial);
+	bool scanChunks(Eng::Serializer& serial, std::vector<ChunkInfo>& table);
+
+	// Saving methods:
+	bool save(const std::string& filename, const Eng::Node& root);
+	virtual bool saveChunk(Eng::Serializer& serial) const;
+
+	// Import-time processing:
+	void setMeshOptimization(bool enable);
+	bool isMeshOptimization() const;
+	void setCompactGeometry(bool enable);
+	bool isCompactGeometry() const;
+	void setMeshClustering(bool enable);
+	bool isMeshClustering() const;
+	void setLodGeneration(uint32_t nrOfLods, float ratio = 0.5f);
+	uint32_t getNrOfGeneratedLods() const;
+	void setShapeRetention(bool enable);
+	bool isShapeRetention() const;
+
+	// Compression:
+	void setMeshCompression(bool enable);
+	bool isMeshCompression() const;
+
+	// Cooked cache:
+	static void setCookedCache(bool enable);
+	static bool isCookedCache();
+	static std::string getCookedFilename(const std::string& filename);
+
+
+	/////////////
+protected: //
+	/////////////
+
+	// Loading methods:
+	Eng::Node& loadChunks(const Eng::Serializer& serial, const std::vector<ChunkInfo>& table);
+
+	// Saving methods:
+	static uint64_t beginChunk(Eng::Serializer& serial, ChunkId chunkId);
+	static bool endChunk(Eng::Serializer& serial, uint64_t chunkPosition);
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct SceneStaging;
+	struct Cooked;
+	static bool cookedCache;
+	bool meshOptimization;
+	bool compactGeometry;
+	bool meshClustering;
+	uint32_t nrOfGeneratedLods;
+	float lodRatio;
+	bool meshCompression;
+	bool shapeRetention;
+
+	// Loading methods:
+	Eng::Node& loadSerial(Eng::Serializer& serial);
+	Eng::Node& loadParallel(Eng::Serializer& serial, SceneStaging& scene);
+	bool decodeChunks(const Eng::Serializer& serial, const std::vector<ChunkInfo>& table, SceneStaging& scene);
+	void loadImages(SceneStaging& scene);
+	Eng::Node& buildScene(SceneStaging& scene);
+
+	// Cooked cache:
+	Eng::Node& loadCooked(const std::string& cookedFilename, const std::string& filename);
+	bool saveCooked(const std::string& cookedFilename, const std::string& filename, const SceneStaging& scene);
 };
@@ -0,0 +1,270 @@
+/**
+ * @file		engine_ovo_index.cpp
+ * @brief	Indexed OVO access, for loading subtrees on demand
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <functional>
+#include <map>
+#include <set>
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief OvoIndex reserved structure.
+ */
+struct Eng::OvoIndex::Reserved
+{
+	std::string filename; ///< Indexed file
+	Eng::Serializer serial; ///< File content, kept open (mapped by default)
+	std::vector<Eng::Ovo::ChunkInfo> table; ///< All the chunks
+	std::vector<Eng::OvoIndex::Entry> entry; ///< Nodes, in file order
+	std::map<std::string, uint32_t> entryByName; ///< First entry with a given name
+	std::map<std::string, uint32_t> materialChunk; ///< First material chunk with a given name
+
+
+	/**
+	 * Constructor.
+	 */
+	Reserved() {}
+};
+
+
+////////////////////////////
+// BODY OF CLASS OvoIndex //
+////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::OvoIndex::OvoIndex() : reserved(std::make_unique<Eng::OvoIndex::Reserved>())
+{
+	ENG_LOG_DETAIL("[+]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::OvoIndex::~OvoIndex()
+{
+	ENG_LOG_DETAIL("[-]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Opens an OVO file in indexed mode: the chunk table is built and, for each node, only the name, the number of children
+ * and the material name are read. Mesh payloads are never touched, so with a mapped file they are not even paged in.
+ * @param filename 3D file
+ * @param mode serializer storage used for reading the file (streamed mode is not supported)
+ * @return TF
+ */
+bool ENG_API Eng::OvoIndex::open(const std::string& filename, Eng::Serializer::Mode mode)
+{
+	// Safety net:
+	if (filename.empty() || mode == Eng::Serializer::Mode::streamed)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	close();
+
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint64_t startTime = timer.getCounter();
+	Eng::Serializer& serial = reserved->serial;
+	if (serial.load(filename, mode) == false)
+	{
+		ENG_LOG_ERROR("Unable to load file '%s'", filename.c_str());
+		return false;
+	}
+	if (loadChunk(serial) == 0 || scanChunks(serial, reserved->table) == false)
+	{
+		ENG_LOG_ERROR("Invalid format version or wrong file format for file '%s'", filename.c_str());
+		close();
+		return false;
+	}
+
+	// Names and number of children (the node properties are at the beginning of node, mesh and light chunks):
+	std::vector<uint32_t> nrOfChildren(reserved->table.size(), 0);
+	std::vector<int32_t> entryOfChunk(reserved->table.size(), -1);
+	for (uint32_t c = 0; c < reserved->table.size(); c++)
+	{
+		const Eng::Ovo::ChunkInfo& chunk = reserved->table[c];
+		serial.setPosition(chunk.position + 2 * sizeof(uint32_t));
+		std::string name;
+		switch (chunk.id)
+		{
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::material):
+			serial.deserialize(name);
+			reserved->materialChunk.emplace(name, c);
+			break;
+
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::node):
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh):
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::encodedMesh):
+		case static_cast<uint32_t>(Eng::Ovo::ChunkId::light):
+		{
+			Entry entry;
+			serial.deserialize(entry.name);
+			serial.skip(sizeof(glm::mat4));
+			serial.deserialize(nrOfChildren[c]);
+			if (chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh) ||
+			    chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::encodedMesh))
+			{
+				std::string_view target;
+				serial.deserialize(target);
+				uint8_t subtype;
+				serial.deserialize(subtype);
+				serial.deserialize(entry.materialName);
+			}
+			entry.chunkId = chunk.id == static_cast<uint32_t>(Eng::Ovo::ChunkId::encodedMesh) ?
+			                static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh) : chunk.id;
+			entry.first = c;
+			entry.last = c + 1;
+			entryOfChunk[c] = static_cast<int32_t>(reserved->entry.size());
+			reserved->entryByName.emplace(entry.name, static_cast<uint32_t>(reserved->entry.size()));
+			reserved->entry.push_back(entry);
+		}
+		break;
+		}
+	}
+
+	// Subtree ranges (children follow their parent, depth-first):
+	std::function<uint32_t(uint32_t)> walk;
+	walk = [&](uint32_t c) -> uint32_t
+	{
+		uint32_t next = c + 1;
+		if (entryOfChunk[c] < 0)
+			return next;
+		for (uint32_t child = 0; child < nrOfChildren[c] && next < reserved->table.size(); child++)
+			next = walk(next);
+		reserved->entry[entryOfChunk[c]].last = next;
+		return next;
+	};
+	for (uint32_t c = 0; c < reserved->table.size(); )
+		c = walk(c);
+	reserved->filename = filename;
+
+	// Done:
+	ENG_LOG_PLAIN("File '%s' indexed in %.1f ms (%zu chunks, %zu nodes)", filename.c_str(),
+	              timer.getCounterDiff(startTime, timer.getCounter()), reserved->table.size(), reserved->entry.size());
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Closes the indexed file. Objects already loaded are not affected.
+ */
+void ENG_API Eng::OvoIndex::close()
+{
+	reserved->filename.clear();
+	reserved->serial.clear();
+	reserved->table.clear();
+	reserved->entry.clear();
+	reserved->entryByName.clear();
+	reserved->materialChunk.clear();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when a file is opened.
+ * @return TF
+ */
+bool ENG_API Eng::OvoIndex::isOpen() const
+{
+	return !reserved->filename.empty();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the indexed nodes.
+ * @return list of nodes, in file order
+ */
+const std::vector<Eng::OvoIndex::Entry> ENG_API& Eng::OvoIndex::getEntries() const
+{
+	return reserved->entry;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns, if existing, the first indexed node with the given name.
+ * @param name node name
+ * @return found entry or nullptr
+ */
+const Eng::OvoIndex::Entry ENG_API* Eng::OvoIndex::findEntry(const std::string& name) const
+{
+	auto it = reserved->entryByName.find(name);
+	if (it == reserved->entryByName.end())
+		return nullptr;
+
+	// Done:
+	return &reserved->entry[it->second];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the subtree starting at the given node, together with the materials used by its meshes that are not already in
+ * the container. Nothing else in the file is decoded or uploaded.
+ * @param name name of the subtree root node
+ * @return subtree root node or Node::empty if error
+ */
+Eng::Node ENG_API& Eng::OvoIndex::loadSubtree(const std::string& name)
+{
+	// Safety net:
+	const Entry* entry = findEntry(name);
+	if (entry == nullptr)
+	{
+		ENG_LOG_ERROR("Node '%s' not found", name.c_str());
+		return Eng::Node::empty;
+	}
+
+	Eng::Timer& timer = Eng::Timer::getInstance();
+	uint64_t startTime = timer.getCounter();
+
+	// Materials first, in file order:
+	Eng::Container& container = Eng::Container::getInstance();
+	std::set<uint32_t> materialChunk;
+	for (auto& e : reserved->entry)
+		if (e.first >= entry->first && e.first < entry->last && !e.materialName.empty() &&
+			dynamic_cast<Eng::Material*>(&container.find(e.materialName)) == nullptr &&
+			reserved->materialChunk.count(e.materialName))
+			materialChunk.insert(reserved->materialChunk[e.materialName]);
+	std::vector<Eng::Ovo::ChunkInfo> table;
+	for (auto c : materialChunk)
+		table.push_back(reserved->table[c]);
+
+	// Subtree:
+	for (uint32_t c = entry->first; c < entry->last; c++)
+		table.push_back(reserved->table[c]);
+
+	// Decode and build:
+	std::reference_wrapper<Eng::Node> root = loadChunks(reserved->serial, table);
+	if (root.get() == Eng::Node::empty)
+		return Eng::Node::empty;
+
+	// Done:
+	ENG_LOG_PLAIN("Subtree '%s' loaded in %.1f ms (%zu of %zu chunks)", name.c_str(),
+	              timer.getCounterDiff(startTime, timer.getCounter()), table.size(), reserved->table.size());
+	return root;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file		engine_ovo_index.h
+ * @brief	Indexed OVO access, for loading subtrees on demand
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief OVO file opened in indexed mode. Opening only reads the chunk headers and the node names; subtrees are then
+ * decoded and uploaded on demand, together with the materials they use.
+ */
+class ENG_API OvoIndex : public Eng::Ovo
+{
+	//////////
+public: //
+	//////////
+
+	/**
+	 * @brief Indexed node (plain node, mesh or light).
+	 */
+	struct Entry
+	{
+		std::string name; ///< Node name
+		uint32_t chunkId; ///< Kind of node (as Ovo::ChunkId)
+		uint32_t first; ///< Position of its chunk in the chunk table
+		uint32_t last; ///< Position following the last chunk of its subtree
+		std::string materialName; ///< Material name (meshes only)
+	};
+
+
+	// Const/dest:
+	OvoIndex();
+	OvoIndex(OvoIndex const&) = delete;
+	virtual ~OvoIndex();
+
+	// Operators:
+	void operator=(OvoIndex const&) = delete;
+
+	// Indexing:
+	bool open(const std::string& filename, Eng::Serializer::Mode mode = Eng::Serializer::Mode::mapped);
+	void close();
+	bool isOpen() const;
+	const std::vector<Entry>& getEntries() const;
+	const Entry* findEntry(const std::string& name) const;
+
+	// Loading methods:
+	Eng::Node& loadSubtree(const std::string& name);
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct Reserved;
+	std::unique_ptr<Reserved> reserved;
+};
@@ -273,6 +273,7 @@ struct Eng::PipelineDefault::Reserved
 	bool wireframe;
 
 	PipelineShadowMapping shadowMapping;
+	std::vector<Eng::PipelineShadowMapping::CasterStats> casterStats; ///< Shadow casters of the last frame, per light
 
 
 	/**
@@ -389,6 +390,28 @@ const Eng::PipelineShadowMapping ENG_API& Eng::PipelineDefault::getShadowMapping
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a reference to the shadow mapping pipeline, for changing its settings (e.g., caster culling).
+ * @return shadow mapping pipeline reference
+ */
+Eng::PipelineShadowMapping ENG_API& Eng::PipelineDefault::getShadowMappingPipeline()
+{
+	return reserved->shadowMapping;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the shadow casters rendered during the last frame, one entry per light (in list order).
+ * @return caster stats per light
+ */
+const std::vector<Eng::PipelineShadowMapping::CasterStats> ENG_API& Eng::PipelineDefault::getCasterStats() const
+{
+	return reserved->casterStats;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Gets the status of the wireframe status.
@@ -455,6 +478,7 @@ bool ENG_API Eng::PipelineDefault::render(const Eng::Camera& camera, const Eng::
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	// Multipass rendering:
+	reserved->casterStats.clear();
 	for (uint32_t l = 0; l < list.getNrOfLights(); l++)
 	{
 		// Enable addictive blending from light 1 on:
@@ -470,6 +494,7 @@ bool ENG_API Eng::PipelineDefault::render(const Eng::Camera& camera, const Eng::
 
 		// Render shadow map:
 		reserved->shadowMapping.render(lightRe, list);
+		reserved->casterStats.push_back(reserved->shadowMapping.getCasterStats());
 
 		// Re-enable this pipeline's program:
 		program.render();
@@ -480,9 +505,8 @@ bool ENG_API Eng::PipelineDefault::render(const Eng::Camera& camera, const Eng::
 		program.setMat4("lightMatrix", lightFinalMatrix);
 		reserved->shadowMapping.getShadowMap().render(4);
 
-		// Render meshes:
-
-		list.render(viewMatrix, Eng::List::Pass::meshes);
+		// Render meshes (only the visible meshlets, if the list was culled):
+		list.render(viewMatrix, Eng::List::Pass::visibleMeshes);
 
 	}
 
@@ -24,6 +24,8 @@ public: //
 
 	// Get/set:
 	const Eng::PipelineShadowMapping& getShadowMappingPipeline() const;
+	Eng::PipelineShadowMapping& getShadowMappingPipeline();
+	const std::vector<Eng::PipelineShadowMapping::CasterStats>& getCasterStats() const;
 	void setWireframe(bool flag);
 	bool isWireframe() const;
 
@@ -75,11 +75,17 @@ struct Eng::PipelineShadowMapping::Reserved
    Eng::Texture depthMap;
    Eng::Fbo fbo;
 
+   // Shadow casters:
+   bool casterCulling;                       ///< TF to render only the meshes within the light frustum
+   bool receiverCulling;                     ///< TF to also skip the meshes whose shadow falls outside the view
+   std::vector<uint32_t> casters;            ///< Indices of the selected casters within the list
+   Eng::PipelineShadowMapping::CasterStats casterStats; ///< Stats of the last render() call
+
 
    /**
     * Constructor. 
     */
-   Reserved()
+   Reserved() : casterCulling{ true }, receiverCulling{ false }
    {}
 };
 
@@ -145,6 +151,62 @@ const Eng::Texture ENG_API &Eng::PipelineShadowMapping::getShadowMap() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the culling of the shadow casters against the light frustum (enabled by default).
+ * @param enable TF
+ */
+void ENG_API Eng::PipelineShadowMapping::setCasterCulling(bool enable)
+{
+   reserved->casterCulling = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when only the meshes within the light frustum are rendered into the shadow map.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineShadowMapping::isCasterCulling() const
+{
+   return reserved->casterCulling;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Enables or disables the culling of the shadow casters whose shadow cannot reach the view set on the list through
+ * List::setView() (disabled by default). Requires caster culling.
+ * @param enable TF
+ */
+void ENG_API Eng::PipelineShadowMapping::setReceiverCulling(bool enable)
+{
+   reserved->receiverCulling = enable;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when the casters whose shadow falls outside the view are skipped.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineShadowMapping::isReceiverCulling() const
+{
+   return reserved->receiverCulling;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of shadow casters rendered by the last render() call.
+ * @return caster stats
+ */
+const Eng::PipelineShadowMapping::CasterStats ENG_API &Eng::PipelineShadowMapping::getCasterStats() const
+{
+   return reserved->casterStats;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Initializes this pipeline. 
@@ -252,8 +314,19 @@ bool ENG_API Eng::PipelineShadowMapping::render(const Eng::List::RenderableElem
    // Light source is the camera:
    glm::mat4 viewMatrix = glm::inverse(lightRe.matrix);       
 
-   // Render meshes:   
-   list.render(viewMatrix, Eng::List::Pass::meshes);         
+   // Render meshes (only the shadow casters, if culling):
+   reserved->casterStats.nrOfMeshes = list.getNrOfRenderableElems() - list.getNrOfLights();
+   if (reserved->casterCulling)
+   {
+      list.selectCasters(lightRe.matrix, light.getProjMatrix(), reserved->casters, reserved->receiverCulling);
+      reserved->casterStats.nrOfCasters = static_cast<uint32_t>(reserved->casters.size());
+      list.render(viewMatrix, reserved->casters);
+   }
+   else
+   {
+      reserved->casterStats.nrOfCasters = reserved->casterStats.nrOfMeshes;
+      list.render(viewMatrix, Eng::List::Pass::meshes);
+   }
 
    // Redo OpenGL settings:
    glCullFace(GL_BACK);
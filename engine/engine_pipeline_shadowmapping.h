@@ -20,6 +20,22 @@ public: //
    // Special values:
    constexpr static uint32_t depthTextureSize = 1024;     ///< Size of the depth map
 
+
+   /**
+    * @brief Shadow casters rendered by the last render() call.
+    */
+   struct CasterStats
+   {
+      uint32_t nrOfMeshes;                      ///< Meshes in the list
+      uint32_t nrOfCasters;                     ///< Meshes rendered into the shadow map
+
+
+      /**
+       * Constructor.
+       */
+      CasterStats() : nrOfMeshes{ 0 }, nrOfCasters{ 0 } {}
+   };
+
    
    // Const/dest:
 	PipelineShadowMapping();      
@@ -29,6 +45,11 @@ public: //
 
    // Get/set:
    const Eng::Texture &getShadowMap() const;
+   void setCasterCulling(bool enable);
+   bool isCasterCulling() const;
+   void setReceiverCulling(bool enable);
+   bool isReceiverCulling() const;
+   const CasterStats &getCasterStats() const;
 
    // Rendering methods:
    // bool render(uint32_t value = 0, void *data = nullptr) const = delete;
@@ -16,6 +16,16 @@
 // C/C++:
 #include <iterator>
 
+// OS:
+#ifdef _WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 ////////////
 // STATIC //
@@ -25,6 +35,43 @@
 Eng::Serializer Eng::Serializer::empty;
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the file position using 64-bit offsets.
+ * @param file file handle
+ * @param offset absolute offset in bytes
+ * @return TF
+ */
+static bool fileSeek(FILE* file, uint64_t offset)
+{
+#ifdef _WINDOWS
+	return _fseeki64(file, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+	return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the file size using 64-bit offsets.
+ * @param file file handle
+ * @return file size in bytes
+ */
+static uint64_t fileSize(FILE* file)
+{
+#ifdef _WINDOWS
+	_fseeki64(file, 0, SEEK_END);
+	uint64_t size = static_cast<uint64_t>(_ftelli64(file));
+#else
+	fseeko(file, 0, SEEK_END);
+	uint64_t size = static_cast<uint64_t>(ftello(file));
+#endif
+	fileSeek(file, 0);
+	return size;
+}
+
+
 /////////////////////////
 // RESERVED STRUCTURES //
 /////////////////////////
@@ -34,15 +81,283 @@ Eng::Serializer Eng::Serializer::empty;
  */
 struct Eng::Serializer::Reserved
 {
+	// Consts:
+	static constexpr uint64_t peekSize = 2 * sizeof(uint32_t); ///< Bytes addressable through getDataAtCurPos() when streamed (a chunk header)
+
+
+	/**
+	 * @brief Read-only view of a memory-mapped file, shared among copies and readers of the serializer.
+	 */
+	struct Mapping
+	{
+		const uint8_t* ptr; ///< Base address of the view
+		uint64_t nrOfBytes; ///< Size of the view
+#ifdef _WINDOWS
+		HANDLE file; ///< File handle
+		HANDLE map; ///< File mapping handle
+#else
+		int fd; ///< File descriptor
+#endif
+
+
+		/**
+		 * Constructor.
+		 */
+#ifdef _WINDOWS
+		Mapping() : ptr{nullptr}, nrOfBytes{0}, file{INVALID_HANDLE_VALUE}, map{nullptr} {}
+#else
+		Mapping() : ptr{nullptr}, nrOfBytes{0}, fd{-1} {}
+#endif
+
+		/**
+		 * Destructor.
+		 */
+		~Mapping()
+		{
+#ifdef _WINDOWS
+			if (ptr)
+				UnmapViewOfFile(ptr);
+			if (map)
+				CloseHandle(map);
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+#else
+			if (ptr)
+				munmap(const_cast<uint8_t*>(ptr), nrOfBytes);
+			if (fd != -1)
+				close(fd);
+#endif
+		}
+
+		/**
+		 * Maps the given file into memory.
+		 * @param filename file name
+		 * @return TF
+		 */
+		bool open(const std::string& filename)
+		{
+#ifdef _WINDOWS
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size))
+				return false;
+			nrOfBytes = static_cast<uint64_t>(size.QuadPart);
+			if (nrOfBytes == 0) // Empty files can't be mapped
+				return true;
+			map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (map == nullptr)
+				return false;
+			ptr = static_cast<const uint8_t*>(MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0));
+			return ptr != nullptr;
+#else
+			fd = ::open(filename.c_str(), O_RDONLY);
+			if (fd == -1)
+				return false;
+			struct stat st;
+			if (fstat(fd, &st) != 0)
+				return false;
+			nrOfBytes = static_cast<uint64_t>(st.st_size);
+			if (nrOfBytes == 0) // Empty files can't be mapped
+				return true;
+			void* addr = mmap(nullptr, nrOfBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr == MAP_FAILED)
+				return false;
+			madvise(addr, nrOfBytes, MADV_SEQUENTIAL);
+			ptr = static_cast<const uint8_t*>(addr);
+			return true;
+#endif
+		}
+	};
+
+	/**
+	 * @brief Sequential file reader through a fixed-size, refillable window.
+	 */
+	struct Stream
+	{
+		std::string filename; ///< File name (to reopen the file for copies)
+		FILE* file; ///< File handle
+		std::vector<uint8_t> window; ///< Resident bytes
+		uint64_t windowStart; ///< File offset of the first resident byte
+		uint64_t windowEnd; ///< File offset past the last resident byte
+		uint64_t windowSize; ///< Configured window size
+		uint64_t peakSize; ///< Largest window allocated so far
+
+
+		/**
+		 * Constructor.
+		 */
+		Stream() : file{nullptr}, windowStart{0}, windowEnd{0}, windowSize{0}, peakSize{0} {}
+
+		/**
+		 * Destructor.
+		 */
+		~Stream()
+		{
+			if (file)
+				fclose(file);
+		}
+
+		/**
+		 * Makes the given file range resident. Bytes already in the window are kept, the rest is read from the file.
+		 * The window grows beyond its configured size only for requests larger than the window itself.
+		 * @param offset file offset
+		 * @param nrOfBytes number of bytes
+		 * @param fileSize total file size
+		 * @return TF
+		 */
+		bool fill(uint64_t offset, uint64_t nrOfBytes, uint64_t fileSize)
+		{
+			// Already resident?
+			if (offset >= windowStart && offset + nrOfBytes <= windowEnd)
+				return true;
+
+			uint64_t capacity = nrOfBytes > windowSize ? nrOfBytes : windowSize;
+
+			// Keep the overlapping part:
+			uint64_t kept = 0;
+			if (offset >= windowStart && offset < windowEnd)
+			{
+				kept = windowEnd - offset;
+				if (kept > capacity)
+					kept = capacity;
+				memmove(window.data(), window.data() + (offset - windowStart), kept);
+				if (kept < windowEnd - offset && !fileSeek(file, offset + kept))
+					return false;
+			}
+			else if (!fileSeek(file, offset))
+				return false;
+
+			// Resize window (back to its configured size after a larger request):
+			if (window.size() != capacity)
+			{
+				window.resize(capacity);
+				if (capacity == windowSize)
+					window.shrink_to_fit();
+			}
+			if (capacity > peakSize)
+				peakSize = capacity;
+
+			// Refill:
+			uint64_t toRead = capacity - kept;
+			if (offset + kept + toRead > fileSize)
+				toRead = fileSize - (offset + kept);
+			if (fread(window.data() + kept, sizeof(uint8_t), toRead, file) != toRead)
+			{
+				windowStart = windowEnd = 0;
+				return false;
+			}
+			windowStart = offset;
+			windowEnd = offset + kept + toRead;
+			return windowEnd >= offset + nrOfBytes;
+		}
+	};
+
 	uint64_t position;
 	uint64_t nrOfBytes;
-	std::vector<uint8_t> data;
+	uint64_t offset; ///< Offset of the first byte within the storage (views only)
+	bool view; ///< Read-only range of a storage shared with another serializer (see view())
+	std::shared_ptr<std::vector<uint8_t>> data; ///< Owned storage (memory mode)
+	std::shared_ptr<Mapping> mapping; ///< Mapped storage (mapped mode)
+	std::shared_ptr<Stream> stream; ///< Windowed storage (streamed mode)
 
 
 	/**
 	 * Constructor.
 	 */
-	Reserved() : position{0}, nrOfBytes{0} {}
+	Reserved() : position{0}, nrOfBytes{0}, offset{0}, view{false}, data{std::make_shared<std::vector<uint8_t>>()} {}
+
+	/**
+	 * Copies the content of another serializer. Owned buffers are duplicated and streams are reopened with their own
+	 * window, while mappings (read-only) are shared.
+	 * @param other source
+	 */
+	void copy(const Reserved& other)
+	{
+		*this = other;
+		if (other.stream)
+		{
+			stream = std::make_shared<Stream>();
+			stream->filename = other.stream->filename;
+			stream->windowSize = other.stream->windowSize;
+			stream->file = fopen(stream->filename.c_str(), "rb");
+			if (stream->file == nullptr)
+			{
+				ENG_LOG_ERROR("Unable to open file '%s'", stream->filename.c_str());
+				*this = Reserved();
+			}
+		}
+		else if (mapping == nullptr)
+			data = std::make_shared<std::vector<uint8_t>>(*other.data);
+	}
+
+	/**
+	 * Gets the base address of the current storage (or of the current window, when streamed).
+	 * @return pointer to the first byte
+	 */
+	inline const uint8_t* getBuffer() const
+	{
+		if (stream)
+			return stream->window.data();
+		return (mapping ? mapping->ptr : data->data()) + offset;
+	}
+
+	/**
+	 * Gets a pointer to the given number of bytes at the current position, making them resident if needed.
+	 * @param size number of bytes that must be addressable
+	 * @return pointer to the data or nullptr on overflow/error
+	 */
+	const uint8_t* access(uint64_t size)
+	{
+		if (position + size > nrOfBytes)
+			return nullptr;
+		if (stream)
+		{
+			if (!stream->fill(offset + position, size, offset + nrOfBytes))
+			{
+				ENG_LOG_ERROR("Unable to read from stream");
+				return nullptr;
+			}
+			return stream->window.data() + (offset + position - stream->windowStart);
+		}
+		return getBuffer() + position;
+	}
+
+	/**
+	 * Gets the length of the zero-terminated string at the current position, without reading past the end of the data.
+	 * When streamed, the search is bounded by the resident bytes (e.g., the prefetched chunk) or by the window size,
+	 * whichever is larger, so that a corrupted string can't grow the window.
+	 * @return string length (terminator excluded) or UINT64_MAX if not terminated
+	 */
+	uint64_t getStringLength()
+	{
+		uint64_t remaining = nrOfBytes - position;
+		if (stream)
+		{
+			const uint64_t start = offset + position;
+			uint64_t limit = stream->windowSize;
+			if (start >= stream->windowStart && start < stream->windowEnd && stream->windowEnd - start > limit)
+				limit = stream->windowEnd - start;
+			if (remaining > limit)
+				remaining = limit;
+		}
+		uint64_t probe = remaining < 64 ? remaining : 64;
+		while (probe)
+		{
+			const uint8_t* ptr = access(probe);
+			if (ptr == nullptr)
+				break;
+			const void* terminator = memchr(ptr, 0, probe);
+			if (terminator)
+				return static_cast<const uint8_t*>(terminator) - ptr;
+			if (probe == remaining)
+				break;
+			probe = (probe * 2 < remaining) ? probe * 2 : remaining;
+		}
+		return UINT64_MAX;
+	}
 };
 
 
@@ -62,12 +377,23 @@ ENG_API Eng::Serializer::Serializer() : reserved(std::make_unique<Eng::Serialize
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Copy constructor.
+ * Copy constructor. Owned data is duplicated, and streamed files are reopened with their own window (see share() for
+ * readers that don't copy the data).
  */
 ENG_API Eng::Serializer::Serializer(const Serializer& other) : reserved(std::make_unique<Eng::Serializer::Reserved>())
 {
 	ENG_LOG_DETAIL("[+]");
-	*reserved = *other.reserved;
+	reserved->copy(*other.reserved);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Move constructor.
+ */
+ENG_API Eng::Serializer::Serializer(Serializer&& other) : reserved(std::move(other.reserved))
+{
+	ENG_LOG_DETAIL("[M]");
 }
 
 
@@ -83,11 +409,11 @@ ENG_API Eng::Serializer::Serializer(const void* rawData, uint64_t nrOfBytes) : r
 	ENG_LOG_DETAIL("[+]");
 	reserved->nrOfBytes = nrOfBytes;
 	if (rawData == nullptr)
-		reserved->data.resize(nrOfBytes);
+		reserved->data->resize(nrOfBytes);
 	else
 	{
 		const uint8_t* ptr = static_cast<const uint8_t*>(rawData);
-		std::copy(ptr, ptr + nrOfBytes, std::back_inserter(reserved->data));
+		reserved->data->assign(ptr, ptr + nrOfBytes);
 	}
 }
 
@@ -104,29 +430,41 @@ ENG_API Eng::Serializer::~Serializer()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Copy assignment.
+ * Copy assignment (see the copy constructor).
  */
 void ENG_API Eng::Serializer::operator=(const Serializer& other)
 {
-	*reserved = *other.reserved;
+	if (this != &other)
+		reserved->copy(*other.reserved);
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Pointer to serialized data.
+ * Move assignment.
+ */
+void ENG_API Eng::Serializer::operator=(Serializer&& other)
+{
+	std::swap(reserved, other.reserved);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Pointer to serialized data. In streamed mode, this is the beginning of the current window.
  * @return pointer to serialized data
  */
 void ENG_API* Eng::Serializer::getData() const
 {
-	reserved->data.shrink_to_fit();
-	return static_cast<void*>(reserved->data.data());
+	return const_cast<uint8_t*>(reserved->getBuffer());
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Pointer to serialized data at the current deserializing position.
+ * Pointer to serialized data at the current deserializing position. In streamed mode, only the bytes currently in the
+ * window are addressable through the returned pointer: at least a chunk header (or up to the end of the data) is
+ * guaranteed, and the window is refilled only when fewer bytes are left. Use prefetch() for larger ranges.
  * @return pointer to serialized data at the current position, or nullptr if no more data left
  */
 void ENG_API* Eng::Serializer::getDataAtCurPos() const
@@ -134,8 +472,16 @@ void ENG_API* Eng::Serializer::getDataAtCurPos() const
 	if (reserved->position >= reserved->nrOfBytes)
 		return nullptr;
 
-	reserved->data.shrink_to_fit();
-	return static_cast<void*>(reserved->data.data() + reserved->position);
+	// Streamed: peek at the resident bytes:
+	if (reserved->stream)
+	{
+		uint64_t available = reserved->nrOfBytes - reserved->position;
+		if (available > Reserved::peekSize)
+			available = Reserved::peekSize;
+		return const_cast<uint8_t*>(reserved->access(available));
+	}
+
+	return const_cast<uint8_t*>(reserved->getBuffer() + reserved->position);
 }
 
 
@@ -150,6 +496,266 @@ uint64_t ENG_API Eng::Serializer::getNrOfBytes() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the current deserializing position.
+ * @return position in bytes from the beginning of the data
+ */
+uint64_t ENG_API Eng::Serializer::getPosition() const
+{
+	return reserved->position;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Moves the current deserializing position.
+ * @param position position in bytes from the beginning of the data
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::setPosition(uint64_t position)
+{
+	// Safety net:
+	if (position > reserved->nrOfBytes)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Done:
+	reserved->position = position;
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the kind of storage currently backing the serializer.
+ * @return storage mode
+ */
+Eng::Serializer::Mode ENG_API Eng::Serializer::getMode() const
+{
+	if (reserved->stream)
+		return Mode::streamed;
+	if (reserved->mapping)
+		return Mode::mapped;
+	if (reserved->nrOfBytes)
+		return Mode::memory;
+	return Mode::none;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the number of bytes of file data held in memory by the serializer: the whole file in memory mode, the largest
+ * window allocated so far in streamed mode, and zero in mapped mode (pages are owned by the OS cache).
+ * @return number of resident bytes
+ */
+uint64_t ENG_API Eng::Serializer::getNrOfResidentBytes() const
+{
+	if (reserved->stream)
+		return reserved->stream->peakSize;
+	if (reserved->mapping)
+		return 0;
+	return reserved->data->size();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the content of a file. In mapped mode, the file is mapped read-only into the address space and the data is
+ * accessed in place, without intermediate copies. The mapping stays alive as long as the serializer (or a copy) exists.
+ * In streamed mode, the file is read through a refillable window of windowSize bytes, so files larger than the
+ * available memory can be processed. Names found in a mounted archive are loaded from the archive (see
+ * Archive::load()), without accessing the file system.
+ * @param filename file name
+ * @param mode type of storage
+ * @param windowSize window size in bytes (streamed mode only)
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::load(const std::string& filename, Mode mode, uint64_t windowSize)
+{
+	// Safety net:
+	if (filename.empty())
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Free previous content:
+	clear();
+
+	// Mounted archives first (see Archive::mount()):
+	if (Eng::Archive::resolve(filename, *this, mode, windowSize))
+		return true;
+
+	switch (mode)
+	{
+		/////////////////////
+	case Mode::memory: //
+	{
+		FILE* dat = fopen(filename.c_str(), "rb");
+		if (dat == nullptr)
+		{
+			ENG_LOG_ERROR("Unable to open file '%s'", filename.c_str());
+			return false;
+		}
+
+		// Get file length:
+		uint64_t length = fileSize(dat);
+
+		// Init mem and copy:
+		reserved->data->resize(length);
+		if (fread(reserved->data->data(), sizeof(uint8_t), length, dat) != length)
+		{
+			ENG_LOG_ERROR("File '%s' is corrupted", filename.c_str());
+			fclose(dat);
+			clear();
+			return false;
+		}
+		fclose(dat);
+		reserved->nrOfBytes = length;
+	}
+	break;
+
+		/////////////////////
+	case Mode::mapped: //
+	{
+		std::shared_ptr<Reserved::Mapping> mapping = std::make_shared<Reserved::Mapping>();
+		if (mapping->open(filename) == false)
+		{
+			ENG_LOG_ERROR("Unable to map file '%s'", filename.c_str());
+			return false;
+		}
+		reserved->mapping = mapping;
+		reserved->nrOfBytes = mapping->nrOfBytes;
+	}
+	break;
+
+		///////////////////////
+	case Mode::streamed: //
+	{
+		if (windowSize == 0)
+		{
+			ENG_LOG_ERROR("Invalid window size");
+			return false;
+		}
+		std::shared_ptr<Reserved::Stream> stream = std::make_shared<Reserved::Stream>();
+		stream->file = fopen(filename.c_str(), "rb");
+		if (stream->file == nullptr)
+		{
+			ENG_LOG_ERROR("Unable to open file '%s'", filename.c_str());
+			return false;
+		}
+		stream->filename = filename;
+		stream->windowSize = windowSize;
+		reserved->stream = stream;
+		reserved->nrOfBytes = fileSize(stream->file);
+	}
+	break;
+
+		///////////
+	default: //
+		ENG_LOG_ERROR("Invalid mode");
+		return false;
+	}
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the serialized data to a file.
+ * @param filename file name
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::save(const std::string& filename) const
+{
+	// Safety net:
+	if (filename.empty() || getMode() != Mode::memory)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	FILE* dat = fopen(filename.c_str(), "wb");
+	if (dat == nullptr)
+	{
+		ENG_LOG_ERROR("Unable to create file '%s'", filename.c_str());
+		return false;
+	}
+	if (fwrite(reserved->getBuffer(), sizeof(uint8_t), reserved->nrOfBytes, dat) != reserved->nrOfBytes)
+	{
+		ENG_LOG_ERROR("Unable to write file '%s'", filename.c_str());
+		fclose(dat);
+		return false;
+	}
+	fclose(dat);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Makes this serializer a read-only view of a range of another serializer's data. No copies are made: the storage
+ * (memory buffer, mapping or stream) is shared, and positions are relative to the beginning of the range. Used to
+ * access files stored within archives. A streamed source hands its window over to the view, and must not be read any
+ * further.
+ * @param source serializer holding the data
+ * @param offset first byte of the range within the source data
+ * @param nrOfBytes size of the range
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::view(const Serializer& source, uint64_t offset, uint64_t nrOfBytes)
+{
+	// Safety net:
+	if (offset > source.reserved->nrOfBytes || nrOfBytes > source.reserved->nrOfBytes - offset)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Share the storage:
+	*reserved = *source.reserved;
+	reserved->offset += offset;
+	reserved->nrOfBytes = nrOfBytes;
+	reserved->position = 0;
+	reserved->view = true;
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Makes this serializer a read-only reader of another serializer's data, starting at the same position. No copies are
+ * made: the storage (memory buffer or mapping) is shared, so the source must be neither modified nor cleared while
+ * being read. This is how independent readers of the same file are created (e.g., one per worker thread). Streamed
+ * serializers are refused, as their window can't be shared (copy them instead).
+ * @param source serializer holding the data
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::share(const Serializer& source)
+{
+	// Safety net:
+	if (source.reserved->stream)
+	{
+		ENG_LOG_ERROR("Streamed serializers can't be shared");
+		return false;
+	}
+
+	// Done:
+	*reserved = *source.reserved;
+	reserved->view = true;
+	return true;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Resets the internal data. 
@@ -166,9 +772,79 @@ void ENG_API Eng::Serializer::reset()
  */
 void ENG_API Eng::Serializer::clear()
 {
-	reserved->data.clear();
+	reserved->data = std::make_shared<std::vector<uint8_t>>();
+	reserved->mapping.reset();
+	reserved->stream.reset();
 	reserved->position = 0;
 	reserved->nrOfBytes = 0;
+	reserved->offset = 0;
+	reserved->view = false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Advances the current position without reading the data.
+ * @param nrOfBytes number of bytes to skip
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::skip(uint64_t nrOfBytes)
+{
+	// Safety net:
+	if (reserved->position + nrOfBytes > reserved->nrOfBytes)
+	{
+		ENG_LOG_ERROR("Buffer overflow");
+		return false;
+	}
+
+	// Done:
+	reserved->position += nrOfBytes;
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns a pointer to the next bytes and advances the current position. No copy is performed: the returned data is
+ * owned by the serializer and stays valid as long as its storage is not cleared (in streamed mode, as long as the
+ * window is not refilled, i.e. while reading within a prefetched range).
+ * @param nrOfBytes number of bytes to read
+ * @return pointer to the data or nullptr on error
+ */
+const void ENG_API* Eng::Serializer::read(uint64_t nrOfBytes)
+{
+	// Safety net:
+	if (reserved->position + nrOfBytes > reserved->nrOfBytes)
+	{
+		ENG_LOG_ERROR("Buffer overflow");
+		return nullptr;
+	}
+
+	// Done:
+	const uint8_t* ptr = reserved->access(nrOfBytes);
+	if (ptr)
+		reserved->position += nrOfBytes;
+	return ptr;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Makes the given number of bytes, starting at the current position, resident. Only meaningful in streamed mode, where
+ * it guarantees that pointers returned by read() within this range stay valid. Other modes just check the bounds.
+ * @param nrOfBytes number of bytes
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::prefetch(uint64_t nrOfBytes)
+{
+	if (reserved->access(nrOfBytes) == nullptr)
+	{
+		ENG_LOG_ERROR("Buffer overflow");
+		return false;
+	}
+
+	// Done:
+	return true;
 }
 
 
@@ -180,8 +856,8 @@ void ENG_API Eng::Serializer::clear()
  */
 bool ENG_API Eng::Serializer::deserialize(std::string& text)
 {
-	uint32_t size = (uint32_t)strlen((char*)(&reserved->data[reserved->position]));
-	if (reserved->position + size > reserved->nrOfBytes)
+	uint64_t size = reserved->getStringLength();
+	if (size == UINT64_MAX)
 	{
 		ENG_LOG_ERROR("Corrupted serialization");
 		return false;
@@ -195,6 +871,35 @@ bool ENG_API Eng::Serializer::deserialize(std::string& text)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Deserializes a string as a view into the serializer storage: no allocations nor copies are performed. The view stays
+ * valid under the same conditions as the pointers returned by read().
+ * @param text view over the string (terminator excluded)
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::deserialize(std::string_view& text)
+{
+	uint64_t size = reserved->getStringLength();
+	if (size == UINT64_MAX)
+	{
+		ENG_LOG_ERROR("Corrupted serialization");
+		text = std::string_view();
+		return false;
+	}
+	const char* ptr = static_cast<const char*>(read(size + 1));
+	if (ptr == nullptr)
+	{
+		text = std::string_view();
+		return false;
+	}
+
+	// Done:
+	text = std::string_view(ptr, size);
+	return true;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Deserializes a byte.
@@ -322,9 +1027,168 @@ bool ENG_API Eng::Serializer::deserialize(void* rawData, uint64_t nrOfBytes)
 	}
 
 	// Increase and store:   
-	memcpy(rawData, &reserved->data[reserved->position], nrOfBytes);
+	const uint8_t* ptr = reserved->access(nrOfBytes);
+	if (ptr == nullptr)
+		return false;
+	memcpy(rawData, ptr, nrOfBytes);
 	reserved->position += nrOfBytes;
 
 	// Done:
 	return true;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a string (zero-terminated).
+ * @param text string to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(std::string_view text)
+{
+	const uint8_t terminator = 0;
+	return serialize(text.data(), text.size()) && serialize(&terminator, sizeof(uint8_t));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a C string (zero-terminated). Required, as literals would otherwise be converted to bool.
+ * @param text string to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const char* text)
+{
+	// Safety net:
+	if (text == nullptr)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// Done:
+	return serialize(std::string_view(text));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a byte.
+ * @param byte byte to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(uint8_t byte)
+{
+	return serialize(&byte, sizeof(uint8_t));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a boolean.
+ * @param _bool boolean to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(bool _bool)
+{
+	return serialize(&_bool, sizeof(bool));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a uint.
+ * @param uint unsigned int to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(uint32_t uint)
+{
+	return serialize(&uint, sizeof(uint32_t));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a float.
+ * @param _float float to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(float _float)
+{
+	return serialize(&_float, sizeof(float));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a vec3.
+ * @param vec vec3 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::vec3& vec)
+{
+	return serialize(&vec, sizeof(glm::vec3));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a vec4.
+ * @param vec vec4 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::vec4& vec)
+{
+	return serialize(&vec, sizeof(glm::vec4));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a mat4.
+ * @param mat mat4 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::mat4& mat)
+{
+	return serialize(&mat, sizeof(glm::mat4));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a series of raw bytes at the current position, overwriting existing data and growing the buffer when
+ * required. Only serializers in memory mode (or empty ones) can be written. Copies of the serializer share the buffer.
+ * @param rawData pointer to data
+ * @param nrOfBytes number of bytes
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const void* rawData, uint64_t nrOfBytes)
+{
+	// Safety net:
+	if (rawData == nullptr && nrOfBytes)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+	if (reserved->mapping || reserved->stream || reserved->view)
+	{
+		ENG_LOG_ERROR("Read-only serializer");
+		return false;
+	}
+
+	// Grow (geometrically, as per std::vector):
+	uint64_t end = reserved->position + nrOfBytes;
+	if (end > reserved->data->size())
+		reserved->data->resize(end);
+	if (end > reserved->nrOfBytes)
+		reserved->nrOfBytes = end;
+
+	// Store:
+	if (nrOfBytes)
+		memcpy(reserved->data->data() + reserved->position, rawData, nrOfBytes);
+	reserved->position = end;
+
+	// Done:
+	return true;
+}
@@ -8,7 +8,8 @@
 
 
 /**
- * @brief Class for (de)serializing data (from)to memory.
+ * @brief Class for (de)serializing data (from)to memory. Data is written in memory mode only, and the buffer grows as
+ * required.
  */
 class ENG_API Serializer
 {
@@ -18,25 +19,86 @@ public: //
 
 	// Special values:
 	static Serializer empty;
+	static constexpr uint64_t defaultWindowSize = 4 * 1024 * 1024; ///< Default window size in streamed mode
+
+
+	/**
+	 * @brief Types of backing storage.
+	 */
+	enum class Mode : uint32_t
+	{
+		none,
+
+		// Sources:
+		memory, ///< File content copied into a memory buffer
+		mapped, ///< Read-only memory-mapped file (no copies)
+		streamed, ///< File read through a fixed-size, refillable window
+
+		// Terminator:
+		last
+	};
+
+
+	/**
+	 * @brief Read-only typed view of an array stored in the serializer. No copies are made: the view points into the
+	 * serializer storage and follows the same lifetime rules as read().
+	 */
+	template <typename T>
+	struct View
+	{
+		const T* ptr; ///< First element
+		uint64_t nrOfElements; ///< Number of elements
+
+
+		/**
+		 * Constructor.
+		 */
+		View() : ptr{nullptr}, nrOfElements{0} {}
+
+		// Accessors:
+		const T* data() const { return ptr; }
+		uint64_t size() const { return nrOfElements; }
+		bool empty() const { return nrOfElements == 0; }
+		const T* begin() const { return ptr; }
+		const T* end() const { return ptr + nrOfElements; }
+		const T& operator[](uint64_t index) const { return ptr[index]; }
+	};
+
 
 	// Const/dest:
 	Serializer();
 	Serializer(const Serializer& other);
+	Serializer(Serializer&& other);
 	Serializer(const void* rawData, uint64_t nrOfBytes);
 	virtual ~Serializer();
 
 	// Operators:
 	void operator=(const Serializer& other);
+	void operator=(Serializer&& other);
 
 	// Get/set:
 	void* getData() const;
 	void* getDataAtCurPos() const;
 	uint64_t getNrOfBytes() const;
+	uint64_t getPosition() const;
+	bool setPosition(uint64_t position);
+	Mode getMode() const;
+	uint64_t getNrOfResidentBytes() const;
+
+	// Loading/saving:
+	bool load(const std::string& filename, Mode mode = Mode::mapped, uint64_t windowSize = defaultWindowSize);
+	bool save(const std::string& filename) const;
+	bool view(const Serializer& source, uint64_t offset, uint64_t nrOfBytes);
+	bool share(const Serializer& source);
 
 	// Serialization:
 	void clear();
 	void reset();
+	bool skip(uint64_t nrOfBytes);
+	bool prefetch(uint64_t nrOfBytes);
+	const void* read(uint64_t nrOfBytes);
 	bool deserialize(std::string& text);
+	bool deserialize(std::string_view& text);
 	bool deserialize(uint8_t& byte);
 	bool deserialize(bool& _bool);
 	bool deserialize(uint32_t& uint);
@@ -45,6 +107,49 @@ public: //
 	bool deserialize(glm::vec4& vec);
 	bool deserialize(glm::mat4& mat);
 	bool deserialize(void* rawData, uint64_t nrOfBytes);
+	bool serialize(std::string_view text);
+	bool serialize(const char* text);
+	bool serialize(uint8_t byte);
+	bool serialize(bool _bool);
+	bool serialize(uint32_t uint);
+	bool serialize(float _float);
+	bool serialize(const glm::vec3& vec);
+	bool serialize(const glm::vec4& vec);
+	bool serialize(const glm::mat4& mat);
+	bool serialize(const void* rawData, uint64_t nrOfBytes);
+
+
+	/**
+	 * Deserializes an array of elements as a view into the serializer storage (no copies).
+	 * @param view view over the array
+	 * @param nrOfElements number of elements
+	 * @return TF
+	 */
+	template <typename T>
+	bool deserialize(View<T>& view, uint64_t nrOfElements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "View elements must be trivially copyable");
+
+		// Safety net:
+		if (nrOfElements > (getNrOfBytes() - getPosition()) / sizeof(T))
+		{
+			view = View<T>();
+			ENG_LOG_ERROR("Buffer overflow");
+			return false;
+		}
+
+		const T* ptr = static_cast<const T*>(read(nrOfElements * sizeof(T)));
+		if (ptr == nullptr && nrOfElements)
+		{
+			view = View<T>();
+			return false;
+		}
+
+		// Done:
+		view.ptr = ptr;
+		view.nrOfElements = nrOfElements;
+		return true;
+	}
 
 
 	/////////////
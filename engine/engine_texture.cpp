@@ -354,19 +354,33 @@ const Eng::Texture ENG_API& Eng::Texture::getDefault(bool white)
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Load the content of the texture from the given bitmap.
+ * Load the content of the texture from the given bitmap. Once loaded, the bitmap data is no longer required and can be
+ * released through Bitmap::releaseData(). BC1/BC3 bitmaps are decoded on the CPU when S3TC is not supported.
  * @param bitmap bitmap
  * @return TF
  */
 bool ENG_API Eng::Texture::load(const Eng::Bitmap& bitmap)
 {
     // Safety net:
-    if (bitmap == Eng::Bitmap::empty)
+    if (bitmap == Eng::Bitmap::empty || bitmap.hasData() == false)
     {
         ENG_LOG_ERROR("Invalid params");
         return false;
     }
 
+    // S3TC not available? Decode BC1/BC3 on the CPU:
+    static const bool s3tcSupported = glewIsSupported("GL_EXT_texture_compression_s3tc");
+    if (!s3tcSupported && (bitmap.getFormat() == Eng::Bitmap::Format::r8g8b8a8_compressed ||
+                           bitmap.getFormat() == Eng::Bitmap::Format::r8g8b8_compressed))
+    {
+        Eng::Bitmap expanded;
+        if (bitmap.decompress(expanded) == false || this->load(expanded) == false)
+            return false;
+        ENG_LOG_DEBUG("Bitmap '%s' decoded on the CPU (no S3TC support)", bitmap.getName().c_str());
+        this->setBitmap(bitmap);
+        return true;
+    }
+
     // Bind texture and copy content:   
     GLuint intFormat;
     GLuint extFormat;
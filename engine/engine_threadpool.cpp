@@ -0,0 +1,270 @@
+/**
+ * @file		engine_threadpool.cpp
+ * @brief	Pool of worker threads for CPU-side jobs
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+// Main include:
+#include "engine.h"
+
+// C/C++:
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief ThreadPool reserved structure.
+ */
+struct Eng::ThreadPool::Reserved
+{
+	std::vector<std::thread> worker; ///< Worker threads
+	std::deque<Eng::ThreadPool::Job> queue; ///< Pending jobs
+	std::mutex mutex; ///< Protects the queue
+	std::condition_variable jobAvailable; ///< Signaled when a job is queued
+	std::condition_variable jobDone; ///< Signaled when a job is completed
+	uint64_t nrOfPendingJobs; ///< Queued or running jobs
+	bool quit; ///< Workers shall terminate
+
+
+	/**
+	 * Constructor.
+	 */
+	Reserved() : nrOfPendingJobs{0}, quit{false} {}
+
+	/**
+	 * Worker main loop.
+	 */
+	void run()
+	{
+		while (true)
+		{
+			Eng::ThreadPool::Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobAvailable.wait(lock, [this] { return quit || !queue.empty(); });
+				if (quit && queue.empty())
+					return;
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				nrOfPendingJobs--;
+			}
+			jobDone.notify_all();
+		}
+	}
+
+	/**
+	 * Stops and joins all the workers, after the pending jobs are completed.
+	 */
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		jobAvailable.notify_all();
+		for (auto& w : worker)
+			w.join();
+		worker.clear();
+		quit = false;
+	}
+
+	/**
+	 * Starts the given number of workers.
+	 * @param nrOfThreads number of workers
+	 */
+	void start(uint32_t nrOfThreads)
+	{
+		for (uint32_t c = 0; c < nrOfThreads; c++)
+			worker.emplace_back(&Reserved::run, this);
+	}
+};
+
+
+//////////////////////////////
+// BODY OF CLASS ThreadPool //
+//////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor. By default, one worker per hardware thread is started.
+ */
+ENG_API Eng::ThreadPool::ThreadPool() : reserved(std::make_unique<Eng::ThreadPool::Reserved>())
+{
+	ENG_LOG_DEBUG("[+]");
+	reserved->start(std::thread::hardware_concurrency());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::ThreadPool::~ThreadPool()
+{
+	ENG_LOG_DEBUG("[-]");
+	reserved->stop();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Get singleton instance.
+ */
+Eng::ThreadPool ENG_API& Eng::ThreadPool::getInstance()
+{
+	static ThreadPool instance;
+	return instance;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of worker threads.
+ * @return number of workers
+ */
+uint32_t ENG_API Eng::ThreadPool::getNrOfThreads() const
+{
+	return static_cast<uint32_t>(reserved->worker.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the number of worker threads. Pending jobs are completed first. With zero workers, jobs run on the calling
+ * thread.
+ * @param nrOfThreads number of workers
+ * @return TF
+ */
+bool ENG_API Eng::ThreadPool::setNrOfThreads(uint32_t nrOfThreads)
+{
+	wait();
+	reserved->stop();
+	reserved->start(nrOfThreads);
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Queues a job for asynchronous execution.
+ * @param job job to execute
+ * @return TF
+ */
+bool ENG_API Eng::ThreadPool::submit(const Job& job)
+{
+	// Safety net:
+	if (!job)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	// No workers, run immediately:
+	if (reserved->worker.empty())
+	{
+		job();
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(reserved->mutex);
+		reserved->queue.push_back(job);
+		reserved->nrOfPendingJobs++;
+	}
+	reserved->jobAvailable.notify_one();
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Executes job(0) ... job(nrOfJobs - 1) using the workers and the calling thread, and returns when all are completed.
+ * Can be safely invoked from within a job.
+ * @param nrOfJobs number of jobs
+ * @param job job to execute, receiving the job index
+ * @return TF
+ */
+bool ENG_API Eng::ThreadPool::parallelFor(uint64_t nrOfJobs, const IndexedJob& job)
+{
+	// Safety net:
+	if (!job)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	/**
+	 * @brief Shared state among the helpers (outlives this call if a helper starts late).
+	 */
+	struct State
+	{
+		std::atomic<uint64_t> next{0};
+		std::atomic<uint32_t> active{0};
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	std::shared_ptr<State> state = std::make_shared<State>();
+
+	// Helpers:
+	uint64_t nrOfHelpers = reserved->worker.size();
+	if (nrOfHelpers > nrOfJobs - 1 && nrOfJobs > 0)
+		nrOfHelpers = nrOfJobs - 1;
+	const IndexedJob* _job = &job;
+	for (uint64_t c = 0; c < nrOfHelpers; c++)
+		submit([state, _job, nrOfJobs]()
+		{
+			state->active++;
+			for (uint64_t i = state->next++; i < nrOfJobs; i = state->next++)
+				(*_job)(i);
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->active--;
+			}
+			state->done.notify_all();
+		});
+
+	// Caller takes part:
+	for (uint64_t i = state->next++; i < nrOfJobs; i = state->next++)
+		job(i);
+
+	// Wait for helpers still busy with a job:
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state] { return state->active == 0; });
+
+	// Done:
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Waits until all the submitted jobs are completed.
+ */
+void ENG_API Eng::ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(reserved->mutex);
+	reserved->jobDone.wait(lock, [this] { return reserved->nrOfPendingJobs == 0; });
+}
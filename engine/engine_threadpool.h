@@ -0,0 +1,53 @@
+/**
+ * @file		engine_threadpool.h
+ * @brief	Pool of worker threads for CPU-side jobs
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+/**
+ * @brief Pool of worker threads. This class is a singleton. Jobs must not call OpenGL.
+ */
+class ENG_API ThreadPool
+{
+	//////////
+public: //
+	//////////
+
+	// Job signatures:
+	typedef std::function<void(void)> Job;
+	typedef std::function<void(uint64_t)> IndexedJob;
+
+	// Const/dest:
+	ThreadPool(ThreadPool const&) = delete;
+	~ThreadPool();
+
+	// Operators:
+	void operator=(ThreadPool const&) = delete;
+
+	// Singleton:
+	static ThreadPool& getInstance();
+
+	// Get/set:
+	uint32_t getNrOfThreads() const;
+	bool setNrOfThreads(uint32_t nrOfThreads);
+
+	// Jobs:
+	bool submit(const Job& job);
+	bool parallelFor(uint64_t nrOfJobs, const IndexedJob& job);
+	void wait();
+
+
+	///////////
+private: //
+	///////////
+
+	// Reserved:
+	struct Reserved;
+	std::unique_ptr<Reserved> reserved;
+
+	// Const/dest:
+	ThreadPool();
+};
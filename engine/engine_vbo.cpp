@@ -37,12 +37,13 @@ struct Eng::Vbo::Reserved
 {
 	GLuint oglId; ///< OpenGL shader ID
 	uint32_t nrOfVertices; ///< Nr. of vertices
+	Eng::Vbo::Layout layout; ///< Buffer layout
 
 
 	/**
 	 * Constructor.
 	 */
-	Reserved() : oglId{0}, nrOfVertices{0} {}
+	Reserved() : oglId{0}, nrOfVertices{0}, layout{Eng::Vbo::Layout::standard} {}
 };
 
 
@@ -115,6 +116,17 @@ uint32_t ENG_API Eng::Vbo::getNrOfVertices() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the layout of the buffer.
+ * @return layout
+ */
+Eng::Vbo::Layout ENG_API Eng::Vbo::getLayout() const
+{
+	return reserved->layout;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Initializes an OpenGL VBO.
@@ -131,6 +143,7 @@ bool ENG_API Eng::Vbo::init()
 		glDeleteBuffers(1, &reserved->oglId);
 		reserved->oglId = 0;
 		reserved->nrOfVertices = 0;
+		reserved->layout = Layout::standard;
 	}
 
 	// Create it:		    
@@ -157,6 +170,7 @@ bool ENG_API Eng::Vbo::free()
 		glDeleteBuffers(1, &reserved->oglId);
 		reserved->oglId = 0;
 		reserved->nrOfVertices = 0;
+		reserved->layout = Layout::standard;
 	}
 
 	// Done:   
@@ -168,12 +182,20 @@ bool ENG_API Eng::Vbo::free()
  * Create buffer by allocating the required storage.
  * @param nfOfVertices number of vertices to store
  * @param data pointer to the data to copy into the buffer 
+ * @param layout VertexData or CompactVertexData (positions in [0, 1], to be scaled by the model matrix)
  * @return TF
  */
-bool ENG_API Eng::Vbo::create(uint32_t nrOfVertices, const void* data)
+bool ENG_API Eng::Vbo::create(uint32_t nrOfVertices, const void* data, Layout layout)
 {
+	// Safety net:
+	if (layout != Layout::standard && layout != Layout::compact)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
 	// Unit size:
-	const uint32_t unitSize = sizeof(VertexData);
+	const uint32_t unitSize = layout == Layout::compact ? sizeof(CompactVertexData) : sizeof(VertexData);
 
 	// Init buffer:
 	if (!this->isInitialized())
@@ -191,10 +213,18 @@ bool ENG_API Eng::Vbo::create(uint32_t nrOfVertices, const void* data)
 	uint32_t offset = 0;
 
 	// Vertex position data:
-	glVertexAttribFormat(static_cast<GLuint>(Attrib::vertex), 3, GL_FLOAT, GL_FALSE, offset);
+	if (layout == Layout::compact)
+	{
+		glVertexAttribFormat(static_cast<GLuint>(Attrib::vertex), 3, GL_UNSIGNED_SHORT, GL_TRUE, offset);
+		offset += sizeof(glm::u16vec4);
+	}
+	else
+	{
+		glVertexAttribFormat(static_cast<GLuint>(Attrib::vertex), 3, GL_FLOAT, GL_FALSE, offset);
+		offset += sizeof(glm::vec3);
+	}
 	glVertexAttribBinding(static_cast<GLuint>(Attrib::vertex), 0);
 	glEnableVertexAttribArray(static_cast<GLuint>(Attrib::vertex));
-	offset += sizeof(glm::vec3);
 
 	// Normal data:   
 	glVertexAttribFormat(static_cast<GLuint>(Attrib::normal), 4, GL_INT_2_10_10_10_REV, GL_TRUE, offset);
@@ -216,6 +246,32 @@ bool ENG_API Eng::Vbo::create(uint32_t nrOfVertices, const void* data)
 
 	// Done:
 	reserved->nrOfVertices = nrOfVertices;
+	reserved->layout = layout;
+	return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reads back the content of the buffer (e.g., for exporting). The current bindings are not affected.
+ * @param data pointer to a destination of at least getNrOfVertices() * sizeof(VertexData) bytes (or CompactVertexData)
+ * @return TF
+ */
+bool ENG_API Eng::Vbo::read(void* data) const
+{
+	// Safety net:
+	if (data == nullptr || reserved->oglId == 0)
+	{
+		ENG_LOG_ERROR("Invalid params");
+		return false;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, reserved->oglId);
+	const uint64_t unitSize = reserved->layout == Layout::compact ? sizeof(CompactVertexData) : sizeof(VertexData);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(reserved->nrOfVertices * unitSize), data);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	// Done:
 	return true;
 }
 
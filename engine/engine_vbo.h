@@ -53,6 +53,38 @@ public: //
 	};
 
 
+	/**
+	 * @brief Per-vertex data, compact layout. Positions are quantized within the mesh bounding box, and the
+	 * dequantization is up to the model matrix.
+	 */
+	struct CompactVertexData
+	{
+		glm::u16vec4 vertex; ///< Vertex data, 16-bit unsigned normalized (w unused)
+		uint32_t normal; ///< Normal, packed as 10_10_10_2
+		uint32_t uv; ///< Tex coords, packed as 2xfp16
+		uint32_t tangent; ///< Tangent, packed as 10_10_10_2
+
+
+		/**
+		 * Constructor. 
+		 */
+		inline CompactVertexData() noexcept : vertex{0}, normal{0}, uv{0}, tangent{0} {}
+	};
+
+
+	/**
+	 * @brief Buffer layouts.
+	 */
+	enum class Layout : uint32_t
+	{
+		standard, ///< VertexData
+		compact, ///< CompactVertexData
+
+		// Terminator:
+		last
+	};
+
+
 	// Const/dest:
 	Vbo();
 	Vbo(Vbo&& other);
@@ -62,9 +94,11 @@ public: //
 	// Get/set:   
 	uint32_t getNrOfVertices() const;
 	uint32_t getOglHandle() const;
+	Layout getLayout() const;
 
 	// Data:
-	bool create(uint32_t nrOfVertices, const void* data = nullptr);
+	bool create(uint32_t nrOfVertices, const void* data = nullptr, Layout layout = Layout::standard);
+	bool read(void* data) const;
 
 	// Rendering methods:   
 	bool render(uint32_t value = 0, void* data = nullptr) const;
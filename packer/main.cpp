@@ -0,0 +1,94 @@
+/**
+ * @file		main.cpp
+ * @brief	Asset archive packer
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Main engine header:
+   #include "engine.h"
+
+   // C/C++:
+#include <algorithm>
+#include <filesystem>
+   #include <iostream>
+
+
+
+//////////
+// MAIN //
+//////////
+
+/**
+ * Application entry point. Packs either the content of a directory (recursively, entries named relative to it) or a
+ * list of files (entries named as given) into an archive, and lists the resulting entries.
+ * @param argc number of command-line arguments passed
+ * @param argv array containing up to argc passed arguments
+ * @return error code (0 on success, error code otherwise)
+ */
+int main(int argc, char *argv[])
+{
+   // Credits:
+   std::cout << "Engine asset packer, A. Peternier (C) SUPSI" << std::endl;
+   std::cout << std::endl;
+
+   // Usage:
+   if (argc < 3)
+   {
+      std::cout << "Usage: packer <archive> <directory>" << std::endl;
+      std::cout << "       packer <archive> <file> [<file> ...]" << std::endl;
+      return 1;
+   }
+   const std::string archiveFilename = argv[1];
+
+   // Collect files:
+   std::vector<std::string> files;
+   std::string basePath;
+   std::error_code error;
+   if (argc == 3 && std::filesystem::is_directory(argv[2], error))
+   {
+      basePath = argv[2];
+      for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(basePath, error))
+         if (entry.is_regular_file(error) && !std::filesystem::equivalent(entry.path(), archiveFilename, error))
+            files.push_back(entry.path().string());
+      std::sort(files.begin(), files.end());
+   }
+   else
+      for (int c = 2; c < argc; c++)
+         files.push_back(argv[c]);
+
+   // Pack:
+   Eng::Timer &timer = Eng::Timer::getInstance();
+   uint64_t t0 = timer.getCounter();
+   if (Eng::Archive::pack(archiveFilename, files, basePath) == false)
+   {
+      std::cout << "[!] Unable to pack archive '" << archiveFilename << "'" << std::endl;
+      return 2;
+   }
+   const double packTime = timer.getCounterDiff(t0, timer.getCounter());
+
+   // Check:
+   Eng::Archive archive;
+   if (archive.open(archiveFilename) == false)
+   {
+      std::cout << "[!] Unable to open archive '" << archiveFilename << "'" << std::endl;
+      return 3;
+   }
+   for (uint32_t c = 0; c < archive.getNrOfEntries(); c++)
+   {
+      Eng::Archive::Entry entry;
+      archive.find(archive.getName(c), entry);
+      std::cout << "   " << archive.getName(c) << " (" << entry.nrOfBytes << " bytes)" << std::endl;
+   }
+   std::cout << archive.getNrOfEntries() << " files packed into '" << archiveFilename << "' in " << packTime << " ms"
+             << std::endl;
+
+   // Done:
+   return 0;
+}